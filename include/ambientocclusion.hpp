@@ -0,0 +1,40 @@
+#ifndef AMBIENTOCCLUSION_HPP
+#define AMBIENTOCCLUSION_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// rays per vertex of the ambient occlusion baked when a model is imported (see Model::ambientOcclusionSamples)
+#define AMBIENT_OCCLUSION_SAMPLES 32
+// length of the rays, as a fraction of the diagonal of the bounding box of the model
+#define AMBIENT_OCCLUSION_DISTANCE 0.1f
+// vertices baked by a thread at a time
+#define AMBIENT_OCCLUSION_GRAIN 256
+
+class Bvh;
+class Mesh;
+class ThreadPool;
+
+// Ambient occlusion of the vertices: the fraction of the cosine weighted hemisphere around the normal that
+// rays leave without hitting a triangle within a distance. The rays of each vertex come from its own random
+// sequence, so the result doesn't depend on the threads
+namespace ambientocclusion {
+    // visibility of the hemisphere around normal (unit length) from origin, against the triangles of bvh closer
+    // than distance, with samples rays. randomState is the state of the random sequence of the rays
+    float visibility(const Bvh &bvh, const glm::vec3 &origin, const glm::vec3 &normal, int samples, float distance,
+                     unsigned int &randomState);
+
+    // the first state of the random sequence of a vertex
+    unsigned int seed(size_t vertex);
+
+    // bake the visibility of the vertices of the meshes (of their full detail triangles) against the triangles
+    // of all of them, which are in the same coordinates, with samples rays per vertex as long as
+    // AMBIENT_OCCLUSION_DISTANCE times the diagonal of their box. occlusion has the visibility of the vertices of
+    // each mesh, returns the number of rays traced
+    size_t bake(const std::vector<const Mesh*> &meshes, int samples, std::vector<std::vector<float>> &occlusion,
+                ThreadPool &pool);
+}
+
+#endif
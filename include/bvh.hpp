@@ -0,0 +1,108 @@
+#ifndef BVH_HPP
+#define BVH_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+//triangles of a leaf before the surface area heuristic is asked if it's worth splitting it, and the most of them
+#define BVH_LEAF_TRIANGLES 2
+#define BVH_MAX_LEAF_TRIANGLES 8
+//bins of the centroids along each axis where the splits are evaluated
+#define BVH_BINS 16
+//cost of visiting a node relative to intersecting a triangle
+#define BVH_TRAVERSAL_COST 1.f
+//nodes with more triangles than this are binned by the threads of the pool
+#define BVH_PARALLEL_TRIANGLES (1 << 16)
+//deeper nodes are split at the median, the traversal stack can't overflow
+#define BVH_MAX_DEPTH 48
+
+class ThreadPool;
+
+// where a ray hits the triangles
+struct BvhHit
+{
+    float distance;
+    // index of the triangle in the indices the BVH was built from
+    unsigned int triangle;
+    // barycentric coordinates of the second and the third corner
+    float u, v;
+};
+
+// Bounding volume hierarchy of a triangle soup for ray queries on the CPU. It's built top down with the
+// binned surface area heuristic, then collapsed to 4 children per node, whose boxes are tested against
+// the ray at once with SSE. The children are visited from the nearest and the farther ones are skipped
+// when a closer hit was already found.
+class Bvh
+{
+public:
+    Bvh();
+
+    // build the hierarchy of the triangles, 3 indices of positions per triangle. The positions are copied
+    void build(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices,
+               ThreadPool &pool);
+    void build(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices);
+
+    // nearest triangle hit by the ray from origin in direction (not necessarily normalized) closer than
+    // maxDistance (in lengths of direction), returns false if there is none
+    bool intersect(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, BvhHit &hit) const;
+
+    // true if any triangle is hit closer than maxDistance, for the shadow rays
+    bool occluded(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance) const;
+
+    // the box of all the triangles
+    glm::vec3 boundsMin() const;
+    glm::vec3 boundsMax() const;
+
+    size_t numberOfNodes() const;
+    size_t numberOfTriangles() const;
+
+private:
+    // a node of the binary tree while it's built, a leaf when count isn't 0
+    struct BuildNode
+    {
+        glm::vec3 min, max;
+        unsigned int left, right;
+        unsigned int first, count;
+    };
+
+    // 4 children in structure of arrays layout. A child with a count is a leaf with count triangles from
+    // child, otherwise child is the index of a node, or EMPTY_CHILD
+    struct alignas(16) Node
+    {
+        float minX[4], minY[4], minZ[4];
+        float maxX[4], maxY[4], maxZ[4];
+        int child[4];
+        unsigned int count[4];
+    };
+
+    // a triangle ready for the intersection, the first corner and the edges to the others
+    struct Triangle
+    {
+        glm::vec3 corner, edge1, edge2;
+    };
+
+    static const int EMPTY_CHILD = -1;
+
+    std::vector<Node> nodes;
+    // in the order of the leaves
+    std::vector<Triangle> triangles;
+    std::vector<unsigned int> triangleIds;
+    glm::vec3 sceneMin, sceneMax;
+
+    // split the triangles in [first, first + count) of order, returns the index of the node
+    unsigned int buildNode(std::vector<BuildNode> &buildNodes, std::vector<unsigned int> &order,
+                           const std::vector<glm::vec3> &boxMin, const std::vector<glm::vec3> &boxMax,
+                           const std::vector<glm::vec3> &centroids, unsigned int first, unsigned int count,
+                           int depth, ThreadPool &pool);
+
+    // turn a node of the binary tree and its descendants into nodes of 4 children, returns the index of the node
+    int collapse(const std::vector<BuildNode> &buildNodes, unsigned int index);
+
+    // the traversal of intersect and occluded, anyHit stops at the first triangle found
+    template<bool anyHit>
+    bool traverse(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, BvhHit &hit) const;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef ENVIRONMENTLIGHTING_HPP
+#define ENVIRONMENTLIGHTING_HPP
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+//the environment map bundled with the resources
+#define ENVIRONMENT_MAP_FILE "resources/textures/hdr/newport_loft.hdr"
+//side of the faces of the cube map made from the equirectangular image, a power of 2
+#define ENVIRONMENT_CUBE_SIZE 512
+//side of the faces of the irradiance map
+#define ENVIRONMENT_IRRADIANCE_SIZE 32
+//side of the faces of the first level of the prefiltered map, its levels go from roughness 0 to 1
+#define ENVIRONMENT_PREFILTER_SIZE 128
+#define ENVIRONMENT_PREFILTER_LEVELS 5
+//GGX samples per texel of the prefiltered map, and per texel of the BRDF table
+#define ENVIRONMENT_PREFILTER_SAMPLES 128
+#define ENVIRONMENT_BRDF_SAMPLES 512
+//side of the BRDF table
+#define ENVIRONMENT_BRDF_SIZE 128
+//first bytes and version of the files of the cache, a file of another version is computed again
+#define ENVIRONMENT_MAGIC 0x304c4249u
+#define ENVIRONMENT_VERSION 1u
+
+class ThreadPool;
+
+// RGB texels of the 6 faces of a cube map, w is 1 so a texel is 4 floats
+struct CubeMap
+{
+    int size;
+    // the faces in the order of GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, each one in the rows of glTexImage2D
+    std::vector<glm::vec4> texels;
+
+    void resize(int faceSize);
+
+    glm::vec4& texel(int face, int x, int y);
+    const glm::vec4& texel(int face, int x, int y) const;
+
+    // direction of a point of a face (not normalized), x and y in texels from the corner of the first texel
+    glm::vec3 direction(int face, float x, float y) const;
+
+    // bilinear filtering of the face the direction points to, clamped at its edges
+    glm::vec3 sample(const glm::vec3 &direction) const;
+};
+
+// Image based lighting computed on the CPU from an equirectangular HDR image: the environment as a cube map,
+// its diffuse irradiance (projected on 9 spherical harmonics, and evaluated into a small cube map), the
+// environment prefiltered with the GGX distribution for the roughness of each level, and the table of the
+// scale and bias of the split sum of the specular BRDF. The irradiance is the cosine weighted average of the
+// radiance (irradiance / pi), so a constant environment has its own color as irradiance.
+// The texels are computed by the threads of the pool, each one by itself, so the results don't depend on the
+// threads. The results are kept in cacheDirectory, under a hash of the image and the settings, and loaded
+// from there the next time, which skips the decoding of the image too.
+class EnvironmentLighting
+{
+public:
+    // milliseconds of each step of the last computation
+    struct Timings
+    {
+        double cube;
+        double irradiance;
+        double prefilter;
+        double brdf;
+        double total;
+    };
+
+    // directory of the computed files, the cache is disabled when it's empty
+    static std::string cacheDirectory;
+
+    // the loops run in the threads of pool
+    EnvironmentLighting(ThreadPool &pool);
+    EnvironmentLighting();
+
+    // compute the lighting of an equirectangular HDR image, or load it from the cache. Returns false if the
+    // image can't be read
+    bool load(const std::string &path);
+
+    // compute the lighting of an environment cube map, without the cache
+    void compute(const CubeMap &environment);
+
+    // the environment, the irradiance map, the levels of the prefiltered map and the BRDF table (scale and
+    // bias of F0 for n.v in x and the roughness in y, from the bottom row)
+    const CubeMap& environment() const;
+    const CubeMap& irradianceMap() const;
+    const std::vector<CubeMap>& prefilteredLevels() const;
+    const std::vector<glm::vec2>& brdfTable() const;
+
+    // irradiance / pi of the spherical harmonics for a normal (unit length)
+    glm::vec3 irradiance(const glm::vec3 &normal) const;
+
+    // spherical harmonics of the irradiance, the bands 0, 1 and 2
+    const glm::vec3* irradianceCoefficients() const;
+
+    // scale and bias of the nearest texel of the BRDF table
+    glm::vec2 brdf(float normalDotView, float roughness) const;
+
+    const Timings& timings() const;
+
+    // true if the last load came from the cache
+    bool loadedFromCache() const;
+
+private:
+    ThreadPool &pool;
+
+    // the environment and its mipmaps, only the first level when it was loaded from the cache
+    std::vector<CubeMap> environmentLevels;
+    glm::vec3 coefficients[9];
+    CubeMap irradianceCube;
+    std::vector<CubeMap> prefiltered;
+    std::vector<glm::vec2> brdfTexels;
+
+    Timings times;
+    bool fromCache;
+
+    // the cube map of an equirectangular image of RGB floats
+    void equirectangularToCube(const float *image, int width, int height);
+
+    // the steps after the cube map of the environment
+    void computeLighting();
+
+    // halve the last level of the environment until it's 1 texel wide
+    void buildEnvironmentLevels();
+
+    void projectIrradiance();
+    void prefilter();
+    void integrateBrdf();
+
+    // file of the cache of an image, empty if there is no cache or the image can't be read
+    std::string cachePath(const std::string &path) const;
+
+    // read the lighting from a file of the cache, false if it's missing or doesn't match the settings
+    bool loadCache(const std::string &path);
+    void saveCache(const std::string &path) const;
+};
+
+#endif
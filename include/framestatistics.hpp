@@ -0,0 +1,48 @@
+#ifndef FRAMESTATISTICS_HPP
+#define FRAMESTATISTICS_HPP
+
+#include <glad/glad.h>
+
+#include <string>
+
+// Measures the frames with OpenGL queries: the GPU time of the scene, the number of
+// fragment shader invocations (when the driver has pipeline statistics) and the fragments
+// that pass the depth test in the lit passes, which are the ones that run the lighting.
+// The averages are printed every second. Reading the queries waits for the GPU, so only enable it to measure
+class FrameStatistics
+{
+public:
+    // create the queries, needs a current OpenGL context
+    FrameStatistics();
+
+    // delete the queries
+    ~FrameStatistics();
+
+    // start measuring the frame
+    void beginFrame();
+
+    // count the fragments that pass the depth test between these calls (the lit passes)
+    void beginShadedPass();
+    void endShadedPass();
+
+    // stop measuring, accumulate the results and print the averages once per second.
+    // currentTime and frameTime are in seconds, label describes the rendering options
+    void endFrame(float currentTime, float frameTime, const std::string &label);
+
+private:
+    GLuint timeQuery;
+    GLuint invocationsQuery;
+    GLuint shadedQuery;
+    bool shadedQueryUsed;
+    bool invocationsSupported;
+
+    // accumulated since the last print
+    int frames;
+    double frameTimeSum;
+    double gpuTimeSum;
+    unsigned long long invocationsSum;
+    unsigned long long shadedSum;
+    float lastPrint;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef GBUFFER_HPP
+#define GBUFFER_HPP
+
+#include <glad/glad.h>
+
+class Shader;
+
+// Framebuffer of the deferred shading. The geometry pass writes the surface of each pixel
+// (position, normal, albedo and specular color) and the lighting pass reads it once per pixel,
+// so the lights are computed for the visible pixels only, instead of for every fragment drawn.
+class GBuffer
+{
+public:
+    // texture units of the attachments in the lighting pass
+    static const int POSITION_UNIT = 0;
+    static const int NORMAL_UNIT = 1;
+    static const int ALBEDO_UNIT = 2;
+    static const int SPECULAR_UNIT = 3;
+
+    // create the framebuffer objects, needs a current OpenGL context. The storage is allocated by resize
+    GBuffer();
+
+    // delete the framebuffer, the textures and the depth buffer
+    ~GBuffer();
+
+    // (re)allocate the attachments when the size changes
+    void resize(int width, int height);
+
+    // bind for the geometry pass and clear it (alpha 0 marks the pixels where nothing was drawn)
+    void bindForGeometryPass();
+
+    // bind the attachments as textures for the lighting pass and send their units to the shader
+    void bindForLightingPass(Shader &shader);
+
+    // copy the depth to the default framebuffer, so forward passes (the lamps) are hidden by the scene
+    void copyDepthToDefaultFramebuffer();
+
+    // draw a triangle that covers the screen (the lighting pass)
+    void drawFullscreenTriangle();
+
+private:
+    GLuint framebuffer;
+    GLuint position, normal, albedo, specular;
+    GLuint depth;
+    // empty VAO for the fullscreen triangle, the vertices come from gl_VertexID
+    GLuint fullscreenVAO;
+    int width;
+    int height;
+    // the depth couldn't be copied to the default framebuffer, reported once
+    bool blitFailed;
+
+    // allocate the storage of an attachment texture
+    void allocateTexture(GLuint texture, GLint internalFormat, GLenum type);
+};
+
+#endif
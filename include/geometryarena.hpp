@@ -0,0 +1,152 @@
+#ifndef GEOMETRYARENA_HPP
+#define GEOMETRYARENA_HPP
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+// vertices and indices of a page, the meshes bigger than a page get a page of their own size
+#define ARENA_PAGE_VERTICES (1 << 18)
+#define ARENA_PAGE_INDICES (1 << 20)
+
+// first fit allocator of ranges in [0, capacity), a freed range is merged with the free ranges around it
+class RangeAllocator
+{
+public:
+    // returned by allocate when no free range is big enough
+    static const size_t INVALID = ~(size_t) 0;
+
+    RangeAllocator(size_t capacity = 0);
+
+    // start of a range of size elements, or INVALID
+    size_t allocate(size_t size);
+
+    // give back a range returned by allocate
+    void free(size_t offset, size_t size);
+
+    size_t capacity() const;
+
+    // elements in allocated ranges
+    size_t used() const;
+
+    // size of the biggest free range
+    size_t largestFreeRange() const;
+
+private:
+    // start -> size of the free ranges
+    std::map<size_t, size_t> freeRanges;
+    size_t totalSize;
+    size_t usedSize;
+};
+
+// vertex layouts of the meshes (see Mesh::splitVertexStreams and Mesh::compressVertices),
+// each one has its own pages and vertex arrays
+enum VertexFormat {
+    // Vertex in a single buffer
+    INTERLEAVED_VERTICES,
+    // the positions in one buffer and VertexAttributes in another
+    SPLIT_VERTICES,
+    // CompressedPosition and CompressedAttributes
+    COMPRESSED_VERTICES,
+    NUMBER_OF_VERTEX_FORMATS
+};
+
+// optional streams of per vertex data, each one in a buffer of its own that a page creates when a mesh
+// uploads the stream for the first time
+enum VertexStream {
+    // BakedLighting, the attributes 5 to 7
+    BAKED_LIGHTING_STREAM,
+    // the ambient occlusion of the vertices in a float, the attribute 8
+    AMBIENT_OCCLUSION_STREAM,
+    // the layers of the diffuse and the specular textures of the mesh in its texture arrays, in 2 unsigned shorts,
+    // the attribute 9
+    TEXTURE_LAYER_STREAM,
+    NUMBER_OF_VERTEX_STREAMS
+};
+
+// where the vertices and the indices of a mesh are in the arena
+struct GeometryAllocation
+{
+    unsigned int page;
+    // the indices of the mesh start at 0, the draws add baseVertex to them
+    unsigned int baseVertex;
+    unsigned int vertexCount;
+    unsigned int firstIndex;
+    unsigned int indexCount;
+};
+
+// Vertex and index buffers shared by all the meshes. The buffers are allocated in big pages, one set of them
+// per vertex format and index type, and the meshes get ranges of a page. Every page has a vertex array for the
+// lit passes and one for the depth passes, so the meshes of a page are drawn with a single vertex array bind
+// and can be merged in one glMultiDrawElementsBaseVertex call.
+class GeometryArena
+{
+public:
+    // needs a current OpenGL context, the pages are created when they are needed
+    GeometryArena();
+
+    // delete the buffers and the vertex arrays of the pages
+    ~GeometryArena();
+
+    // reserve vertexCount vertices and indexCount indices in a page of this format and index type (GL_UNSIGNED_SHORT
+    // or GL_UNSIGNED_INT), a new page is created when none has the space
+    GeometryAllocation allocate(VertexFormat format, GLenum indexType, size_t vertexCount, size_t indexCount);
+
+    // copy the vertex streams (attributes is ignored by the interleaved format) and the indices of an allocation
+    void upload(const GeometryAllocation &allocation, const void *positions, const void *attributes, const void *indices);
+
+    // copy an optional stream of the vertices of an allocation, the page gets a buffer for it and its attributes
+    // in the vertex array of the lit passes the first time
+    void uploadStream(const GeometryAllocation &allocation, VertexStream stream, const void *data);
+
+    // release the ranges of an allocation, an empty one is ignored
+    void free(const GeometryAllocation &allocation);
+
+    // vertex array of a page with all the attributes, for the lit passes
+    GLuint vertexArray(unsigned int page) const;
+
+    // vertex array of a page with only the positions, for the depth passes
+    GLuint depthVertexArray(unsigned int page) const;
+
+    GLenum indexType(unsigned int page) const;
+
+    // bytes of an index of a page
+    size_t indexSize(unsigned int page) const;
+
+    size_t numberOfPages() const;
+
+    // bytes of buffers allocated in the GPU and bytes used by the meshes
+    size_t reservedBytes() const;
+    size_t usedBytes() const;
+
+    // arena shared by all the meshes, created with the first one and kept until the end of the program
+    static GeometryArena& global();
+
+private:
+    struct Page
+    {
+        VertexFormat format;
+        GLenum indexType;
+        GLuint positionBuffer, attributeBuffer, indexBuffer;
+        // 0 until a mesh of the page uploads the stream
+        GLuint streamBuffers[NUMBER_OF_VERTEX_STREAMS];
+        GLuint vertexArray, depthVertexArray;
+        RangeAllocator vertices;
+        RangeAllocator indices;
+    };
+
+    std::vector<Page> pages;
+
+    // create a page with room for at least these vertices and indices
+    unsigned int createPage(VertexFormat format, GLenum indexType, size_t vertexCount, size_t indexCount);
+
+    // set the attribute pointers of the vertex arrays of a page
+    void setupVertexArrays(Page &page);
+
+    // set the attribute pointers of an optional stream in the vertex array of the lit passes of a page
+    void setupStreamAttributes(Page &page, VertexStream stream);
+};
+
+#endif
@@ -4,13 +4,33 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/gtc/type_ptr.hpp>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include <mesh.hpp>
+#include <sceneobjects.hpp>
+
+//scene read by the application
+#define SCENE_FILE "scene.txt"
+
+//max number of lights sent in uniform arrays, more lights than this always use the clustered shading
 #define MAX_LIGHT_NUMBER 100
 
 
 class Shader;
+class ShaderCache;
 class Model;
+class LightClusters;
+class GBuffer;
+class FrameStatistics;
+class Camera;
+class LightBaker;
+
+namespace scenefile{
+    struct Scene;
+    struct SceneDiff;
+}
 
 namespace ml{
     template<class T>
@@ -24,18 +44,61 @@ namespace graphicslib {
         float texcoord[2];
     };
 
-    struct ModelInformation{
-        //model
-        Model* model;
-        //its shaders
-        Shader* phongShader;
-        Shader* gouraudShader;
+    //shading techniques, cycled with the L key
+    enum ShadingMode{
+        PHONG_SHADING,
+        GOURAUD_SHADING,
+        //Phong lighting computed per pixel from a G-buffer
+        DEFERRED_SHADING,
+        //lighting baked into the vertices by LightBaker, with the specular term of its light direction per pixel
+        BAKED_SHADING,
+        NUMBER_OF_SHADING_MODES
+    };
 
-        //its coordinates
-        float position[3];
-        float rotation[3];
-        float scale[3];
-        float finalPosition[3];
+    //lighting shader variants of a material
+    enum ShaderVariant{
+        PHONG_SHADER,
+        GOURAUD_SHADER,
+        PHONG_CLUSTERED_SHADER,
+        GOURAUD_CLUSTERED_SHADER,
+        //geometry pass of the deferred shading, independent of the lights
+        GBUFFER_SHADER,
+        //reads the baked lighting of the vertices, independent of the lights too
+        BAKED_SHADER,
+        NUMBER_OF_SHADER_VARIANTS
+    };
+
+    //what the shaders of a model depend on
+    struct MaterialInformation{
+        //textures of the material
+        bool hasDiffuseTexture;
+        bool hasSpecularTexture;
+        //the meshes use the compressed vertex layout
+        bool compressedVertices;
+        //the meshes have baked lighting, otherwise the baked shading falls back to the Gouraud shading
+        bool bakedLighting;
+        //the meshes have the ambient occlusion of their vertices, which darkens the ambient term of the lights
+        bool ambientOcclusion;
+        //the textures are layers of texture arrays, the meshes have their layers in the vertices
+        bool textureArrays;
+    };
+
+    //what an object draws, its transform is in SceneObjects
+    struct ModelInformation{
+        //model, shared by all the objects of the same file (see readScene) and deleted with the last one
+        std::shared_ptr<Model> model;
+        //its shaders, selected when first used
+        Shader* shaders[NUMBER_OF_SHADER_VARIANTS];
+        //its material
+        MaterialInformation material;
+        //level of detail drawn in the last frame
+        unsigned int lod;
+        //the meshlets of each mesh of the model this object draws in this frame, empty when it draws all the triangles
+        std::vector<MeshletVisibility> meshlets;
+        //the lighting baked into the vertices of each mesh for this object (see LightBaker), and its id, 0 when it
+        //wasn't baked. The model uploads it when the object is drawn after another one (see Model::setBakedLighting)
+        std::vector<std::vector<BakedLighting>> bakedLighting;
+        unsigned int bakedLightingId;
     };
 
 
@@ -62,20 +125,53 @@ namespace graphicslib {
         glm::vec3 ambient;
         glm::vec3 diffuse;
         glm::vec3 specular;
+
+        //distance where the light stops contributing (see LightClusters::pointLightRadius)
+        float radius;
     };
 
     //All the light information in the scene
     struct LightingInformation{
-        //array of point lights for rendering
-        PointLightForBuffer bufferOfPointLights[MAX_LIGHT_NUMBER];
-        //array of point lights that holds all the information
-        PointLight pointLights[MAX_LIGHT_NUMBER];
+        //point lights for rendering
+        std::vector<PointLightForBuffer> bufferOfPointLights;
+        //point lights that hold all the information
+        std::vector<PointLight> pointLights;
 
         //number of point lights in the scene
         int numberOfPointLights;
     };
 
 
+    //read the lights, the camera and the models of a scene file, the models are loaded and placed in the scene, in
+    //the order of the file, with their world matrices. Each file is loaded once, its objects share the model.
+    //description gets what was read, for the reloads of the file
+    void readScene(const char* path, LightingInformation &lightingInformation, SceneObjects &objects,
+                   Camera &sceneCamera, scenefile::Scene *description = NULL);
+
+    //take the models and the lights of the scene read before to the next one (see scenefile::diff): only the models
+    //of the objects added are loaded, unless another object has them already, the ones no object draws anymore are
+    //deleted, and only the lights that changed are set
+    void applySceneChanges(const scenefile::Scene &next, const scenefile::SceneDiff &diff,
+                           LightingInformation &lightingInformation, SceneObjects &objects, Camera &sceneCamera);
+
+    //remove the objects, their models are deleted
+    void deleteObjects(SceneObjects &objects);
+
+    //model matrix of a transform, with the matrices of utils (not transposed). SceneObjects::updateTransforms
+    //computes the same matrices for all the objects at once
+    ml::matrix<float> getModelMatrix(const SceneObjects::Transform &transform);
+
+    //the perspective projection of the scene
+    ml::matrix<float> getProjectionMatrix();
+
+    //a matrix of matrixlib (row major) as a glm matrix, for the renderers that run on the CPU
+    glm::mat4 toGlm(ml::matrix<float> &matrix);
+
+    //radius in pixels of a sphere on the screen of framebufferHeight pixels: infinite when the camera is inside
+    //it, 0 when it's behind the camera
+    float projectedSphereRadius(const glm::vec3 &center, float radius, ml::matrix<float> &view,
+                                ml::matrix<float> &projection, int framebufferHeight);
+
     //responds to mouse movements via callback (argument to glfw)
     void mouseCallback(GLFWwindow* window, double xpos, double ypos);
 
@@ -137,11 +233,30 @@ namespace graphicslib {
         GLuint mCoreProgram;
 
 
-        // perspective type
-        bool mPhong;
+        // shading technique
+        ShadingMode mShadingMode;
         bool mShowCube;
         bool mLReleased;
         bool mCReleased;
+        // lights from the clusters instead of uniform arrays
+        bool mClustered;
+        bool mKReleased;
+        // depth only pass before the lit pass, so each pixel is shaded once
+        bool mDepthPrepass;
+        bool mPReleased;
+        // print the frame times and the fragment shader invocations
+        bool mFrameStatistics;
+        bool mFReleased;
+        // draw the models at the level of detail of their size on the screen
+        bool mLevelOfDetail;
+        bool mOReleased;
+        // skip the meshlets of the full meshes that are out of the view or facing away from the camera
+        bool mMeshletCulling;
+        bool mMReleased;
+        // toggles Model::mergeDraws
+        bool mBReleased;
+        // triangles of the models submitted in the last frame
+        size_t mTrianglesDrawn;
 
         // timing
         float mDeltaTime;
@@ -150,16 +265,68 @@ namespace graphicslib {
         //struct to keep all the lighting information
         LightingInformation lightingInformation;
 
-        //------------------------//
-        //MODEL INFORMATION VECTOR//
-        //------------------------//
+        //-------------//
+        //SCENE OBJECTS//
+        //-------------//
 
-        //struct to keep all the model information
-        std::vector<ModelInformation> mModelInformationVector;
+        //the models of the objects and their transforms
+        SceneObjects mObjects;
+        //the objects in the view frustum in this frame
+        std::vector<unsigned int> mVisibleObjects;
+        //the visible objects with their shaders, sorted by shader
+        std::vector<std::pair<Shader*, unsigned int>> mDrawList;
 
         unsigned int loadCubeVAO();
         unsigned int loadPointLightsVAO();
 
+        //get the lighting shader variant (Phong or Gouraud, clustered or not) for a material
+        Shader* getLightingShader(ShaderCache &shaderCache, ShaderVariant variant, const MaterialInformation &material);
+
+        //get the shader of the lighting pass of the deferred shading
+        Shader* getDeferredLightingShader(ShaderCache &shaderCache);
+
+        //variant of a material used in this frame
+        ShaderVariant currentShaderVariant(const MaterialInformation &material);
+
+        //the shader of the current variant in shaders, compiled when first used
+        Shader* selectShader(ShaderCache &shaderCache, Shader** shaders, const MaterialInformation &material);
+
+        //shade the G-buffer to the default framebuffer
+        void deferredLightingPass(ShaderCache &shaderCache, GBuffer &gBuffer, const LightClusters &lightClusters,
+                                  ml::matrix<float> &view);
+
+        //radius in pixels of the bounding sphere of an object on the screen (see projectedSphereRadius)
+        float projectedRadius(unsigned int object, ml::matrix<float> &view, ml::matrix<float> &projection,
+                              int framebufferHeight);
+
+        //the objects in the view frustum, and the draw list of the lit pass
+        void cullObjects(ShaderCache &shaderCache, ml::matrix<float> &view, ml::matrix<float> &projection);
+
+        //choose the level of detail of each model for this frame
+        void selectLevelsOfDetail(ml::matrix<float> &view, ml::matrix<float> &projection, int framebufferHeight);
+
+        //request the levels of the textures each model samples in this frame and update the streamed levels
+        void streamTextures(ml::matrix<float> &view, ml::matrix<float> &projection, int framebufferHeight);
+
+        //keep the meshlets of the objects drawn at the level 0 that can be visible in this frame, in each object
+        void cullMeshlets(ml::matrix<float> &view, ml::matrix<float> &projection);
+
+        //write the depth of the scene, the lit pass then only shades the visible fragments
+        void depthPrepass(ShaderCache &shaderCache, ml::matrix<float> &view, ml::matrix<float> &projection,
+                          unsigned int cubeVAO);
+
+        //description of the rendering options for the statistics, with the lights per cluster of lightClusters
+        std::string renderingLabel(const LightClusters &lightClusters);
+
+        //read the scene file again after it was written, and load what changed in it
+        void reloadScene(scenefile::Scene &scene, LightBaker &lightBaker, unsigned int pointLightsVAO);
+
+        //send the lights to the shader, as uniforms or as the clusters
+        void sendLights(Shader &shader, const LightClusters &lightClusters);
+
+        //send the point lights information to the shader
+        void sendPointLights(Shader &shader);
+
         //callback function to execute when the window is resized
         static void framebufferResizeCallback(GLFWwindow* window, int fbWidth, int fbHeight);
 
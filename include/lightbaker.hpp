@@ -0,0 +1,103 @@
+#ifndef LIGHTBAKER_HPP
+#define LIGHTBAKER_HPP
+
+#include <bvh.hpp>
+#include <graphicslib.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//vertices baked by a thread at a time
+#define LIGHT_BAKE_GRAIN 256
+//length of the ambient occlusion rays, as a fraction of the diagonal of the scene
+#define LIGHT_BAKE_AO_DISTANCE 0.1f
+//first bytes and version of the files of the cache, a file of another version is baked again
+#define LIGHT_BAKE_MAGIC 0x4b41424cu
+#define LIGHT_BAKE_VERSION 1u
+
+class Mesh;
+class ThreadPool;
+struct BakedLighting;
+
+// Bakes the point lights of a scene into the vertices of its meshes, which never move: the ambient and diffuse
+// terms of CalcPointLight (pointLight.glsl) without the material color, the specular light and the direction
+// it comes from (the average of the directions of the lights weighted by their specular light). Optionally the
+// lights blocked by a triangle are left out (shadow rays) and the ambient term is darkened by the ambient
+// occlusion (the fraction of cosine weighted rays that leave the vertex without hitting a triangle nearby).
+// The shaders compiled with BAKED then only add the specular highlight of that direction, so their cost
+// doesn't depend on the number of lights.
+// The vertices are baked by the threads of the pool against the BVH of the whole scene, each one with its own
+// random sequence, so the result doesn't depend on the threads. The results are kept in cacheDirectory, under
+// a hash of the geometry, the transforms, the lights and the settings, and loaded from there the next time.
+class LightBaker
+{
+public:
+    // test the shadow rays
+    static bool shadows;
+
+    // ambient occlusion rays per vertex, 0 bakes without ambient occlusion
+    static int ambientOcclusionSamples;
+
+    // directory of the baked files, the cache is disabled when it's empty
+    static std::string cacheDirectory;
+
+    // the loops run in the threads of pool
+    LightBaker(ThreadPool &pool);
+    LightBaker();
+
+    // bake the lights into the vertices of the objects (see graphicslib::readScene), placed in the world of the
+    // window. Each object keeps the lighting of its meshes (ModelInformation::bakedLighting), as they share models
+    void bake(SceneObjects &objects, const graphicslib::LightingInformation &lightingInformation);
+
+    // bake the meshes of a scene built directly in the world, baked has the lighting of the vertices of each mesh
+    void bake(const std::vector<const Mesh*> &meshes, const std::vector<glm::mat4> &modelMatrices,
+              const graphicslib::LightingInformation &lightingInformation, std::vector<std::vector<BakedLighting>> &baked);
+
+    // vertices baked (or loaded) by the last bake
+    size_t vertices() const;
+
+    // rays traced by the last bake, 0 when it was loaded from the cache
+    size_t raysTraced() const;
+
+    // milliseconds taken by the last bake, the BVH build and the cache included
+    double bakeMilliseconds() const;
+
+    // true if the last bake was loaded from the cache
+    bool loadedFromCache() const;
+
+private:
+    ThreadPool &pool;
+
+    // all the vertices and the triangles of the scene in the world
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<unsigned int> indices;
+    Bvh bvh;
+    // rays leave the vertices this far along their normals, so they don't hit the triangles around them
+    float rayOffset;
+    float occlusionDistance;
+
+    graphicslib::LightingInformation lighting;
+
+    size_t vertexCount;
+    size_t rays;
+    double bakeTime;
+    bool fromCache;
+
+    // lighting of a vertex of the world, randomState seeds its ambient occlusion rays
+    BakedLighting bakeVertex(const glm::vec3 &position, const glm::vec3 &normal, unsigned int randomState,
+                             size_t &rayCount) const;
+
+    // file of the cache of the scene in positions, normals and indices, empty if there is no cache
+    std::string cachePath(const std::vector<const Mesh*> &meshes) const;
+
+    // read the lighting of the meshes from a file of the cache, false if it's missing or doesn't match them
+    bool loadCache(const std::string &path, const std::vector<const Mesh*> &meshes,
+                   std::vector<std::vector<BakedLighting>> &baked) const;
+    void saveCache(const std::string &path, const std::vector<std::vector<BakedLighting>> &baked) const;
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef LIGHTCLUSTERS_HPP
+#define LIGHTCLUSTERS_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+
+//size of the cluster grid: tiles on the screen and slices in depth
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 16
+#define CLUSTER_GRID_Z 24
+//the depth slices are exponential between these view distances (farther fragments use the last slice)
+#define CLUSTER_NEAR 0.1f
+#define CLUSTER_FAR 1000.f
+//a light stops affecting the scene when its contribution gets below this (half of an 8 bits step)
+#define LIGHT_CUTOFF_INTENSITY (0.5f/255.f)
+//reflection coefficients of the lighting model, the same of pointLight.glsl
+#define POINT_LIGHT_KA 0.01f
+#define POINT_LIGHT_KD 0.1f
+#define POINT_LIGHT_KS 0.1f
+
+class Shader;
+
+namespace ml{
+    template<class T>
+        class matrix;
+}
+
+namespace graphicslib {
+    struct PointLight;
+    struct LightingInformation;
+}
+
+// Clustered forward shading: the view frustum is split in a 3D grid of clusters (froxels) and
+// each cluster receives the list of the lights whose sphere of influence touches it.
+// The lists go to the shaders in texture buffers, so a fragment only loops over the lights of its cluster.
+class LightClusters
+{
+public:
+    // create the buffers, needs a current OpenGL context
+    LightClusters();
+
+    // delete the buffers
+    ~LightClusters();
+
+    // distance where the light contribution gets below LIGHT_CUTOFF_INTENSITY,
+    // found from its attenuation (infinite if the light isn't attenuated)
+    static float pointLightRadius(const graphicslib::PointLight &light);
+
+    // assign the lights to the clusters for this camera and upload the lists.
+    // view and projection are the matrices as they're sent to the shaders
+    void update(ml::matrix<float> &view, ml::matrix<float> &projection,
+                const graphicslib::LightingInformation &lightingInformation, int viewportWidth, int viewportHeight);
+
+    // bind the texture buffers and send the grid parameters to a shader compiled with CLUSTERED
+    void bind(Shader &shader) const;
+
+    // average number of lights in the clusters that have any light, for statistics
+    float averageLightsPerCluster() const;
+
+    // texture units used by the light data, the clusters and the light indices
+    static const int LIGHT_DATA_UNIT = 8;
+    static const int CLUSTER_LIGHTS_UNIT = 9;
+    static const int LIGHT_INDICES_UNIT = 10;
+
+private:
+    // bounding boxes of the clusters in view space, in structure of arrays so 4 clusters
+    // are tested at once. The clusters of a slice are padded to a multiple of 4
+    std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+    int clustersPerSlicePadded;
+
+    // projection used to build the bounding boxes, they're rebuilt when it changes
+    float cachedProjection[16];
+    bool boxesBuilt;
+
+    // lights of each cluster, kept between the frames to reuse the memory
+    std::vector<std::vector<unsigned int>> clusterLists;
+    // offset and count of each cluster, and all the lists one after the other
+    std::vector<unsigned int> clusterRanges;
+    std::vector<unsigned int> lightIndices;
+    // light data in 4 vec4 per light
+    std::vector<float> lightData;
+
+    int viewportWidth;
+    int viewportHeight;
+    int numberOfLights;
+
+    // buffers and their texture views
+    GLuint lightDataBuffer, clusterRangesBuffer, lightIndicesBuffer;
+    GLuint lightDataTexture, clusterRangesTexture, lightIndicesTexture;
+
+    // compute the view space bounding box of every cluster for this projection (row major)
+    void buildClusterBoxes(const float* projection);
+
+    // upload a vector to a buffer (at least one element, empty texture buffers are invalid)
+    template<class T>
+        void upload(GLuint buffer, const std::vector<T> &data);
+};
+
+#endif
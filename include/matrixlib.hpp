@@ -1,6 +1,12 @@
 #ifndef MATRIXLIB_HPP
 #define MATRIXLIB_HPP
 #define MATRIXLIB_DEBUG 0
+//products with at least this many multiply-adds use the blocked multithreaded kernel:
+#define MATRIXLIB_BLOCKED_THRESHOLD (64*64*64)
+//block sizes of the blocked kernel (rows of the result, inner dimension, columns of the result):
+#define MATRIXLIB_BLOCK_ROWS 64
+#define MATRIXLIB_BLOCK_INNER 256
+#define MATRIXLIB_BLOCK_COLS 128
 
 #include <iostream>
 #include <string>
@@ -8,6 +14,12 @@
 #include <iomanip>
 #include <new>
 #include <stdexcept>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <threadpool.hpp>
 
 namespace ml{
     template<class T> 
@@ -91,6 +103,30 @@ namespace ml{
 
                 matrix<T> transpose() const;
 
+                //linear algebra:
+                //straightforward triple loop product, used for small matrices:
+                matrix<T> naiveMultiply(const matrix<T>& m) const;
+
+                //cache blocked product that splits the rows of the result between the threads:
+                matrix<T> blockedMultiply(const matrix<T>& m) const;
+
+                //LU decomposition with partial pivoting (PA = LU) of a square matrix.
+                //lu receives L (below the diagonal, unit diagonal implied) and U, permutation the row order.
+                //returns the sign of the permutation, or 0 if the matrix is singular:
+                int luDecomposition(matrix<T>& lu, std::vector<int>& permutation) const;
+
+                //determinant of a square matrix:
+                T determinant() const;
+
+                //inverse of a square matrix, throws std::domain_error if it is singular:
+                matrix<T> inverse() const;
+
+                //closed form inverse of a 4x4 matrix, throws std::domain_error if it is singular:
+                matrix<T> inverse4x4() const;
+
+                //solve the system this * x = b for each column of b, throws std::domain_error if singular:
+                matrix<T> solve(const matrix<T>& b) const;
+
         };
 
     //-----------------------------------------------------
@@ -222,6 +222,16 @@ namespace ml{
     //* operator:
     template<class T>
         matrix<T> matrix<T> :: operator*(const matrix<T>& m) const{
+            //big products are worth the blocking and the threads:
+            if((long long)rows * cols * m.cols >= MATRIXLIB_BLOCKED_THRESHOLD){
+                return blockedMultiply(m);
+            }
+            return naiveMultiply(m);
+        }
+
+    //straightforward triple loop product:
+    template<class T>
+        matrix<T> matrix<T> :: naiveMultiply(const matrix<T>& m) const{
             //alloc:
             try{
                 matrix<T> m3(rows, m.cols);
@@ -290,7 +300,7 @@ namespace ml{
         matrix<T> matrix<T> :: transpose() const{
             //alloc:
             try{
-                matrix<T> m(rows, cols);
+                matrix<T> m(cols, rows);
 
                 //transposition:
                 int i, j;
@@ -306,6 +316,299 @@ namespace ml{
         }
 
 
+    //cache blocked product:
+    //the result is split in blocks of MATRIXLIB_BLOCK_ROWS rows, each one computed by a single thread.
+    //inside a block the inner dimension and the columns are also tiled, so the pieces of both
+    //operands that are being used stay in cache, and the innermost loop walks contiguous memory
+    template<class T>
+        matrix<T> matrix<T> :: blockedMultiply(const matrix<T>& m) const{
+            //alloc:
+            try{
+                matrix<T> m3(T(0), rows, m.cols);
+
+                //the rows are stored in a single block, so we can address them linearly:
+                const T* a = ptr[0];
+                const T* b = m.ptr[0];
+                T* c = m3.ptr[0];
+                int inner = cols;
+                int resultCols = m.cols;
+                int resultRows = rows;
+
+                int rowBlocks = (resultRows + MATRIXLIB_BLOCK_ROWS - 1) / MATRIXLIB_BLOCK_ROWS;
+                ThreadPool::global().parallelFor(0, rowBlocks, 1, [&](int firstBlock, int lastBlock){
+                    for(int block = firstBlock; block < lastBlock; block++){
+                        int iBegin = block * MATRIXLIB_BLOCK_ROWS;
+                        int iEnd = std::min(iBegin + MATRIXLIB_BLOCK_ROWS, resultRows);
+
+                        for(int kBegin = 0; kBegin < inner; kBegin += MATRIXLIB_BLOCK_INNER){
+                            int kEnd = std::min(kBegin + MATRIXLIB_BLOCK_INNER, inner);
+
+                            for(int jBegin = 0; jBegin < resultCols; jBegin += MATRIXLIB_BLOCK_COLS){
+                                int jEnd = std::min(jBegin + MATRIXLIB_BLOCK_COLS, resultCols);
+
+                                //four rows of the result at a time share each row of b that is loaded:
+                                int i = iBegin;
+                                for(; i + 4 <= iEnd; i += 4){
+                                    const T* a0 = a + (long long)i * inner;
+                                    const T* a1 = a0 + inner;
+                                    const T* a2 = a1 + inner;
+                                    const T* a3 = a2 + inner;
+                                    T* __restrict c0 = c + (long long)i * resultCols;
+                                    T* __restrict c1 = c0 + resultCols;
+                                    T* __restrict c2 = c1 + resultCols;
+                                    T* __restrict c3 = c2 + resultCols;
+                                    for(int k = kBegin; k < kEnd; k++){
+                                        const T a0k = a0[k], a1k = a1[k], a2k = a2[k], a3k = a3[k];
+                                        const T* __restrict bRow = b + (long long)k * resultCols;
+                                        //contiguous and independent, the compiler vectorizes it:
+                                        for(int j = jBegin; j < jEnd; j++){
+                                            const T bkj = bRow[j];
+                                            c0[j] += a0k * bkj;
+                                            c1[j] += a1k * bkj;
+                                            c2[j] += a2k * bkj;
+                                            c3[j] += a3k * bkj;
+                                        }
+                                    }
+                                }
+                                //remaining rows of the block:
+                                for(; i < iEnd; i++){
+                                    const T* aRow = a + (long long)i * inner;
+                                    T* __restrict cRow = c + (long long)i * resultCols;
+                                    for(int k = kBegin; k < kEnd; k++){
+                                        const T aik = aRow[k];
+                                        const T* __restrict bRow = b + (long long)k * resultCols;
+                                        for(int j = jBegin; j < jEnd; j++){
+                                            cRow[j] += aik * bRow[j];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                });
+                return m3;
+            }catch( std::bad_alloc &ba ){
+                throw ba;
+            }
+        }
+
+    //LU decomposition with partial pivoting (Doolittle, in place over a copy of the matrix)
+    template<class T>
+        int matrix<T> :: luDecomposition(matrix<T>& lu, std::vector<int>& permutation) const{
+            if(rows != cols || lu.rows != rows || lu.cols != cols){
+                throw std::invalid_argument("LU decomposition needs square matrices of the same size");
+            }
+            int n = rows;
+            copy(lu.ptr, ptr, n, n);
+
+            permutation.resize(n);
+            int i, j, k;
+            for(i = 0; i < n; i++){
+                permutation[i] = i;
+            }
+
+            //pivots smaller than this are considered zero:
+            T biggest = 0;
+            for(i = 0; i < n; i++){
+                for(j = 0; j < n; j++){
+                    biggest = std::max(biggest, (T)std::abs(ptr[i][j]));
+                }
+            }
+            T tolerance = biggest * n * std::numeric_limits<T>::epsilon();
+
+            int sign = 1;
+            for(k = 0; k < n; k++){
+                //find the row with the biggest pivot:
+                int pivotRow = k;
+                for(i = k + 1; i < n; i++){
+                    if(std::abs(lu.ptr[i][k]) > std::abs(lu.ptr[pivotRow][k])){
+                        pivotRow = i;
+                    }
+                }
+                if(std::abs(lu.ptr[pivotRow][k]) <= tolerance){
+                    return 0;
+                }
+                //swap the contents of the rows (the pointers must keep the single block layout):
+                if(pivotRow != k){
+                    std::swap_ranges(lu.ptr[k], lu.ptr[k] + n, lu.ptr[pivotRow]);
+                    std::swap(permutation[k], permutation[pivotRow]);
+                    sign = -sign;
+                }
+
+                //eliminate below the pivot:
+                T pivot = lu.ptr[k][k];
+                for(i = k + 1; i < n; i++){
+                    T factor = lu.ptr[i][k] / pivot;
+                    lu.ptr[i][k] = factor;
+                    T* row = lu.ptr[i];
+                    const T* pivotRowPtr = lu.ptr[k];
+                    for(j = k + 1; j < n; j++){
+                        row[j] -= factor * pivotRowPtr[j];
+                    }
+                }
+            }
+            return sign;
+        }
+
+    //determinant: product of the diagonal of U times the sign of the permutation
+    template<class T>
+        T matrix<T> :: determinant() const{
+            if(rows != cols){
+                throw std::invalid_argument("determinant needs a square matrix");
+            }
+            matrix<T> lu(rows, cols);
+            std::vector<int> permutation;
+            int sign = luDecomposition(lu, permutation);
+            if(sign == 0){
+                return 0;
+            }
+            T det = sign;
+            for(int i = 0; i < rows; i++){
+                det *= lu.ptr[i][i];
+            }
+            return det;
+        }
+
+    //inverse: solve the system for the identity, the 4x4 case has a closed form
+    template<class T>
+        matrix<T> matrix<T> :: inverse() const{
+            if(rows != cols){
+                throw std::invalid_argument("inverse needs a square matrix");
+            }
+            if(rows == 4){
+                return inverse4x4();
+            }
+            matrix<T> identity(rows, cols, true);
+            return solve(identity);
+        }
+
+    //closed form inverse of a 4x4 matrix using the cofactors (2x2 sub-determinants shared between them)
+    template<class T>
+        matrix<T> matrix<T> :: inverse4x4() const{
+            if(rows != 4 || cols != 4){
+                throw std::invalid_argument("inverse4x4 needs a 4x4 matrix");
+            }
+            const T* m = ptr[0];
+
+            //2x2 determinants of the two upper rows:
+            T s0 = m[0] * m[5] - m[4] * m[1];
+            T s1 = m[0] * m[6] - m[4] * m[2];
+            T s2 = m[0] * m[7] - m[4] * m[3];
+            T s3 = m[1] * m[6] - m[5] * m[2];
+            T s4 = m[1] * m[7] - m[5] * m[3];
+            T s5 = m[2] * m[7] - m[6] * m[3];
+
+            //2x2 determinants of the two lower rows:
+            T c5 = m[10] * m[15] - m[14] * m[11];
+            T c4 = m[9] * m[15] - m[13] * m[11];
+            T c3 = m[9] * m[14] - m[13] * m[10];
+            T c2 = m[8] * m[15] - m[12] * m[11];
+            T c1 = m[8] * m[14] - m[12] * m[10];
+            T c0 = m[8] * m[13] - m[12] * m[9];
+
+            T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+            //the determinant is at most the product of the lengths of the rows, and of the columns (Hadamard): a
+            //determinant within the rounding of that scale is zero. The smaller product keeps the model matrices
+            //with small scales and big translations
+            T rowProduct = 1, columnProduct = 1;
+            for(int i = 0; i < 4; i++){
+                T row = 0, column = 0;
+                for(int j = 0; j < 4; j++){
+                    row += m[4 * i + j] * m[4 * i + j];
+                    column += m[4 * j + i] * m[4 * j + i];
+                }
+                rowProduct *= std::sqrt(row);
+                columnProduct *= std::sqrt(column);
+            }
+            T tolerance = std::min(rowProduct, columnProduct) * 16 * std::numeric_limits<T>::epsilon();
+            if(std::abs(det) <= tolerance){
+                throw std::domain_error("inverse of a singular matrix");
+            }
+            T invDet = T(1) / det;
+
+            matrix<T> result(4, 4);
+            T* r = result.ptr[0];
+            r[0]  = ( m[5] * c5 - m[6] * c4 + m[7] * c3) * invDet;
+            r[1]  = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * invDet;
+            r[2]  = ( m[13] * s5 - m[14] * s4 + m[15] * s3) * invDet;
+            r[3]  = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * invDet;
+
+            r[4]  = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * invDet;
+            r[5]  = ( m[0] * c5 - m[2] * c2 + m[3] * c1) * invDet;
+            r[6]  = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * invDet;
+            r[7]  = ( m[8] * s5 - m[10] * s2 + m[11] * s1) * invDet;
+
+            r[8]  = ( m[4] * c4 - m[5] * c2 + m[7] * c0) * invDet;
+            r[9]  = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * invDet;
+            r[10] = ( m[12] * s4 - m[13] * s2 + m[15] * s0) * invDet;
+            r[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * invDet;
+
+            r[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * invDet;
+            r[13] = ( m[0] * c3 - m[1] * c1 + m[2] * c0) * invDet;
+            r[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * invDet;
+            r[15] = ( m[8] * s3 - m[9] * s1 + m[10] * s0) * invDet;
+
+            return result;
+        }
+
+    //solve this * x = b using the LU decomposition, one forward and one back substitution per column of b
+    template<class T>
+        matrix<T> matrix<T> :: solve(const matrix<T>& b) const{
+            if(rows != cols || b.rows != rows){
+                throw std::invalid_argument("solve needs a square matrix and a right side with the same rows");
+            }
+            int n = rows;
+            matrix<T> lu(n, n);
+            std::vector<int> permutation;
+            if(luDecomposition(lu, permutation) == 0){
+                throw std::domain_error("solve with a singular matrix");
+            }
+
+            //apply the permutation to b:
+            matrix<T> x(n, b.cols);
+            int i, j;
+            for(i = 0; i < n; i++){
+                for(j = 0; j < b.cols; j++){
+                    x.ptr[i][j] = b.ptr[permutation[i]][j];
+                }
+            }
+
+            //the columns are independent, large systems (inverses) split them between the threads.
+            //each thread walks the rows over its range of columns, so the inner loops are contiguous:
+            int grain = std::max(16, (int)(MATRIXLIB_BLOCKED_THRESHOLD / ((long long)n * n + 1)));
+            ThreadPool::global().parallelFor(0, b.cols, grain, [&](int firstCol, int lastCol){
+                //forward substitution (L has unit diagonal):
+                for(int r = 1; r < n; r++){
+                    T* xRow = x.ptr[r];
+                    for(int c = 0; c < r; c++){
+                        const T factor = lu.ptr[r][c];
+                        const T* xc = x.ptr[c];
+                        for(int col = firstCol; col < lastCol; col++){
+                            xRow[col] -= factor * xc[col];
+                        }
+                    }
+                }
+                //back substitution:
+                for(int r = n - 1; r >= 0; r--){
+                    T* xRow = x.ptr[r];
+                    for(int c = r + 1; c < n; c++){
+                        const T factor = lu.ptr[r][c];
+                        const T* xc = x.ptr[c];
+                        for(int col = firstCol; col < lastCol; col++){
+                            xRow[col] -= factor * xc[col];
+                        }
+                    }
+                    const T pivot = lu.ptr[r][r];
+                    for(int col = firstCol; col < lastCol; col++){
+                        xRow[col] /= pivot;
+                    }
+                }
+            });
+            return x;
+        }
+
+
     //functions:
 
     //alloc a 2d-array:
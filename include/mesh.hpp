@@ -3,6 +3,7 @@
 
 #include <glm/glm.hpp>
 
+#include <geometryarena.hpp>
 #include <shader.hpp>
 
 #include <vector>
@@ -17,33 +18,218 @@ struct Vertex {
     glm::vec3 Bitangent;
 };
 
+// the attributes of Vertex without the position, for the second stream of the split layout
+struct VertexAttributes {
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+    glm::vec3 Tangent;
+    glm::vec3 Bitangent;
+};
+
+// vertex of the compressed layout (Mesh::compressVertices), 20 bytes instead of 56.
+// The position goes in the position stream: 16 bits per axis inside the bounding box of the mesh,
+// the 4th component keeps the handedness of the tangent frame (0 is -1, 65535 is +1)
+struct CompressedPosition {
+    unsigned short Position[4];
+};
+
+// and the other attributes in the attribute stream: normal and tangent octahedral encoded in
+// 2 snorm16 each (the bitangent is cross(normal, tangent) * handedness), texture coordinates in half floats
+struct CompressedAttributes {
+    short Normal[2];
+    unsigned short TexCoords[2];
+    short Tangent[2];
+};
+
+// lighting of a vertex baked by LightBaker, in half floats, for the shaders compiled with BAKED. It goes in a
+// stream of its own, next to the vertices of the mesh in the geometry arena
+struct BakedLighting {
+    // ambient and diffuse light (multiplied by the diffuse color in the shaders), w is the ambient occlusion
+    unsigned short Diffuse[4];
+    // specular light, w is unused
+    unsigned short Specular[4];
+    // direction in the world the specular light comes from, w is unused
+    unsigned short LightDirection[4];
+};
+
+// biggest errors of the compression of a mesh
+struct CompressionError {
+    // distance between the original and the decoded positions
+    float position;
+    // angle between the original and the decoded normals and tangents, in degrees
+    float normal;
+    float tangent;
+    // difference in the texture coordinates
+    float texCoords;
+};
+
+// a level of detail of a mesh: a range of its index buffer, all the levels use the same vertices
+struct MeshLod {
+    unsigned int indexOffset;
+    unsigned int indexCount;
+    // distance the simplified surface moved from the full one, in the coordinates of the mesh
+    float error;
+};
+
+// a cluster of neighboring triangles of the full mesh: a range of its index buffer, with the bounds used
+// to skip it when it's out of the frustum or facing away from the camera
+struct Meshlet {
+    unsigned int indexOffset;
+    unsigned int indexCount;
+    // sphere around the vertices, in the coordinates of the mesh
+    glm::vec3 center;
+    float radius;
+    // the normals of the triangles are within the cone around coneAxis, coneCutoff is the sine of its
+    // half angle (1 when the normals spread too much for the cluster to ever face away)
+    glm::vec3 coneAxis;
+    float coneCutoff;
+};
+
+// the meshlets of the level 0 of a mesh that can be visible for one object (see Mesh::cullMeshlets). The meshes of a
+// model are shared by all the objects that load its file, so each object keeps its own
+struct MeshletVisibility {
+    // false when all the triangles of the level 0 are drawn
+    bool culled;
+    // the index ranges of the visible meshlets, the ones that follow each other merged, in bytes from the start
+    // of the index buffer of the page
+    vector<GLsizei> counts;
+    vector<const void*> offsets;
+};
+
 struct Texture {
     unsigned int id;
     string type;
     string path;
+    // layer of the texture in id when id is a GL_TEXTURE_2D_ARRAY (see Model::textureArrays), -1 when it's a
+    // GL_TEXTURE_2D
+    int layer;
 };
 
 class Mesh {
 public:
     /*  Mesh Data  */
     vector<Vertex> vertices;
+    // the indices of all the levels of detail, one after the other
     vector<unsigned int> indices;
     vector<Texture> textures;
-    unsigned int VAO;
+    // the levels of detail, from the full mesh (0) to the coarsest
+    vector<MeshLod> lods;
+    // the meshlets of the full mesh, one after the other in its indices
+    vector<Meshlet> meshlets;
+    // fraction of the hemisphere of each vertex that isn't blocked by the triangles of the model (see
+    // Model::ambientOcclusionSamples), empty when it wasn't baked
+    vector<float> ambientOcclusion;
+    // where the vertices and the indices are in the shared buffers of GeometryArena::global()
+    GeometryAllocation geometry;
+    // GL_UNSIGNED_SHORT when the mesh has at most 65536 vertices, GL_UNSIGNED_INT otherwise
+    unsigned int indexType;
+    // texture coordinates per unit of the mesh: the square root of the area of the triangles in the texture over
+    // their area in the mesh (0 when they have no area), which gives the level of the textures that is sampled
+    float uvDensity;
+
+    // upload the positions in their own buffer (12 bytes per vertex) and the other attributes in a second one,
+    // so the depth passes only fetch the positions. Otherwise a single interleaved buffer is used
+    static bool splitVertexStreams;
+
+    // upload the compressed layout (CompressedPosition and CompressedAttributes), decoded by the shaders
+    // compiled with COMPRESSED_VERTICES. The streams are always split in this layout
+    static bool compressVertices;
+
+    // upload the vertices and the indices to the geometry arena and the textures to OpenGL. Without it the meshes
+    // and the models only keep their data in memory, for the software renderer that runs without an OpenGL context
+    static bool uploadToGpu;
+
+    // octahedral encoding of a unit vector in 2 snorm16, the rounding that decodes closest to the vector is chosen.
+    // A zero vector is encoded as +Z
+    static void octahedralEncode(glm::vec3 v, short encoded[2]);
+
+    // the decoding of the shaders (vertexInput.glsl)
+    static glm::vec3 octahedralDecode(const short encoded[2]);
+
+    // true if this mesh was uploaded compressed
+    bool compressed;
+    // bounding box of the quantized positions: position = positionOffset + quantized * positionScale
+    glm::vec3 positionOffset;
+    glm::vec3 positionScale;
+    // precision lost by the compression
+    CompressionError compressionError;
 
     /*  Functions  */
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures);
+    // constructor, without levels of detail all the indices are the level 0
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures,
+         vector<MeshLod> lods = vector<MeshLod>(), vector<Meshlet> meshlets = vector<Meshlet>());
+
+    // render the mesh at a level of detail (the coarsest one if it has less levels), the level 0 only draws the
+    // meshlets in visible when it's given
+    void Draw(Shader shader, unsigned int lod = 0, const MeshletVisibility *visible = NULL);
+
+    // render only the triangles, without binding the textures (depth passes)
+    void DrawGeometry(Shader &shader, unsigned int lod = 0, const MeshletVisibility *visible = NULL);
+
+    // upload the lighting baked into the vertices for an object (see LightBaker) next to them in the arena, the
+    // next draws use it
+    void setBakedLighting(const vector<BakedLighting> &lighting);
+
+    // keep the ambient occlusion of the vertices and upload it next to them in the arena
+    void setAmbientOcclusion(vector<float> occlusion);
+
+    // upload the layers of the first diffuse and specular textures next to the vertices in the arena, after the
+    // textures were packed in texture arrays
+    void setTextureLayers();
+
+    // bind the textures to the samplers of the shader
+    void bindTextures(Shader &shader);
+
+    // send the bounding box of the quantized positions to the shader
+    void setDecoding(Shader &shader);
 
-    // render the mesh
-    void Draw(Shader shader);
+    // true if the shader decodes the vertices of both meshes in the same way, so they can be drawn together
+    bool sameDecoding(const Mesh &other) const;
+
+    // add the index ranges drawn for lod (the meshlets in visible at the level 0 when they are culled)
+    // to the arguments of a glMultiDrawElementsBaseVertex call
+    void appendDraws(unsigned int lod, vector<GLsizei> &counts, vector<const void*> &offsets, vector<GLint> &baseVertices,
+                     const MeshletVisibility *visible = NULL);
+
+    // vertex array of the page of the arena with the mesh, with all the attributes (lit passes)
+    // or only the positions (depth passes)
+    unsigned int vertexArray() const;
+    unsigned int depthVertexArray() const;
+
+    // the meshlets that can be visible from the camera in visible, for the draws of the level 0 of an object.
+    // The camera and the frustum planes are in the coordinates of the mesh, returns the triangles kept
+    size_t cullMeshlets(const glm::vec3 &cameraPosition, const glm::vec4 planes[6], MeshletVisibility &visible) const;
+
+    // the level of detail that is drawn for lod
+    const MeshLod& getLod(unsigned int lod) const;
+
+    // bytes of vertex data in the GPU
+    size_t vertexBytes() const;
+
+    // bytes of index data in the GPU
+    size_t indexBytes() const;
 
 private:
     /*  Render data  */
-    unsigned int VBO, EBO;
+    // true once baked lighting was uploaded, the stream then has it for every vertex
+    bool hasBakedLighting;
+    // arguments of the draw of this mesh alone
+    vector<GLsizei> drawCounts;
+    vector<const void*> drawOffsets;
+    vector<GLint> drawBaseVertices;
 
     /*  Functions    */
-    // initializes all the buffer objects/arrays
+    // bytes of an index
+    size_t indexSize() const;
+
+    // upload the vertices and the indices to the arena
     void setupMesh();
+
+    // fill the compressed streams and measure the error of the compression
+    void compress(vector<CompressedPosition> &positions, vector<CompressedAttributes> &attributes);
+
+
+    // draw the triangles of a level of detail with the bound vertex array
+    void drawElements(unsigned int lod, const MeshletVisibility *visible);
 };
 #endif
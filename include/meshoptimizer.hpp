@@ -0,0 +1,121 @@
+#ifndef MESHOPTIMIZER_HPP
+#define MESHOPTIMIZER_HPP
+
+#include <mesh.hpp>
+
+#include <cstddef>
+#include <vector>
+
+// size of the LRU cache modeled by the triangle reordering
+#define OPTIMIZER_CACHE_SIZE 32
+// size of the FIFO post-transform cache simulated by the statistics
+#define FIFO_CACHE_SIZE 16
+// a collapse can't turn the normal of a vertex by more than this (cosine of 60 degrees)
+#define SIMPLIFY_NORMAL_COSINE 0.5f
+// nor turn a triangle by more than this (cosine of about 75 degrees), a triangle turned further is close to flipping
+#define SIMPLIFY_TRIANGLE_COSINE 0.25f
+// weight of the planes that keep the borders and the seams, relative to the triangle planes
+#define SIMPLIFY_BORDER_WEIGHT 2.0
+// a simplification pass collapses edges from the cheapest 1/SIMPLIFY_PASS_FRACTION of them
+#define SIMPLIFY_PASS_FRACTION 3
+// levels of detail of each mesh, including the full one
+#define LOD_COUNT 5
+// meshes with less triangles aren't simplified
+#define LOD_MIN_TRIANGLES 64
+// a level that keeps more than this fraction of the previous one isn't worth it
+#define LOD_MIN_REDUCTION 0.85f
+// most vertices and triangles of a meshlet
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+// weight of the normal of a triangle against the new vertices it adds when a meshlet grows,
+// the meshlets with flatter normal cones face away from the camera more often
+#define MESHLET_CONE_WEIGHT 1.f
+
+// vertices closer than this fraction of the diagonal of the bounding box are welded
+#define WELD_POSITION_TOLERANCE 1e-6f
+// if their normals are within this cosine (about 0.8 degrees) and their texture coordinates within this distance
+#define WELD_NORMAL_COSINE 0.9999f
+#define WELD_TEXCOORD_TOLERANCE 1e-5f
+
+// the generated normals are smoothed across the edges whose triangles are within this cosine (60 degrees),
+// the sharper edges are creases that keep a normal on each side
+#define NORMAL_CREASE_COSINE 0.5f
+
+// Import stage that welds the vertices of a mesh and generates its normals and tangents, reorders the triangles
+// and the vertices for the GPU caches and simplifies it into levels of detail
+namespace meshoptimizer {
+    // post-transform cache behavior of an index buffer, added up over several meshes with +=
+    struct VertexCacheStatistics{
+        // vertices transformed (cache misses)
+        size_t transformedVertices;
+        size_t triangles;
+        size_t vertices;
+
+        VertexCacheStatistics();
+        VertexCacheStatistics& operator+=(const VertexCacheStatistics &other);
+
+        // average cache miss ratio: transformed vertices per triangle (0.5 is the best of a regular grid, 3 the worst)
+        float acmr() const;
+        // average transformed vertex ratio: transformed vertices per vertex (1 is the best)
+        float atvr() const;
+    };
+
+    // merge the vertices with the same position, normal and texture coordinates (within the WELD tolerances,
+    // the tangents aren't compared) through a hash grid, and remove the triangles that become degenerate.
+    // Returns the number of vertices removed
+    size_t weldVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // smooth normals: each corner gets the sum of the normals of the triangles around its position that are within
+    // NORMAL_CREASE_COSINE of its own, weighted by the angle of the triangle at the vertex, so the result doesn't depend
+    // on how the faces are split in triangles. The vertices whose corners end up with other normals are split
+    void generateNormals(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // tangent frames in the way of MikkTSpace: the texture directions of each triangle are projected on the tangent
+    // plane of the vertex normal and summed weighted by the angle of the triangle at the vertex. The tangent is then
+    // orthogonalized to the normal and the bitangent is cross(normal, tangent) with the handedness of the texture
+    // mapping. The vertices with the same position and normal but other texture coordinates are already apart, the
+    // ones on a mirrored seam, whose triangles disagree on the handedness, are split before summing
+    void generateTangents(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // simulate a FIFO post-transform cache of cacheSize entries on the triangle list
+    VertexCacheStatistics analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                             unsigned int cacheSize = FIFO_CACHE_SIZE);
+
+    // reorder the triangles so the vertices are reused while they are in the post-transform cache
+    // (Forsyth's linear-speed vertex cache optimization). The winding of each triangle is kept
+    void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount);
+
+    // reorder the vertices in the order the triangles first use them, so the vertex fetch reads
+    // the buffer sequentially. Vertices that no triangle uses are removed
+    void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // simplify the triangles down to at most targetIndexCount indices (or as close as the mesh allows) by
+    // collapsing vertices into their neighbors in the order of the quadric error metric. The vertices are
+    // kept, so the result indexes the same vertex buffer. The copies of a vertex on a UV seam or a crease
+    // (the same position with other attributes) move together, along the seam, and the borders only
+    // move along themselves, so the texture mapping and the outline are preserved. The collapses that turn
+    // the normal of a vertex too much or flip a triangle are skipped. error is set to the distance the
+    // surface moved (the root mean square distance to the original planes of the worst collapse)
+    std::vector<unsigned int> simplify(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                       size_t targetIndexCount, float &error);
+
+    // simplify the mesh into a chain of levels of detail, each one with half the triangles of the previous one.
+    // They are all simplified from the full mesh, so their errors are measured against it, and appended to
+    // indices. The chain stops at LOD_COUNT levels or when the mesh can't be simplified more.
+    // The triangles of each level are reordered for the vertex cache when optimizeCache is set
+    std::vector<MeshLod> generateLods(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                      bool optimizeCache);
+
+    // group the triangles into meshlets of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES
+    // triangles. Each meshlet grows from the next free triangle in the current order through the triangles that
+    // share a position with it (across the seams too), and its triangles are then reordered for the vertex cache.
+    // The indices are rewritten meshlet after meshlet
+    std::vector<Meshlet> buildMeshlets(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices);
+
+    // true if the meshlet can have a visible triangle: its sphere isn't behind any of the frustum planes
+    // (a, b, c, d with a*x + b*y + c*z + d >= 0 inside and (a, b, c) unit length) and its normal cone doesn't
+    // face away from the camera. The planes and the camera position are in the coordinates of the mesh
+    bool meshletVisible(const Meshlet &meshlet, const glm::vec3 &cameraPosition, const glm::vec4 planes[6]);
+}
+
+#endif
@@ -1,9 +1,10 @@
 #ifndef MODEL_HPP
 #define MODEL_HPP
-#define STB_IMAGE_IMPLEMENTATION
 
 #include <mesh.hpp>
+#include <meshoptimizer.hpp>
 #include <shader.hpp>
+#include <texturecompressor.hpp>
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -13,8 +14,50 @@
 
 using namespace std;
 
-// load and generate textures from the object file
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+// post processing of the imported files. Every triangle comes with its own 3 vertices, Model::readMesh welds
+// them (otherwise there is nothing for the vertex cache to reuse) and generates the normals and the tangents
+#define MODEL_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_FlipUVs)
+
+// biggest error on the screen, in pixels, of the level of detail drawn
+#define LOD_PIXEL_ERROR 1.f
+// fraction of LOD_PIXEL_ERROR a coarser level has to be below before it's selected
+#define LOD_HYSTERESIS 0.25f
+
+// load and generate textures from the object file. The texture conditioned by --condition-textures is used
+// instead when there is one for the image and Model::conditionedTextures is set
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false,
+                             texturecompressor::TextureKind kind = texturecompressor::COLOR_TEXTURE);
+
+// size and format of a texture of a model, the textures with the same ones can be layers of a texture array
+struct TextureLayout
+{
+    string type;
+    int width;
+    int height;
+    // the texturecompressor::BlockFormat of the conditioned texture, -1 when the image is uploaded as it is
+    int blockFormat;
+    // components of the image uploaded as it is (0 when it can't be read)
+    int components;
+};
+
+// vertices and times of the import of meshes, added up over several meshes with +=
+struct ImportStatistics
+{
+    // vertices from the file and after the welding
+    size_t importedVertices;
+    size_t weldedVertices;
+    // meshes whose normals were generated
+    unsigned int meshesWithoutNormals;
+    double weldMilliseconds;
+    double normalMilliseconds;
+    double tangentMilliseconds;
+    // the ambient occlusion baked into the vertices
+    double occlusionMilliseconds;
+    size_t occlusionRays;
+
+    ImportStatistics();
+    ImportStatistics& operator+=(const ImportStatistics &other);
+};
 
 struct Dimension
 {
@@ -41,12 +84,80 @@ public:
     bool gammaCorrection;
     BoundingBox boundingBox;
 
+    // reorder the triangles and the vertices of the meshes for the GPU caches when they are imported
+    static bool optimizeMeshes;
+
+    // simplify the meshes into levels of detail when they are imported
+    static bool generateLods;
+
+    // group the triangles of the full meshes into meshlets when they are imported, for the culling
+    static bool generateMeshlets;
+
+    // draw the meshes that share the textures and the vertex arrays of the arena with one
+    // glMultiDrawElementsBaseVertex call, otherwise each mesh is drawn by itself
+    static bool mergeDraws;
+
+    // rays per vertex of the ambient occlusion baked when the meshes are imported, 0 doesn't bake it
+    static int ambientOcclusionSamples;
+
+    // upload the compressed textures of texturecompressor::cacheDirectory when the images have one, otherwise
+    // the images are decoded and their mipmaps generated by the driver
+    static bool conditionedTextures;
+
+    // pack the textures of the same type, size and format in GL_TEXTURE_2D_ARRAY textures when the model is
+    // loaded, so the meshes that only differ in their textures are drawn together. The layers go in the vertices
+    // of the meshes and the shaders are compiled with TEXTURE_ARRAYS. The arrays aren't streamed
+    static bool textureArrays;
+
     /*  Functions   */
+    // the textures packed in each array: the indices of the layouts that match, at most maxLayers in an array.
+    // The layouts that can't be read aren't packed
+    static vector<vector<unsigned int>> groupTextureArrays(const vector<TextureLayout> &layouts, int maxLayers);
+
+    // the triangles of an imported mesh (points and lines aren't drawn) with their vertices welded, the normals
+    // generated when the file has none and the tangents generated
+    static void readMesh(const aiMesh *mesh, vector<Vertex> &vertices, vector<unsigned int> &indices,
+                         ImportStatistics &statistics);
+
     // constructor, expects a filepath to a 3D model.
     Model(string const &path, bool gamma = false);
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader shader);
+    // give the ranges of the meshes back to the geometry arena
+    ~Model();
+
+    // draws the model, and thus all its meshes, at a level of detail. At the level 0 the meshes only draw the
+    // meshlets of an object in visible (see cullMeshlets) when it's given
+    void Draw(Shader shader, unsigned int lod = 0, const vector<MeshletVisibility> *visible = NULL);
+
+    // draws the triangles of all the meshes without their textures (depth passes)
+    void DrawGeometry(Shader &shader, unsigned int lod = 0, const vector<MeshletVisibility> *visible = NULL);
+
+    // draw calls of Draw
+    unsigned int drawCallCount();
+
+    // number of levels of detail of the mesh that has the most
+    unsigned int numberOfLods();
+
+    // biggest error of the meshes at a level of detail, in the coordinates of the model
+    float lodError(unsigned int lod);
+
+    // triangles drawn at a level of detail
+    size_t triangleCount(unsigned int lod);
+
+    // radius of the sphere around the bounding box
+    float boundingRadius();
+
+    // the coarsest level of detail whose error is below LOD_PIXEL_ERROR when the bounding sphere covers
+    // projectedRadius pixels on the screen, with hysteresis around the currently drawn level
+    unsigned int selectLod(unsigned int currentLod, float projectedRadius);
+
+    // the meshlets of each mesh that can be visible from the camera in visible, for the draws of the level 0 of an
+    // object. The camera and the frustum planes are in the coordinates of the model, returns the triangles kept
+    size_t cullMeshlets(const glm::vec3 &cameraPosition, const glm::vec4 planes[6], vector<MeshletVisibility> &visible) const;
+
+    // upload the lighting baked for an object into the vertices of each mesh (see LightBaker), unless the lighting
+    // with this id is the last one uploaded. The model is shared by the objects of its file, each one with its own
+    void setBakedLighting(unsigned int id, const vector<vector<BakedLighting>> &lighting);
 
     // calculate the bounding box of the model
     void calcBoundingBox();
@@ -55,11 +166,54 @@ public:
     float biggestDimensionSize();
     int getNumberOfTexturesLoaded();
 
+    // check if any of the meshes uses a texture of this type (texture_diffuse, texture_specular...)
+    bool hasTextureType(const string &type);
+
+    // true if the meshes use the compressed vertex layout
+    bool hasCompressedVertices();
+
+    // true if the ambient occlusion of the vertices was baked
+    bool hasAmbientOcclusion();
+
+    // true if the textures were packed in texture arrays
+    bool hasTextureArrays();
+
 private:
     /*  Functions   */
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path);
 
+    // print the memory and the error of the compressed meshes
+    void printCompressionReport(string const &path);
+
+    // print the post-transform cache statistics of the meshes before and after the import optimization
+    void printVertexCacheReport(string const &path);
+
+    // print the triangles and the error of each level of detail
+    void printLodReport(string const &path);
+
+    // bake the ambient occlusion of the vertices of all the meshes, so the parts of the model occlude each other
+    void bakeAmbientOcclusion();
+
+    // upload the textures loaded in texture arrays instead of one texture each, and give the meshes their layers
+    void packTextureArrays();
+
+    // print the vertices removed by the welding and the times of the import
+    void printImportReport(string const &path, double milliseconds);
+
+    // print the draw calls of the model and the memory of the geometry arena
+    void printDrawReport(string const &path);
+
+    // group the meshes that can be drawn together: the same page of the arena and the same decoding,
+    // and also the same textures for the lit passes
+    void buildDrawBatches();
+
+    // draw the meshes of a batch with one call, the vertex array of their page is bound
+    void drawBatch(const vector<unsigned int> &batch, unsigned int lod, const vector<MeshletVisibility> *visible);
+
+    // print the number and the size of the meshlets
+    void printMeshletReport(string const &path);
+
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
     void processNode(aiNode *node, const aiScene *scene);
 
@@ -69,6 +223,26 @@ private:
     // the required info is returned as a Texture struct.
     vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName);
 
+    ImportStatistics importStatistics;
+
+    // post-transform cache behavior of all the meshes, as they were in the file and as they are drawn
+    meshoptimizer::VertexCacheStatistics importedCacheStatistics;
+    meshoptimizer::VertexCacheStatistics optimizedCacheStatistics;
+
+    // texture arrays the textures were packed in
+    unsigned int numberOfTextureArrays;
+
+    // id of the baked lighting in the streams of the meshes, 0 when none was uploaded
+    unsigned int bakedLightingId;
+
+    // the meshes drawn together in the lit passes and in the depth passes
+    vector<vector<unsigned int>> drawBatches;
+    vector<vector<unsigned int>> depthBatches;
+    // arguments of the glMultiDrawElementsBaseVertex call of a batch
+    vector<GLsizei> batchCounts;
+    vector<const void*> batchOffsets;
+    vector<GLint> batchBaseVertices;
+
     // finds the lowest and highest vertices of the model on the X axis
     Dimension xLimits();
     
@@ -0,0 +1,118 @@
+#ifndef PATHTRACER_HPP
+#define PATHTRACER_HPP
+
+#include <bvh.hpp>
+#include <graphicslib.hpp>
+#include <textureimage.hpp>
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+//side of the square tiles of the image, each one is traced by a thread at a time
+#define PATH_TRACER_TILE_SIZE 16
+//bounces after the first hit, and the bounce from which the paths can end at random
+#define PATH_TRACER_MAX_BOUNCES 8
+#define PATH_TRACER_ROULETTE_BOUNCE 2
+//samples per pixel of a converged image, and of each pass of the progressive output
+#define PATH_TRACER_SAMPLES 256
+#define PATH_TRACER_PASS_SAMPLES 8
+
+class Camera;
+class Mesh;
+class ThreadPool;
+
+// Offline reference renderer: traces paths from the camera of the scene through the triangles of the models,
+// in the world coordinates of the window. The surfaces are the materials of multipleLights.fs without its
+// ambient term: the diffuse and specular terms of the point lights reach a point unless a triangle is in
+// between (shadow rays), and the light bounced by the other surfaces is gathered by sampling the cosine
+// weighted hemisphere, with KD times the diffuse color as albedo. So the images match the ones of the window but for
+// the shadows and the indirect light.
+// The samples are added in passes over the tiles of the image, which the threads of the pool take one at a time,
+// and each pixel draws its random numbers from its own sequence, so the image doesn't depend on the threads.
+class PathTracer
+{
+public:
+    // an image of width x height pixels, the loops run in the threads of pool
+    PathTracer(int width, int height, ThreadPool &pool);
+    PathTracer(int width, int height);
+
+    // take the triangles of the objects (see graphicslib::readScene) to the world and build their BVH, the
+    // camera is the one the window starts with. The samples of the image are cleared
+    void setScene(SceneObjects &objects, const graphicslib::LightingInformation &lightingInformation, Camera &camera);
+
+    // the meshes of a scene built directly in the world, with their world to clip matrix and position of the eye
+    void setScene(const std::vector<const Mesh*> &meshes, const std::vector<glm::mat4> &modelMatrices,
+                  const std::vector<std::string> &directories, const graphicslib::LightingInformation &lightingInformation,
+                  const glm::mat4 &viewProjection, const glm::vec3 &viewPosition);
+
+    // trace samplesPerPixel more paths through every pixel
+    void addSamples(int samplesPerPixel);
+
+    // forget the samples of the image
+    void clear();
+
+    // write the average of the samples to a binary PPM file, returns false if the file can't be written
+    bool writeImage(const std::string &path) const;
+
+    // average color of a pixel, (0, 0) is the bottom left corner as in OpenGL
+    glm::vec3 pixel(int x, int y) const;
+
+    int getWidth() const;
+    int getHeight() const;
+
+    // samples per pixel of the image so far
+    int samples() const;
+
+    // rays traced by the last addSamples, the shadow rays included
+    size_t raysTraced() const;
+
+    // milliseconds taken by the last BVH build
+    double buildMilliseconds() const;
+
+    const Bvh& getBvh() const;
+
+private:
+    // the material of a mesh of the scene
+    struct Material
+    {
+        // NULL when the mesh doesn't have the texture
+        const TextureImage *diffuse;
+        const TextureImage *specular;
+    };
+
+    int width, height;
+    int tilesX, tilesY;
+    ThreadPool &pool;
+
+    // all the vertices of the scene in the world, the 3 indices of each triangle and its material
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> triangleMaterials;
+    std::vector<Material> materials;
+    Bvh bvh;
+    TextureCache textures;
+    // rays leave the surfaces this far from them, so they don't hit the triangle they start from
+    float rayOffset;
+
+    graphicslib::LightingInformation lighting;
+    glm::mat4 inverseViewProjection;
+    glm::vec3 viewPosition;
+
+    // sum of the samples of each pixel, from the bottom row
+    std::vector<glm::vec3> accumulated;
+    int sampleCount;
+    size_t rays;
+    double buildTime;
+
+    // color seen by a path that starts at origin in direction, rayCount counts the rays it traces
+    glm::vec3 tracePath(glm::vec3 origin, glm::vec3 direction, unsigned int &randomState, size_t &rayCount) const;
+
+    // add the samples of a pass to a tile
+    void traceTile(int tile, int firstSample, int samplesPerPixel, size_t &rayCount);
+};
+
+#endif
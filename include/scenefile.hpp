@@ -0,0 +1,100 @@
+#ifndef SCENEFILE_HPP
+#define SCENEFILE_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// The scene description file (scene.txt), one entry per line:
+//   object <path of the model> <X Y Z of the center of the object>
+//   light <position (x,y,z)> <color (r,g,b)> <attenuation (linear, constant, quadratic)>
+//   camera <position (x,y,z)> <look at point (x,y,z)> <view up vector>
+// and the lines that start with another word (the comments) are skipped.
+// The file is mapped in memory and its numbers are read in place with std::from_chars, without copying the lines,
+// and each path is kept once however many objects use it, so generated scenes with hundreds of thousands of
+// entries are read in milliseconds. diff finds what changed between two versions of the file, so a running
+// application only loads the objects and the lights that changed (see SceneWatcher).
+namespace scenefile {
+    struct SceneObject{
+        // index of the path of its model in Scene::paths
+        unsigned int path;
+        glm::vec3 position;
+    };
+
+    struct SceneLight{
+        glm::vec3 position;
+        glm::vec3 color;
+        float linear;
+        float constant;
+        float quadratic;
+
+        bool operator==(const SceneLight &other) const;
+    };
+
+    struct Scene{
+        // the different paths of the models, in the order they first appear
+        std::vector<std::string> paths;
+        std::vector<SceneObject> objects;
+        std::vector<SceneLight> lights;
+        // the last camera of the file, if it has one
+        bool hasCamera = false;
+        glm::vec3 cameraPosition;
+        glm::vec3 cameraLookAt;
+        glm::vec3 cameraUp;
+    };
+
+    // what changed from a scene to the next one
+    struct SceneDiff{
+        // for each object of the next scene, the object of the previous one with the same model it takes the place
+        // of (-1 when it's new, so its model has to be loaded)
+        std::vector<int> previousObjects;
+        // objects of the next scene at a new position, and the ones added, in their order
+        std::vector<unsigned int> movedObjects;
+        std::vector<unsigned int> addedObjects;
+        // objects of the previous scene that aren't in the next one, in their order
+        std::vector<unsigned int> removedObjects;
+        // lights of the next scene that are new or different from the light at the same line before
+        std::vector<unsigned int> changedLights;
+        // lights left out at the end of the previous scene
+        size_t removedLights;
+        bool cameraChanged;
+
+        // true if the scenes are the same
+        bool empty() const;
+    };
+
+    // read the entries of a scene from the text between begin and end. Returns the number of object, light and
+    // camera lines that couldn't be read (they're left out)
+    size_t parse(const char *begin, const char *end, Scene &scene);
+
+    // map a scene file in memory and parse it. Returns false if it can't be read
+    bool read(const std::string &path, Scene &scene);
+
+    // the objects are matched by their model and their position: the ones that are in both scenes are kept,
+    // the ones left of a model are moved to the positions left of that model, and the rest are added or removed.
+    // The lights are matched by their line
+    SceneDiff diff(const Scene &previous, const Scene &next);
+}
+
+// Tells when a file was written, for the reloads of the scene while the application runs. Linux only: it's
+// notified by inotify of the writes to the directory of the file (the editors that save to a new file and rename
+// it over the old one included), and it's never changed elsewhere
+class SceneWatcher
+{
+public:
+    SceneWatcher(const std::string &path);
+
+    ~SceneWatcher();
+
+    // true if the file was written since the last call, it never waits
+    bool changed();
+
+private:
+    std::string fileName;
+    // the inotify instance, -1 when the file can't be watched
+    int notifier;
+};
+
+#endif
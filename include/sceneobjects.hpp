@@ -0,0 +1,129 @@
+#ifndef SCENEOBJECTS_HPP
+#define SCENEOBJECTS_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//objects the batch systems process at once (the width of the SSE registers), the arrays are padded to it
+#define OBJECT_BATCH 4
+//objects per job of the transform update
+#define OBJECT_TRANSFORM_GRAIN 4096
+
+class ThreadPool;
+
+namespace graphicslib {
+    struct ModelInformation;
+}
+
+// the handle of an object of SceneObjects: the slot it was given and the generation of the slot, which changes
+// when its object is removed, so the handle of a removed object never refers to the object that takes the slot
+struct ObjectHandle
+{
+    std::uint32_t slot;
+    std::uint32_t generation;
+
+    bool operator==(const ObjectHandle &other) const;
+    bool operator!=(const ObjectHandle &other) const;
+};
+
+// The objects of the scene, stored as structures of arrays: the models they draw, each coordinate of their
+// transforms, their world matrices and their bounding spheres in arrays of their own, dense (the last object
+// takes the place of a removed one) and padded to OBJECT_BATCH. The systems go through the arrays linearly,
+// OBJECT_BATCH objects at once: updateTransforms computes the world matrices and the bounding spheres of all the
+// objects after their transforms changed, and cull finds the objects in the view frustum.
+// An object is referred to by its index while no object is removed, and by its handle across removals.
+class SceneObjects
+{
+public:
+    // the transform of an object, applied to its model in this order: the offset (the model centered at the
+    // origin), the scale, the rotations around Z, Y and X (radians), and the translation to the position
+    struct Transform
+    {
+        glm::vec3 offset;
+        glm::vec3 scale;
+        glm::vec3 rotation;
+        glm::vec3 position;
+    };
+
+    // the arrays of the components, the positions, the scales and the offsets can be written in place (the
+    // rotations are written by setTransform, which keeps their sines and cosines)
+    enum Component
+    {
+        OFFSET_X, OFFSET_Y, OFFSET_Z,
+        SCALE_X, SCALE_Y, SCALE_Z,
+        ROTATION_X, ROTATION_Y, ROTATION_Z,
+        SINE_X, SINE_Y, SINE_Z,
+        COSINE_X, COSINE_Y, COSINE_Z,
+        POSITION_X, POSITION_Y, POSITION_Z,
+        // the bounding sphere of the model, in its coordinates
+        MODEL_CENTER_X, MODEL_CENTER_Y, MODEL_CENTER_Z, MODEL_RADIUS,
+        // the bounding sphere of the object, in the world (see updateTransforms)
+        CENTER_X, CENTER_Y, CENTER_Z, RADIUS,
+        NUMBER_OF_COMPONENTS
+    };
+
+    // add an object with its model and its transform, its world matrix is computed by the next updateTransforms
+    ObjectHandle add(const graphicslib::ModelInformation &modelInfo, const Transform &transform);
+
+    // remove an object, the last one takes its index. Its model is deleted when no other object draws it
+    void remove(ObjectHandle handle);
+
+    // remove all the objects, the handles given before are invalid
+    void clear();
+
+    // true if the object of the handle wasn't removed
+    bool contains(ObjectHandle handle) const;
+
+    size_t size() const;
+    bool empty() const;
+
+    // the index of an object in the arrays, and the handle of the object at an index
+    unsigned int index(ObjectHandle handle) const;
+    ObjectHandle handle(unsigned int index) const;
+
+    // the model the object draws, with its shaders and its material
+    graphicslib::ModelInformation& model(unsigned int index);
+    const graphicslib::ModelInformation& model(unsigned int index) const;
+
+    Transform transform(unsigned int index) const;
+    void setTransform(unsigned int index, const Transform &transform);
+
+    // the array of a component, size() objects and the padding
+    float* component(Component component);
+    const float* component(Component component) const;
+
+    // the world matrix of the object after the last updateTransforms, as OpenGL takes it
+    const glm::mat4& worldMatrix(unsigned int index) const;
+
+    // compute the world matrices and the bounding spheres in the world from the transforms, by the threads of a
+    // pool (the global one by default)
+    void updateTransforms();
+    void updateTransforms(ThreadPool &pool);
+
+    // the indices of the objects whose bounding spheres (of the last updateTransforms) are in the view frustum of
+    // viewProjection, in their order
+    void cull(const glm::mat4 &viewProjection, std::vector<unsigned int> &visible) const;
+
+private:
+    std::vector<graphicslib::ModelInformation> models;
+    std::vector<float> components[NUMBER_OF_COMPONENTS];
+    std::vector<glm::mat4> worldMatrices;
+
+    // the slot of each object, and the index of the object and the generation of each slot
+    std::vector<std::uint32_t> objectSlots;
+    std::vector<std::uint32_t> slotIndices;
+    std::vector<std::uint32_t> slotGenerations;
+    // the slots of the removed objects, given to the next objects added
+    std::vector<std::uint32_t> freeSlots;
+
+    // resize the arrays for a number of objects, padded to OBJECT_BATCH
+    void resize(size_t numberOfObjects);
+
+    // world matrices and bounding spheres of the objects in [first, last), first a multiple of OBJECT_BATCH
+    void updateTransformRange(size_t first, size_t last);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef SCENESNAPSHOT_HPP
+#define SCENESNAPSHOT_HPP
+
+#include <graphicslib.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//first bytes and version of the snapshots, a snapshot of another version is written again
+#define SCENE_SNAPSHOT_MAGIC 0x504e5353u
+#define SCENE_SNAPSHOT_VERSION 2u
+//default snapshot of the scene file, written after the file is read when SceneSnapshot::writeAfterLoad is set
+#define SCENE_SNAPSHOT_FILE "cache/scene.snapshot"
+
+namespace scenefile {
+    struct Scene;
+}
+
+// A scene file with what readScene resolves from it, in a binary file that is mapped in memory at once: the paths
+// of the models, the transforms of the objects, the point lights with their radii and the camera. The models are
+// still loaded for each object (from their files and their caches), the snapshot only saves the read of the text.
+// It's tied to the scene file and to the files of its models by their sizes and modification times, so a
+// snapshot of files that changed since it was written isn't opened. The records are the structs of this build,
+// their sizes are in the header.
+class SceneSnapshot
+{
+public:
+    // a model of the scene
+    struct ModelRecord
+    {
+        // the path in the characters after the records
+        std::uint64_t pathOffset;
+        std::uint64_t fileSize;
+        std::int64_t fileTime;
+        std::uint32_t pathLength;
+    };
+
+    // an object of the scene, with its SceneObjects::Transform
+    struct ObjectRecord
+    {
+        std::uint32_t model;
+        float offset[3];
+        float rotation[3];
+        float scale[3];
+        float position[3];
+    };
+
+    // the files of the snapshots are read from the mapping instead of the scene file
+    static bool enabled;
+
+    // write the snapshot of the scene file after it's read
+    static bool writeAfterLoad;
+
+    // the snapshot readScene opens and writes, SCENE_SNAPSHOT_FILE by default
+    static std::string file;
+
+    // write the snapshot of a scene read from sourcePath, with the models and the lights readScene made of it.
+    // Returns false if the file can't be written
+    static bool write(const std::string &path, const std::string &sourcePath, const scenefile::Scene &scene,
+                      const graphicslib::LightingInformation &lightingInformation, const SceneObjects &objects);
+
+    SceneSnapshot();
+
+    // unmap the file
+    ~SceneSnapshot();
+
+    SceneSnapshot(const SceneSnapshot&) = delete;
+    SceneSnapshot& operator=(const SceneSnapshot&) = delete;
+
+    // map a snapshot of sourcePath. Returns false if it can't be read, it's of another version or another build,
+    // or the scene file or its models changed after it was written
+    bool open(const std::string &path, const std::string &sourcePath);
+
+    // the records, in the mapping
+    size_t numberOfModels() const;
+    const ModelRecord& model(size_t index) const;
+    std::string_view modelPath(size_t index) const;
+    size_t numberOfObjects() const;
+    const ObjectRecord* objects() const;
+    size_t numberOfLights() const;
+    const graphicslib::PointLight* lights() const;
+
+    // the description of the scene file it was written from, for its reloads
+    void scene(scenefile::Scene &scene) const;
+
+private:
+    struct Header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        // sizes of the records of the build that wrote it
+        std::uint32_t modelRecordSize;
+        std::uint32_t objectRecordSize;
+        std::uint32_t lightRecordSize;
+        std::uint32_t hasCamera;
+        std::uint64_t sourceSize;
+        std::int64_t sourceTime;
+        std::uint64_t numberOfModels;
+        std::uint64_t numberOfObjects;
+        std::uint64_t numberOfLights;
+        // position, look at point and view up vector
+        float camera[9];
+        // the models, the objects, the lights and the characters of the paths follow the header in this order
+        std::uint64_t pathBytes;
+    };
+
+    const unsigned char *data;
+    size_t size;
+    const Header *header;
+
+    void close();
+};
+
+#endif
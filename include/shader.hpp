@@ -5,15 +5,33 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly.
+    // defines are injected after the #version line ("NAME" or "NAME VALUE")
+    // and #include "file" directives are resolved relative to the including file
+    // (keep them out of #if blocks, or the #line directives that follow them are skipped)
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath);
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string> &defines = std::vector<std::string>());
+
+    // read a shader source file, inject the defines and resolve its includes
+    // ------------------------------------------------------------------------
+    static std::string preprocess(const std::string &path, const std::vector<std::string> &defines);
+
+    // directory where the linked programs are saved (glGetProgramBinary) to skip the compilation
+    // in the next runs, empty disables the cache. The default is "cache/shaders"
+    // ------------------------------------------------------------------------
+    static std::string binaryCacheDirectory;
+
+    // true if this program was loaded from the binary cache instead of compiled
+    bool loadedFromCache;
 
     // activate the shader
     // ------------------------------------------------------------------------
@@ -39,6 +57,8 @@ public:
     void setMat2(const std::string &name, const glm::mat2 &mat) const;
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const;
+
+    void setMat3(const std::string &name, float** mat) const;
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
 
@@ -48,6 +68,46 @@ private:
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type);
+
+    // append the file to output, expanding its includes recursively.
+    // each file gets a source string number in #line directives, its path is kept in files
+    // ------------------------------------------------------------------------
+    static bool appendSource(const std::string &path, std::string &output, std::vector<std::string> &files,
+                             const std::vector<std::string> &defines, int depth);
+
+    // path of the cached binary of these sources for the current driver, empty if binaries aren't supported.
+    // the name is a hash of the preprocessed sources, the defines and the vendor/renderer/version strings
+    // ------------------------------------------------------------------------
+    static std::string binaryCachePath(const std::string &vertexCode, const std::string &fragmentCode,
+                                       const std::vector<std::string> &defines);
+
+    // create the program from a cached binary, false if there's no binary or the driver rejected it
+    // ------------------------------------------------------------------------
+    bool loadBinary(const std::string &path);
+
+    // save the linked program to the binary cache
+    // ------------------------------------------------------------------------
+    void saveBinary(const std::string &path) const;
+};
+
+// Variants of the shaders (same sources, different defines), compiled the first time
+// they're requested and shared afterwards. The programs are deleted with the cache.
+class ShaderCache
+{
+public:
+    ~ShaderCache();
+
+    // the program of the sources with these defines, compiled if it's the first request
+    Shader* get(const std::string &vertexPath, const std::string &fragmentPath, std::vector<std::string> defines = std::vector<std::string>());
+
+    // number of programs created so far
+    size_t size() const;
+
+    // how many of them came from the binary cache
+    size_t loadedFromCache() const;
+
+private:
+    std::map<std::string, std::unique_ptr<Shader>> variants;
 };
 
 #endif
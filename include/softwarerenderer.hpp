@@ -0,0 +1,189 @@
+#ifndef SOFTWARERENDERER_HPP
+#define SOFTWARERENDERER_HPP
+
+#include <graphicslib.hpp>
+#include <textureimage.hpp>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+#include <string>
+#include <vector>
+
+//side of the square tiles of the screen, the tiles are rasterized in parallel
+#define SOFTWARE_TILE_SIZE 64
+//biggest width and height of the frame, the edge functions fit in 32 bits up to it
+#define SOFTWARE_MAX_SIZE 2048
+//fractional bits of the window coordinates of the vertices
+#define SOFTWARE_SUBPIXEL_BITS 4
+//triangles set up and binned by each job
+#define SOFTWARE_TRIANGLE_GRAIN 2048
+//side in pixels of the squares the lamps are drawn with (gl_PointSize of lamp.vs)
+#define SOFTWARE_LAMP_SIZE 10.f
+
+class Camera;
+class Mesh;
+class ThreadPool;
+
+// Renders the scene on the CPU, without OpenGL, into a color and a depth buffer: the reference of the
+// OpenGL renderer on the machines without a GPU. The pipeline follows the one of Window::run: the vertices are
+// transformed with the same matrices and lit as multipleLights.vs/fs (Phong per pixel or Gouraud per vertex),
+// the triangles are clipped in clip coordinates and rasterized with the fill convention of the GPUs,
+// the depth test is GL_LESS and the lamps are squares of SOFTWARE_LAMP_SIZE pixels.
+// The triangles are set up and binned to the tiles of the screen in parallel, then each tile is rasterized
+// by one thread with the edge functions of 4 pixels at once. The bins keep the order of the draws, so the
+// image doesn't depend on the number of threads.
+class SoftwareRenderer
+{
+public:
+    // a frame of width x height pixels (up to SOFTWARE_MAX_SIZE), the loops run in the threads of pool
+    SoftwareRenderer(int width, int height, ThreadPool &pool);
+    SoftwareRenderer(int width, int height);
+
+    // clear the color and the depth and keep the lights for the draws of the frame.
+    // viewProjection transforms the world to the clip coordinates, the lamps are drawn with it
+    void beginFrame(const graphicslib::LightingInformation &lightingInformation, const glm::mat4 &viewProjection,
+                    const glm::vec3 &viewPosition, graphicslib::ShadingMode shadingMode);
+
+    // queue a level of detail of a mesh: clip transforms its vertices to the clip coordinates and model to the
+    // world. The textures of the mesh are read from directory the first time they're used
+    void draw(const Mesh &mesh, const glm::mat4 &clip, const glm::mat4 &model, const std::string &directory,
+              unsigned int lod = 0);
+
+    // transform, set up, bin and rasterize the draws of the frame, then the lamps
+    void endFrame();
+
+    // a whole frame of the objects of a scene (see graphicslib::readScene) seen from the camera, the meshes
+    // can be loaded with Mesh::uploadToGpu false. The deferred shading is drawn as the Phong shading
+    void render(SceneObjects &objects, const graphicslib::LightingInformation &lightingInformation, Camera &camera,
+                graphicslib::ShadingMode shadingMode);
+
+    // write the color buffer to a binary PPM file, returns false if the file can't be written
+    bool writeImage(const std::string &path) const;
+
+    // color of a pixel, (0, 0) is the bottom left corner as in OpenGL
+    glm::u8vec3 pixel(int x, int y) const;
+
+    int getWidth() const;
+    int getHeight() const;
+
+    // statistics of the last frame: triangles of the draws, triangles left after the clipping, pixels inside
+    // the triangles and pixels that passed the depth test
+    size_t trianglesSubmitted() const;
+    size_t trianglesRasterized() const;
+    size_t fragmentsCovered() const;
+    size_t fragmentsShaded() const;
+
+private:
+    // a mesh queued for the frame
+    struct Draw
+    {
+        const Mesh *mesh;
+        glm::mat4 clip;
+        glm::mat4 model;
+        glm::mat3 normalMatrix;
+        // the indices of the level of detail
+        const unsigned int *indices;
+        unsigned int triangleCount;
+        // where the vertices and the triangles of the mesh start in the frame
+        size_t firstVertex;
+        size_t firstTriangle;
+        // NULL when the mesh doesn't have the texture
+        const TextureImage *diffuse;
+        const TextureImage *specular;
+    };
+
+    // a triangle ready to be rasterized, a part of a triangle of a draw when it was clipped
+    struct RasterTriangle
+    {
+        // window coordinates in fixed point with SOFTWARE_SUBPIXEL_BITS, counterclockwise
+        int x[3], y[3];
+        // pixels covered by its bounding box, inclusive
+        int minX, minY, maxX, maxY;
+        // window depth and 1 / w of the corners
+        float depth[3];
+        float inverseW[3];
+        // vertices of the triangle of the draw, in the frame
+        size_t vertex[3];
+        // the corners as barycentric coordinates of the triangle of the draw, a column per corner
+        // (the identity when it wasn't clipped)
+        glm::mat3 corners;
+        unsigned int draw;
+    };
+
+    // the triangles set up by a job and the ones that touch each tile, in the order of the draws
+    struct TriangleBins
+    {
+        std::vector<RasterTriangle> triangles;
+        std::vector<std::vector<unsigned int>> tiles;
+    };
+
+    // a lamp in window coordinates
+    struct Lamp
+    {
+        float x, y, depth;
+        glm::u8vec3 color;
+    };
+
+    int width, height;
+    // pixels in a row of the buffers, a multiple of 4 so the rows of 4 pixels never cross a tile or a row
+    int stride;
+    int tilesX, tilesY;
+    ThreadPool &pool;
+
+    // rgb color and window depth of the pixels, from the bottom row
+    std::vector<unsigned char> color;
+    std::vector<float> depth;
+
+    // what the draws of the frame are lit with
+    graphicslib::LightingInformation lighting;
+    glm::mat4 viewProjection;
+    glm::vec3 viewPosition;
+    graphicslib::ShadingMode shadingMode;
+
+    std::vector<Draw> draws;
+    std::vector<Lamp> lamps;
+    size_t vertexCount;
+    size_t triangleCount;
+    // images of the textures already read
+    TextureCache textures;
+
+    // the vertices of all the draws after the vertex stage: clip and world positions, world normals, texture
+    // coordinates, ambient occlusion and, with the Gouraud shading, the light that reaches them
+    std::vector<glm::vec4> clipPositions;
+    std::vector<glm::vec3> worldPositions;
+    std::vector<glm::vec3> worldNormals;
+    std::vector<glm::vec2> texCoords;
+    std::vector<float> occlusions;
+    std::vector<glm::vec3> vertexLighting;
+
+    // bins of the triangle jobs, kept between the frames to reuse the memory
+    std::vector<TriangleBins> bins;
+    // fragments of each tile in the last frame
+    std::vector<size_t> tileCovered;
+    std::vector<size_t> tileShaded;
+
+    // transform and light the vertices of the draws
+    void vertexStage();
+
+    // clip and set up the triangles in [first, last) of the frame and put them in the bins of a job
+    void setupTriangles(size_t first, size_t last, TriangleBins &jobBins);
+
+    // set up a triangle in clip coordinates and add it to the bins, corners are its barycentric
+    // coordinates in the triangle of the draw
+    void addTriangle(const glm::vec4 clip[3], const glm::mat3 &corners, const size_t vertex[3], unsigned int draw,
+                     TriangleBins &jobBins);
+
+    // rasterize the triangles and the lamps of a tile
+    void rasterizeTile(int tile);
+
+    // draw the triangle in the pixels of a tile
+    void rasterizeTriangle(const RasterTriangle &triangle, int tileMinX, int tileMinY, int tileMaxX, int tileMaxY,
+                           size_t &covered, size_t &shaded);
+
+    // color of a pixel of a triangle from the barycentric coordinates of its corners on the screen,
+    // and their change to the next pixel on the right and above for the texture derivatives
+    glm::vec3 shade(const RasterTriangle &triangle, const glm::vec3 &screen, const glm::vec3 &dx, const glm::vec3 &dy) const;
+};
+
+#endif
@@ -2,6 +2,8 @@
 #define TESTER_HPP
 
 namespace tester {
+    //number of checks of the tests run so far that failed
+    int failedChecks();
     //do the same operations that are executed in the run function, but without transposition
     void matrixOperationsTest();
     //test translation
@@ -10,6 +12,99 @@ namespace tester {
     void rotationTest();
     //test scale
     void scaleTest();
+    //compare the blocked multiplication with the naive one and with a known product
+    void multiplicationTest();
+    //test the LU and the closed form inverses against known inverses
+    void inverseTest();
+    //test the determinant against known values
+    void determinantTest();
+    //test the linear system solver against a known solution
+    void solveTest();
+    //compare the normal matrix with the transpose of the inverse of the model matrix
+    void normalMatrixTest();
+    //check the light radius against its attenuation
+    void lightRadiusTest();
+    //check that the mesh optimization keeps the triangles and improves the cache use of a shuffled grid
+    void meshOptimizationTest();
+    //check the simplification of a flat grid (keeps its outline) and of a sphere (keeps its shape and winding)
+    void simplificationTest();
+    //check that the welding merges the vertices within the tolerance and keeps the UV seams
+    void weldTest();
+    //check the generated normals of a sphere and of a cube corner, and the tangents of the sphere
+    void tangentSpaceTest();
+    //check that the octahedral encoding of the compressed vertices decodes the axes, both halves and random
+    //directions, and a zero vector to a unit vector
+    void octahedralEncodingTest();
+    //check that the ranges of the geometry arena don't overlap and are merged when they are freed
+    void rangeAllocatorTest();
+    //check that the meshlets keep the triangles within their limits and that the culling doesn't lose a visible one
+    void meshletTest();
+    //check the coverage, the clipping and the depth test of the software rasterizer and that its image doesn't depend
+    //on the number of threads
+    void softwareRasterizerTest();
+    //check the nearest hits and the shadow rays of the BVH against all the triangles
+    void bvhTest();
+    //check the direct light of the path tracer and that its image doesn't depend on the number of threads
+    void pathTracerTest();
+    //check the baked light of a floor against CalcPointLight, its shadow and ambient occlusion, that it doesn't depend
+    //on the number of threads and that it's loaded from the cache
+    void lightBakingTest();
+    //check the ambient occlusion of a floor at the foot of a wall and far from it, that it doesn't depend on the
+    //number of threads and that no rays are traced without samples
+    void ambientOcclusionTest();
+    //check the irradiance and the prefiltered levels of a constant and of a half lit environment, the energy of
+    //the BRDF table, that nothing depends on the number of threads and the cache of the bundled HDR image
+    void environmentLightingTest();
+    //check the error of each block format on smooth images, that the mipmaps of the colors are averaged in linear
+    //space and the normals stay unit length, the sizes of the levels, the KTX file and that the blocks and the
+    //mipmaps don't depend on the number of threads, and the containers found for the images
+    void textureCompressionTest();
+    //check the level the streamer requests for the size of a texture on the screen, the size of an object behind
+    //the camera, and that the read of the coarse levels of a KTX file has the same blocks as the read of the whole
+    //file
+    void textureStreamingTest();
+    //check that the textures packed in the same texture array have the same type, size and format, in the order
+    //they were loaded, and that the arrays are split at the limit of layers
+    void textureArrayTest();
+    //check the entries read from a scene file (the lines that can't be read left out), the objects and the lights
+    //that change between two versions of it, its read from the mapping and that its writes are noticed
+    void sceneFileTest();
+    //check that a scene read from its snapshot has the transforms, the lights and the camera of the scene read from
+    //the text, and that a snapshot cut short or older than its scene file isn't opened
+    void sceneSnapshotTest();
+    //check the world matrices of the scene objects against the matrices of utils, their handles across removals
+    //and the objects the frustum culling keeps
+    void sceneObjectsTest();
+    //time the naive and the blocked multiplication from 4x4 to 1024x1024
+    void multiplicationBenchmark();
+    //ACMR and ATVR of every bundled model before and after the mesh optimization, and its levels of detail
+    void meshOptimizationBenchmark();
+    //vertices and times of the import of every bundled model (its ambient occlusion included), against the post
+    //processing of assimp
+    void importBenchmark();
+    //triangles submitted with the meshlet culling against the ones that can be seen, around every bundled model
+    void meshletBenchmark();
+    //milliseconds per frame and triangles per second of the software renderer drawing the scene, for each shading
+    void softwareRendererBenchmark();
+    //BVH build time and rays per second of the path tracer in the scene, for one thread and the whole pool
+    void pathTracerBenchmark();
+    //bake time and rays per second of the lighting of the scene, with and without the shadows and the ambient occlusion
+    void lightBakingBenchmark();
+    //time of each step of the environment lighting of the bundled HDR image, for one thread and the whole pool,
+    //and of its load from the cache
+    void environmentLightingBenchmark();
+    //memory of the textures of the bundled models as RGBA8 with the mipmaps against their blocks, the time of the
+    //decoding of each image against the read of its KTX file, and the time of its conditioning
+    void textureCompressionBenchmark();
+    //time of the read of a generated scene of 100000 objects and 1000 lights with getline and istringstream against
+    //the mapped file with from_chars, and of the diff that finds an object moved in it
+    void sceneFileBenchmark();
+    //readScene of a generated scene of 200 objects of the bundled models and 1000 lights from the text, against
+    //the read of its snapshot (the models are loaded in both)
+    void sceneSnapshotBenchmark();
+    //500000 moving objects: their model matrices with the matrices of utils, against the transform update of the
+    //scene objects on one thread and on the pool, and the frustum culling
+    void sceneObjectsBenchmark();
 }
 
 #endif
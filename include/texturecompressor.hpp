@@ -0,0 +1,114 @@
+#ifndef TEXTURECOMPRESSOR_HPP
+#define TEXTURECOMPRESSOR_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//rows of 4x4 blocks encoded by a thread at a time
+#define TEXTURE_BLOCK_ROW_GRAIN 4
+//power iterations that find the axis of the colors of a block
+#define TEXTURE_AXIS_ITERATIONS 8
+//version of the conditioning, part of the hash of the files so the textures are conditioned again when it changes
+#define TEXTURE_CONDITIONING_VERSION 1u
+
+class ThreadPool;
+
+// Offline conditioning of the textures of the models: mipmaps filtered with a Lanczos kernel in linear space
+// (the colors are sRGB, so they're decoded before the filter and encoded after it, and the normals are
+// normalized again), every level encoded in 4x4 blocks that the GPU samples as they are, and a KTX 1.1 file
+// with all the levels that is read at once and uploaded with one glCompressedTexImage2D per level.
+// The shaders read the same values they read from the uncompressed textures: the colors stay sRGB encoded in
+// UNORM formats, 1 component images are red only, and the normal maps keep x and y (z = sqrt(1 - x^2 - y^2)).
+namespace texturecompressor {
+    // what the texels of a texture are, which decides its filter and its format
+    enum TextureKind{
+        COLOR_TEXTURE,  // sRGB colors (texture_diffuse)
+        DATA_TEXTURE,   // linear values (texture_specular, texture_height)
+        NORMAL_TEXTURE  // tangent space normals in [0, 1] (texture_normal)
+    };
+
+    // formats of 4x4 blocks
+    enum BlockFormat{
+        BC1_FORMAT, // RGB in 8 bytes
+        BC3_FORMAT, // RGBA in 16 bytes, the alpha as a BC4 block
+        BC4_FORMAT, // red in 8 bytes
+        BC5_FORMAT, // red and green in 16 bytes, two BC4 blocks
+        BC7_FORMAT  // RGBA in 16 bytes, only written in mode 6 (1 subset, 7 bits endpoints, 4 bits indices)
+    };
+
+    // 8 bits RGBA texels, in the rows of the file
+    struct Image{
+        int width, height;
+        std::vector<unsigned char> texels;
+    };
+
+    // a texture as the GPU stores it: the blocks of all the levels in one buffer
+    struct CompressedTexture{
+        struct Level{
+            int width, height;
+            size_t offset;
+            size_t size;
+        };
+
+        BlockFormat format;
+        std::vector<Level> levels;
+        // the levels before it have no blocks in data (they weren't read)
+        int firstLevel = 0;
+        std::vector<unsigned char> data;
+
+        // bytes of the blocks of all the levels
+        size_t bytes() const;
+    };
+
+    // the kind of the textures of a type of Texture (texture_diffuse, texture_normal...)
+    TextureKind kindOf(const std::string &type);
+
+    // format of a texture: BC5 for the normals, BC4 for 1 component images, otherwise BC7 if highQuality,
+    // BC3 with an alpha channel and BC1 without one
+    BlockFormat chooseFormat(TextureKind kind, int components, bool hasAlpha, bool highQuality);
+
+    // bytes of a level of width x height texels
+    size_t levelSize(BlockFormat format, int width, int height);
+
+    // the mipmaps down to 1x1, the first one is the image. Each level is half the previous one (rounded down)
+    std::vector<Image> generateMipmaps(const Image &image, TextureKind kind, ThreadPool &pool);
+
+    // encode an image in blocks, the blocks past the edges repeat the last row and column
+    void encode(const Image &image, BlockFormat format, std::vector<unsigned char> &blocks, ThreadPool &pool);
+
+    // decode the blocks of an image (the BC7 blocks of encode only)
+    Image decode(const unsigned char *blocks, BlockFormat format, int width, int height);
+
+    // build the mipmaps of an image and encode them
+    void compress(const Image &image, TextureKind kind, BlockFormat format, CompressedTexture &texture, ThreadPool &pool);
+
+    // read an image file, build its mipmaps and encode them. highQuality chooses BC7 for the colors.
+    // Returns false if the file can't be read
+    bool compress(const std::string &filename, TextureKind kind, bool highQuality, CompressedTexture &texture,
+                  ThreadPool &pool);
+
+    // write and read a KTX 1.1 file. The read only keeps the levels whose biggest side is at most maxSize (at
+    // least the last one, all of them when it's 0): the header, then all those levels with one call
+    bool writeContainer(const std::string &path, const CompressedTexture &texture);
+    bool readContainer(const std::string &path, CompressedTexture &texture, int maxSize = 0);
+
+    // the file of the conditioned texture of an image in cacheDirectory, under a hash of its path, its size, its
+    // modification time and its kind (the image isn't read). Empty if the image isn't there
+    std::string containerPath(const std::string &filename, TextureKind kind);
+
+    // directory of the conditioned textures
+    extern std::string cacheDirectory;
+
+    // internal format of OpenGL of a block format
+    unsigned int internalFormat(BlockFormat format);
+
+    // true if the current OpenGL context can sample a format
+    bool isSupported(BlockFormat format);
+
+    // create a texture with the levels from firstLevel (the filters and the wrapping of TextureFromFile), returns
+    // 0 if the format isn't supported
+    unsigned int upload(const CompressedTexture &texture);
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef TEXTUREIMAGE_HPP
+#define TEXTUREIMAGE_HPP
+
+#include <glm/glm.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// The 8 bits texels of an image file and its mipmaps, halved with a box filter as glGenerateMipmap does.
+// The renderers that run on the CPU sample them as the shaders sample the textures of Model.
+class TextureImage
+{
+public:
+    // a level of the image, in the rows of the file
+    struct Level
+    {
+        int width, height;
+        std::vector<unsigned char> texels;
+    };
+
+    int components;
+    std::vector<Level> levels;
+
+    // read an image file and build its mipmaps, returns false if it can't be read
+    bool load(const std::string &filename);
+
+    // bilinear filtering with GL_REPEAT of a level
+    glm::vec3 sampleLevel(int level, const glm::vec2 &coordinates) const;
+
+    // vec3(texture(sampler, coordinates)) with GL_LINEAR_MIPMAP_LINEAR, the level of detail comes from the
+    // change of the coordinates to the next pixel on the right (dx) and above (dy)
+    glm::vec3 sample(const glm::vec2 &coordinates, const glm::vec2 &dx, const glm::vec2 &dy) const;
+};
+
+// the images of the textures of the meshes, read the first time they're used
+class TextureCache
+{
+public:
+    // the image of a texture of a mesh loaded from directory (NULL if it can't be read)
+    const TextureImage* get(const std::string &directory, const std::string &path);
+
+private:
+    // by file name, empty when the file couldn't be read
+    std::map<std::string, TextureImage> images;
+};
+
+#endif
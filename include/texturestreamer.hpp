@@ -0,0 +1,150 @@
+#ifndef TEXTURESTREAMER_HPP
+#define TEXTURESTREAMER_HPP
+
+#include <texturecompressor.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//biggest side of the coarse levels loaded with a streamed texture, they stay in the GPU until it's released
+#define TEXTURE_STREAM_RESIDENT_SIZE 64
+//memory of the levels of the streamed textures in the GPU, in MB, unless --texture-budget says otherwise
+#define TEXTURE_STREAM_BUDGET 256
+//bytes of levels uploaded in a frame, the other loaded levels wait for the next frames (a load is never split)
+#define TEXTURE_STREAM_UPLOAD_BYTES (8 << 20)
+
+// Streaming of the levels of the conditioned textures (see texturecompressor): a texture is created with its
+// coarse levels only, and each frame the renderer requests the level it's sampled at from the size of its meshes
+// on the screen. The finer levels are read from the KTX files by a thread of the streamer and uploaded by update,
+// the base level of the texture follows the levels in the GPU, so its id never changes and the meshes keep it.
+// When the levels in the GPU would go past the budget, the finest levels of the textures used least recently are
+// dropped first (the ones used in the frame only drop the levels finer than they need), and a load that still
+// doesn't fit loads coarser levels instead.
+// All the calls are made from the thread of the OpenGL context, only the reads of the files run in the other one.
+class TextureStreamer
+{
+public:
+    // stream the conditioned textures of the models, otherwise they're uploaded with all their levels
+    static bool enabled;
+    // memory of the levels in the GPU of the textures of global(), in bytes
+    static size_t budget;
+
+    // the streamer of the textures of the models, created with budget when first used
+    static TextureStreamer& global();
+
+    TextureStreamer(size_t budgetBytes);
+
+    // stop the thread of the loads, the textures stay
+    ~TextureStreamer();
+
+    // create a texture with the coarse levels of a KTX file, the others are loaded when they're requested.
+    // Returns 0 if the file can't be read or the GPU can't sample its format
+    unsigned int load(const std::string &container);
+
+    // level of a texture of width x height with levels levels that a surface with pixelsPerUv pixels per unit of
+    // the texture coordinates on the screen samples (a texel per pixel)
+    static int requiredLevel(int width, int height, float pixelsPerUv, int levels);
+
+    // a texture is drawn in this frame with pixelsPerUv pixels per unit of its texture coordinates. Textures that
+    // aren't streamed are ignored
+    void request(unsigned int texture, float pixelsPerUv);
+
+    // forget a texture before it's deleted: its levels no longer count for the budget and its loads are dropped.
+    // Textures that aren't streamed are ignored
+    void release(unsigned int texture);
+
+    // after the requests of a frame: upload the levels that were read, keep the levels within the budget and
+    // start the loads of the levels requested
+    void update();
+
+    // wait for the reads of the loads started, update uploads them
+    void finishLoads();
+
+    // bytes of the levels in the GPU of the streamed textures
+    size_t residentBytes() const;
+
+    size_t numberOfTextures() const;
+
+    // first level in the GPU of a streamed texture, -1 if it isn't streamed
+    int residentLevel(unsigned int texture) const;
+
+    // levels uploaded and dropped since the streamer was created
+    size_t levelsUploaded() const;
+    size_t levelsDropped() const;
+
+private:
+    struct StreamedTexture
+    {
+        unsigned int id;
+        std::string path;
+        texturecompressor::BlockFormat format;
+        std::vector<texturecompressor::CompressedTexture::Level> levels;
+        // the coarse levels from this one are never dropped
+        int coarseLevel;
+        // first level in the GPU
+        int residentLevel;
+        // finest level requested in the current frame (coarseLevel without requests)
+        int wantedLevel;
+        // level being loaded, -1 when there is no load
+        int loadingLevel;
+        // finest level that can be requested, the resident level after a load that couldn't be read
+        int finestLevel;
+        // frame of the last request
+        unsigned long long lastUsed;
+    };
+
+    // the levels of a texture read by the thread, from level to its resident level
+    struct Load
+    {
+        size_t texture;
+        int level;
+        std::string path;
+        // biggest side of the level, what readContainer reads from
+        int maxSize;
+        texturecompressor::CompressedTexture data;
+        bool read;
+    };
+
+    size_t budgetBytes;
+    std::vector<StreamedTexture> textures;
+    std::unordered_map<unsigned int, size_t> textureIndices;
+    size_t resident;
+    // bytes of the loads started and not uploaded yet, they count for the budget
+    size_t loading;
+    unsigned long long frame;
+    size_t uploaded;
+    size_t dropped;
+
+    // the loads waiting for the thread, and the ones it read
+    std::thread loader;
+    std::mutex loadMutex;
+    std::condition_variable loadAvailable;
+    std::condition_variable loadsRead;
+    std::deque<Load> pendingLoads;
+    std::deque<Load> readLoads;
+    bool reading;
+    bool stopping;
+
+    // main function of the thread of the loads
+    void loaderLoop();
+
+    // bytes of the levels of a texture from first to last (not included)
+    static size_t levelBytes(const StreamedTexture &texture, int first, int last);
+
+    // upload the levels of a load that was read
+    void uploadLoad(Load &load);
+
+    // drop the levels of a texture finer than level
+    void dropLevels(StreamedTexture &texture, int level);
+
+    // drop levels of the textures used least recently, but not of skipped, until bytes are free in the budget.
+    // Returns false if they can't be freed
+    bool makeRoom(size_t bytes, size_t skipped);
+};
+
+#endif
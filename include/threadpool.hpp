@@ -0,0 +1,60 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that split loops among themselves.
+// The calling thread also works on the loop, so a pool of size 1 runs everything inline.
+class ThreadPool
+{
+public:
+    // create the pool, 0 threads means one per hardware core
+    ThreadPool(unsigned int numberOfThreads = 0);
+
+    // wait the workers and join them
+    ~ThreadPool();
+
+    // number of threads (including the caller) that execute a loop
+    unsigned int size() const;
+
+    // calls body(begin, end) for chunks of at most grain indices until [first, last) is covered.
+    // The chunks are taken on demand, so uneven work is balanced between the threads.
+    // Returns when the whole range was processed. Nested calls run inline on the calling thread.
+    void parallelFor(int first, int last, int grain, const std::function<void(int, int)> &body);
+
+    // pool shared by the whole program
+    static ThreadPool& global();
+
+private:
+    // the loop being executed by the pool
+    struct Job
+    {
+        const std::function<void(int, int)> *body;
+        std::atomic<int> next;
+        int last;
+        int grain;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex jobMutex;
+    std::mutex callerMutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobFinished;
+    Job job;
+    unsigned long long generation;
+    unsigned int busyWorkers;
+    bool stopping;
+
+    // main function of each worker thread
+    void workerLoop();
+
+    // take chunks of the current job until it's over
+    void runChunks();
+};
+
+#endif
@@ -23,6 +23,8 @@ namespace utils{
     //apply scale in the model matrix
     ml::matrix<float> scale(ml::matrix<float> &modelMatrix, float* scale);
     ml::matrix<float> scale(ml::matrix<float> &modelMatrix, ml::matrix<float> &scale);
+    //return the normal matrix (transpose of the inverse of the upper 3x3) of the model matrix
+    ml::matrix<float> normalMatrix(ml::matrix<float> &modelMatrix);
     //return the orthogonal projection's matrix
     ml::matrix<float> orthogonalMatrix(float xw_max, float xw_min, float yw_max, float yw_min, float z_near, float z_far);
     //return the perspective projection's matrix
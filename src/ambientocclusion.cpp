@@ -0,0 +1,109 @@
+#include <ambientocclusion.hpp>
+#include <bvh.hpp>
+#include <mesh.hpp>
+#include <threadpool.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ambientocclusion {
+
+    static const float PI = 3.14159265f;
+
+    //a well mixed 32 bits number from another (the hash of PCG)
+    static unsigned int mixBits(unsigned int value){
+        unsigned int state = value * 747796405u + 2891336453u;
+        unsigned int word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+        return (word >> 22u) ^ word;
+    }
+
+    //next number of a sequence in [0, 1)
+    static float random(unsigned int &state){
+        state = mixBits(state);
+        return (state >> 8) * (1.f / 16777216.f);
+    }
+
+    float visibility(const Bvh &bvh, const glm::vec3 &origin, const glm::vec3 &normal, int samples, float distance,
+                     unsigned int &randomState){
+        if(samples <= 0){
+            return 1.f;
+        }
+        glm::vec3 tangent = glm::normalize(glm::cross(std::abs(normal.x) > 0.5f ? glm::vec3(0.f, 1.f, 0.f) : glm::vec3(1.f, 0.f, 0.f), normal));
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+        int escaped = 0;
+        for(int s = 0; s < samples; s++){
+            //the directions are drawn with the density of the cosine, so each ray has the same weight
+            float angle = 2.f * PI * random(randomState);
+            float radius2 = random(randomState);
+            float radius = std::sqrt(radius2);
+            glm::vec3 direction = tangent * (radius * std::cos(angle)) + bitangent * (radius * std::sin(angle)) +
+                                  normal * std::sqrt(std::max(1.f - radius2, 0.f));
+            if(!bvh.occluded(origin, direction, distance)){
+                escaped++;
+            }
+        }
+        return (float) escaped / samples;
+    }
+
+    unsigned int seed(size_t vertex){
+        return mixBits((unsigned int) vertex * 0x9E3779B9u);
+    }
+
+    size_t bake(const std::vector<const Mesh*> &meshes, int samples, std::vector<std::vector<float>> &occlusion,
+                ThreadPool &pool){
+        //the vertices of all the meshes and their full detail triangles
+        std::vector<glm::vec3> positions, normals;
+        std::vector<unsigned int> indices;
+        for(const Mesh *mesh : meshes){
+            unsigned int firstVertex = positions.size();
+            for(const ::Vertex &vertex : mesh->vertices){
+                positions.push_back(vertex.Position);
+                normals.push_back(glm::length(vertex.Normal) > 0.f ? glm::normalize(vertex.Normal) : glm::vec3(0.f));
+            }
+            const MeshLod &level = mesh->getLod(0);
+            for(unsigned int i = level.indexOffset; i < level.indexOffset + level.indexCount; i++){
+                indices.push_back(firstVertex + mesh->indices[i]);
+            }
+        }
+
+        std::vector<float> visibilities(positions.size(), 1.f);
+        int chunks = (positions.size() + AMBIENT_OCCLUSION_GRAIN - 1) / AMBIENT_OCCLUSION_GRAIN;
+        std::vector<size_t> chunkRays(chunks, 0);
+        if(samples > 0 && !indices.empty()){
+            Bvh bvh;
+            bvh.build(positions, indices, pool);
+            float diagonal = glm::length(bvh.boundsMax() - bvh.boundsMin());
+            //the rays leave the vertices a bit above them, so they don't hit the triangles around them
+            float offset = 1e-4f * diagonal + 1e-6f;
+            float distance = AMBIENT_OCCLUSION_DISTANCE * diagonal;
+            pool.parallelFor(0, chunks, 1, [&](int begin, int end){
+                for(int chunk = begin; chunk < end; chunk++){
+                    size_t last = std::min<size_t>((size_t) (chunk + 1) * AMBIENT_OCCLUSION_GRAIN, positions.size());
+                    for(size_t v = (size_t) chunk * AMBIENT_OCCLUSION_GRAIN; v < last; v++){
+                        //the vertices without a normal don't have a hemisphere
+                        if(normals[v] == glm::vec3(0.f)){
+                            continue;
+                        }
+                        unsigned int randomState = seed(v);
+                        visibilities[v] = visibility(bvh, positions[v] + normals[v] * offset, normals[v], samples,
+                                                     distance, randomState);
+                        chunkRays[chunk] += samples;
+                    }
+                }
+            });
+        }
+
+        occlusion.resize(meshes.size());
+        size_t firstVertex = 0;
+        for(size_t m = 0; m < meshes.size(); m++){
+            size_t count = meshes[m]->vertices.size();
+            occlusion[m].assign(visibilities.begin() + firstVertex, visibilities.begin() + firstVertex + count);
+            firstVertex += count;
+        }
+        size_t rays = 0;
+        for(size_t count : chunkRays){
+            rays += count;
+        }
+        return rays;
+    }
+}
@@ -0,0 +1,481 @@
+#include <bvh.hpp>
+#include <threadpool.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+//the binary tree is at most BVH_MAX_DEPTH levels of splits and 32 of median splits deep, a node of
+//the traversal pushes at most 3 more entries than it pops
+static const int STACK_SIZE = 3 * (BVH_MAX_DEPTH + 32) + 1;
+
+//triangles and bounds of a bin of the centroids
+struct Bin
+{
+    glm::vec3 min, max;
+    unsigned int count;
+};
+
+//the bins of the 3 axes
+struct Bins
+{
+    Bin axis[3][BVH_BINS];
+};
+
+static void clearBins(Bins &bins){
+    for(int a = 0; a < 3; a++){
+        for(int b = 0; b < BVH_BINS; b++){
+            bins.axis[a][b] = Bin{glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX), 0};
+        }
+    }
+}
+
+//half of the surface area of a box
+static float halfArea(const glm::vec3 &min, const glm::vec3 &max){
+    glm::vec3 size = max - min;
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+//bin of a centroid along an axis
+static int binOf(const glm::vec3 &centroid, int axis, const glm::vec3 &centroidMin, const glm::vec3 &scale){
+    return std::min((int) ((centroid[axis] - centroidMin[axis]) * scale[axis]), BVH_BINS - 1);
+}
+
+//the bounds of the triangles and of their centroids
+struct Bounds
+{
+    glm::vec3 min, max, centroidMin, centroidMax;
+};
+
+Bvh::Bvh(){
+    sceneMin = glm::vec3(0.f);
+    sceneMax = glm::vec3(0.f);
+}
+
+void Bvh::build(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices){
+    build(positions, indices, ThreadPool::global());
+}
+
+void Bvh::build(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices,
+                ThreadPool &pool){
+    nodes.clear();
+    triangles.clear();
+    triangleIds.clear();
+    sceneMin = sceneMax = glm::vec3(0.f);
+    unsigned int count = indices.size() / 3;
+    if(count == 0){
+        return;
+    }
+
+    //boxes and centroids of the triangles
+    std::vector<glm::vec3> boxMin(count), boxMax(count), centroids(count);
+    std::vector<unsigned int> order(count);
+    pool.parallelFor(0, count, 4096, [&](int begin, int end){
+        for(int t = begin; t < end; t++){
+            const glm::vec3 &a = positions[indices[3 * t]];
+            const glm::vec3 &b = positions[indices[3 * t + 1]];
+            const glm::vec3 &c = positions[indices[3 * t + 2]];
+            boxMin[t] = glm::min(glm::min(a, b), c);
+            boxMax[t] = glm::max(glm::max(a, b), c);
+            centroids[t] = (boxMin[t] + boxMax[t]) * 0.5f;
+            order[t] = t;
+        }
+    });
+
+    std::vector<BuildNode> buildNodes;
+    buildNodes.reserve(2 * count / BVH_LEAF_TRIANGLES + 1);
+    buildNode(buildNodes, order, boxMin, boxMax, centroids, 0, count, 0, pool);
+    sceneMin = buildNodes[0].min;
+    sceneMax = buildNodes[0].max;
+
+    //the triangles in the order of the leaves
+    triangles.resize(count);
+    triangleIds = order;
+    for(unsigned int i = 0; i < count; i++){
+        unsigned int t = order[i];
+        const glm::vec3 &a = positions[indices[3 * t]];
+        triangles[i] = Triangle{a, positions[indices[3 * t + 1]] - a, positions[indices[3 * t + 2]] - a};
+    }
+
+    nodes.reserve(buildNodes.size() / 2 + 1);
+    collapse(buildNodes, 0);
+}
+
+unsigned int Bvh::buildNode(std::vector<BuildNode> &buildNodes, std::vector<unsigned int> &order,
+                            const std::vector<glm::vec3> &boxMin, const std::vector<glm::vec3> &boxMax,
+                            const std::vector<glm::vec3> &centroids, unsigned int first, unsigned int count,
+                            int depth, ThreadPool &pool){
+    //the big nodes are split in chunks that are bounded and binned by the threads, then merged
+    unsigned int chunks = 1;
+    if(count > BVH_PARALLEL_TRIANGLES){
+        chunks = std::min<unsigned int>(4 * pool.size(), count / (BVH_PARALLEL_TRIANGLES / 4));
+    }
+    unsigned int chunkSize = (count + chunks - 1) / chunks;
+    auto forChunks = [&](const std::function<void(unsigned int, unsigned int, unsigned int)> &body){
+        auto run = [&](int begin, int end){
+            for(int c = begin; c < end; c++){
+                unsigned int start = first + c * chunkSize;
+                body(c, start, std::min(start + chunkSize, first + count));
+            }
+        };
+        if(chunks == 1){
+            run(0, 1);
+        }else{
+            pool.parallelFor(0, chunks, 1, run);
+        }
+    };
+
+    std::vector<Bounds> chunkBounds(chunks);
+    forChunks([&](unsigned int c, unsigned int begin, unsigned int end){
+        Bounds bounds{glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX), glm::vec3(FLT_MAX), glm::vec3(-FLT_MAX)};
+        for(unsigned int i = begin; i < end; i++){
+            unsigned int t = order[i];
+            bounds.min = glm::min(bounds.min, boxMin[t]);
+            bounds.max = glm::max(bounds.max, boxMax[t]);
+            bounds.centroidMin = glm::min(bounds.centroidMin, centroids[t]);
+            bounds.centroidMax = glm::max(bounds.centroidMax, centroids[t]);
+        }
+        chunkBounds[c] = bounds;
+    });
+    Bounds bounds = chunkBounds[0];
+    for(unsigned int c = 1; c < chunks; c++){
+        bounds.min = glm::min(bounds.min, chunkBounds[c].min);
+        bounds.max = glm::max(bounds.max, chunkBounds[c].max);
+        bounds.centroidMin = glm::min(bounds.centroidMin, chunkBounds[c].centroidMin);
+        bounds.centroidMax = glm::max(bounds.centroidMax, chunkBounds[c].centroidMax);
+    }
+
+    unsigned int index = buildNodes.size();
+    buildNodes.push_back(BuildNode{bounds.min, bounds.max, 0, 0, first, count});
+    if(count <= BVH_LEAF_TRIANGLES){
+        return index;
+    }
+
+    glm::vec3 extent = bounds.centroidMax - bounds.centroidMin;
+    int axis = -1;
+    int split = 0;
+    if(depth < BVH_MAX_DEPTH && (extent.x > 0.f || extent.y > 0.f || extent.z > 0.f)){
+        glm::vec3 scale;
+        for(int a = 0; a < 3; a++){
+            scale[a] = extent[a] > 0.f ? BVH_BINS / extent[a] : 0.f;
+        }
+        std::vector<Bins> chunkBins(chunks);
+        forChunks([&](unsigned int c, unsigned int begin, unsigned int end){
+            Bins &bins = chunkBins[c];
+            clearBins(bins);
+            for(unsigned int i = begin; i < end; i++){
+                unsigned int t = order[i];
+                for(int a = 0; a < 3; a++){
+                    Bin &bin = bins.axis[a][binOf(centroids[t], a, bounds.centroidMin, scale)];
+                    bin.min = glm::min(bin.min, boxMin[t]);
+                    bin.max = glm::max(bin.max, boxMax[t]);
+                    bin.count++;
+                }
+            }
+        });
+        Bins &bins = chunkBins[0];
+        for(unsigned int c = 1; c < chunks; c++){
+            for(int a = 0; a < 3; a++){
+                for(int b = 0; b < BVH_BINS; b++){
+                    Bin &bin = bins.axis[a][b];
+                    const Bin &other = chunkBins[c].axis[a][b];
+                    bin.min = glm::min(bin.min, other.min);
+                    bin.max = glm::max(bin.max, other.max);
+                    bin.count += other.count;
+                }
+            }
+        }
+
+        //the split with the least expected cost of the rays that hit the node, against a leaf
+        float bestCost = (float) count;
+        float parentArea = halfArea(bounds.min, bounds.max);
+        for(int a = 0; a < 3; a++){
+            if(extent[a] <= 0.f){
+                continue;
+            }
+            //areas and counts of the bins on the right of each split
+            float rightArea[BVH_BINS];
+            unsigned int rightCount[BVH_BINS];
+            glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+            unsigned int right = 0;
+            for(int b = BVH_BINS - 1; b > 0; b--){
+                const Bin &bin = bins.axis[a][b];
+                min = glm::min(min, bin.min);
+                max = glm::max(max, bin.max);
+                right += bin.count;
+                rightArea[b] = right ? halfArea(min, max) : 0.f;
+                rightCount[b] = right;
+            }
+            min = glm::vec3(FLT_MAX);
+            max = glm::vec3(-FLT_MAX);
+            unsigned int left = 0;
+            for(int b = 1; b < BVH_BINS; b++){
+                const Bin &bin = bins.axis[a][b - 1];
+                min = glm::min(min, bin.min);
+                max = glm::max(max, bin.max);
+                left += bin.count;
+                if(left == 0 || rightCount[b] == 0){
+                    continue;
+                }
+                float cost = BVH_TRAVERSAL_COST + (halfArea(min, max) * left + rightArea[b] * rightCount[b]) / parentArea;
+                if(cost < bestCost){
+                    bestCost = cost;
+                    axis = a;
+                    split = b;
+                }
+            }
+        }
+        if(axis < 0 && count <= BVH_MAX_LEAF_TRIANGLES){
+            return index;
+        }
+        if(axis >= 0){
+            auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](unsigned int t){
+                return binOf(centroids[t], axis, bounds.centroidMin, scale) < split;
+            });
+            unsigned int leftCount = middle - (order.begin() + first);
+            unsigned int left = buildNode(buildNodes, order, boxMin, boxMax, centroids, first, leftCount, depth + 1, pool);
+            unsigned int right = buildNode(buildNodes, order, boxMin, boxMax, centroids, first + leftCount,
+                                           count - leftCount, depth + 1, pool);
+            buildNodes[index].left = left;
+            buildNodes[index].right = right;
+            buildNodes[index].count = 0;
+            return index;
+        }
+    }else if(count <= BVH_MAX_LEAF_TRIANGLES){
+        return index;
+    }
+
+    //too deep, or the centroids are all at the same point, or a leaf would be too big: halve the triangles
+    int longest = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    unsigned int half = count / 2;
+    std::nth_element(order.begin() + first, order.begin() + first + half, order.begin() + first + count,
+                     [&](unsigned int a, unsigned int b){ return centroids[a][longest] < centroids[b][longest]; });
+    unsigned int left = buildNode(buildNodes, order, boxMin, boxMax, centroids, first, half, depth + 1, pool);
+    unsigned int right = buildNode(buildNodes, order, boxMin, boxMax, centroids, first + half, count - half,
+                                   depth + 1, pool);
+    buildNodes[index].left = left;
+    buildNodes[index].right = right;
+    buildNodes[index].count = 0;
+    return index;
+}
+
+int Bvh::collapse(const std::vector<BuildNode> &buildNodes, unsigned int index){
+    int nodeIndex = nodes.size();
+    nodes.push_back(Node());
+
+    //open the inner child with the biggest surface until there are 4 children
+    std::vector<unsigned int> children;
+    const BuildNode &root = buildNodes[index];
+    if(root.count){
+        children.push_back(index);
+    }else{
+        children.push_back(root.left);
+        children.push_back(root.right);
+    }
+    while(children.size() < 4){
+        int biggest = -1;
+        float biggestArea = -1.f;
+        for(unsigned int c = 0; c < children.size(); c++){
+            const BuildNode &child = buildNodes[children[c]];
+            float area = halfArea(child.min, child.max);
+            if(!child.count && area > biggestArea){
+                biggest = c;
+                biggestArea = area;
+            }
+        }
+        if(biggest < 0){
+            break;
+        }
+        const BuildNode &opened = buildNodes[children[biggest]];
+        children[biggest] = opened.left;
+        children.push_back(opened.right);
+    }
+
+    Node node;
+    for(int c = 0; c < 4; c++){
+        //an empty child is an inverted box, that no ray enters
+        glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+        node.child[c] = EMPTY_CHILD;
+        node.count[c] = 0;
+        if(c < (int) children.size()){
+            const BuildNode &child = buildNodes[children[c]];
+            min = child.min;
+            max = child.max;
+            if(child.count){
+                node.child[c] = child.first;
+                node.count[c] = child.count;
+            }else{
+                node.child[c] = collapse(buildNodes, children[c]);
+            }
+        }
+        node.minX[c] = min.x;
+        node.minY[c] = min.y;
+        node.minZ[c] = min.z;
+        node.maxX[c] = max.x;
+        node.maxY[c] = max.y;
+        node.maxZ[c] = max.z;
+    }
+    nodes[nodeIndex] = node;
+    return nodeIndex;
+}
+
+template<bool anyHit>
+bool Bvh::traverse(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, BvhHit &hit) const{
+    if(nodes.empty()){
+        return false;
+    }
+    //a direction parallel to an axis gets a huge inverse instead of an infinite one
+    glm::vec3 inverse;
+    for(int k = 0; k < 3; k++){
+        float d = std::abs(direction[k]) < 1e-20f ? std::copysign(1e-20f, direction[k]) : direction[k];
+        inverse[k] = 1.f / d;
+    }
+    //the near planes of the boxes are the minimums along the positive directions
+    bool negative[3] = {inverse.x < 0.f, inverse.y < 0.f, inverse.z < 0.f};
+
+    struct Entry
+    {
+        int child;
+        unsigned int count;
+        float distance;
+    };
+    Entry stack[STACK_SIZE];
+    int size = 0;
+    stack[size++] = Entry{0, 0, 0.f};
+    float closest = maxDistance;
+    bool found = false;
+
+#ifdef __SSE2__
+    __m128 inverseX = _mm_set1_ps(inverse.x), inverseY = _mm_set1_ps(inverse.y), inverseZ = _mm_set1_ps(inverse.z);
+    __m128 originX = _mm_set1_ps(origin.x * inverse.x), originY = _mm_set1_ps(origin.y * inverse.y);
+    __m128 originZ = _mm_set1_ps(origin.z * inverse.z);
+#endif
+
+    while(size){
+        Entry entry = stack[--size];
+        if(entry.distance > closest){
+            continue;
+        }
+
+        //Möller-Trumbore intersection of the triangles of a leaf
+        if(entry.count){
+            for(unsigned int t = entry.child; t < entry.child + entry.count; t++){
+                const Triangle &triangle = triangles[t];
+                glm::vec3 p = glm::cross(direction, triangle.edge2);
+                float determinant = glm::dot(triangle.edge1, p);
+                if(std::abs(determinant) < 1e-20f){
+                    continue;
+                }
+                float inverseDeterminant = 1.f / determinant;
+                glm::vec3 s = origin - triangle.corner;
+                float u = glm::dot(s, p) * inverseDeterminant;
+                if(u < 0.f || u > 1.f){
+                    continue;
+                }
+                glm::vec3 q = glm::cross(s, triangle.edge1);
+                float v = glm::dot(direction, q) * inverseDeterminant;
+                if(v < 0.f || u + v > 1.f){
+                    continue;
+                }
+                float distance = glm::dot(triangle.edge2, q) * inverseDeterminant;
+                if(distance <= 0.f || distance >= closest){
+                    continue;
+                }
+                closest = distance;
+                hit.triangle = triangleIds[t];
+                hit.u = u;
+                hit.v = v;
+                found = true;
+                if(anyHit){
+                    hit.distance = closest;
+                    return true;
+                }
+            }
+            continue;
+        }
+
+        //the distances where the ray enters the boxes of the 4 children, the ones it misses aren't in the mask
+        const Node &node = nodes[entry.child];
+        float entries[4];
+        int mask;
+#ifdef __SSE2__
+        __m128 nearX = _mm_sub_ps(_mm_mul_ps(_mm_load_ps(negative[0] ? node.maxX : node.minX), inverseX), originX);
+        __m128 nearY = _mm_sub_ps(_mm_mul_ps(_mm_load_ps(negative[1] ? node.maxY : node.minY), inverseY), originY);
+        __m128 nearZ = _mm_sub_ps(_mm_mul_ps(_mm_load_ps(negative[2] ? node.maxZ : node.minZ), inverseZ), originZ);
+        __m128 farX = _mm_sub_ps(_mm_mul_ps(_mm_load_ps(negative[0] ? node.minX : node.maxX), inverseX), originX);
+        __m128 farY = _mm_sub_ps(_mm_mul_ps(_mm_load_ps(negative[1] ? node.minY : node.maxY), inverseY), originY);
+        __m128 farZ = _mm_sub_ps(_mm_mul_ps(_mm_load_ps(negative[2] ? node.minZ : node.maxZ), inverseZ), originZ);
+        __m128 enter = _mm_max_ps(_mm_max_ps(nearX, nearY), _mm_max_ps(nearZ, _mm_setzero_ps()));
+        __m128 exit = _mm_min_ps(_mm_min_ps(farX, farY), _mm_min_ps(farZ, _mm_set1_ps(closest)));
+        mask = _mm_movemask_ps(_mm_cmple_ps(enter, exit));
+        _mm_storeu_ps(entries, enter);
+#else
+        mask = 0;
+        for(int c = 0; c < 4; c++){
+            float nearX = ((negative[0] ? node.maxX[c] : node.minX[c]) - origin.x) * inverse.x;
+            float nearY = ((negative[1] ? node.maxY[c] : node.minY[c]) - origin.y) * inverse.y;
+            float nearZ = ((negative[2] ? node.maxZ[c] : node.minZ[c]) - origin.z) * inverse.z;
+            float farX = ((negative[0] ? node.minX[c] : node.maxX[c]) - origin.x) * inverse.x;
+            float farY = ((negative[1] ? node.minY[c] : node.maxY[c]) - origin.y) * inverse.y;
+            float farZ = ((negative[2] ? node.minZ[c] : node.maxZ[c]) - origin.z) * inverse.z;
+            entries[c] = std::max(std::max(nearX, nearY), std::max(nearZ, 0.f));
+            float exit = std::min(std::min(farX, farY), std::min(farZ, closest));
+            mask |= (entries[c] <= exit) << c;
+        }
+#endif
+
+        //push the children hit from the farthest, so the nearest is visited first
+        Entry hits[4];
+        int hitCount = 0;
+        for(int c = 0; c < 4; c++){
+            if(!(mask & (1 << c))){
+                continue;
+            }
+            Entry child{node.child[c], node.count[c], entries[c]};
+            int position = hitCount++;
+            while(position > 0 && hits[position - 1].distance < child.distance){
+                hits[position] = hits[position - 1];
+                position--;
+            }
+            hits[position] = child;
+        }
+        for(int h = 0; h < hitCount; h++){
+            stack[size++] = hits[h];
+        }
+    }
+
+    if(found){
+        hit.distance = closest;
+    }
+    return found;
+}
+
+bool Bvh::intersect(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, BvhHit &hit) const{
+    return traverse<false>(origin, direction, maxDistance, hit);
+}
+
+bool Bvh::occluded(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance) const{
+    BvhHit hit;
+    return traverse<true>(origin, direction, maxDistance, hit);
+}
+
+glm::vec3 Bvh::boundsMin() const{
+    return sceneMin;
+}
+
+glm::vec3 Bvh::boundsMax() const{
+    return sceneMax;
+}
+
+size_t Bvh::numberOfNodes() const{
+    return nodes.size();
+}
+
+size_t Bvh::numberOfTriangles() const{
+    return triangles.size();
+}
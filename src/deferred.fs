@@ -0,0 +1,39 @@
+#version 330 core
+// lighting pass of the deferred shading: the Phong lighting of pointLight.glsl for each pixel of the G-buffer.
+// Compiled with NUM_POINT_LIGHTS (uniform arrays) or CLUSTERED (the lights of the pixel's cluster)
+
+out vec4 FragColor;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedo;
+uniform sampler2D gSpecular;
+
+#include "pointLight.glsl"
+
+uniform vec3 viewPos;
+uniform mat4 view;
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 albedo = texelFetch(gAlbedo, pixel, 0);
+    // nothing was drawn here, keep the clear color
+    if(albedo.a == 0.0){
+        discard;
+    }
+
+    vec3 pos = texelFetch(gPosition, pixel, 0).xyz;
+    vec4 normalOcclusion = texelFetch(gNormal, pixel, 0);
+    vec3 norm = normalOcclusion.xyz;
+    vec3 specularColor = texelFetch(gSpecular, pixel, 0).rgb;
+    vec3 viewDir = normalize(viewPos - pos);
+
+#ifdef CLUSTERED
+    float viewDepth = -(view * vec4(pos, 1.0)).z;
+    int cluster = ClusterIndex(gl_FragCoord.xy, viewDepth);
+    FragColor = vec4(SumClusterLights(cluster, norm, pos, viewDir, albedo.rgb, specularColor, normalOcclusion.w, objectColor), 1.0);
+#else
+    FragColor = vec4(SumPointLights(norm, pos, viewDir, albedo.rgb, specularColor, normalOcclusion.w, objectColor), 1.0);
+#endif
+}
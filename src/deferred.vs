@@ -0,0 +1,9 @@
+#version 330 core
+// lighting pass of the deferred shading: one triangle that covers the screen, no vertex buffer
+
+void main()
+{
+    // (-1,-1), (3,-1), (-1,3)
+    vec2 position = vec2(float((gl_VertexID & 1) << 2) - 1.0, float((gl_VertexID & 2) << 1) - 1.0);
+    gl_Position = vec4(position, 0.0, 1.0);
+}
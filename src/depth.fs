@@ -0,0 +1,6 @@
+#version 330 core
+// depth only passes: no color output, the fixed function depth write does all the work
+
+void main()
+{
+}
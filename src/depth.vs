@@ -0,0 +1,19 @@
+#version 330 core
+// depth only passes (the depth pre-pass): reads only the positions.
+// The position is computed with the same operations of multipleLights.vs,
+// so the lit pass can test the depth with GL_EQUAL
+
+#include "vertexInput.glsl"
+
+invariant gl_Position;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    vec3 pos = vec3(model * vec4(VertexPosition(), 1.0));
+    vec4 viewPosition = view * vec4(pos, 1.0);
+    gl_Position = projection * viewPosition;
+}
@@ -0,0 +1,625 @@
+#include <environmentlighting.hpp>
+#include <threadpool.hpp>
+
+#include <stb_image.h>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static const float PI = 3.14159265f;
+
+//rows of the faces computed by a thread at a time
+static const int ROW_GRAIN = 4;
+
+//the texels are added and scaled 4 floats at a time
+#ifdef __SSE2__
+typedef __m128 Color;
+
+static inline Color loadColor(const glm::vec4 &texel){
+    return _mm_loadu_ps(&texel.x);
+}
+
+static inline Color addColors(Color a, Color b){
+    return _mm_add_ps(a, b);
+}
+
+static inline Color scaleColor(Color color, float weight){
+    return _mm_mul_ps(color, _mm_set1_ps(weight));
+}
+
+static inline Color zeroColor(){
+    return _mm_setzero_ps();
+}
+
+static inline glm::vec4 storeColor(Color color){
+    glm::vec4 texel;
+    _mm_storeu_ps(&texel.x, color);
+    return texel;
+}
+#else
+typedef glm::vec4 Color;
+
+static inline Color loadColor(const glm::vec4 &texel){
+    return texel;
+}
+
+static inline Color addColors(Color a, Color b){
+    return a + b;
+}
+
+static inline Color scaleColor(Color color, float weight){
+    return color * weight;
+}
+
+static inline Color zeroColor(){
+    return glm::vec4(0.f);
+}
+
+static inline glm::vec4 storeColor(Color color){
+    return color;
+}
+#endif
+
+std::string EnvironmentLighting::cacheDirectory = "cache/ibl";
+
+void CubeMap::resize(int faceSize){
+    size = faceSize;
+    texels.assign(6 * (size_t) size * size, glm::vec4(0.f, 0.f, 0.f, 1.f));
+}
+
+glm::vec4& CubeMap::texel(int face, int x, int y){
+    return texels[((size_t) face * size + y) * size + x];
+}
+
+const glm::vec4& CubeMap::texel(int face, int x, int y) const{
+    return texels[((size_t) face * size + y) * size + x];
+}
+
+glm::vec3 CubeMap::direction(int face, float x, float y) const{
+    //the face coordinates of the table of the cube maps in the OpenGL specification
+    float sc = 2.f * x / size - 1.f;
+    float tc = 2.f * y / size - 1.f;
+    switch(face){
+        case 0: return glm::vec3(1.f, -tc, -sc);
+        case 1: return glm::vec3(-1.f, -tc, sc);
+        case 2: return glm::vec3(sc, 1.f, tc);
+        case 3: return glm::vec3(sc, -1.f, -tc);
+        case 4: return glm::vec3(sc, -tc, 1.f);
+        default: return glm::vec3(-sc, -tc, -1.f);
+    }
+}
+
+//bilinear filtering of a cube map as CubeMap::sample
+static Color sampleCube(const CubeMap &cube, const glm::vec3 &direction){
+    glm::vec3 absolute = glm::abs(direction);
+    int face;
+    float sc, tc, major;
+    if(absolute.x >= absolute.y && absolute.x >= absolute.z){
+        face = direction.x > 0.f ? 0 : 1;
+        sc = direction.x > 0.f ? -direction.z : direction.z;
+        tc = -direction.y;
+        major = absolute.x;
+    }else if(absolute.y >= absolute.z){
+        face = direction.y > 0.f ? 2 : 3;
+        sc = direction.x;
+        tc = direction.y > 0.f ? direction.z : -direction.z;
+        major = absolute.y;
+    }else{
+        face = direction.z > 0.f ? 4 : 5;
+        sc = direction.z > 0.f ? direction.x : -direction.x;
+        tc = -direction.y;
+        major = absolute.z;
+    }
+    float x = std::min(std::max((sc / major + 1.f) * 0.5f * cube.size - 0.5f, 0.f), cube.size - 1.f);
+    float y = std::min(std::max((tc / major + 1.f) * 0.5f * cube.size - 0.5f, 0.f), cube.size - 1.f);
+    int x0 = (int) x, y0 = (int) y;
+    int x1 = std::min(x0 + 1, cube.size - 1), y1 = std::min(y0 + 1, cube.size - 1);
+    float ax = x - x0, ay = y - y0;
+    Color bottom = addColors(scaleColor(loadColor(cube.texel(face, x0, y0)), (1.f - ax) * (1.f - ay)),
+                             scaleColor(loadColor(cube.texel(face, x1, y0)), ax * (1.f - ay)));
+    Color top = addColors(scaleColor(loadColor(cube.texel(face, x0, y1)), (1.f - ax) * ay),
+                          scaleColor(loadColor(cube.texel(face, x1, y1)), ax * ay));
+    return addColors(bottom, top);
+}
+
+glm::vec3 CubeMap::sample(const glm::vec3 &direction) const{
+    return glm::vec3(storeColor(sampleCube(*this, direction)));
+}
+
+//trilinear filtering of the mipmaps of a cube map, the level of detail is clamped to the levels
+static Color sampleLevels(const std::vector<CubeMap> &levels, const glm::vec3 &direction, float lod){
+    lod = std::min(std::max(lod, 0.f), levels.size() - 1.f);
+    int level = (int) lod;
+    float fraction = lod - level;
+    Color color = sampleCube(levels[level], direction);
+    if(fraction > 0.f){
+        color = addColors(scaleColor(color, 1.f - fraction), scaleColor(sampleCube(levels[level + 1], direction), fraction));
+    }
+    return color;
+}
+
+//the 9 spherical harmonics of the bands 0, 1 and 2 for a direction
+static void shBasis(const glm::vec3 &n, float basis[9]){
+    basis[0] = 0.282095f;
+    basis[1] = 0.488603f * n.y;
+    basis[2] = 0.488603f * n.z;
+    basis[3] = 0.488603f * n.x;
+    basis[4] = 1.092548f * n.x * n.y;
+    basis[5] = 1.092548f * n.y * n.z;
+    basis[6] = 0.315392f * (3.f * n.z * n.z - 1.f);
+    basis[7] = 1.092548f * n.x * n.z;
+    basis[8] = 0.546274f * (n.x * n.x - n.y * n.y);
+}
+
+//a point of the Hammersley set of count points in [0, 1)^2
+static glm::vec2 hammersley(unsigned int i, unsigned int count){
+    unsigned int bits = i;
+    bits = (bits << 16u) | (bits >> 16u);
+    bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+    bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+    bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+    bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+    return glm::vec2((float) i / count, bits * 2.3283064365386963e-10f);
+}
+
+//half vector drawn with the density of the GGX distribution around the z axis
+static glm::vec3 sampleGgx(const glm::vec2 &point, float roughness){
+    float a = roughness * roughness;
+    float phi = 2.f * PI * point.x;
+    float cosTheta = std::sqrt((1.f - point.y) / (1.f + (a * a - 1.f) * point.y));
+    float sinTheta = std::sqrt(std::max(1.f - cosTheta * cosTheta, 0.f));
+    return glm::vec3(std::cos(phi) * sinTheta, std::sin(phi) * sinTheta, cosTheta);
+}
+
+static float distributionGgx(float normalDotHalf, float roughness){
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float denominator = normalDotHalf * normalDotHalf * (a2 - 1.f) + 1.f;
+    return a2 / (PI * denominator * denominator);
+}
+
+//Smith's geometry term with the k of the image based lighting
+static float geometrySmith(float normalDotView, float normalDotLight, float roughness){
+    float k = roughness * roughness / 2.f;
+    return normalDotView / (normalDotView * (1.f - k) + k) * normalDotLight / (normalDotLight * (1.f - k) + k);
+}
+
+EnvironmentLighting::EnvironmentLighting(ThreadPool &pool) : pool(pool){
+    for(glm::vec3 &coefficient : coefficients){
+        coefficient = glm::vec3(0.f);
+    }
+    times = Timings{0.0, 0.0, 0.0, 0.0, 0.0};
+    fromCache = false;
+}
+
+EnvironmentLighting::EnvironmentLighting() : EnvironmentLighting(ThreadPool::global()){
+}
+
+bool EnvironmentLighting::load(const std::string &path){
+    auto start = std::chrono::steady_clock::now();
+    times = Timings{0.0, 0.0, 0.0, 0.0, 0.0};
+    fromCache = false;
+    std::string cache = cachePath(path);
+    if(!cache.empty() && loadCache(cache)){
+        fromCache = true;
+        times.total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    int width, height, components;
+    float *image = stbi_loadf(path.c_str(), &width, &height, &components, 3);
+    if(!image){
+        std::cerr << "ERROR::ENVIRONMENT::IMAGE_NOT_READ " << path << std::endl;
+        return false;
+    }
+    equirectangularToCube(image, width, height);
+    stbi_image_free(image);
+    times.cube = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    computeLighting();
+
+    if(!cache.empty()){
+        saveCache(cache);
+    }
+    times.total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+void EnvironmentLighting::compute(const CubeMap &environment){
+    auto start = std::chrono::steady_clock::now();
+    times = Timings{0.0, 0.0, 0.0, 0.0, 0.0};
+    fromCache = false;
+    environmentLevels.assign(1, environment);
+    computeLighting();
+    times.total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void EnvironmentLighting::computeLighting(){
+    auto start = std::chrono::steady_clock::now();
+    buildEnvironmentLevels();
+    auto irradianceStart = std::chrono::steady_clock::now();
+    times.cube += std::chrono::duration<double, std::milli>(irradianceStart - start).count();
+    projectIrradiance();
+    auto prefilterStart = std::chrono::steady_clock::now();
+    times.irradiance = std::chrono::duration<double, std::milli>(prefilterStart - irradianceStart).count();
+    prefilter();
+    auto brdfStart = std::chrono::steady_clock::now();
+    times.prefilter = std::chrono::duration<double, std::milli>(brdfStart - prefilterStart).count();
+    integrateBrdf();
+    times.brdf = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - brdfStart).count();
+}
+
+void EnvironmentLighting::equirectangularToCube(const float *image, int width, int height){
+    environmentLevels.assign(1, CubeMap());
+    CubeMap &cube = environmentLevels[0];
+    cube.resize(ENVIRONMENT_CUBE_SIZE);
+    auto pixel = [&](int x, int y){
+        const float *rgb = image + 3 * ((size_t) y * width + x);
+#ifdef __SSE2__
+        return _mm_set_ps(1.f, rgb[2], rgb[1], rgb[0]);
+#else
+        return glm::vec4(rgb[0], rgb[1], rgb[2], 1.f);
+#endif
+    };
+    pool.parallelFor(0, 6 * cube.size, ROW_GRAIN, [&](int begin, int end){
+        for(int row = begin; row < end; row++){
+            int face = row / cube.size, y = row % cube.size;
+            for(int x = 0; x < cube.size; x++){
+                glm::vec3 direction = glm::normalize(cube.direction(face, x + 0.5f, y + 0.5f));
+                //longitude around y from the first column, latitude from the top row
+                float u = std::atan2(direction.z, direction.x) / (2.f * PI) + 0.5f;
+                float v = std::acos(std::min(std::max(direction.y, -1.f), 1.f)) / PI;
+                float px = u * width - 0.5f;
+                float py = std::min(std::max(v * height - 0.5f, 0.f), height - 1.f);
+                int x0 = (int) std::floor(px), y0 = (int) py;
+                float ax = px - x0, ay = py - y0;
+                //the longitude wraps around
+                x0 = (x0 % width + width) % width;
+                int x1 = (x0 + 1) % width, y1 = std::min(y0 + 1, height - 1);
+                Color top = addColors(scaleColor(pixel(x0, y0), (1.f - ax) * (1.f - ay)), scaleColor(pixel(x1, y0), ax * (1.f - ay)));
+                Color bottom = addColors(scaleColor(pixel(x0, y1), (1.f - ax) * ay), scaleColor(pixel(x1, y1), ax * ay));
+                cube.texel(face, x, y) = storeColor(addColors(top, bottom));
+            }
+        }
+    });
+}
+
+void EnvironmentLighting::buildEnvironmentLevels(){
+    environmentLevels.resize(1);
+    while(environmentLevels.back().size > 1){
+        CubeMap level;
+        level.resize(environmentLevels.back().size / 2);
+        const CubeMap &previous = environmentLevels.back();
+        pool.parallelFor(0, 6 * level.size, ROW_GRAIN, [&](int begin, int end){
+            for(int row = begin; row < end; row++){
+                int face = row / level.size, y = row % level.size;
+                for(int x = 0; x < level.size; x++){
+                    Color sum = addColors(addColors(loadColor(previous.texel(face, 2 * x, 2 * y)),
+                                                    loadColor(previous.texel(face, 2 * x + 1, 2 * y))),
+                                          addColors(loadColor(previous.texel(face, 2 * x, 2 * y + 1)),
+                                                    loadColor(previous.texel(face, 2 * x + 1, 2 * y + 1))));
+                    level.texel(face, x, y) = storeColor(scaleColor(sum, 0.25f));
+                }
+            }
+        });
+        environmentLevels.push_back(std::move(level));
+    }
+}
+
+void EnvironmentLighting::projectIrradiance(){
+    const CubeMap &cube = environmentLevels[0];
+    //the sums of each row, added in order after the loop so they don't depend on the threads
+    int rows = 6 * cube.size;
+    std::vector<glm::vec4> rowSums(9 * (size_t) rows);
+    std::vector<double> rowWeights(rows);
+    pool.parallelFor(0, rows, ROW_GRAIN, [&](int begin, int end){
+        for(int row = begin; row < end; row++){
+            int face = row / cube.size, y = row % cube.size;
+            Color sums[9];
+            for(Color &sum : sums){
+                sum = zeroColor();
+            }
+            double rowWeight = 0.0;
+            for(int x = 0; x < cube.size; x++){
+                glm::vec3 direction = cube.direction(face, x + 0.5f, y + 0.5f);
+                //solid angle of the texel, up to a constant factor
+                float distance2 = glm::dot(direction, direction);
+                float weight = 1.f / (distance2 * std::sqrt(distance2));
+                float basis[9];
+                shBasis(direction / std::sqrt(distance2), basis);
+                Color color = loadColor(cube.texel(face, x, y));
+                for(int k = 0; k < 9; k++){
+                    sums[k] = addColors(sums[k], scaleColor(color, basis[k] * weight));
+                }
+                rowWeight += weight;
+            }
+            for(int k = 0; k < 9; k++){
+                rowSums[9 * (size_t) row + k] = storeColor(sums[k]);
+            }
+            rowWeights[row] = rowWeight;
+        }
+    });
+
+    glm::dvec3 sums[9];
+    for(glm::dvec3 &sum : sums){
+        sum = glm::dvec3(0.0);
+    }
+    double totalWeight = 0.0;
+    for(int row = 0; row < rows; row++){
+        for(int k = 0; k < 9; k++){
+            sums[k] += glm::dvec3(rowSums[9 * (size_t) row + k]);
+        }
+        totalWeight += rowWeights[row];
+    }
+    //the weights add up to the whole sphere, and the convolution with the cosine divided by pi scales each band
+    const double bandScale[9] = {1.0, 2.0 / 3.0, 2.0 / 3.0, 2.0 / 3.0, 0.25, 0.25, 0.25, 0.25, 0.25};
+    for(int k = 0; k < 9; k++){
+        coefficients[k] = glm::vec3(sums[k] * (4.0 * PI / totalWeight * bandScale[k]));
+    }
+
+    irradianceCube.resize(ENVIRONMENT_IRRADIANCE_SIZE);
+    pool.parallelFor(0, 6 * irradianceCube.size, ROW_GRAIN, [&](int begin, int end){
+        for(int row = begin; row < end; row++){
+            int face = row / irradianceCube.size, y = row % irradianceCube.size;
+            for(int x = 0; x < irradianceCube.size; x++){
+                glm::vec3 normal = glm::normalize(irradianceCube.direction(face, x + 0.5f, y + 0.5f));
+                irradianceCube.texel(face, x, y) = glm::vec4(irradiance(normal), 1.f);
+            }
+        }
+    });
+}
+
+void EnvironmentLighting::prefilter(){
+    int environmentSize = environmentLevels[0].size;
+    //solid angle of a texel of the environment
+    float texelSolidAngle = 4.f * PI / (6.f * environmentSize * environmentSize);
+    prefiltered.assign(ENVIRONMENT_PREFILTER_LEVELS, CubeMap());
+    for(int l = 0; l < ENVIRONMENT_PREFILTER_LEVELS; l++){
+        CubeMap &level = prefiltered[l];
+        level.resize(std::max(ENVIRONMENT_PREFILTER_SIZE >> l, 1));
+        float roughness = ENVIRONMENT_PREFILTER_LEVELS > 1 ? (float) l / (ENVIRONMENT_PREFILTER_LEVELS - 1) : 0.f;
+        //the level of the environment with the size of this one
+        float baseLod = std::max(std::log2((float) environmentSize / level.size), 0.f);
+
+        //the view is the normal, so the samples are the same around every normal: the directions of the light
+        //in the space of the normal (z), their weight n.l and the level of the environment that averages the
+        //solid angle of each one (filtered importance sampling)
+        std::vector<glm::vec3> directions;
+        std::vector<float> weights, lods;
+        for(unsigned int i = 0; roughness > 0.f && i < ENVIRONMENT_PREFILTER_SAMPLES; i++){
+            glm::vec3 half = sampleGgx(hammersley(i, ENVIRONMENT_PREFILTER_SAMPLES), roughness);
+            glm::vec3 light = 2.f * half.z * half - glm::vec3(0.f, 0.f, 1.f);
+            if(light.z <= 0.f){
+                continue;
+            }
+            float pdf = distributionGgx(half.z, roughness) / 4.f;
+            float sampleSolidAngle = 1.f / (ENVIRONMENT_PREFILTER_SAMPLES * pdf + 1e-4f);
+            directions.push_back(light);
+            weights.push_back(light.z);
+            lods.push_back(std::max(0.5f * std::log2(sampleSolidAngle / texelSolidAngle), baseLod));
+        }
+
+        pool.parallelFor(0, 6 * level.size, ROW_GRAIN, [&](int begin, int end){
+            for(int row = begin; row < end; row++){
+                int face = row / level.size, y = row % level.size;
+                for(int x = 0; x < level.size; x++){
+                    glm::vec3 normal = glm::normalize(level.direction(face, x + 0.5f, y + 0.5f));
+                    if(directions.empty()){
+                        level.texel(face, x, y) = storeColor(sampleLevels(environmentLevels, normal, baseLod));
+                        continue;
+                    }
+                    glm::vec3 tangent = glm::normalize(glm::cross(std::abs(normal.z) < 0.999f ? glm::vec3(0.f, 0.f, 1.f) : glm::vec3(1.f, 0.f, 0.f), normal));
+                    glm::vec3 bitangent = glm::cross(normal, tangent);
+                    Color sum = zeroColor();
+                    float weightSum = 0.f;
+                    for(size_t s = 0; s < directions.size(); s++){
+                        glm::vec3 light = tangent * directions[s].x + bitangent * directions[s].y + normal * directions[s].z;
+                        sum = addColors(sum, scaleColor(sampleLevels(environmentLevels, light, lods[s]), weights[s]));
+                        weightSum += weights[s];
+                    }
+                    level.texel(face, x, y) = storeColor(scaleColor(sum, 1.f / weightSum));
+                }
+            }
+        });
+    }
+}
+
+void EnvironmentLighting::integrateBrdf(){
+    brdfTexels.assign((size_t) ENVIRONMENT_BRDF_SIZE * ENVIRONMENT_BRDF_SIZE, glm::vec2(0.f));
+    pool.parallelFor(0, ENVIRONMENT_BRDF_SIZE, 1, [&](int begin, int end){
+        for(int y = begin; y < end; y++){
+            float roughness = (y + 0.5f) / ENVIRONMENT_BRDF_SIZE;
+            for(int x = 0; x < ENVIRONMENT_BRDF_SIZE; x++){
+                float normalDotView = (x + 0.5f) / ENVIRONMENT_BRDF_SIZE;
+                glm::vec3 view(std::sqrt(1.f - normalDotView * normalDotView), 0.f, normalDotView);
+                float scale = 0.f, bias = 0.f;
+                for(unsigned int i = 0; i < ENVIRONMENT_BRDF_SAMPLES; i++){
+                    glm::vec3 half = sampleGgx(hammersley(i, ENVIRONMENT_BRDF_SAMPLES), roughness);
+                    float viewDotHalf = glm::dot(view, half);
+                    glm::vec3 light = 2.f * viewDotHalf * half - view;
+                    if(light.z <= 0.f || viewDotHalf <= 0.f){
+                        continue;
+                    }
+                    float visibility = geometrySmith(normalDotView, light.z, roughness) * viewDotHalf / (half.z * normalDotView);
+                    float fresnel = std::pow(1.f - viewDotHalf, 5.f);
+                    scale += (1.f - fresnel) * visibility;
+                    bias += fresnel * visibility;
+                }
+                brdfTexels[(size_t) y * ENVIRONMENT_BRDF_SIZE + x] = glm::vec2(scale, bias) / (float) ENVIRONMENT_BRDF_SAMPLES;
+            }
+        }
+    });
+}
+
+const CubeMap& EnvironmentLighting::environment() const{
+    return environmentLevels[0];
+}
+
+const CubeMap& EnvironmentLighting::irradianceMap() const{
+    return irradianceCube;
+}
+
+const std::vector<CubeMap>& EnvironmentLighting::prefilteredLevels() const{
+    return prefiltered;
+}
+
+const std::vector<glm::vec2>& EnvironmentLighting::brdfTable() const{
+    return brdfTexels;
+}
+
+glm::vec3 EnvironmentLighting::irradiance(const glm::vec3 &normal) const{
+    float basis[9];
+    shBasis(normal, basis);
+    glm::vec3 result(0.f);
+    for(int k = 0; k < 9; k++){
+        result += coefficients[k] * basis[k];
+    }
+    //the harmonics ring around strong lights
+    return glm::max(result, glm::vec3(0.f));
+}
+
+const glm::vec3* EnvironmentLighting::irradianceCoefficients() const{
+    return coefficients;
+}
+
+glm::vec2 EnvironmentLighting::brdf(float normalDotView, float roughness) const{
+    int x = std::min(std::max((int) (normalDotView * ENVIRONMENT_BRDF_SIZE), 0), ENVIRONMENT_BRDF_SIZE - 1);
+    int y = std::min(std::max((int) (roughness * ENVIRONMENT_BRDF_SIZE), 0), ENVIRONMENT_BRDF_SIZE - 1);
+    return brdfTexels[(size_t) y * ENVIRONMENT_BRDF_SIZE + x];
+}
+
+const EnvironmentLighting::Timings& EnvironmentLighting::timings() const{
+    return times;
+}
+
+bool EnvironmentLighting::loadedFromCache() const{
+    return fromCache;
+}
+
+std::string EnvironmentLighting::cachePath(const std::string &path) const{
+    if(cacheDirectory.empty()){
+        return "";
+    }
+    std::ifstream image(path, std::ios::binary);
+    if(!image.is_open()){
+        return "";
+    }
+
+    //FNV-1a of the image and of the settings
+    unsigned long long hash = 14695981039346656037ULL;
+    auto add = [&hash](const void *data, size_t size){
+        const unsigned char *bytes = (const unsigned char*) data;
+        for(size_t i = 0; i < size; i++){
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    unsigned int settings[] = {ENVIRONMENT_VERSION, ENVIRONMENT_CUBE_SIZE, ENVIRONMENT_IRRADIANCE_SIZE,
+                               ENVIRONMENT_PREFILTER_SIZE, ENVIRONMENT_PREFILTER_LEVELS, ENVIRONMENT_PREFILTER_SAMPLES,
+                               ENVIRONMENT_BRDF_SIZE, ENVIRONMENT_BRDF_SAMPLES};
+    add(settings, sizeof(settings));
+    std::vector<char> bytes((std::istreambuf_iterator<char>(image)), std::istreambuf_iterator<char>());
+    add(bytes.data(), bytes.size());
+
+    std::ostringstream cache;
+    cache << cacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return cache.str();
+}
+
+//the texels of a cube map in half floats, as an RGBA16F texture
+static void writeCube(std::ofstream &file, const CubeMap &cube){
+    std::vector<glm::uint64> packed(cube.texels.size());
+    for(size_t t = 0; t < cube.texels.size(); t++){
+        packed[t] = glm::packHalf4x16(cube.texels[t]);
+    }
+    file.write((const char*) packed.data(), packed.size() * sizeof(glm::uint64));
+}
+
+static bool readCube(std::ifstream &file, CubeMap &cube, int size){
+    cube.resize(size);
+    std::vector<glm::uint64> packed(cube.texels.size());
+    file.read((char*) packed.data(), packed.size() * sizeof(glm::uint64));
+    for(size_t t = 0; t < cube.texels.size(); t++){
+        cube.texels[t] = glm::unpackHalf4x16(packed[t]);
+    }
+    return (bool) file;
+}
+
+bool EnvironmentLighting::loadCache(const std::string &path){
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open()){
+        return false;
+    }
+
+    //header: magic, version and the sizes, then the harmonics, the cube maps and the BRDF table
+    unsigned int header[7];
+    file.read((char*) header, sizeof(header));
+    if(!file || header[0] != ENVIRONMENT_MAGIC || header[1] != ENVIRONMENT_VERSION || header[2] != ENVIRONMENT_CUBE_SIZE ||
+       header[3] != ENVIRONMENT_IRRADIANCE_SIZE || header[4] != ENVIRONMENT_PREFILTER_SIZE ||
+       header[5] != ENVIRONMENT_PREFILTER_LEVELS || header[6] != ENVIRONMENT_BRDF_SIZE){
+        return false;
+    }
+    glm::vec3 loadedCoefficients[9];
+    file.read((char*) loadedCoefficients, sizeof(loadedCoefficients));
+    std::vector<CubeMap> loadedEnvironment(1), loadedPrefiltered(ENVIRONMENT_PREFILTER_LEVELS);
+    CubeMap loadedIrradiance;
+    if(!file || !readCube(file, loadedEnvironment[0], ENVIRONMENT_CUBE_SIZE) ||
+       !readCube(file, loadedIrradiance, ENVIRONMENT_IRRADIANCE_SIZE)){
+        return false;
+    }
+    for(int l = 0; l < ENVIRONMENT_PREFILTER_LEVELS; l++){
+        if(!readCube(file, loadedPrefiltered[l], std::max(ENVIRONMENT_PREFILTER_SIZE >> l, 1))){
+            return false;
+        }
+    }
+    std::vector<unsigned int> packedBrdf((size_t) ENVIRONMENT_BRDF_SIZE * ENVIRONMENT_BRDF_SIZE);
+    file.read((char*) packedBrdf.data(), packedBrdf.size() * sizeof(unsigned int));
+    if(!file){
+        return false;
+    }
+
+    environmentLevels = std::move(loadedEnvironment);
+    std::copy(loadedCoefficients, loadedCoefficients + 9, coefficients);
+    irradianceCube = std::move(loadedIrradiance);
+    prefiltered = std::move(loadedPrefiltered);
+    brdfTexels.resize(packedBrdf.size());
+    for(size_t t = 0; t < packedBrdf.size(); t++){
+        brdfTexels[t] = glm::unpackHalf2x16(packedBrdf[t]);
+    }
+    return true;
+}
+
+void EnvironmentLighting::saveCache(const std::string &path) const{
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    std::ofstream file(path, std::ios::binary);
+    if(!file.is_open()){
+        std::cerr << "ERROR::ENVIRONMENT::CACHE_NOT_WRITABLE " << path << std::endl;
+        return;
+    }
+    unsigned int header[7] = {ENVIRONMENT_MAGIC, ENVIRONMENT_VERSION, ENVIRONMENT_CUBE_SIZE, ENVIRONMENT_IRRADIANCE_SIZE,
+                              ENVIRONMENT_PREFILTER_SIZE, ENVIRONMENT_PREFILTER_LEVELS, ENVIRONMENT_BRDF_SIZE};
+    file.write((const char*) header, sizeof(header));
+    file.write((const char*) coefficients, sizeof(coefficients));
+    writeCube(file, environmentLevels[0]);
+    writeCube(file, irradianceCube);
+    for(const CubeMap &level : prefiltered){
+        writeCube(file, level);
+    }
+    std::vector<unsigned int> packedBrdf(brdfTexels.size());
+    for(size_t t = 0; t < brdfTexels.size(); t++){
+        packedBrdf[t] = glm::packHalf2x16(brdfTexels[t]);
+    }
+    file.write((const char*) packedBrdf.data(), packedBrdf.size() * sizeof(unsigned int));
+}
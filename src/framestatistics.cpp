@@ -0,0 +1,95 @@
+#include <framestatistics.hpp>
+
+#include <cstring>
+#include <iostream>
+
+// core in OpenGL 4.6, GL_ARB_pipeline_statistics_query before
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS
+#define GL_FRAGMENT_SHADER_INVOCATIONS 0x82F4
+#endif
+
+FrameStatistics::FrameStatistics(){
+    glGenQueries(1, &timeQuery);
+    glGenQueries(1, &invocationsQuery);
+    glGenQueries(1, &shadedQuery);
+    shadedQueryUsed = false;
+
+    invocationsSupported = GLAD_GL_VERSION_4_6;
+    GLint numberOfExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numberOfExtensions);
+    for(GLint i = 0; i < numberOfExtensions && !invocationsSupported; i++){
+        const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+        invocationsSupported = extension && strcmp(extension, "GL_ARB_pipeline_statistics_query") == 0;
+    }
+
+    frames = 0;
+    frameTimeSum = 0.0;
+    gpuTimeSum = 0.0;
+    invocationsSum = 0;
+    shadedSum = 0;
+    lastPrint = 0.f;
+}
+
+FrameStatistics::~FrameStatistics(){
+    glDeleteQueries(1, &shadedQuery);
+    glDeleteQueries(1, &invocationsQuery);
+    glDeleteQueries(1, &timeQuery);
+}
+
+void FrameStatistics::beginFrame(){
+    glBeginQuery(GL_TIME_ELAPSED, timeQuery);
+    if(invocationsSupported){
+        glBeginQuery(GL_FRAGMENT_SHADER_INVOCATIONS, invocationsQuery);
+    }
+}
+
+void FrameStatistics::beginShadedPass(){
+    glBeginQuery(GL_SAMPLES_PASSED, shadedQuery);
+}
+
+void FrameStatistics::endShadedPass(){
+    glEndQuery(GL_SAMPLES_PASSED);
+    shadedQueryUsed = true;
+}
+
+void FrameStatistics::endFrame(float currentTime, float frameTime, const std::string &label){
+    glEndQuery(GL_TIME_ELAPSED);
+    if(invocationsSupported){
+        glEndQuery(GL_FRAGMENT_SHADER_INVOCATIONS);
+    }
+
+    GLuint64 gpuTime = 0;
+    glGetQueryObjectui64v(timeQuery, GL_QUERY_RESULT, &gpuTime);
+    GLuint64 invocations = 0;
+    if(invocationsSupported){
+        glGetQueryObjectui64v(invocationsQuery, GL_QUERY_RESULT, &invocations);
+    }
+    GLuint64 shaded = 0;
+    if(shadedQueryUsed){
+        glGetQueryObjectui64v(shadedQuery, GL_QUERY_RESULT, &shaded);
+        shadedQueryUsed = false;
+    }
+
+    frames++;
+    frameTimeSum += frameTime;
+    gpuTimeSum += gpuTime * 1e-9;
+    invocationsSum += invocations;
+    shadedSum += shaded;
+
+    if(currentTime - lastPrint >= 1.f){
+        std::cout << label << ": frame " << frameTimeSum / frames * 1000.0 << " ms, gpu "
+                  << gpuTimeSum / frames * 1000.0 << " ms";
+        if(invocationsSupported){
+            std::cout << ", fragment shader invocations " << invocationsSum / frames;
+        }
+        std::cout << ", shaded fragments " << shadedSum / frames;
+        std::cout << std::endl;
+
+        frames = 0;
+        frameTimeSum = 0.0;
+        gpuTimeSum = 0.0;
+        invocationsSum = 0;
+        shadedSum = 0;
+        lastPrint = currentTime;
+    }
+}
@@ -0,0 +1,120 @@
+#include <gbuffer.hpp>
+#include <shader.hpp>
+
+#include <iostream>
+
+GBuffer::GBuffer(){
+    width = 0;
+    height = 0;
+    blitFailed = false;
+
+    glGenFramebuffers(1, &framebuffer);
+    glGenTextures(1, &position);
+    glGenTextures(1, &normal);
+    glGenTextures(1, &albedo);
+    glGenTextures(1, &specular);
+    glGenRenderbuffers(1, &depth);
+    glGenVertexArrays(1, &fullscreenVAO);
+}
+
+GBuffer::~GBuffer(){
+    glDeleteVertexArrays(1, &fullscreenVAO);
+    glDeleteRenderbuffers(1, &depth);
+    glDeleteTextures(1, &specular);
+    glDeleteTextures(1, &albedo);
+    glDeleteTextures(1, &normal);
+    glDeleteTextures(1, &position);
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GBuffer::allocateTexture(GLuint texture, GLint internalFormat, GLenum type){
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, type, NULL);
+    // the lighting pass reads exact pixels
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void GBuffer::resize(int newWidth, int newHeight){
+    if(newWidth == width && newHeight == height){
+        return;
+    }
+    width = newWidth;
+    height = newHeight;
+
+    // world positions need the full precision, the normals are fine with half floats
+    allocateTexture(position, GL_RGBA32F, GL_FLOAT);
+    allocateTexture(normal, GL_RGBA16F, GL_FLOAT);
+    allocateTexture(albedo, GL_RGBA8, GL_UNSIGNED_BYTE);
+    allocateTexture(specular, GL_RGBA8, GL_UNSIGNED_BYTE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, depth);
+    // the format of the default framebuffer (see the hints of the window), the blit of the depth needs the same
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, position, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, normal, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, albedo, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT3, GL_TEXTURE_2D, specular, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+    GLenum attachments[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 };
+    glDrawBuffers(4, attachments);
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cerr << "ERROR::GBUFFER::FRAMEBUFFER_NOT_COMPLETE" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GBuffer::bindForGeometryPass(){
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+}
+
+void GBuffer::bindForLightingPass(Shader &shader){
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glActiveTexture(GL_TEXTURE0 + POSITION_UNIT);
+    glBindTexture(GL_TEXTURE_2D, position);
+    glActiveTexture(GL_TEXTURE0 + NORMAL_UNIT);
+    glBindTexture(GL_TEXTURE_2D, normal);
+    glActiveTexture(GL_TEXTURE0 + ALBEDO_UNIT);
+    glBindTexture(GL_TEXTURE_2D, albedo);
+    glActiveTexture(GL_TEXTURE0 + SPECULAR_UNIT);
+    glBindTexture(GL_TEXTURE_2D, specular);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.setInt("gPosition", POSITION_UNIT);
+    shader.setInt("gNormal", NORMAL_UNIT);
+    shader.setInt("gAlbedo", ALBEDO_UNIT);
+    shader.setInt("gSpecular", SPECULAR_UNIT);
+}
+
+void GBuffer::copyDepthToDefaultFramebuffer(){
+    // the errors before are not the ones of the blit
+    while(glGetError() != GL_NO_ERROR){
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    // a default framebuffer of another depth format can't be blitted to, the lamps aren't hidden then
+    GLenum error = glGetError();
+    if(error != GL_NO_ERROR && !blitFailed){
+        std::cerr << "ERROR::GBUFFER::DEPTH_NOT_COPIED 0x" << std::hex << error << std::dec << std::endl;
+        blitFailed = true;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GBuffer::drawFullscreenTriangle(){
+    glBindVertexArray(fullscreenVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
@@ -0,0 +1,43 @@
+#version 330 core
+// geometry pass of the deferred shading: writes the surface of the pixel to the G-buffer.
+// Compiled with multipleLights.vs and the same defines (PHONG and the texture ones, TEXTURE_ARRAYS included)
+
+#if defined(HAS_DIFFUSE_TEX) || defined(HAS_SPECULAR_TEX)
+#define HAS_TEX_COORDS
+#endif
+
+layout (location = 0) out vec4 gPosition;
+layout (location = 1) out vec4 gNormal;
+layout (location = 2) out vec4 gAlbedo;
+layout (location = 3) out vec4 gSpecular;
+
+in vec3 FragPos;
+in vec3 Normal;
+in float Occlusion;
+
+#include "materialTextures.glsl"
+
+#include "pointLight.glsl"
+
+void main()
+{
+    gPosition = vec4(FragPos, 1.0);
+    // w is the ambient occlusion
+    gNormal = vec4(normalize(Normal), Occlusion);
+
+    // the same material colors of the forward Phong shading
+#ifdef HAS_DIFFUSE_TEX
+    vec3 diffuseColor = vec3(DiffuseTexel());
+#else
+    vec3 diffuseColor = objectColor;
+#endif
+#ifdef HAS_SPECULAR_TEX
+    vec3 specularColor = vec3(SpecularTexel());
+#else
+    vec3 specularColor = diffuseColor;
+#endif
+
+    // alpha 1 marks the pixel as covered
+    gAlbedo = vec4(diffuseColor, 1.0);
+    gSpecular = vec4(specularColor, 1.0);
+}
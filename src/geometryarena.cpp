@@ -0,0 +1,358 @@
+#include <geometryarena.hpp>
+#include <mesh.hpp>
+
+#include <algorithm>
+#include <cstddef>
+
+RangeAllocator::RangeAllocator(size_t capacity){
+    totalSize = capacity;
+    usedSize = 0;
+    if(capacity){
+        freeRanges[0] = capacity;
+    }
+}
+
+size_t RangeAllocator::allocate(size_t size){
+    if(size == 0){
+        return 0;
+    }
+    for(auto range = freeRanges.begin(); range != freeRanges.end(); range++){
+        if(range->second < size){
+            continue;
+        }
+        size_t offset = range->first;
+        size_t remaining = range->second - size;
+        freeRanges.erase(range);
+        if(remaining){
+            freeRanges[offset + size] = remaining;
+        }
+        usedSize += size;
+        return offset;
+    }
+    return INVALID;
+}
+
+void RangeAllocator::free(size_t offset, size_t size){
+    if(size == 0){
+        return;
+    }
+    usedSize -= size;
+    auto next = freeRanges.lower_bound(offset);
+    //merge with the free range that ends where this one starts
+    if(next != freeRanges.begin()){
+        auto previous = std::prev(next);
+        if(previous->first + previous->second == offset){
+            offset = previous->first;
+            size += previous->second;
+            freeRanges.erase(previous);
+        }
+    }
+    //and with the one that starts where it ends
+    if(next != freeRanges.end() && offset + size == next->first){
+        size += next->second;
+        freeRanges.erase(next);
+    }
+    freeRanges[offset] = size;
+}
+
+size_t RangeAllocator::capacity() const{
+    return totalSize;
+}
+
+size_t RangeAllocator::used() const{
+    return usedSize;
+}
+
+size_t RangeAllocator::largestFreeRange() const{
+    size_t largest = 0;
+    for(const auto &range : freeRanges){
+        largest = std::max(largest, range.second);
+    }
+    return largest;
+}
+
+//bytes of a vertex in the position buffer and in the attribute buffer of a format
+static size_t positionStride(VertexFormat format){
+    switch(format){
+        case SPLIT_VERTICES: return sizeof(glm::vec3);
+        case COMPRESSED_VERTICES: return sizeof(CompressedPosition);
+        default: return sizeof(Vertex);
+    }
+}
+
+static size_t attributeStride(VertexFormat format){
+    switch(format){
+        case SPLIT_VERTICES: return sizeof(VertexAttributes);
+        case COMPRESSED_VERTICES: return sizeof(CompressedAttributes);
+        default: return 0;
+    }
+}
+
+//bytes of a vertex in the buffer of an optional stream
+static size_t streamStride(VertexStream stream){
+    if(stream == BAKED_LIGHTING_STREAM){
+        return sizeof(BakedLighting);
+    }
+    return stream == TEXTURE_LAYER_STREAM ? 2 * sizeof(unsigned short) : sizeof(float);
+}
+
+GeometryArena::GeometryArena(){
+}
+
+GeometryArena::~GeometryArena(){
+    for(Page &page : pages){
+        glDeleteVertexArrays(1, &page.vertexArray);
+        glDeleteVertexArrays(1, &page.depthVertexArray);
+        glDeleteBuffers(1, &page.positionBuffer);
+        if(page.attributeBuffer){
+            glDeleteBuffers(1, &page.attributeBuffer);
+        }
+        for(GLuint buffer : page.streamBuffers){
+            if(buffer){
+                glDeleteBuffers(1, &buffer);
+            }
+        }
+        glDeleteBuffers(1, &page.indexBuffer);
+    }
+}
+
+GeometryArena& GeometryArena::global(){
+    //never destroyed, the context is gone when the program ends
+    static GeometryArena *arena = new GeometryArena();
+    return *arena;
+}
+
+unsigned int GeometryArena::createPage(VertexFormat format, GLenum indexType, size_t vertexCount, size_t indexCount){
+    Page page;
+    page.format = format;
+    page.indexType = indexType;
+    page.vertices = RangeAllocator(std::max<size_t>(vertexCount, ARENA_PAGE_VERTICES));
+    page.indices = RangeAllocator(std::max<size_t>(indexCount, ARENA_PAGE_INDICES));
+
+    glGenBuffers(1, &page.positionBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, page.positionBuffer);
+    glBufferData(GL_ARRAY_BUFFER, page.vertices.capacity() * positionStride(format), NULL, GL_STATIC_DRAW);
+    page.attributeBuffer = 0;
+    for(GLuint &buffer : page.streamBuffers){
+        buffer = 0;
+    }
+    if(attributeStride(format)){
+        glGenBuffers(1, &page.attributeBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, page.attributeBuffer);
+        glBufferData(GL_ARRAY_BUFFER, page.vertices.capacity() * attributeStride(format), NULL, GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenVertexArrays(1, &page.vertexArray);
+    glGenVertexArrays(1, &page.depthVertexArray);
+    glGenBuffers(1, &page.indexBuffer);
+    //the index buffer is bound through the vertex array, so it isn't unbound from the default one
+    glBindVertexArray(page.vertexArray);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, page.indices.capacity() * (indexType == GL_UNSIGNED_SHORT ? 2 : 4), NULL, GL_STATIC_DRAW);
+    setupVertexArrays(page);
+
+    pages.push_back(page);
+    return pages.size() - 1;
+}
+
+void GeometryArena::setupVertexArrays(Page &page){
+    GLsizei stride = positionStride(page.format);
+    glBindVertexArray(page.vertexArray);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.indexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, page.positionBuffer);
+    if(page.format == COMPRESSED_VERTICES){
+        //quantized positions and the handedness, normalized to [0, 1]
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)0);
+
+        glBindBuffer(GL_ARRAY_BUFFER, page.attributeBuffer);
+        GLsizei attributes = sizeof(CompressedAttributes);
+        //octahedral normal in [-1, 1]
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, attributes, (void*)offsetof(CompressedAttributes, Normal));
+        //texture coords, converted from half floats by the vertex fetch
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, attributes, (void*)offsetof(CompressedAttributes, TexCoords));
+        //octahedral tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, attributes, (void*)offsetof(CompressedAttributes, Tangent));
+    }else{
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+
+        //the other attributes follow the position in Vertex, or are in their own buffer
+        GLsizei attributes = stride;
+        size_t base = offsetof(Vertex, Normal);
+        if(page.format == SPLIT_VERTICES){
+            glBindBuffer(GL_ARRAY_BUFFER, page.attributeBuffer);
+            attributes = sizeof(VertexAttributes);
+            base = 0;
+        }
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, attributes, (void*)(base + offsetof(VertexAttributes, Normal)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, attributes, (void*)(base + offsetof(VertexAttributes, TexCoords)));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, attributes, (void*)(base + offsetof(VertexAttributes, Tangent)));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, attributes, (void*)(base + offsetof(VertexAttributes, Bitangent)));
+    }
+
+    //the depth passes only read the positions
+    glBindVertexArray(page.depthVertexArray);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page.indexBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, page.positionBuffer);
+    glEnableVertexAttribArray(0);
+    if(page.format == COMPRESSED_VERTICES){
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)0);
+    }else{
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    }
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GeometryAllocation GeometryArena::allocate(VertexFormat format, GLenum indexType, size_t vertexCount, size_t indexCount){
+    for(unsigned int p = 0; p < pages.size(); p++){
+        Page &page = pages[p];
+        if(page.format != format || page.indexType != indexType){
+            continue;
+        }
+        if(page.vertices.largestFreeRange() < vertexCount || page.indices.largestFreeRange() < indexCount){
+            continue;
+        }
+        size_t baseVertex = page.vertices.allocate(vertexCount);
+        size_t firstIndex = page.indices.allocate(indexCount);
+        return GeometryAllocation{p, (unsigned int) baseVertex, (unsigned int) vertexCount,
+                                  (unsigned int) firstIndex, (unsigned int) indexCount};
+    }
+    unsigned int p = createPage(format, indexType, vertexCount, indexCount);
+    size_t baseVertex = pages[p].vertices.allocate(vertexCount);
+    size_t firstIndex = pages[p].indices.allocate(indexCount);
+    return GeometryAllocation{p, (unsigned int) baseVertex, (unsigned int) vertexCount,
+                              (unsigned int) firstIndex, (unsigned int) indexCount};
+}
+
+void GeometryArena::upload(const GeometryAllocation &allocation, const void *positions, const void *attributes,
+                           const void *indices){
+    const Page &page = pages[allocation.page];
+    size_t stride = positionStride(page.format);
+    if(allocation.vertexCount){
+        glBindBuffer(GL_ARRAY_BUFFER, page.positionBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, allocation.baseVertex * stride, allocation.vertexCount * stride, positions);
+        if(page.attributeBuffer){
+            stride = attributeStride(page.format);
+            glBindBuffer(GL_ARRAY_BUFFER, page.attributeBuffer);
+            glBufferSubData(GL_ARRAY_BUFFER, allocation.baseVertex * stride, allocation.vertexCount * stride, attributes);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    if(allocation.indexCount){
+        size_t size = indexSize(allocation.page);
+        glBindVertexArray(page.vertexArray);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, allocation.firstIndex * size, allocation.indexCount * size, indices);
+        glBindVertexArray(0);
+    }
+}
+
+void GeometryArena::setupStreamAttributes(Page &page, VertexStream stream){
+    GLsizei stride = streamStride(stream);
+    //only the lit passes read them
+    glBindVertexArray(page.vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, page.streamBuffers[stream]);
+    if(stream == BAKED_LIGHTING_STREAM){
+        //the half floats are converted by the vertex fetch
+        glEnableVertexAttribArray(5);
+        glVertexAttribPointer(5, 4, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(BakedLighting, Diffuse));
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(BakedLighting, Specular));
+        glEnableVertexAttribArray(7);
+        glVertexAttribPointer(7, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(BakedLighting, LightDirection));
+    }else if(stream == TEXTURE_LAYER_STREAM){
+        //converted to floats, the shaders use them as the third texture coordinate
+        glEnableVertexAttribArray(9);
+        glVertexAttribPointer(9, 2, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void*)0);
+    }else{
+        glEnableVertexAttribArray(8);
+        glVertexAttribPointer(8, 1, GL_FLOAT, GL_FALSE, stride, (void*)0);
+    }
+    glBindVertexArray(0);
+}
+
+void GeometryArena::uploadStream(const GeometryAllocation &allocation, VertexStream stream, const void *data){
+    if(!allocation.vertexCount){
+        return;
+    }
+    Page &page = pages[allocation.page];
+    size_t stride = streamStride(stream);
+    if(!page.streamBuffers[stream]){
+        glGenBuffers(1, &page.streamBuffers[stream]);
+        glBindBuffer(GL_ARRAY_BUFFER, page.streamBuffers[stream]);
+        glBufferData(GL_ARRAY_BUFFER, page.vertices.capacity() * stride, NULL, GL_STATIC_DRAW);
+        setupStreamAttributes(page, stream);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, page.streamBuffers[stream]);
+    glBufferSubData(GL_ARRAY_BUFFER, allocation.baseVertex * stride, allocation.vertexCount * stride, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryArena::free(const GeometryAllocation &allocation){
+    if(!allocation.vertexCount && !allocation.indexCount){
+        return;
+    }
+    Page &page = pages[allocation.page];
+    page.vertices.free(allocation.baseVertex, allocation.vertexCount);
+    page.indices.free(allocation.firstIndex, allocation.indexCount);
+}
+
+GLuint GeometryArena::vertexArray(unsigned int page) const{
+    return pages[page].vertexArray;
+}
+
+GLuint GeometryArena::depthVertexArray(unsigned int page) const{
+    return pages[page].depthVertexArray;
+}
+
+GLenum GeometryArena::indexType(unsigned int page) const{
+    return pages[page].indexType;
+}
+
+size_t GeometryArena::indexSize(unsigned int page) const{
+    return pages[page].indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+size_t GeometryArena::numberOfPages() const{
+    return pages.size();
+}
+
+size_t GeometryArena::reservedBytes() const{
+    size_t bytes = 0;
+    for(unsigned int p = 0; p < pages.size(); p++){
+        const Page &page = pages[p];
+        bytes += page.vertices.capacity() * (positionStride(page.format) + attributeStride(page.format)) +
+                 page.indices.capacity() * indexSize(p);
+        for(int stream = 0; stream < NUMBER_OF_VERTEX_STREAMS; stream++){
+            if(page.streamBuffers[stream]){
+                bytes += page.vertices.capacity() * streamStride((VertexStream) stream);
+            }
+        }
+    }
+    return bytes;
+}
+
+size_t GeometryArena::usedBytes() const{
+    size_t bytes = 0;
+    for(unsigned int p = 0; p < pages.size(); p++){
+        const Page &page = pages[p];
+        bytes += page.vertices.used() * (positionStride(page.format) + attributeStride(page.format)) +
+                 page.indices.used() * indexSize(p);
+        for(int stream = 0; stream < NUMBER_OF_VERTEX_STREAMS; stream++){
+            if(page.streamBuffers[stream]){
+                bytes += page.vertices.used() * streamStride((VertexStream) stream);
+            }
+        }
+    }
+    return bytes;
+}
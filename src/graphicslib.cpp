@@ -1,7 +1,13 @@
 #include <iostream>
-#include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
 
 #include <graphicslib.hpp>
 #include <utils.hpp>
@@ -9,11 +15,18 @@
 #include <shader.hpp>
 #include <model.hpp>
 #include <camera.hpp>
-
+#include <lightclusters.hpp>
+#include <gbuffer.hpp>
+#include <framestatistics.hpp>
+#include <lightbaker.hpp>
+#include <scenefile.hpp>
+#include <scenesnapshot.hpp>
+#include <texturestreamer.hpp>
+
+#include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 
-#define FILE "scene.txt"
 
 
 namespace graphicslib {
@@ -27,6 +40,263 @@ namespace graphicslib {
     // lighting
     glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
+    //the models loaded by path, an entry expires with the last object that draws its model
+    static std::map<std::string, std::weak_ptr<Model>> loadedModels;
+
+    //the model of a file, loaded unless an object draws it already
+    static std::shared_ptr<Model> sharedModel(const std::string &path){
+        std::weak_ptr<Model> &loaded = loadedModels[path];
+        std::shared_ptr<Model> model = loaded.lock();
+        if(!model){
+            model = std::make_shared<Model>(path);
+            loaded = model;
+        }
+        return model;
+    }
+
+    //load the model of an object of the scene, with its material
+    static ModelInformation loadModelOf(const std::string &path){
+        //create an ModelInformation instance
+        ModelInformation currentModelInfo;
+
+        //the objects of the same file share the model
+        currentModelInfo.model = sharedModel(path);
+        //add a reference to it just to ease the coding
+        Model &model = *(currentModelInfo.model);
+
+
+        // the shaders are selected when first used (they depend on the number of lights)
+        for(int variant = 0; variant < NUMBER_OF_SHADER_VARIANTS; variant++){
+            currentModelInfo.shaders[variant] = NULL;
+        }
+        currentModelInfo.material.hasDiffuseTexture = model.hasTextureType("texture_diffuse");
+        currentModelInfo.material.hasSpecularTexture = model.hasTextureType("texture_specular");
+        currentModelInfo.material.compressedVertices = model.hasCompressedVertices();
+        currentModelInfo.material.bakedLighting = false;
+        currentModelInfo.material.ambientOcclusion = model.hasAmbientOcclusion();
+        currentModelInfo.material.textureArrays = model.hasTextureArrays();
+        currentModelInfo.lod = 0;
+        currentModelInfo.bakedLightingId = 0;
+
+        return currentModelInfo;
+    }
+
+    //load the model of an object of the scene and scale it to the size of the objects, around the origin (the
+    //model computes its bounding box when it's loaded)
+    static ModelInformation loadObject(const std::string &path, SceneObjects::Transform &transform){
+        ModelInformation currentModelInfo = loadModelOf(path);
+        Model &model = *(currentModelInfo.model);
+
+        // size of the biggest dimension of the model
+        float size = model.biggestDimensionSize();
+
+        // initial rotation
+        transform.rotation = glm::vec3(0.f);
+
+        // initial scale
+        transform.scale = glm::vec3(2.f/size);
+
+        // translate object to origin
+        transform.offset = -glm::vec3(model.boundingBox.x.center, model.boundingBox.y.center, model.boundingBox.z.center);
+
+        return currentModelInfo;
+    }
+
+    //the lights, the camera and the objects of a snapshot, with the transforms resolved when it was written
+    static void readSnapshot(const SceneSnapshot &snapshot, LightingInformation &lightingInformation,
+                             SceneObjects &objects, Camera &sceneCamera, scenefile::Scene &scene){
+        snapshot.scene(scene);
+
+        lightingInformation.pointLights.assign(snapshot.lights(), snapshot.lights() + snapshot.numberOfLights());
+        lightingInformation.bufferOfPointLights.resize(snapshot.numberOfLights());
+        for(size_t l = 0; l < snapshot.numberOfLights(); l++){
+            lightingInformation.bufferOfPointLights[l].position = lightingInformation.pointLights[l].position;
+            lightingInformation.bufferOfPointLights[l].color = lightingInformation.pointLights[l].ambient;
+        }
+        lightingInformation.numberOfPointLights = snapshot.numberOfLights();
+
+        if(scene.hasCamera){
+            sceneCamera = Camera(scene.cameraPosition, scene.cameraUp, scene.cameraLookAt);
+        }
+
+        //each model is loaded once, when its first object comes, the transforms are the ones of the snapshot
+        objects.clear();
+        std::vector<ModelInformation> models(snapshot.numberOfModels());
+        for(size_t o = 0; o < snapshot.numberOfObjects(); o++){
+            const SceneSnapshot::ObjectRecord &record = snapshot.objects()[o];
+            SceneObjects::Transform transform;
+            std::memcpy(&transform.offset, record.offset, sizeof(record.offset));
+            std::memcpy(&transform.rotation, record.rotation, sizeof(record.rotation));
+            std::memcpy(&transform.scale, record.scale, sizeof(record.scale));
+            std::memcpy(&transform.position, record.position, sizeof(record.position));
+            if(!models[record.model].model){
+                models[record.model] = loadModelOf(std::string(snapshot.modelPath(record.model)));
+            }
+            objects.add(models[record.model], transform);
+        }
+        objects.updateTransforms();
+    }
+
+    //read the lights, the camera and the models of a scene file, the models are loaded and placed in the scene
+    void readScene(const char* path, LightingInformation &lightingInformation, SceneObjects &objects,
+                   Camera &sceneCamera, scenefile::Scene *description){
+        scenefile::Scene scene;
+        //the snapshot of the file when it's up to date, it has everything resolved
+        SceneSnapshot snapshot;
+        if(SceneSnapshot::enabled && snapshot.open(SceneSnapshot::file, path)){
+            readSnapshot(snapshot, lightingInformation, objects, sceneCamera, scene);
+        }else{
+            //check if an error has ocurred while reading the file
+            if(!scenefile::read(path, scene)){
+                std::cerr << "*** Error while opening file " << path << " ***" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+
+            //everything in the file is new
+            lightingInformation.numberOfPointLights = 0;
+            objects.clear();
+            applySceneChanges(scene, scenefile::diff(scenefile::Scene(), scene), lightingInformation, objects,
+                              sceneCamera);
+            if(SceneSnapshot::writeAfterLoad &&
+               !SceneSnapshot::write(SceneSnapshot::file, path, scene, lightingInformation, objects)){
+                std::cerr << "ERROR::SCENESNAPSHOT::NOT_WRITTEN " << SceneSnapshot::file << std::endl;
+            }
+        }
+        if(description){
+            *description = std::move(scene);
+        }
+    }
+
+    //take the models and the lights of the scene read before to the next one
+    void applySceneChanges(const scenefile::Scene &next, const scenefile::SceneDiff &diff,
+                           LightingInformation &lightingInformation, SceneObjects &objects, Camera &sceneCamera){
+        //---------------------//
+        //READ LIGHTS FROM FILE//
+        //---------------------//
+
+        lightingInformation.pointLights.resize(next.lights.size());
+        lightingInformation.bufferOfPointLights.resize(next.lights.size());
+        lightingInformation.numberOfPointLights = next.lights.size();
+        for(unsigned int l : diff.changedLights){
+            const scenefile::SceneLight &light = next.lights[l];
+            //the point light to add
+            PointLight &currentPointLight = lightingInformation.pointLights[l];
+            currentPointLight.position = light.position;
+            currentPointLight.ambient = light.color;
+            currentPointLight.linear = light.linear;
+            currentPointLight.constant = light.constant;
+            currentPointLight.quadratic = light.quadratic;
+            currentPointLight.diffuse = currentPointLight.ambient;
+            currentPointLight.specular = currentPointLight.ambient;
+
+            //distance where its attenuation makes it invisible
+            currentPointLight.radius = LightClusters::pointLightRadius(currentPointLight);
+
+            //also the point light for buffer
+            PointLightForBuffer &currentPointLightForBuffer = lightingInformation.bufferOfPointLights[l];
+            currentPointLightForBuffer.position = currentPointLight.position;
+            currentPointLightForBuffer.color = currentPointLight.ambient;
+        }
+
+        // if it's defining a camera
+        if(diff.cameraChanged){
+            sceneCamera = Camera(next.cameraPosition, next.cameraUp, next.cameraLookAt);
+        }
+
+        //the objects in the order of the file, the ones that were there already keep their models, and the new ones
+        //share the model of their file when an object draws it already
+        std::vector<ModelInformation> models(next.objects.size());
+        std::vector<SceneObjects::Transform> transforms(next.objects.size());
+        for(size_t o = 0; o < next.objects.size(); o++){
+            const scenefile::SceneObject &object = next.objects[o];
+            if(diff.previousObjects[o] >= 0){
+                models[o] = std::move(objects.model(diff.previousObjects[o]));
+                transforms[o] = objects.transform(diff.previousObjects[o]);
+            }else{
+                models[o] = loadObject(next.paths[object.path], transforms[o]);
+            }
+
+            // translate object to its position in the file
+            transforms[o].position = object.position;
+        }
+        //the indices of the file, the handles of the objects before are invalid. The models of the objects removed
+        //are deleted here, unless other objects draw them
+        objects.clear();
+        for(size_t o = 0; o < next.objects.size(); o++){
+            objects.add(models[o], transforms[o]);
+        }
+        objects.updateTransforms();
+    }
+
+    //remove the objects, their models are deleted with the last object that draws them
+    void deleteObjects(SceneObjects &objects){
+        objects.clear();
+    }
+
+    //the perspective projection of the scene
+    ml::matrix<float> getProjectionMatrix(){
+        return utils::perspectiveMatrix(0.f, 1.f, 0.f, 1.f, 5.f, -5.f);
+    }
+
+    //model matrix of a transform (not transposed)
+    ml::matrix<float> getModelMatrix(const SceneObjects::Transform &transform){
+        ml::matrix<float> modelMatrix(4, 4, true);
+        float position[3] = {transform.position.x, transform.position.y, transform.position.z};
+        float scale[3] = {transform.scale.x, transform.scale.y, transform.scale.z};
+        float offset[3] = {transform.offset.x, transform.offset.y, transform.offset.z};
+
+        //translate the object to the final position
+        modelMatrix = utils::translate(modelMatrix, position);
+
+        // apply rotation
+        modelMatrix = utils::rotateX(modelMatrix, transform.rotation.x);
+        modelMatrix = utils::rotateY(modelMatrix, transform.rotation.y);
+        modelMatrix = utils::rotateZ(modelMatrix, transform.rotation.z);
+
+        // apply scale
+        modelMatrix = utils::scale(modelMatrix, scale);
+
+        // apply translation to the origin
+        modelMatrix = utils::translate(modelMatrix, offset);
+
+        return modelMatrix;
+    }
+
+    //a matrix of matrixlib (row major) as a glm matrix, for the renderers that run on the CPU
+    glm::mat4 toGlm(ml::matrix<float> &matrix){
+        float** m = matrix.getMatrix();
+        glm::mat4 result;
+        for(int row = 0; row < 4; row++){
+            for(int column = 0; column < 4; column++){
+                result[column][row] = m[row][column];
+            }
+        }
+        return result;
+    }
+
+    float projectedSphereRadius(const glm::vec3 &center, float radius, ml::matrix<float> &view,
+                                ml::matrix<float> &projection, int framebufferHeight){
+        //the matrices are sent to the shaders without transposing, so the ones OpenGL uses are their transposes
+        float** v = view.getMatrix();
+        float** p = projection.getMatrix();
+        float viewPosition[4];
+        for(int row = 0; row < 4; row++){
+            viewPosition[row] = v[0][row] * center.x + v[1][row] * center.y + v[2][row] * center.z + v[3][row];
+        }
+        float distance = std::sqrt(viewPosition[0] * viewPosition[0] + viewPosition[1] * viewPosition[1] +
+                                   viewPosition[2] * viewPosition[2]);
+        if(distance <= radius){
+            return std::numeric_limits<float>::infinity();
+        }
+        //behind the camera it covers no pixels
+        float w = p[0][3] * viewPosition[0] + p[1][3] * viewPosition[1] + p[2][3] * viewPosition[2] + p[3][3] * viewPosition[3];
+        if(w <= 0.f){
+            return 0.f;
+        }
+        //the vertical scale of the projection, from normalized device coordinates to pixels
+        return radius * std::abs(p[1][1]) / w * framebufferHeight * 0.5f;
+    }
+
     //initialize glfw stuff
     Window::Window(int windowWidth, int windowHeight){
         //listen for errors generated by glfw
@@ -41,6 +311,9 @@ namespace graphicslib {
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
         glfwWindowHint(GLFW_RESIZABLE, GL_TRUE); //make window resizable
         glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); //compatibility to mac os users
+        //the depth of the G-buffer (GL_DEPTH24_STENCIL8) is blitted to the default framebuffer
+        glfwWindowHint(GLFW_DEPTH_BITS, 24);
+        glfwWindowHint(GLFW_STENCIL_BITS, 8);
 
         mWindowWidth = windowWidth;
         mWindowHeight = windowHeight;
@@ -51,10 +324,22 @@ namespace graphicslib {
         lastX = windowWidth/2.0f;
         lastY = windowHeight/2.0f;
 
-        mPhong = true;
+        mShadingMode = PHONG_SHADING;
         mShowCube = false;
         mLReleased = true;
         mCReleased = true;
+        mClustered = false;
+        mKReleased = true;
+        mDepthPrepass = false;
+        mPReleased = true;
+        mFrameStatistics = false;
+        mFReleased = true;
+        mLevelOfDetail = true;
+        mOReleased = true;
+        mMeshletCulling = true;
+        mMReleased = true;
+        mBReleased = true;
+        mTrianglesDrawn = 0;
 
         // timing
         mDeltaTime = 0.0f;
@@ -118,150 +403,53 @@ namespace graphicslib {
 
     void Window::run(){
 
-        Shader phongColorShader("src/multipleLightsPhongColor.vs", "src/multipleLightsPhongColor.fs");
-        Shader gouraudColorShader("src/multipleLightsGouraudColor.vs", "src/multipleLightsGouraudColor.fs");
-
-        Shader phongTexShader("src/multipleLightsPhongTex.vs", "src/multipleLightsPhongTex.fs");
-        Shader gouraudTexShader("src/multipleLightsGouraudTex.vs", "src/multipleLightsGouraudTex.fs");
+        //all the shader variants used by the scene, compiled when first requested
+        ShaderCache shaderCache;
 
         //------------------//
         //READ THE SCENE.TXT//
         //------------------//
 
-        std::ifstream sceneFile(FILE);
-        //check if an error has ocurred while opening the file
-        if(!sceneFile){
-            std::cerr << "*** Error while opening file " << FILE << " ***" << std::endl;
-            exit(EXIT_FAILURE);
-        }
-        std::string line;
-        
-        int i = 0;
-
-        //initialize the number of lights
-        lightingInformation.numberOfPointLights = 0;
-        
-        //read a line of the file
-        while(std::getline(sceneFile, line)){
-            //treat the case of having \n in the end of the file
-            if(line.compare("") == 0){
-                continue;
-            }
-
-            // first word of the line
-            std::string firstWord;
-
-            //read the first word of the line
-            std::istringstream lineStream(line);
-            lineStream >> firstWord;
-
-            //---------------------//
-            //READ LIGHTS FROM FILE//
-            //---------------------//
-
-            //if it's adding a light in the scene
-            if(firstWord == "light"){
-                //get the point light to alter
-                int index = lightingInformation.numberOfPointLights;
-                PointLight* currentPointLight = &lightingInformation.pointLights[index];
-
-                lineStream >> currentPointLight->position[0]
-                           >> currentPointLight->position[1]
-                           >> currentPointLight->position[2]
-                           >> currentPointLight->ambient[0]
-                           >> currentPointLight->ambient[1]
-                           >> currentPointLight->ambient[2]
-                           >> currentPointLight->linear
-                           >> currentPointLight->constant
-                           >> currentPointLight->quadratic;
-                currentPointLight->diffuse = currentPointLight->ambient;
-                currentPointLight->specular = currentPointLight->ambient;
-
-                //also alter the point light for buffer
-                PointLightForBuffer* currentPointLightForBuffer = &lightingInformation.bufferOfPointLights[index];
-                currentPointLightForBuffer->position = currentPointLight->position;
-                currentPointLightForBuffer->color = currentPointLight->ambient;
-
-                //increment the number of point lights
-                lightingInformation.numberOfPointLights++;
-            }
-
-            // if it's defining a camera
-            else if(firstWord == "camera"){
-                glm::vec3 position, up, lookAt;
-                // read information about the camera (position, lookAt point and view up vector)
-                lineStream >> position.x >> position.y >> position.z
-                           >> lookAt.x >> lookAt.y >> lookAt.z
-                           >> up.x >> up.y >> up.z;
-                camera = Camera(position, up, lookAt);
-            }
-
-            // if it's defining an object
-            else if(firstWord == "object"){
-                std::string path;
-                glm::vec3 finalPos;
-                lineStream >> path >> finalPos.x >> finalPos.y >> finalPos.z;
-
-                //create an ModelInformation instance
-                ModelInformation currentModelInfo;
-
-                //create a new model
-                currentModelInfo.model = new Model(path);
-                //add a reference to it just to ease the coding
-                Model &model = *(currentModelInfo.model);
-
-
-                //----------------//
-                //SHADER SELECTION//
-                //----------------//
-
-                //check if the model has textures
-                if(model.getNumberOfTexturesLoaded()){
-                    //set the shaders with textures
-                    currentModelInfo.phongShader = &phongTexShader;
-                    currentModelInfo.gouraudShader = &gouraudTexShader;
-                }else{
-                    //set the shaders with color
-                    currentModelInfo.phongShader = &phongColorShader;
-                    currentModelInfo.gouraudShader = &gouraudColorShader;
-                }
-
+        //what was read of it, and its writes while the application runs
+        scenefile::Scene scene;
+        readScene(SCENE_FILE, lightingInformation, mObjects, camera, &scene);
+        SceneWatcher sceneWatcher(SCENE_FILE);
 
-                // calculate the bounding box of the model
-                model.calcBoundingBox();
 
-                // size of the biggest dimension of the model
-                float size = model.biggestDimensionSize();
 
-                // initial rotation
-                currentModelInfo.rotation[0] = 0.f;
-                currentModelInfo.rotation[1] = 0.f;
-                currentModelInfo.rotation[2] = 0.f;
+        //----------------------//
+        //BAKE THE STATIC LIGHTS//
+        //----------------------//
 
-                // initial scale
-                currentModelInfo.scale[0] = 2.f/size;
-                currentModelInfo.scale[1] = 2.f/size;
-                currentModelInfo.scale[2] = 2.f/size;
+        //the lights and the models never move, the baked shading reads their lighting from the vertices
+        LightBaker lightBaker;
+        lightBaker.bake(mObjects, lightingInformation);
+        std::cout << "lighting of " << lightBaker.vertices() << " vertices ";
+        if(lightBaker.loadedFromCache()){
+            std::cout << "loaded from the cache";
+        }else{
+            std::cout << "baked with " << lightBaker.raysTraced() << " rays";
+        }
+        std::cout << " in " << lightBaker.bakeMilliseconds() << " ms" << std::endl;
 
-                // translate object to origin
-                currentModelInfo.position[0] = -model.boundingBox.x.center;
-                currentModelInfo.position[1] = -model.boundingBox.y.center;
-                currentModelInfo.position[2] = -model.boundingBox.z.center;
 
-                // translate object to position "finalPos"
-                currentModelInfo.finalPosition[0] = finalPos.x;
-                currentModelInfo.finalPosition[1] = finalPos.y;
-                currentModelInfo.finalPosition[2] = finalPos.z;
 
-                i++;
+        //----------------//
+        //SHADER SELECTION//
+        //----------------//
 
-                //finally append the current information to the vector
-                mModelInformationVector.push_back(currentModelInfo);
+        double shadersStart = glfwGetTime();
 
-            }
+        //the uniform arrays can't hold all the lights
+        if(lightingInformation.numberOfPointLights > MAX_LIGHT_NUMBER){
+            mClustered = true;
+        }
 
+        //the variant depends on the textures the model has, the other variants are compiled when used
+        for(unsigned int object = 0; object < mObjects.size(); object++){
+            ModelInformation &modelInfo = mObjects.model(object);
+            selectShader(shaderCache, modelInfo.shaders, modelInfo.material);
         }
-        sceneFile.close();
 
 
 
@@ -283,57 +471,24 @@ namespace graphicslib {
         ml::matrix<float> modelMatrix(4, 4, true);
 
 
-        Shader phongShader("src/multipleLightsPhong.vs", "src/multipleLightsPhong.fs");
-        //set phong shader material properties
-        phongShader.use();
-        phongShader.setInt("material.diffuse", 0);
-        phongShader.setInt("material.specular", 1);
-        phongShader.setFloat("material.shininess", 32.0f);
-
-        //send the number of point lights
-        phongShader.setInt("numberOfPointLights", lightingInformation.numberOfPointLights);
-
+        //the cube has no textures
+        Shader* cubeShaders[NUMBER_OF_SHADER_VARIANTS] = {NULL};
+        MaterialInformation cubeMaterial = {false, false, false, false, false, false};
 
-        Shader gouraudShader("src/multipleLightsGouraud.vs", "src/multipleLightsGouraud.fs");
-        //set gouraud shader material properties
-        gouraudShader.use();
-        gouraudShader.setInt("material.diffuse", 0);
-        gouraudShader.setInt("material.specular", 1);
-        gouraudShader.setFloat("material.shininess", 32.0f);
+        //lights of each cluster of the view frustum
+        LightClusters lightClusters;
 
-        //send the number of point lights
-        gouraudShader.setInt("numberOfPointLights", lightingInformation.numberOfPointLights);
-        //send the color of the cube
-        gouraudShader.setVec3("objectColor", glm::vec3(1.0, 0.5, 0.31));
+        //surfaces of the deferred shading, allocated when first used
+        GBuffer gBuffer;
 
+        //queries to measure the frames
+        FrameStatistics frameStatistics;
 
-        //setup the multiple light model using textures
-        phongTexShader.use();
-        phongTexShader.setFloat("shininess", 32.0f);
-        //send the number of point lights
-        phongTexShader.setInt("numberOfPointLights", lightingInformation.numberOfPointLights);
 
+        Shader &lampShader = *shaderCache.get("src/lamp.vs", "src/lamp.fs");
 
-        //setup the multiple light model using textures
-        gouraudTexShader.use();
-        gouraudTexShader.setFloat("shininess", 32.0f);
-        //send the number of point lights
-        gouraudTexShader.setInt("numberOfPointLights", lightingInformation.numberOfPointLights);
-
-        //setup the multiple light model using textures
-        phongColorShader.use();
-        phongColorShader.setFloat("shininess", 32.0f);
-        //send the number of point lights
-        phongColorShader.setInt("numberOfPointLights", lightingInformation.numberOfPointLights);
-
-
-        //setup the multiple light model using textures
-        gouraudColorShader.use();
-        gouraudColorShader.setFloat("shininess", 32.0f);
-        //send the number of point lights
-        gouraudColorShader.setInt("numberOfPointLights", lightingInformation.numberOfPointLights);
-
-        Shader lampShader("src/lamp.vs", "src/lamp.fs");
+        std::cout << "shaders: " << shaderCache.size() << " programs (" << shaderCache.loadedFromCache()
+                  << " from the binary cache) ready in " << (glfwGetTime() - shadersStart) * 1000.0 << " ms" << std::endl;
 
 
 
@@ -352,221 +507,161 @@ namespace graphicslib {
             // input
             updateInput(mWindow);
 
+            //only the objects and the lights that changed in the file are loaded again
+            if(sceneWatcher.changed()){
+                reloadScene(scene, lightBaker, pointLightsVAO);
+                std::fill(cubeShaders, cubeShaders + NUMBER_OF_SHADER_VARIANTS, (Shader*) NULL);
+            }
+
             // render
             glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+            if(mFrameStatistics){
+                frameStatistics.beginFrame();
+            }
 
 
-            if(mPhong){
-                //enable shader
-                phongTexShader.use();
-                //use perspective projection
-                projection = utils::perspectiveMatrix(0.f, 1.f, 0.f, 1.f, 5.f, -5.f);
-                // view/projection transformations
-                phongTexShader.setMat4("projection", projection.getMatrix());
-                view = camera.GetViewMatrix();
-                phongTexShader.setMat4("view", view.getMatrix());
-
-                //enable shader
-                phongColorShader.use();
-                //use perspective projection
-                projection = utils::perspectiveMatrix(0.f, 1.f, 0.f, 1.f, 5.f, -5.f);
-                // view/projection transformations
-                phongColorShader.setMat4("projection", projection.getMatrix());
-                view = camera.GetViewMatrix();
-                phongColorShader.setMat4("view", view.getMatrix());
-            }else{
-                //enable shader
-                gouraudTexShader.use();
-                //use perspective projection
-                projection = utils::perspectiveMatrix(0.f, 1.f, 0.f, 1.f, 5.f, -5.f);
-                // view/projection transformations
-                gouraudTexShader.setMat4("projection", projection.getMatrix());
-                view = camera.GetViewMatrix();
-                gouraudTexShader.setMat4("view", view.getMatrix());
 
-                //enable shader
-                gouraudColorShader.use();
-                //use perspective projection
-                projection = utils::perspectiveMatrix(0.f, 1.f, 0.f, 1.f, 5.f, -5.f);
-                // view/projection transformations
-                gouraudColorShader.setMat4("projection", projection.getMatrix());
-                view = camera.GetViewMatrix();
-                gouraudColorShader.setMat4("view", view.getMatrix());
+            //use perspective projection
+            projection = getProjectionMatrix();
+            view = camera.GetViewMatrix();
 
+            int framebufferWidth, framebufferHeight;
+            glfwGetFramebufferSize(mWindow, &framebufferWidth, &framebufferHeight);
+
+            //assign the lights to the clusters of this view
+            if(mClustered){
+                lightClusters.update(view, projection, lightingInformation, framebufferWidth, framebufferHeight);
             }
 
+            //the objects out of the view aren't drawn, the others are drawn grouped by shader
+            cullObjects(shaderCache, view, projection);
 
-            i = 0;
-            // render the loaded models
-            for(auto modelInfo : mModelInformationVector){
+            //the distant models are drawn with less triangles
+            selectLevelsOfDetail(view, projection, framebufferHeight);
 
-                Shader* currentShader;
+            //and sample coarser levels of their textures, the finer ones are streamed in when they come closer
+            streamTextures(view, projection, framebufferHeight);
 
-                //-----------------//
-                //SHADING SELECTION//
-                //-----------------//
+            //and the meshlets out of the view or facing away aren't drawn
+            cullMeshlets(view, projection);
 
-                if(mPhong){
-                    currentShader = modelInfo.phongShader;
-                }else{
-                    currentShader = modelInfo.gouraudShader;
-                }
+            //the models write their surfaces to the G-buffer, the lights are computed later
+            if(mShadingMode == DEFERRED_SHADING){
+                gBuffer.resize(framebufferWidth, framebufferHeight);
+                gBuffer.bindForGeometryPass();
+            }
 
-                currentShader->use();
-
-                //TODO put this thing in the if out of the for
-                currentShader->setVec3("viewPos", camera.Position);
-
-                //send the point lights information to the shader for each point light
-                for(int i = 0; i < lightingInformation.numberOfPointLights; i++){
-                //get the point light
-                PointLight* currentPointLight = &lightingInformation.pointLights[i];
-                //set the parameters of the shader
-                currentShader->setVec3(std::string("pointLights[") + std::to_string(i) +
-                    std::string("].position"), currentPointLight->position);
-                currentShader->setFloat(std::string("pointLights[") + std::to_string(i) +
-                    std::string("].constant"), currentPointLight->constant);
-                currentShader->setFloat(std::string("pointLights[") + std::to_string(i) +
-                    std::string("].linear"), currentPointLight->linear);
-                currentShader->setFloat(std::string("pointLights[") + std::to_string(i) +
-                    std::string("].quadratic"), currentPointLight->quadratic);
-                currentShader->setVec3(std::string("pointLights[") + std::to_string(i) +
-                    std::string("].ambient"), currentPointLight->ambient);
-                currentShader->setVec3(std::string("pointLights[") + std::to_string(i) +
-                    std::string("].diffuse"), currentPointLight->diffuse);
-                currentShader->setVec3(std::string("pointLights[") + std::to_string(i) +
-                    std::string("].specular"), currentPointLight->specular);
-                }
+            //--------------//
+            //DEPTH PRE-PASS//
+            //--------------//
 
-                ml::matrix<float> modelMatrix(4, 4, true);
+            //the lit pass only draws the fragments with the depth of the pre-pass
+            if(mDepthPrepass){
+                depthPrepass(shaderCache, view, projection, cubeVAO);
+                glDepthFunc(GL_EQUAL);
+                glDepthMask(GL_FALSE);
+            }
+
+            if(mFrameStatistics){
+                frameStatistics.beginShadedPass();
+            }
 
-                //translate the object to the final position
-                modelMatrix = utils::translate(modelMatrix, modelInfo.finalPosition);
 
-                // apply rotation
-                modelMatrix = utils::rotateX(modelMatrix, modelInfo.rotation[0]);
-                modelMatrix = utils::rotateY(modelMatrix, modelInfo.rotation[1]);
-                modelMatrix = utils::rotateZ(modelMatrix, modelInfo.rotation[2]);
+            // render the visible models, the uniforms of a program are set once for all its objects
+            Shader* currentShader = NULL;
+            for(const std::pair<Shader*, unsigned int> &draw : mDrawList){
+                ModelInformation &modelInfo = mObjects.model(draw.second);
+
+                //-----------------//
+                //SHADING SELECTION//
+                //-----------------//
 
-                // apply scale
-                modelMatrix = utils::scale(modelMatrix, modelInfo.scale);
+                if(draw.first != currentShader){
+                    currentShader = draw.first;
+                    ShaderVariant variant = currentShaderVariant(modelInfo.material);
 
-                // apply translation to the origin
-                modelMatrix = utils::translate(modelMatrix, modelInfo.position);
+                    currentShader->use();
 
-                //transpose the matrix
-                modelMatrix = modelMatrix.transpose();
+                    // view/projection transformations
+                    currentShader->setMat4("projection", projection.getMatrix());
+                    currentShader->setMat4("view", view.getMatrix());
+                    currentShader->setVec3("viewPos", camera.Position);
+                    currentShader->setBool("hasNormalMatrix", true);
 
-                //pass the model matrix to the shader
-                currentShader->setMat4("model", modelMatrix.getMatrix());
-                modelInfo.model->Draw(*currentShader);
+                    //send the point lights information to the shader, the geometry pass and the baked shading don't use them
+                    if(variant != GBUFFER_SHADER && variant != BAKED_SHADER){
+                        sendLights(*currentShader, lightClusters);
+                    }
+                }
 
-                i++;
+                //the world matrix is already as OpenGL takes it, the normal matrix is computed once per object here
+                //instead of once per vertex in the shader
+                const glm::mat4 &worldMatrix = mObjects.worldMatrix(draw.second);
+                currentShader->setMat4("model", worldMatrix);
+                currentShader->setMat3("normalMatrix", glm::inverseTranspose(glm::mat3(worldMatrix)));
+                //the model is shared, the meshes get the baked lighting of this object
+                if(currentShaderVariant(modelInfo.material) == BAKED_SHADER){
+                    modelInfo.model->setBakedLighting(modelInfo.bakedLightingId, modelInfo.bakedLighting);
+                }
+                modelInfo.model->Draw(*currentShader, modelInfo.lod, &modelInfo.meshlets);
             }
 
 
 #ifdef SHOW_CUBE
 
             if(mShowCube){
-                //use the phong shader
-                if(mPhong){
 
                 //---------//
                 //DRAW CUBE//
                 //---------//
 
+                Shader &cubeShader = *selectShader(shaderCache, cubeShaders, cubeMaterial);
+
                 // be sure to activate shader when setting uniforms/drawing objects
-                phongShader.use();
-                phongShader.setVec3("viewPos", camera.Position);
-
-                //send the point lights information to the shader for each point light
-                for(int i = 0; i < lightingInformation.numberOfPointLights; i++){
-                    //get the point light
-                    PointLight* currentPointLight = &lightingInformation.pointLights[i];
-                    //set the parameters of the shader
-                    phongShader.setVec3(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].position"), currentPointLight->position);
-                    phongShader.setFloat(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].constant"), currentPointLight->constant);
-                    phongShader.setFloat(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].linear"), currentPointLight->linear);
-                    phongShader.setFloat(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].quadratic"), currentPointLight->quadratic);
-                    phongShader.setVec3(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].ambient"), currentPointLight->ambient);
-                    phongShader.setVec3(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].diffuse"), currentPointLight->diffuse);
-                    phongShader.setVec3(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].specular"), currentPointLight->specular);
+                cubeShader.use();
+                cubeShader.setVec3("viewPos", camera.Position);
+
+                //send the point lights information to the shader
+                if(mShadingMode != DEFERRED_SHADING){
+                    sendLights(cubeShader, lightClusters);
                 }
 
                 //set tranformation matrices
+                ml::matrix<float> cubeNormalMatrix = utils::normalMatrix(modelMatrix);
+                cubeNormalMatrix = cubeNormalMatrix.transpose();
                 modelMatrix = modelMatrix.transpose();
-                phongShader.setMat4("model", modelMatrix.getMatrix());
-                view = camera.GetViewMatrix();
-                phongShader.setMat4("view", view.getMatrix());
-                projection = utils::perspectiveMatrix(0.f, 1.f, 0.f, 1.f, 5.f, -5.f);
-                phongShader.setMat4("projection", projection.getMatrix());
+                cubeShader.setMat4("model", modelMatrix.getMatrix());
+                cubeShader.setMat3("normalMatrix", cubeNormalMatrix.getMatrix());
+                cubeShader.setBool("hasNormalMatrix", true);
+                cubeShader.setMat4("view", view.getMatrix());
+                cubeShader.setMat4("projection", projection.getMatrix());
 
                 // render the cube
                 glBindVertexArray(cubeVAO);
                 glDrawArrays(GL_TRIANGLES, 0, 36);
+            }
 
+#endif
 
-                //use the gouraud shader
-                }else{
-
-                //---------//
-                //DRAW CUBE//
-                //---------//
-
-                // be sure to activate shader when setting uniforms/drawing objects
-                gouraudShader.use();
-                gouraudShader.setVec3("viewPos", camera.Position);
-
-                //send the point lights information to the shader for each point light
-                for(int i = 0; i < lightingInformation.numberOfPointLights; i++){
-                    //get the point light
-                    PointLight* currentPointLight = &lightingInformation.pointLights[i];
-                    //set the parameters of the shader
-                    gouraudShader.setVec3(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].position"), currentPointLight->position);
-                    gouraudShader.setFloat(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].constant"), currentPointLight->constant);
-                    gouraudShader.setFloat(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].linear"), currentPointLight->linear);
-                    gouraudShader.setFloat(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].quadratic"), currentPointLight->quadratic);
-                    gouraudShader.setVec3(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].ambient"), currentPointLight->ambient);
-                    gouraudShader.setVec3(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].diffuse"), currentPointLight->diffuse);
-                    gouraudShader.setVec3(std::string("pointLights[") + std::to_string(i) +
-                            std::string("].specular"), currentPointLight->specular);
-                }
+            if(mFrameStatistics){
+                frameStatistics.endShadedPass();
+            }
 
-                // be sure to activate shader when setting uniforms/drawing objects
-                gouraudShader.use();
-                gouraudShader.setVec3("objectColor", 1.0f, 0.5f, 0.31f);
+            if(mDepthPrepass){
+                glDepthFunc(GL_LESS);
+                glDepthMask(GL_TRUE);
+            }
 
-                // view/projection transformations
-                modelMatrix = modelMatrix.transpose();
-                gouraudShader.setMat4("model", modelMatrix.getMatrix());
-                view = camera.GetViewMatrix();
-                gouraudShader.setMat4("view", view.getMatrix());
-                projection = utils::perspectiveMatrix(0.f, 1.f, 0.f, 1.f, 5.f, -5.f);
-                gouraudShader.setMat4("projection", projection.getMatrix());
+            //----------------------//
+            //DEFERRED LIGHTING PASS//
+            //----------------------//
 
-                // render the cube
-                glBindVertexArray(cubeVAO);
-                glDrawArrays(GL_TRIANGLES, 0, 36);
-                }
+            if(mShadingMode == DEFERRED_SHADING){
+                deferredLightingPass(shaderCache, gBuffer, lightClusters, view);
             }
 
-#endif
-
             //-----------------//
             //DRAW POINT LIGHTS//
             //-----------------//
@@ -582,6 +677,9 @@ namespace graphicslib {
             glBindVertexArray(pointLightsVAO);
             glDrawArrays(GL_POINTS, 0, lightingInformation.numberOfPointLights);
 
+            if(mFrameStatistics){
+                frameStatistics.endFrame(currentFrame, mDeltaTime, renderingLabel(lightClusters));
+            }
 
 
 
@@ -591,11 +689,7 @@ namespace graphicslib {
         }
 
         //delete the allocated models
-        for(auto modelInfo: mModelInformationVector){
-            if(modelInfo.model){
-                delete modelInfo.model;
-            }
-        }
+        deleteObjects(mObjects);
 
     }
 
@@ -625,6 +719,364 @@ namespace graphicslib {
     }
 #endif
 
+    //get the lighting shader variant (Phong or Gouraud, clustered or not) for a material, compiled on the first request
+    Shader* Window::getLightingShader(ShaderCache &shaderCache, ShaderVariant variant, const MaterialInformation &material){
+        bool phong = variant == PHONG_SHADER || variant == PHONG_CLUSTERED_SHADER || variant == GBUFFER_SHADER;
+        std::vector<std::string> defines;
+        if(variant == GBUFFER_SHADER || variant == BAKED_SHADER){
+            //the geometry pass and the baked shading don't use the lights
+            defines.push_back("NUM_POINT_LIGHTS 0");
+        }else if(variant == PHONG_CLUSTERED_SHADER || variant == GOURAUD_CLUSTERED_SHADER){
+            defines.push_back("CLUSTERED");
+        }else{
+            //the light loops are unrolled with the number of lights of the scene
+            defines.push_back("NUM_POINT_LIGHTS " + std::to_string(lightingInformation.numberOfPointLights));
+        }
+        if(phong){
+            defines.push_back("PHONG");
+        }
+        if(variant == BAKED_SHADER){
+            defines.push_back("BAKED");
+        }
+        if(material.hasDiffuseTexture){
+            defines.push_back("HAS_DIFFUSE_TEX");
+        }
+        //the Gouraud shading doesn't use the specular texture
+        if(material.hasSpecularTexture && (phong || variant == BAKED_SHADER)){
+            defines.push_back("HAS_SPECULAR_TEX");
+        }
+        if(material.compressedVertices){
+            defines.push_back("COMPRESSED_VERTICES");
+        }
+        if(material.textureArrays && (material.hasDiffuseTexture || material.hasSpecularTexture)){
+            defines.push_back("TEXTURE_ARRAYS");
+        }
+        //the baked lighting has its own ambient occlusion
+        if(material.ambientOcclusion && variant != BAKED_SHADER){
+            defines.push_back("AMBIENT_OCCLUSION");
+        }
+
+        const char* fragmentPath = variant == GBUFFER_SHADER ? "src/gbuffer.fs" : "src/multipleLights.fs";
+        Shader* shader = shaderCache.get("src/multipleLights.vs", fragmentPath, defines);
+
+        //material properties
+        shader->use();
+        shader->setFloat("shininess", 32.0f);
+
+        return shader;
+    }
+
+    //get the shader of the lighting pass of the deferred shading, with the lights as uniforms or as the clusters
+    Shader* Window::getDeferredLightingShader(ShaderCache &shaderCache){
+        std::vector<std::string> defines;
+        if(mClustered){
+            defines.push_back("CLUSTERED");
+        }else{
+            defines.push_back("NUM_POINT_LIGHTS " + std::to_string(lightingInformation.numberOfPointLights));
+        }
+        Shader* shader = shaderCache.get("src/deferred.vs", "src/deferred.fs", defines);
+
+        //material properties, the same of the forward shading
+        shader->use();
+        shader->setFloat("shininess", 32.0f);
+
+        return shader;
+    }
+
+    //variant of a material used in this frame
+    ShaderVariant Window::currentShaderVariant(const MaterialInformation &material){
+        if(mShadingMode == DEFERRED_SHADING){
+            return GBUFFER_SHADER;
+        }
+        if(mShadingMode == BAKED_SHADING && material.bakedLighting){
+            return BAKED_SHADER;
+        }
+        bool phong = mShadingMode == PHONG_SHADING;
+        if(mClustered){
+            return phong ? PHONG_CLUSTERED_SHADER : GOURAUD_CLUSTERED_SHADER;
+        }
+        return phong ? PHONG_SHADER : GOURAUD_SHADER;
+    }
+
+    //shade the G-buffer to the default framebuffer, each pixel only once whatever the overdraw
+    void Window::deferredLightingPass(ShaderCache &shaderCache, GBuffer &gBuffer, const LightClusters &lightClusters,
+                                      ml::matrix<float> &view){
+        Shader &lightingShader = *getDeferredLightingShader(shaderCache);
+        gBuffer.bindForLightingPass(lightingShader);
+        lightingShader.setVec3("viewPos", camera.Position);
+        lightingShader.setMat4("view", view.getMatrix());
+        sendLights(lightingShader, lightClusters);
+
+        //the triangle covers everything, the depth of the scene is copied after
+        glDisable(GL_DEPTH_TEST);
+        gBuffer.drawFullscreenTriangle();
+        glEnable(GL_DEPTH_TEST);
+
+        gBuffer.copyDepthToDefaultFramebuffer();
+    }
+
+    //the shader of the current variant in shaders, compiled when first used
+    Shader* Window::selectShader(ShaderCache &shaderCache, Shader** shaders, const MaterialInformation &material){
+        ShaderVariant variant = currentShaderVariant(material);
+        if(!shaders[variant]){
+            shaders[variant] = getLightingShader(shaderCache, variant, material);
+        }
+        return shaders[variant];
+    }
+
+    //radius in pixels of the bounding sphere of an object on the screen (the sphere of the last
+    //SceneObjects::updateTransforms)
+    float Window::projectedRadius(unsigned int object, ml::matrix<float> &view, ml::matrix<float> &projection,
+                                  int framebufferHeight){
+        glm::vec3 center(mObjects.component(SceneObjects::CENTER_X)[object], mObjects.component(SceneObjects::CENTER_Y)[object],
+                         mObjects.component(SceneObjects::CENTER_Z)[object]);
+        return projectedSphereRadius(center, mObjects.component(SceneObjects::RADIUS)[object], view, projection,
+                                     framebufferHeight);
+    }
+
+    //the objects in the view frustum, and the draw list of the lit pass
+    void Window::cullObjects(ShaderCache &shaderCache, ml::matrix<float> &view, ml::matrix<float> &projection){
+        //the matrices OpenGL uses are the transposes of the view and the projection
+        ml::matrix<float> worldToClip = projection.transpose() * view.transpose();
+        mObjects.cull(toGlm(worldToClip), mVisibleObjects);
+
+        //the draw list grouped by shader: there are a few programs, the objects of each one are counted and placed
+        //after the ones of the programs before, in their order
+        std::vector<Shader*> programs;
+        std::vector<unsigned int> programOffsets;
+        std::vector<unsigned int> objectPrograms(mVisibleObjects.size());
+        for(size_t v = 0; v < mVisibleObjects.size(); v++){
+            ModelInformation &modelInfo = mObjects.model(mVisibleObjects[v]);
+            Shader* shader = selectShader(shaderCache, modelInfo.shaders, modelInfo.material);
+            unsigned int program = std::find(programs.begin(), programs.end(), shader) - programs.begin();
+            if(program == programs.size()){
+                programs.push_back(shader);
+                programOffsets.push_back(0);
+            }
+            objectPrograms[v] = program;
+            programOffsets[program]++;
+        }
+        unsigned int offset = 0;
+        for(unsigned int &programOffset : programOffsets){
+            unsigned int count = programOffset;
+            programOffset = offset;
+            offset += count;
+        }
+        mDrawList.resize(mVisibleObjects.size());
+        for(size_t v = 0; v < mVisibleObjects.size(); v++){
+            mDrawList[programOffsets[objectPrograms[v]]++] = std::make_pair(programs[objectPrograms[v]], mVisibleObjects[v]);
+        }
+    }
+
+    //choose the level of detail of each model for this frame
+    void Window::selectLevelsOfDetail(ml::matrix<float> &view, ml::matrix<float> &projection, int framebufferHeight){
+        for(unsigned int object : mVisibleObjects){
+            ModelInformation &modelInfo = mObjects.model(object);
+            if(mLevelOfDetail){
+                float radius = projectedRadius(object, view, projection, framebufferHeight);
+                modelInfo.lod = modelInfo.model->selectLod(modelInfo.lod, radius);
+            }else{
+                modelInfo.lod = 0;
+            }
+        }
+    }
+
+    //request the levels of the textures each model samples in this frame and update the streamed levels
+    void Window::streamTextures(ml::matrix<float> &view, ml::matrix<float> &projection, int framebufferHeight){
+        if(!TextureStreamer::enabled){
+            return;
+        }
+        TextureStreamer &streamer = TextureStreamer::global();
+        //the objects out of the view frustum sample nothing, their textures keep the levels they have
+        for(unsigned int object : mVisibleObjects){
+            Model &model = *mObjects.model(object).model;
+            //pixels per unit of the model, as the bounding sphere covers projectedRadius pixels
+            float pixelsPerUnit = projectedRadius(object, view, projection, framebufferHeight) /
+                                  std::max(model.boundingRadius(), 1e-6f);
+            for(Mesh &mesh : model.meshes){
+                float pixelsPerUv = mesh.uvDensity > 0.f ? pixelsPerUnit / mesh.uvDensity : pixelsPerUnit;
+                for(const Texture &texture : mesh.textures){
+                    streamer.request(texture.id, pixelsPerUv);
+                }
+            }
+        }
+        streamer.update();
+    }
+
+    //keep the meshlets of the objects drawn at the level 0 that can be visible in this frame, in each object
+    void Window::cullMeshlets(ml::matrix<float> &view, ml::matrix<float> &projection){
+        mTrianglesDrawn = 0;
+        //the matrices OpenGL uses are the transposes of the view and the projection
+        ml::matrix<float> worldToClipMatrix = projection.transpose() * view.transpose();
+        glm::mat4 worldToClip = toGlm(worldToClipMatrix);
+        for(unsigned int object : mVisibleObjects){
+            ModelInformation &modelInfo = mObjects.model(object);
+            Model &model = *modelInfo.model;
+            if(!mMeshletCulling || modelInfo.lod != 0){
+                modelInfo.meshlets.clear();
+                mTrianglesDrawn += model.triangleCount(modelInfo.lod);
+                continue;
+            }
+
+            //the transform from the model to the clip coordinates
+            const glm::mat4 &worldMatrix = mObjects.worldMatrix(object);
+            glm::mat4 clip = worldToClip * worldMatrix;
+            //the frustum planes in the coordinates of the model (Gribb and Hartmann): w +- x, w +- y, w +- z
+            glm::vec4 planes[6];
+            for(int axis = 0; axis < 3; axis++){
+                for(int side = 0; side < 2; side++){
+                    float sign = side ? -1.f : 1.f;
+                    glm::vec4 plane(clip[0][3] + sign * clip[0][axis], clip[1][3] + sign * clip[1][axis],
+                                    clip[2][3] + sign * clip[2][axis], clip[3][3] + sign * clip[3][axis]);
+                    float length = glm::length(glm::vec3(plane));
+                    planes[2 * axis + side] = length > 0.f ? plane / length : glm::vec4(0.f, 0.f, 0.f, 1.f);
+                }
+            }
+
+            glm::vec3 cameraPosition = glm::vec3(glm::inverse(worldMatrix) * glm::vec4(camera.Position, 1.f));
+            mTrianglesDrawn += model.cullMeshlets(cameraPosition, planes, modelInfo.meshlets);
+        }
+    }
+
+    //write the depth of the models and the cube with the positions only and no color
+    void Window::depthPrepass(ShaderCache &shaderCache, ml::matrix<float> &view, ml::matrix<float> &projection,
+                              unsigned int cubeVAO){
+        //a variant for each vertex layout
+        Shader* depthShaders[2] = {shaderCache.get("src/depth.vs", "src/depth.fs"),
+                                   shaderCache.get("src/depth.vs", "src/depth.fs", {"COMPRESSED_VERTICES"})};
+        for(Shader* depthShader : depthShaders){
+            depthShader->use();
+            depthShader->setMat4("projection", projection.getMatrix());
+            depthShader->setMat4("view", view.getMatrix());
+        }
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+        for(unsigned int object : mVisibleObjects){
+            ModelInformation &modelInfo = mObjects.model(object);
+            Shader &depthShader = *depthShaders[modelInfo.material.compressedVertices];
+            depthShader.use();
+            depthShader.setMat4("model", mObjects.worldMatrix(object));
+            modelInfo.model->DrawGeometry(depthShader, modelInfo.lod, &modelInfo.meshlets);
+        }
+
+#ifdef SHOW_CUBE
+        if(mShowCube){
+            Shader &depthShader = *depthShaders[0];
+            depthShader.use();
+            ml::matrix<float> modelMatrix(4, 4, true);
+            depthShader.setMat4("model", modelMatrix.getMatrix());
+            glBindVertexArray(cubeVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+        }
+#endif
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    }
+
+    //description of the rendering options for the statistics
+    std::string Window::renderingLabel(const LightClusters &lightClusters){
+        const char* shadingNames[] = {"phong", "gouraud", "deferred", "baked"};
+        std::string label = shadingNames[mShadingMode];
+        if(mClustered){
+            //the lights of the clusters that have any, what the clustered shading loops over
+            char lightsPerCluster[32];
+            std::snprintf(lightsPerCluster, sizeof(lightsPerCluster), "%.1f", lightClusters.averageLightsPerCluster());
+            label += ", clustered lights (" + std::string(lightsPerCluster) + " per cluster)";
+        }else{
+            label += ", uniform lights";
+        }
+        label += mDepthPrepass ? ", depth pre-pass" : "";
+        label += mLevelOfDetail ? ", levels of detail" : "";
+        label += mMeshletCulling ? ", meshlet culling" : "";
+        label += ", " + std::to_string(mVisibleObjects.size()) + " of " + std::to_string(mObjects.size()) + " objects";
+        label += ", " + std::to_string(mTrianglesDrawn) + " triangles";
+        unsigned int drawCalls = 0;
+        for(unsigned int object : mVisibleObjects){
+            drawCalls += mObjects.model(object).model->drawCallCount();
+        }
+        label += ", " + std::to_string(drawCalls) + (Model::mergeDraws ? " merged" : "") + " draw calls";
+        if(TextureStreamer::enabled){
+            label += ", " + std::to_string(TextureStreamer::global().residentBytes() >> 20) + " MB of streamed textures";
+        }
+        return label;
+    }
+
+    //read the scene file again after it was written, and load what changed in it
+    void Window::reloadScene(scenefile::Scene &scene, LightBaker &lightBaker, unsigned int pointLightsVAO){
+        double start = glfwGetTime();
+        scenefile::Scene next;
+        if(!scenefile::read(SCENE_FILE, next)){
+            std::cerr << "ERROR::SCENEFILE::FILE_NOT_READ " << SCENE_FILE << std::endl;
+            return;
+        }
+        scenefile::SceneDiff diff = scenefile::diff(scene, next);
+        if(diff.empty()){
+            return;
+        }
+        int previousLights = lightingInformation.numberOfPointLights;
+        applySceneChanges(next, diff, lightingInformation, mObjects, camera);
+        scene = std::move(next);
+
+        //the points of the lights are drawn from the buffer of their vertex array
+        GLint pointLightsVBO;
+        glBindVertexArray(pointLightsVAO);
+        glGetVertexAttribiv(0, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &pointLightsVBO);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, pointLightsVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(PointLightForBuffer) * lightingInformation.numberOfPointLights,
+                     lightingInformation.bufferOfPointLights.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        //the shaders unroll the loops of the lights, they're selected again with the new number
+        if(lightingInformation.numberOfPointLights != previousLights){
+            for(unsigned int object = 0; object < mObjects.size(); object++){
+                ModelInformation &modelInfo = mObjects.model(object);
+                std::fill(modelInfo.shaders, modelInfo.shaders + NUMBER_OF_SHADER_VARIANTS, (Shader*) NULL);
+            }
+        }
+        if(lightingInformation.numberOfPointLights > MAX_LIGHT_NUMBER){
+            mClustered = true;
+        }
+
+        //the baked lighting of every vertex depends on all the lights and the models
+        bool sceneChanged = !diff.movedObjects.empty() || !diff.addedObjects.empty() || !diff.removedObjects.empty() ||
+                            !diff.changedLights.empty() || diff.removedLights;
+        if(sceneChanged){
+            lightBaker.bake(mObjects, lightingInformation);
+        }
+
+        std::cout << SCENE_FILE << " reloaded: " << diff.addedObjects.size() << " objects added, "
+                  << diff.movedObjects.size() << " moved, " << diff.removedObjects.size() << " removed, "
+                  << diff.changedLights.size() << " lights changed, " << diff.removedLights << " removed in "
+                  << (glfwGetTime() - start) * 1000.0 << " ms" << std::endl;
+    }
+
+    //send the lights to the shader, the clustered variants read them from the clusters
+    void Window::sendLights(Shader &shader, const LightClusters &lightClusters){
+        if(mClustered){
+            lightClusters.bind(shader);
+        }else{
+            sendPointLights(shader);
+        }
+    }
+
+    //send the point lights information to the shader for each point light
+    void Window::sendPointLights(Shader &shader){
+        for(int i = 0; i < lightingInformation.numberOfPointLights; i++){
+            //get the point light
+            PointLight* currentPointLight = &lightingInformation.pointLights[i];
+            std::string name = std::string("pointLights[") + std::to_string(i) + std::string("]");
+            //set the parameters of the shader
+            shader.setVec3(name + ".position", currentPointLight->position);
+            shader.setFloat(name + ".constant", currentPointLight->constant);
+            shader.setFloat(name + ".linear", currentPointLight->linear);
+            shader.setFloat(name + ".quadratic", currentPointLight->quadratic);
+            shader.setVec3(name + ".ambient", currentPointLight->ambient);
+            shader.setVec3(name + ".diffuse", currentPointLight->diffuse);
+            shader.setVec3(name + ".specular", currentPointLight->specular);
+        }
+    }
+
     //gen and setup a VAO to the point lights and fill it's buffer
     unsigned int Window::loadPointLightsVAO(){
 
@@ -636,7 +1088,7 @@ namespace graphicslib {
         glGenBuffers(1, &pointLightsVBO);
         glBindBuffer(GL_ARRAY_BUFFER, pointLightsVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(PointLightForBuffer) * lightingInformation.numberOfPointLights,
-                     lightingInformation.bufferOfPointLights, GL_STATIC_DRAW);
+                     lightingInformation.bufferOfPointLights.data(), GL_STATIC_DRAW);
 
         //setup the VAO attributes
         glBindVertexArray(pointLightsVAO);
@@ -688,7 +1140,7 @@ namespace graphicslib {
 
         if(mLReleased){
             if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS){
-                mPhong = !mPhong;
+                mShadingMode = (ShadingMode) ((mShadingMode + 1) % NUMBER_OF_SHADING_MODES);
             }
             mLReleased = false;
         }
@@ -705,6 +1157,72 @@ namespace graphicslib {
         if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE){
             mCReleased = true;
         }
+
+        if(mPReleased){
+            if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS){
+                mDepthPrepass = !mDepthPrepass;
+            }
+            mPReleased = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE){
+            mPReleased = true;
+        }
+
+        if(mFReleased){
+            if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS){
+                mFrameStatistics = !mFrameStatistics;
+            }
+            mFReleased = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F) == GLFW_RELEASE){
+            mFReleased = true;
+        }
+
+        if(mOReleased){
+            if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS){
+                mLevelOfDetail = !mLevelOfDetail;
+                std::cout << "levels of detail " << (mLevelOfDetail ? "on" : "off") << std::endl;
+            }
+            mOReleased = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE){
+            mOReleased = true;
+        }
+
+        if(mBReleased){
+            if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS){
+                Model::mergeDraws = !Model::mergeDraws;
+                std::cout << "merged draws " << (Model::mergeDraws ? "on" : "off") << std::endl;
+            }
+            mBReleased = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE){
+            mBReleased = true;
+        }
+
+        if(mMReleased){
+            if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS){
+                mMeshletCulling = !mMeshletCulling;
+                std::cout << "meshlet culling " << (mMeshletCulling ? "on" : "off") << std::endl;
+            }
+            mMReleased = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE){
+            mMReleased = true;
+        }
+
+        //the clustered shading can only be turned off when the lights fit in the uniform arrays
+        if(mKReleased){
+            if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS &&
+                lightingInformation.numberOfPointLights <= MAX_LIGHT_NUMBER){
+                mClustered = !mClustered;
+                std::cout << "clustered shading " << (mClustered ? "on" : "off") << std::endl;
+            }
+            mKReleased = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_K) == GLFW_RELEASE){
+            mKReleased = true;
+        }
     }
 
     // glfw: whenever the mouse moves, this callback is called
@@ -0,0 +1,296 @@
+#include <lightbaker.hpp>
+#include <ambientocclusion.hpp>
+#include <lightclusters.hpp>
+#include <matrixlib.hpp>
+#include <mesh.hpp>
+#include <model.hpp>
+#include <threadpool.hpp>
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace graphicslib;
+
+bool LightBaker::shadows = true;
+int LightBaker::ambientOcclusionSamples = 0;
+std::string LightBaker::cacheDirectory = "cache/lighting";
+
+//id of the lighting baked for the last object, each object gets a new one at each bake (0 is none)
+static unsigned int lastLightingId = 0;
+
+//3 components in half floats, and the 4th one
+static void packHalf4(const glm::vec3 &value, float w, unsigned short packed[4]){
+    for(int c = 0; c < 3; c++){
+        packed[c] = glm::packHalf1x16(value[c]);
+    }
+    packed[3] = glm::packHalf1x16(w);
+}
+
+LightBaker::LightBaker(ThreadPool &pool) : pool(pool){
+    rayOffset = 0.f;
+    occlusionDistance = 0.f;
+    vertexCount = 0;
+    rays = 0;
+    bakeTime = 0.0;
+    fromCache = false;
+}
+
+LightBaker::LightBaker() : LightBaker(ThreadPool::global()){
+}
+
+void LightBaker::bake(SceneObjects &objects, const LightingInformation &lightingInformation){
+    std::vector<const Mesh*> meshes;
+    std::vector<glm::mat4> modelMatrices;
+    for(unsigned int object = 0; object < objects.size(); object++){
+        for(const Mesh &mesh : objects.model(object).model->meshes){
+            meshes.push_back(&mesh);
+            modelMatrices.push_back(objects.worldMatrix(object));
+        }
+    }
+    std::vector<std::vector<BakedLighting>> baked;
+    bake(meshes, modelMatrices, lightingInformation, baked);
+    //the objects of a file share its model, each one keeps the lighting of its meshes
+    size_t m = 0;
+    for(unsigned int object = 0; object < objects.size(); object++){
+        ModelInformation &modelInfo = objects.model(object);
+        modelInfo.bakedLighting.resize(modelInfo.model->meshes.size());
+        for(std::vector<BakedLighting> &lighting : modelInfo.bakedLighting){
+            lighting = std::move(baked[m++]);
+        }
+        modelInfo.bakedLightingId = ++lastLightingId;
+        modelInfo.material.bakedLighting = true;
+    }
+}
+
+void LightBaker::bake(const std::vector<const Mesh*> &meshes, const std::vector<glm::mat4> &modelMatrices,
+                      const LightingInformation &lightingInformation, std::vector<std::vector<BakedLighting>> &baked){
+    auto start = std::chrono::steady_clock::now();
+    lighting = lightingInformation;
+    positions.clear();
+    normals.clear();
+    indices.clear();
+    rays = 0;
+    fromCache = false;
+
+    //the vertices of every mesh and the full detail triangles, in the world
+    for(size_t m = 0; m < meshes.size(); m++){
+        const Mesh &mesh = *meshes[m];
+        const glm::mat4 &model = modelMatrices[m];
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+        unsigned int firstVertex = positions.size();
+        for(const ::Vertex &vertex : mesh.vertices){
+            positions.push_back(glm::vec3(model * glm::vec4(vertex.Position, 1.f)));
+            glm::vec3 normal = normalMatrix * vertex.Normal;
+            normals.push_back(glm::length(normal) > 0.f ? glm::normalize(normal) : normal);
+        }
+        const MeshLod &level = mesh.getLod(0);
+        for(unsigned int i = level.indexOffset; i < level.indexOffset + level.indexCount; i++){
+            indices.push_back(firstVertex + mesh.indices[i]);
+        }
+    }
+    vertexCount = positions.size();
+
+    std::string path = cachePath(meshes);
+    if(!path.empty() && loadCache(path, meshes, baked)){
+        fromCache = true;
+        bakeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return;
+    }
+
+    //only the rays need the BVH
+    if(shadows || ambientOcclusionSamples > 0){
+        bvh.build(positions, indices, pool);
+        float diagonal = glm::length(bvh.boundsMax() - bvh.boundsMin());
+        //the vertices are shared by the triangles around them, so the offset is bigger than the one of the path tracer
+        rayOffset = 1e-4f * diagonal + 1e-6f;
+        occlusionDistance = LIGHT_BAKE_AO_DISTANCE * diagonal;
+    }
+
+    std::vector<BakedLighting> vertexLighting(vertexCount);
+    int chunks = (vertexCount + LIGHT_BAKE_GRAIN - 1) / LIGHT_BAKE_GRAIN;
+    std::vector<size_t> chunkRays(chunks, 0);
+    pool.parallelFor(0, chunks, 1, [&](int begin, int end){
+        for(int chunk = begin; chunk < end; chunk++){
+            size_t last = std::min<size_t>((size_t) (chunk + 1) * LIGHT_BAKE_GRAIN, vertexCount);
+            for(size_t v = (size_t) chunk * LIGHT_BAKE_GRAIN; v < last; v++){
+                unsigned int randomState = ambientocclusion::seed(v);
+                vertexLighting[v] = bakeVertex(positions[v], normals[v], randomState, chunkRays[chunk]);
+            }
+        }
+    });
+    for(size_t count : chunkRays){
+        rays += count;
+    }
+
+    baked.resize(meshes.size());
+    size_t firstVertex = 0;
+    for(size_t m = 0; m < meshes.size(); m++){
+        size_t count = meshes[m]->vertices.size();
+        baked[m].assign(vertexLighting.begin() + firstVertex, vertexLighting.begin() + firstVertex + count);
+        firstVertex += count;
+    }
+    if(!path.empty()){
+        saveCache(path, baked);
+    }
+    bakeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+BakedLighting LightBaker::bakeVertex(const glm::vec3 &position, const glm::vec3 &normal, unsigned int randomState,
+                                     size_t &rayCount) const{
+    glm::vec3 surface = position + normal * rayOffset;
+
+    //fraction of the cosine weighted hemisphere that isn't blocked by the triangles nearby
+    float visibility = 1.f;
+    if(ambientOcclusionSamples > 0 && glm::length(normal) > 0.f){
+        visibility = ambientocclusion::visibility(bvh, surface, normal, ambientOcclusionSamples, occlusionDistance, randomState);
+        rayCount += ambientOcclusionSamples;
+    }
+
+    //the terms of CalcPointLight without the colors of the material. Without lights the shaders use the color
+    //of the material itself
+    glm::vec3 diffuse(lighting.pointLights.empty() ? 1.f : 0.f);
+    glm::vec3 specular(0.f);
+    glm::vec3 direction(0.f);
+    for(const PointLight &light : lighting.pointLights){
+        glm::vec3 toLight = light.position - position;
+        float distance = glm::length(toLight);
+        //as in the clustered shading, the lights don't reach past their radius
+        if(distance >= light.radius){
+            continue;
+        }
+        float attenuation = 1.f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+        diffuse += POINT_LIGHT_KA * light.ambient * attenuation * visibility;
+
+        glm::vec3 lightDirection = distance > 0.f ? toLight / distance : normal;
+        float cosine = glm::dot(normal, lightDirection);
+        if(cosine <= 0.f){
+            continue;
+        }
+        if(shadows){
+            rayCount++;
+            if(bvh.occluded(surface, light.position - surface, 1.f)){
+                continue;
+            }
+        }
+        diffuse += POINT_LIGHT_KD * light.diffuse * cosine * attenuation;
+        glm::vec3 lightSpecular = POINT_LIGHT_KS * light.specular * attenuation;
+        specular += lightSpecular;
+        direction += lightDirection * (lightSpecular.x + lightSpecular.y + lightSpecular.z);
+    }
+    direction = glm::length(direction) > 0.f ? glm::normalize(direction) : normal;
+
+    BakedLighting baked;
+    packHalf4(diffuse, visibility, baked.Diffuse);
+    packHalf4(specular, 0.f, baked.Specular);
+    packHalf4(direction, 0.f, baked.LightDirection);
+    return baked;
+}
+
+std::string LightBaker::cachePath(const std::vector<const Mesh*> &meshes) const{
+    if(cacheDirectory.empty()){
+        return "";
+    }
+
+    //FNV-1a of everything that changes the result
+    unsigned long long hash = 14695981039346656037ULL;
+    auto add = [&hash](const void *data, size_t size){
+        const unsigned char *bytes = (const unsigned char*) data;
+        for(size_t i = 0; i < size; i++){
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    unsigned int version = LIGHT_BAKE_VERSION;
+    add(&version, sizeof(version));
+    add(&shadows, sizeof(shadows));
+    add(&ambientOcclusionSamples, sizeof(ambientOcclusionSamples));
+    for(const Mesh *mesh : meshes){
+        unsigned int count = mesh->vertices.size();
+        add(&count, sizeof(count));
+    }
+    add(positions.data(), positions.size() * sizeof(glm::vec3));
+    add(normals.data(), normals.size() * sizeof(glm::vec3));
+    add(indices.data(), indices.size() * sizeof(unsigned int));
+    for(const PointLight &light : lighting.pointLights){
+        float values[] = {light.position.x, light.position.y, light.position.z, light.constant, light.linear,
+                          light.quadratic, light.ambient.x, light.ambient.y, light.ambient.z, light.diffuse.x,
+                          light.diffuse.y, light.diffuse.z, light.specular.x, light.specular.y, light.specular.z,
+                          light.radius};
+        add(values, sizeof(values));
+    }
+
+    std::ostringstream path;
+    path << cacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return path.str();
+}
+
+bool LightBaker::loadCache(const std::string &path, const std::vector<const Mesh*> &meshes,
+                           std::vector<std::vector<BakedLighting>> &baked) const{
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open()){
+        return false;
+    }
+
+    //header: magic, version and number of meshes, then the vertex count and the lighting of each mesh
+    unsigned int header[3];
+    file.read((char*) header, sizeof(header));
+    if(!file || header[0] != LIGHT_BAKE_MAGIC || header[1] != LIGHT_BAKE_VERSION || header[2] != meshes.size()){
+        return false;
+    }
+    std::vector<std::vector<BakedLighting>> loaded(meshes.size());
+    for(size_t m = 0; m < meshes.size(); m++){
+        unsigned int count;
+        file.read((char*) &count, sizeof(count));
+        if(!file || count != meshes[m]->vertices.size()){
+            return false;
+        }
+        loaded[m].resize(count);
+        file.read((char*) loaded[m].data(), count * sizeof(BakedLighting));
+        if(!file){
+            return false;
+        }
+    }
+    baked = std::move(loaded);
+    return true;
+}
+
+void LightBaker::saveCache(const std::string &path, const std::vector<std::vector<BakedLighting>> &baked) const{
+    std::error_code error;
+    std::filesystem::create_directories(cacheDirectory, error);
+    std::ofstream file(path, std::ios::binary);
+    if(!file.is_open()){
+        std::cerr << "ERROR::LIGHTBAKER::CACHE_NOT_WRITABLE " << path << std::endl;
+        return;
+    }
+    unsigned int header[3] = {LIGHT_BAKE_MAGIC, LIGHT_BAKE_VERSION, (unsigned int) baked.size()};
+    file.write((const char*) header, sizeof(header));
+    for(const std::vector<BakedLighting> &lighting : baked){
+        unsigned int count = lighting.size();
+        file.write((const char*) &count, sizeof(count));
+        file.write((const char*) lighting.data(), count * sizeof(BakedLighting));
+    }
+}
+
+size_t LightBaker::vertices() const{
+    return vertexCount;
+}
+
+size_t LightBaker::raysTraced() const{
+    return rays;
+}
+
+double LightBaker::bakeMilliseconds() const{
+    return bakeTime;
+}
+
+bool LightBaker::loadedFromCache() const{
+    return fromCache;
+}
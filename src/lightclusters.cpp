@@ -0,0 +1,285 @@
+#include <lightclusters.hpp>
+#include <graphicslib.hpp>
+#include <matrixlib.hpp>
+#include <shader.hpp>
+#include <threadpool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define NUMBER_OF_CLUSTERS (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+
+// distance to the near plane of a depth slice (the first one starts at the camera)
+static float sliceNear(int slice){
+    if(slice == 0)
+        return 0.f;
+    return CLUSTER_NEAR * std::pow(CLUSTER_FAR / CLUSTER_NEAR, (float) slice / CLUSTER_GRID_Z);
+}
+
+// view space x and y of the point with this normalized device x and y at the view depth z.
+// Solves the 2 lines of the projection (row major) that give x_ndc and y_ndc
+static void unproject(const float* p, float xNdc, float yNdc, float z, float &x, float &y){
+    float a11 = p[0] - xNdc * p[12];
+    float a12 = p[1] - xNdc * p[13];
+    float b1 = xNdc * (p[14] * z + p[15]) - (p[2] * z + p[3]);
+    float a21 = p[4] - yNdc * p[12];
+    float a22 = p[5] - yNdc * p[13];
+    float b2 = yNdc * (p[14] * z + p[15]) - (p[6] * z + p[7]);
+    float det = a11 * a22 - a12 * a21;
+    x = (b1 * a22 - a12 * b2) / det;
+    y = (a11 * b2 - b1 * a21) / det;
+}
+
+LightClusters::LightClusters(){
+    clustersPerSlicePadded = (CLUSTER_GRID_X * CLUSTER_GRID_Y + 3) & ~3;
+    int paddedSize = clustersPerSlicePadded * CLUSTER_GRID_Z;
+    minX.resize(paddedSize); minY.resize(paddedSize); minZ.resize(paddedSize);
+    maxX.resize(paddedSize); maxY.resize(paddedSize); maxZ.resize(paddedSize);
+    boxesBuilt = false;
+
+    clusterLists.resize(NUMBER_OF_CLUSTERS);
+    clusterRanges.resize(2 * NUMBER_OF_CLUSTERS, 0);
+
+    viewportWidth = 1;
+    viewportHeight = 1;
+    numberOfLights = 0;
+
+    glGenBuffers(1, &lightDataBuffer);
+    glGenBuffers(1, &clusterRangesBuffer);
+    glGenBuffers(1, &lightIndicesBuffer);
+    glGenTextures(1, &lightDataTexture);
+    glGenTextures(1, &clusterRangesTexture);
+    glGenTextures(1, &lightIndicesTexture);
+
+    // the buffers need a data store before they're attached to the textures
+    upload(lightDataBuffer, lightData);
+    upload(clusterRangesBuffer, clusterRanges);
+    upload(lightIndicesBuffer, lightIndices);
+
+    glBindTexture(GL_TEXTURE_BUFFER, lightDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightDataBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, clusterRangesTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, clusterRangesBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, lightIndicesTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, lightIndicesBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+LightClusters::~LightClusters(){
+    glDeleteTextures(1, &lightDataTexture);
+    glDeleteTextures(1, &clusterRangesTexture);
+    glDeleteTextures(1, &lightIndicesTexture);
+    glDeleteBuffers(1, &lightDataBuffer);
+    glDeleteBuffers(1, &clusterRangesBuffer);
+    glDeleteBuffers(1, &lightIndicesBuffer);
+}
+
+float LightClusters::pointLightRadius(const graphicslib::PointLight &light){
+    // brightest contribution of the light before the attenuation
+    auto maxComponent = [](const glm::vec3 &v){ return std::max(v.x, std::max(v.y, v.z)); };
+    float intensity = POINT_LIGHT_KA * maxComponent(light.ambient)
+                    + POINT_LIGHT_KD * maxComponent(light.diffuse)
+                    + POINT_LIGHT_KS * maxComponent(light.specular);
+
+    // solve constant + linear*d + quadratic*d^2 = intensity/cutoff
+    float k = intensity / LIGHT_CUTOFF_INTENSITY;
+    if(k <= light.constant)
+        return 0.f;
+    if(light.quadratic > 0.f)
+        return (-light.linear + std::sqrt(light.linear * light.linear + 4.f * light.quadratic * (k - light.constant)))
+               / (2.f * light.quadratic);
+    if(light.linear > 0.f)
+        return (k - light.constant) / light.linear;
+    return std::numeric_limits<float>::infinity();
+}
+
+void LightClusters::buildClusterBoxes(const float* p){
+    for(int slice = 0; slice < CLUSTER_GRID_Z; slice++){
+        // the view space z is negative in front of the camera
+        float zNear = -sliceNear(slice);
+        float zFar = -sliceNear(slice + 1);
+        for(int ty = 0; ty < CLUSTER_GRID_Y; ty++){
+            for(int tx = 0; tx < CLUSTER_GRID_X; tx++){
+                int index = slice * clustersPerSlicePadded + ty * CLUSTER_GRID_X + tx;
+                float boxMin[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), zFar };
+                float boxMax[3] = { -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), zNear };
+                // the 8 corners of the cluster
+                for(int corner = 0; corner < 8; corner++){
+                    float xNdc = -1.f + 2.f * (tx + (corner & 1)) / CLUSTER_GRID_X;
+                    float yNdc = -1.f + 2.f * (ty + ((corner >> 1) & 1)) / CLUSTER_GRID_Y;
+                    float z = (corner & 4) ? zFar : zNear;
+                    float x, y;
+                    unproject(p, xNdc, yNdc, z, x, y);
+                    boxMin[0] = std::min(boxMin[0], x); boxMax[0] = std::max(boxMax[0], x);
+                    boxMin[1] = std::min(boxMin[1], y); boxMax[1] = std::max(boxMax[1], y);
+                }
+                minX[index] = boxMin[0]; minY[index] = boxMin[1]; minZ[index] = boxMin[2];
+                maxX[index] = boxMax[0]; maxY[index] = boxMax[1]; maxZ[index] = boxMax[2];
+            }
+        }
+        // padding, the lights found in it are ignored
+        for(int i = CLUSTER_GRID_X * CLUSTER_GRID_Y; i < clustersPerSlicePadded; i++){
+            int index = slice * clustersPerSlicePadded + i;
+            minX[index] = minY[index] = minZ[index] = std::numeric_limits<float>::max();
+            maxX[index] = maxY[index] = maxZ[index] = std::numeric_limits<float>::max();
+        }
+    }
+    boxesBuilt = true;
+}
+
+void LightClusters::update(ml::matrix<float> &view, ml::matrix<float> &projection,
+                           const graphicslib::LightingInformation &lightingInformation, int width, int height){
+    viewportWidth = std::max(width, 1);
+    viewportHeight = std::max(height, 1);
+    numberOfLights = lightingInformation.numberOfPointLights;
+
+    // the matrices are sent to the shaders without transposing, so the ones OpenGL uses are their transposes
+    float** v = view.getMatrix();
+    float** sentProjection = projection.getMatrix();
+    float p[16];
+    for(int row = 0; row < 4; row++)
+        for(int col = 0; col < 4; col++)
+            p[row * 4 + col] = sentProjection[col][row];
+
+    // the boxes only depend on the projection
+    if(!boxesBuilt || !std::equal(p, p + 16, cachedProjection)){
+        std::copy(p, p + 16, cachedProjection);
+        buildClusterBoxes(p);
+    }
+
+    // light data for the shaders and the light positions in view space
+    lightData.resize(16 * numberOfLights);
+    std::vector<float> lightX(numberOfLights), lightY(numberOfLights), lightZ(numberOfLights), lightRadius(numberOfLights);
+    for(int i = 0; i < numberOfLights; i++){
+        const graphicslib::PointLight &light = lightingInformation.pointLights[i];
+        float* data = &lightData[16 * i];
+        data[0] = light.position.x; data[1] = light.position.y; data[2] = light.position.z; data[3] = light.constant;
+        data[4] = light.ambient.r; data[5] = light.ambient.g; data[6] = light.ambient.b; data[7] = light.linear;
+        data[8] = light.diffuse.r; data[9] = light.diffuse.g; data[10] = light.diffuse.b; data[11] = light.quadratic;
+        data[12] = light.specular.r; data[13] = light.specular.g; data[14] = light.specular.b; data[15] = light.radius;
+
+        const glm::vec3 &pos = light.position;
+        lightX[i] = v[0][0] * pos.x + v[1][0] * pos.y + v[2][0] * pos.z + v[3][0];
+        lightY[i] = v[0][1] * pos.x + v[1][1] * pos.y + v[2][1] * pos.z + v[3][1];
+        lightZ[i] = v[0][2] * pos.x + v[1][2] * pos.y + v[2][2] * pos.z + v[3][2];
+        lightRadius[i] = light.radius;
+    }
+
+    // each slice is binned by one thread
+    ThreadPool::global().parallelFor(0, CLUSTER_GRID_Z, 1, [&](int firstSlice, int lastSlice){
+        for(int slice = firstSlice; slice < lastSlice; slice++){
+            int clusterBase = slice * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+            int boxBase = slice * clustersPerSlicePadded;
+            for(int i = 0; i < CLUSTER_GRID_X * CLUSTER_GRID_Y; i++)
+                clusterLists[clusterBase + i].clear();
+
+            float zNear = -sliceNear(slice);
+            float zFar = -sliceNear(slice + 1);
+
+            for(int light = 0; light < numberOfLights; light++){
+                float radius = lightRadius[light];
+                // skip the lights that don't reach the slice
+                if(lightZ[light] - radius > zNear || lightZ[light] + radius < zFar)
+                    continue;
+                float radius2 = radius * radius;
+
+#ifdef __SSE2__
+                // sphere against 4 boxes at once: squared distance from the center to each box
+                __m128 cx = _mm_set1_ps(lightX[light]);
+                __m128 cy = _mm_set1_ps(lightY[light]);
+                __m128 cz = _mm_set1_ps(lightZ[light]);
+                __m128 r2 = _mm_set1_ps(radius2);
+                __m128 zero = _mm_setzero_ps();
+                for(int i = 0; i < clustersPerSlicePadded; i += 4){
+                    int b = boxBase + i;
+                    __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minX[b]), cx), zero),
+                                           _mm_max_ps(_mm_sub_ps(cx, _mm_loadu_ps(&maxX[b])), zero));
+                    __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minY[b]), cy), zero),
+                                           _mm_max_ps(_mm_sub_ps(cy, _mm_loadu_ps(&maxY[b])), zero));
+                    __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&minZ[b]), cz), zero),
+                                           _mm_max_ps(_mm_sub_ps(cz, _mm_loadu_ps(&maxZ[b])), zero));
+                    __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                    int mask = _mm_movemask_ps(_mm_cmple_ps(distance2, r2));
+                    while(mask){
+                        int lane = __builtin_ctz(mask);
+                        mask &= mask - 1;
+                        if(i + lane < CLUSTER_GRID_X * CLUSTER_GRID_Y)
+                            clusterLists[clusterBase + i + lane].push_back(light);
+                    }
+                }
+#else
+                for(int i = 0; i < CLUSTER_GRID_X * CLUSTER_GRID_Y; i++){
+                    int b = boxBase + i;
+                    float dx = std::max(minX[b] - lightX[light], 0.f) + std::max(lightX[light] - maxX[b], 0.f);
+                    float dy = std::max(minY[b] - lightY[light], 0.f) + std::max(lightY[light] - maxY[b], 0.f);
+                    float dz = std::max(minZ[b] - lightZ[light], 0.f) + std::max(lightZ[light] - maxZ[b], 0.f);
+                    if(dx * dx + dy * dy + dz * dz <= radius2)
+                        clusterLists[clusterBase + i].push_back(light);
+                }
+#endif
+            }
+        }
+    });
+
+    // put the lists one after the other
+    unsigned int offset = 0;
+    for(int i = 0; i < NUMBER_OF_CLUSTERS; i++){
+        clusterRanges[2 * i] = offset;
+        clusterRanges[2 * i + 1] = clusterLists[i].size();
+        offset += clusterLists[i].size();
+    }
+    lightIndices.resize(offset);
+    for(int i = 0; i < NUMBER_OF_CLUSTERS; i++)
+        std::copy(clusterLists[i].begin(), clusterLists[i].end(), lightIndices.begin() + clusterRanges[2 * i]);
+
+    upload(lightDataBuffer, lightData);
+    upload(clusterRangesBuffer, clusterRanges);
+    upload(lightIndicesBuffer, lightIndices);
+}
+
+void LightClusters::bind(Shader &shader) const{
+    glActiveTexture(GL_TEXTURE0 + LIGHT_DATA_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, lightDataTexture);
+    glActiveTexture(GL_TEXTURE0 + CLUSTER_LIGHTS_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, clusterRangesTexture);
+    glActiveTexture(GL_TEXTURE0 + LIGHT_INDICES_UNIT);
+    glBindTexture(GL_TEXTURE_BUFFER, lightIndicesTexture);
+    glActiveTexture(GL_TEXTURE0);
+
+    shader.setInt("lightData", LIGHT_DATA_UNIT);
+    shader.setInt("clusterLights", CLUSTER_LIGHTS_UNIT);
+    shader.setInt("lightIndices", LIGHT_INDICES_UNIT);
+    glUniform3i(glGetUniformLocation(shader.ID, "clusterGridSize"), CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
+    shader.setVec2("clusterViewport", (float) viewportWidth, (float) viewportHeight);
+    // slice = log(depth) * scale - bias, the inverse of sliceNear
+    float scale = CLUSTER_GRID_Z / std::log(CLUSTER_FAR / CLUSTER_NEAR);
+    shader.setFloat("clusterSliceScale", scale);
+    shader.setFloat("clusterSliceBias", std::log(CLUSTER_NEAR) * scale);
+    shader.setInt("numberOfPointLights", numberOfLights);
+}
+
+float LightClusters::averageLightsPerCluster() const{
+    int usedClusters = 0;
+    for(int i = 0; i < NUMBER_OF_CLUSTERS; i++)
+        if(clusterRanges[2 * i + 1] > 0)
+            usedClusters++;
+    return usedClusters ? (float) lightIndices.size() / usedClusters : 0.f;
+}
+
+template<class T>
+void LightClusters::upload(GLuint buffer, const std::vector<T> &data){
+    glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+    // a new data store every time, the driver doesn't wait for the frames using the old one
+    if(data.empty()){
+        T empty = T();
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(T), &empty, GL_STREAM_DRAW);
+    }else{
+        glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(T), data.data(), GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
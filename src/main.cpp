@@ -1,9 +1,25 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <string>
 
 
 #include <graphicslib.hpp>
 #include <utils.hpp>
 #include <tester.hpp>
+#include <mesh.hpp>
+#include <model.hpp>
+#include <camera.hpp>
+#include <environmentlighting.hpp>
+#include <lightbaker.hpp>
+#include <pathtracer.hpp>
+#include <scenesnapshot.hpp>
+#include <softwarerenderer.hpp>
+#include <texturecompressor.hpp>
+#include <texturestreamer.hpp>
+#include <threadpool.hpp>
 
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 800
@@ -11,6 +27,194 @@
 #define COLS 2
 
 int main(int argc, char *argv[]) {
+    std::string mode;
+    int samples = PATH_TRACER_SAMPLES;
+    bool highQuality = false;
+    for(int i = 1; i < argc; i++){
+        std::string argument = argv[i];
+        //options of the model import
+        if(argument == "--compress-vertices"){
+            Mesh::compressVertices = true;
+        }else if(argument == "--keep-triangle-order"){
+            Model::optimizeMeshes = false;
+        }else if(argument == "--ao-samples" && i + 1 < argc){
+            Model::ambientOcclusionSamples = std::max(std::atoi(argv[++i]), 0);
+        }else if(argument == "--raw-textures"){
+            Model::conditionedTextures = false;
+        }else if(argument == "--texture-arrays"){
+            Model::textureArrays = true;
+        }else if(argument == "--resident-textures"){
+            TextureStreamer::enabled = false;
+        }else if(argument == "--texture-budget" && i + 1 < argc){
+            TextureStreamer::budget = (size_t) std::max(std::atoi(argv[++i]), 1) << 20;
+        //BC7 instead of BC1 and BC3 for the colors of --condition-textures
+        }else if(argument == "--bc7"){
+            highQuality = true;
+        //options of the light baking
+        }else if(argument == "--bake-without-shadows"){
+            LightBaker::shadows = false;
+        }else if(argument == "--bake-ao" && i + 1 < argc){
+            LightBaker::ambientOcclusionSamples = std::max(std::atoi(argv[++i]), 0);
+        //options of the scene snapshot
+        }else if(argument == "--write-snapshot"){
+            SceneSnapshot::writeAfterLoad = true;
+        }else if(argument == "--no-snapshot"){
+            SceneSnapshot::enabled = false;
+        //samples per pixel of --render
+        }else if(argument == "--samples" && i + 1 < argc){
+            samples = std::max(std::atoi(argv[++i]), 1);
+        }else{
+            mode = argument;
+        }
+    }
+
+    //run the tests instead of the application
+    if(mode == "--test"){
+        tester::multiplicationTest();
+        tester::inverseTest();
+        tester::determinantTest();
+        tester::solveTest();
+        tester::normalMatrixTest();
+        tester::lightRadiusTest();
+        tester::meshOptimizationTest();
+        tester::simplificationTest();
+        tester::meshletTest();
+        tester::rangeAllocatorTest();
+        tester::weldTest();
+        tester::tangentSpaceTest();
+        tester::octahedralEncodingTest();
+        tester::softwareRasterizerTest();
+        tester::bvhTest();
+        tester::pathTracerTest();
+        tester::lightBakingTest();
+        tester::ambientOcclusionTest();
+        tester::environmentLightingTest();
+        tester::textureCompressionTest();
+        tester::textureStreamingTest();
+        tester::textureArrayTest();
+        tester::sceneFileTest();
+        tester::sceneSnapshotTest();
+        tester::sceneObjectsTest();
+        //make tests fails when a check does
+        return tester::failedChecks() ? EXIT_FAILURE : 0;
+    }
+
+    //run the benchmarks instead of the application
+    if(mode == "--benchmark"){
+        tester::multiplicationBenchmark();
+        tester::meshOptimizationBenchmark();
+        tester::meshletBenchmark();
+        tester::importBenchmark();
+        tester::softwareRendererBenchmark();
+        tester::pathTracerBenchmark();
+        tester::lightBakingBenchmark();
+        tester::environmentLightingBenchmark();
+        tester::textureCompressionBenchmark();
+        tester::sceneFileBenchmark();
+        tester::sceneSnapshotBenchmark();
+        tester::sceneObjectsBenchmark();
+        return 0;
+    }
+
+    //render the scene on the CPU to an image per shading, without a window
+    if(mode == "--software"){
+        Mesh::uploadToGpu = false;
+        graphicslib::LightingInformation lightingInformation;
+        SceneObjects objects;
+        Camera camera;
+        graphicslib::readScene(SCENE_FILE, lightingInformation, objects, camera);
+        SoftwareRenderer renderer(WINDOW_WIDTH, WINDOW_HEIGHT);
+        for(graphicslib::ShadingMode shading : {graphicslib::PHONG_SHADING, graphicslib::GOURAUD_SHADING}){
+            std::string path = shading == graphicslib::PHONG_SHADING ? "software_phong.ppm" : "software_gouraud.ppm";
+            auto start = std::chrono::steady_clock::now();
+            renderer.render(objects, lightingInformation, camera, shading);
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if(renderer.writeImage(path)){
+                std::cout << path << ": " << renderer.trianglesSubmitted() << " triangles ("
+                          << renderer.trianglesRasterized() << " rasterized), " << renderer.fragmentsShaded()
+                          << " fragments in " << milliseconds << " ms" << std::endl;
+            }
+        }
+        return 0;
+    }
+
+    //path trace the scene, the image is written after every pass until it has all the samples
+    if(mode == "--render"){
+        Mesh::uploadToGpu = false;
+        graphicslib::LightingInformation lightingInformation;
+        SceneObjects objects;
+        Camera camera;
+        graphicslib::readScene(SCENE_FILE, lightingInformation, objects, camera);
+        PathTracer tracer(WINDOW_WIDTH, WINDOW_HEIGHT);
+        tracer.setScene(objects, lightingInformation, camera);
+        std::cout << "BVH of " << tracer.getBvh().numberOfTriangles() << " triangles built in "
+                  << tracer.buildMilliseconds() << " ms" << std::endl;
+        while(tracer.samples() < samples){
+            auto start = std::chrono::steady_clock::now();
+            tracer.addSamples(std::min(PATH_TRACER_PASS_SAMPLES, samples - tracer.samples()));
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            tracer.writeImage("render.ppm");
+            std::cout << "render.ppm: " << tracer.samples() << "/" << samples << " samples, "
+                      << tracer.raysTraced() / (milliseconds * 1000.0) << " Mrays/s" << std::endl;
+        }
+        return 0;
+    }
+
+    //compute the image based lighting of the bundled HDR image, or load it from the cache
+    if(mode == "--ibl"){
+        EnvironmentLighting lighting;
+        if(!lighting.load(ENVIRONMENT_MAP_FILE)){
+            return 1;
+        }
+        const EnvironmentLighting::Timings &timings = lighting.timings();
+        if(lighting.loadedFromCache()){
+            std::cout << ENVIRONMENT_MAP_FILE << ": loaded from the cache in " << timings.total << " ms" << std::endl;
+        }else{
+            std::cout << ENVIRONMENT_MAP_FILE << ": cube map in " << timings.cube << " ms, irradiance in "
+                      << timings.irradiance << " ms, " << lighting.prefilteredLevels().size() << " prefiltered levels in "
+                      << timings.prefilter << " ms, BRDF table in " << timings.brdf << " ms, " << timings.total
+                      << " ms in all" << std::endl;
+        }
+        return 0;
+    }
+
+    //compress the textures of the scene into the files that the models load instead of the images
+    if(mode == "--condition-textures"){
+        Mesh::uploadToGpu = false;
+        Model::ambientOcclusionSamples = 0;
+        graphicslib::LightingInformation lightingInformation;
+        SceneObjects objects;
+        Camera camera;
+        graphicslib::readScene(SCENE_FILE, lightingInformation, objects, camera);
+        const char *formats[] = {"BC1", "BC3", "BC4", "BC5", "BC7"};
+        std::error_code error;
+        std::filesystem::create_directories(texturecompressor::cacheDirectory, error);
+        for(unsigned int object = 0; object < objects.size(); object++){
+            const Model &model = *objects.model(object).model;
+            for(const Texture &texture : model.textures_loaded){
+                std::string filename = model.directory + '/' + texture.path;
+                texturecompressor::TextureKind kind = texturecompressor::kindOf(texture.type);
+                texturecompressor::CompressedTexture compressed;
+                auto start = std::chrono::steady_clock::now();
+                if(!texturecompressor::compress(filename, kind, highQuality, compressed, ThreadPool::global())){
+                    std::cerr << "ERROR::TEXTURECOMPRESSOR::FILE_NOT_READ " << filename << std::endl;
+                    continue;
+                }
+                double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                std::string path = texturecompressor::containerPath(filename, kind);
+                if(!texturecompressor::writeContainer(path, compressed)){
+                    std::cerr << "ERROR::TEXTURECOMPRESSOR::CACHE_NOT_WRITABLE " << path << std::endl;
+                    continue;
+                }
+                const texturecompressor::CompressedTexture::Level &first = compressed.levels[0];
+                std::cout << filename << ": " << first.width << "x" << first.height << " " << formats[compressed.format]
+                          << ", " << compressed.levels.size() << " levels, " << compressed.bytes() / 1024 << " KB instead of "
+                          << (size_t) first.width * first.height * 16 / 3 / 1024 << " KB in " << milliseconds << " ms" << std::endl;
+            }
+        }
+        return 0;
+    }
+
     graphicslib::Window window(WINDOW_WIDTH, WINDOW_HEIGHT);
     window.createWindow();
     window.run();
@@ -0,0 +1,41 @@
+// the textures of the material, shared by the fragment shaders of the lit passes.
+// TEXTURE_ARRAYS: the textures are layers of texture arrays (Model::textureArrays), the layers of the diffuse and
+// the specular textures come from the vertices
+
+#ifdef HAS_TEX_COORDS
+in vec2 TexCoords;
+#endif
+
+#ifdef TEXTURE_ARRAYS
+flat in vec2 TextureLayers;
+
+#ifdef HAS_DIFFUSE_TEX
+uniform sampler2DArray texture_diffuse1;
+
+vec4 DiffuseTexel(){
+    return texture(texture_diffuse1, vec3(TexCoords, TextureLayers.x));
+}
+#endif
+#ifdef HAS_SPECULAR_TEX
+uniform sampler2DArray texture_specular1;
+
+vec4 SpecularTexel(){
+    return texture(texture_specular1, vec3(TexCoords, TextureLayers.y));
+}
+#endif
+#else
+#ifdef HAS_DIFFUSE_TEX
+uniform sampler2D texture_diffuse1;
+
+vec4 DiffuseTexel(){
+    return texture(texture_diffuse1, TexCoords);
+}
+#endif
+#ifdef HAS_SPECULAR_TEX
+uniform sampler2D texture_specular1;
+
+vec4 SpecularTexel(){
+    return texture(texture_specular1, TexCoords);
+}
+#endif
+#endif
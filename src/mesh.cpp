@@ -1,22 +1,139 @@
 #include <glad/glad.h> // holds all OpenGL type declarations
 
 #include <mesh.hpp>
+#include <meshoptimizer.hpp>
 
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
 #include <string>
 
 using namespace std;
 
-Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+bool Mesh::splitVertexStreams = true;
+bool Mesh::compressVertices = false;
+bool Mesh::uploadToGpu = true;
+
+glm::vec3 Mesh::octahedralDecode(const short encoded[2])
+{
+    glm::vec2 e(std::max(encoded[0] / 32767.f, -1.f), std::max(encoded[1] / 32767.f, -1.f));
+    glm::vec3 v(e.x, e.y, 1.f - std::abs(e.x) - std::abs(e.y));
+    if(v.z < 0.f)
+    {
+        v.x = (1.f - std::abs(e.y)) * (e.x >= 0.f ? 1.f : -1.f);
+        v.y = (1.f - std::abs(e.x)) * (e.y >= 0.f ? 1.f : -1.f);
+    }
+    return glm::normalize(v);
+}
+
+// angle in degrees between two vectors
+static float angleBetween(const glm::vec3 &a, const glm::vec3 &b)
+{
+    float cosine = glm::dot(glm::normalize(a), glm::normalize(b));
+    return glm::degrees(std::acos(std::min(std::max(cosine, -1.f), 1.f)));
+}
+
+void Mesh::octahedralEncode(glm::vec3 v, short encoded[2])
+{
+    float length = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+    // a vector without direction is encoded as +Z, like the meshes without tangents keep an arbitrary one
+    if(!(length > 0.f))
+        v = glm::vec3(0.f, 0.f, 1.f);
+    else
+        v /= length;
+    glm::vec2 e(v.x, v.y);
+    if(v.z < 0.f)
+    {
+        e = glm::vec2((1.f - std::abs(v.y)) * (v.x >= 0.f ? 1.f : -1.f),
+                      (1.f - std::abs(v.x)) * (v.y >= 0.f ? 1.f : -1.f));
+    }
+    glm::vec3 original = glm::normalize(v);
+    float bestDistance = -2.f;
+    for(int i = 0; i < 4; i++)
+    {
+        short candidate[2];
+        candidate[0] = (short) ((i & 1) ? std::ceil(e.x * 32767.f) : std::floor(e.x * 32767.f));
+        candidate[1] = (short) ((i & 2) ? std::ceil(e.y * 32767.f) : std::floor(e.y * 32767.f));
+        float distance = glm::dot(original, octahedralDecode(candidate));
+        if(distance > bestDistance)
+        {
+            bestDistance = distance;
+            encoded[0] = candidate[0];
+            encoded[1] = candidate[1];
+        }
+    }
+}
+
+Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, vector<MeshLod> lods,
+           vector<Meshlet> meshlets)
 {
     this->vertices = vertices;
     this->indices = indices;
     this->textures = textures;
+    this->lods = lods;
+    if(this->lods.empty())
+        this->lods.push_back(MeshLod{0, (unsigned int) indices.size(), 0.f});
+    this->meshlets = meshlets;
+    hasBakedLighting = false;
+
+    // the areas of the full mesh, the other levels cover the same surface
+    double area = 0.0, uvArea = 0.0;
+    for(unsigned int i = this->lods[0].indexOffset; i + 2 < this->lods[0].indexOffset + this->lods[0].indexCount; i += 3)
+    {
+        const Vertex &a = this->vertices[this->indices[i]];
+        const Vertex &b = this->vertices[this->indices[i + 1]];
+        const Vertex &c = this->vertices[this->indices[i + 2]];
+        area += glm::length(glm::cross(b.Position - a.Position, c.Position - a.Position));
+        glm::vec2 u = b.TexCoords - a.TexCoords, v = c.TexCoords - a.TexCoords;
+        uvArea += std::abs(u.x * v.y - u.y * v.x);
+    }
+    uvDensity = area > 0.0 ? (float) std::sqrt(uvArea / area) : 0.f;
 
     // now that we have all the required data, set the vertex buffers and its attribute pointers.
     setupMesh();
 }
 
-void Mesh::Draw(Shader shader) 
+void Mesh::setBakedLighting(const vector<BakedLighting> &lighting)
+{
+    if(!uploadToGpu || lighting.size() != vertices.size())
+        return;
+    GeometryArena::global().uploadStream(geometry, BAKED_LIGHTING_STREAM, lighting.data());
+    hasBakedLighting = true;
+}
+
+void Mesh::setAmbientOcclusion(vector<float> occlusion)
+{
+    ambientOcclusion = occlusion;
+    if(uploadToGpu && ambientOcclusion.size() == vertices.size())
+        GeometryArena::global().uploadStream(geometry, AMBIENT_OCCLUSION_STREAM, ambientOcclusion.data());
+}
+
+void Mesh::setTextureLayers()
+{
+    if(!uploadToGpu)
+        return;
+    // the same layers in all the vertices, the shaders pick them up like the other attributes
+    unsigned short layers[2] = {0, 0};
+    for(int t = (int) textures.size() - 1; t >= 0; t--)
+    {
+        if(textures[t].layer < 0)
+            continue;
+        if(textures[t].type == "texture_diffuse")
+            layers[0] = textures[t].layer;
+        else if(textures[t].type == "texture_specular")
+            layers[1] = textures[t].layer;
+    }
+    vector<unsigned short> stream(vertices.size() * 2);
+    for(size_t v = 0; v < vertices.size(); v++)
+    {
+        stream[2 * v] = layers[0];
+        stream[2 * v + 1] = layers[1];
+    }
+    GeometryArena::global().uploadStream(geometry, TEXTURE_LAYER_STREAM, stream.data());
+}
+
+void Mesh::bindTextures(Shader &shader)
 {
     // bind appropriate textures
     unsigned int diffuseNr  = 1;
@@ -41,52 +158,245 @@ void Mesh::Draw(Shader shader)
                                                     // now set the sampler to the correct texture unit
         glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
         // and finally bind the texture
-        glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        glBindTexture(textures[i].layer < 0 ? GL_TEXTURE_2D : GL_TEXTURE_2D_ARRAY, textures[i].id);
     }
-    
+}
+
+void Mesh::Draw(Shader shader, unsigned int lod, const MeshletVisibility *visible)
+{
+    bindTextures(shader);
+    setDecoding(shader);
+
     // draw mesh
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(vertexArray());
+    drawElements(lod, visible);
     glBindVertexArray(0);
 
     // always good practice to set everything back to defaults once configured.
     glActiveTexture(GL_TEXTURE0);
 }
 
+void Mesh::DrawGeometry(Shader &shader, unsigned int lod, const MeshletVisibility *visible)
+{
+    setDecoding(shader);
+    glBindVertexArray(depthVertexArray());
+    drawElements(lod, visible);
+    glBindVertexArray(0);
+}
+
+void Mesh::drawElements(unsigned int lod, const MeshletVisibility *visible)
+{
+    drawCounts.clear();
+    drawOffsets.clear();
+    drawBaseVertices.clear();
+    appendDraws(lod, drawCounts, drawOffsets, drawBaseVertices, visible);
+    if(drawCounts.size() == 1)
+        glDrawElementsBaseVertex(GL_TRIANGLES, drawCounts[0], indexType, drawOffsets[0], geometry.baseVertex);
+    else if(!drawCounts.empty())
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), indexType, drawOffsets.data(), drawCounts.size(),
+                                      drawBaseVertices.data());
+}
+
+void Mesh::appendDraws(unsigned int lod, vector<GLsizei> &counts, vector<const void*> &offsets, vector<GLint> &baseVertices,
+                       const MeshletVisibility *visible)
+{
+    if(lod == 0 && visible && visible->culled)
+    {
+        counts.insert(counts.end(), visible->counts.begin(), visible->counts.end());
+        offsets.insert(offsets.end(), visible->offsets.begin(), visible->offsets.end());
+        baseVertices.insert(baseVertices.end(), visible->counts.size(), (GLint) geometry.baseVertex);
+        return;
+    }
+    const MeshLod &level = getLod(lod);
+    if(!level.indexCount)
+        return;
+    counts.push_back(level.indexCount);
+    offsets.push_back((void*)((geometry.firstIndex + level.indexOffset) * indexSize()));
+    baseVertices.push_back(geometry.baseVertex);
+}
+
+unsigned int Mesh::vertexArray() const
+{
+    return GeometryArena::global().vertexArray(geometry.page);
+}
+
+unsigned int Mesh::depthVertexArray() const
+{
+    return GeometryArena::global().depthVertexArray(geometry.page);
+}
+
+bool Mesh::sameDecoding(const Mesh &other) const
+{
+    return compressed == other.compressed && positionOffset == other.positionOffset && positionScale == other.positionScale;
+}
+
+size_t Mesh::cullMeshlets(const glm::vec3 &cameraPosition, const glm::vec4 planes[6], MeshletVisibility &visible) const
+{
+    visible.counts.clear();
+    visible.offsets.clear();
+    visible.culled = !meshlets.empty();
+    if(meshlets.empty())
+        return lods[0].indexCount / 3;
+    size_t triangles = 0;
+    // end of the last range, to merge the next meshlet into it
+    unsigned int rangeEnd = ~0u;
+    for(const Meshlet &meshlet : meshlets)
+    {
+        if(!meshoptimizer::meshletVisible(meshlet, cameraPosition, planes))
+            continue;
+        if(meshlet.indexOffset == rangeEnd)
+            visible.counts.back() += meshlet.indexCount;
+        else
+        {
+            visible.counts.push_back(meshlet.indexCount);
+            visible.offsets.push_back((void*)((geometry.firstIndex + meshlet.indexOffset) * indexSize()));
+        }
+        rangeEnd = meshlet.indexOffset + meshlet.indexCount;
+        triangles += meshlet.indexCount / 3;
+    }
+    return triangles;
+}
+
+size_t Mesh::vertexBytes() const
+{
+    size_t baked = (hasBakedLighting ? vertices.size() * sizeof(BakedLighting) : 0) + ambientOcclusion.size() * sizeof(float);
+    if(compressed)
+        return vertices.size() * (sizeof(CompressedPosition) + sizeof(CompressedAttributes)) + baked;
+    return vertices.size() * sizeof(Vertex) + baked;
+}
+
+const MeshLod& Mesh::getLod(unsigned int lod) const
+{
+    return lods[std::min<size_t>(lod, lods.size() - 1)];
+}
+
+size_t Mesh::indexBytes() const
+{
+    return indices.size() * indexSize();
+}
+
+size_t Mesh::indexSize() const
+{
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+}
+
+void Mesh::setDecoding(Shader &shader)
+{
+    if(compressed)
+    {
+        shader.setVec3("positionOffset", positionOffset);
+        shader.setVec3("positionScale", positionScale);
+    }
+}
+
+void Mesh::compress(vector<CompressedPosition> &positions, vector<CompressedAttributes> &attributes)
+{
+    // bounding box of the positions
+    glm::vec3 minimum(0.f), maximum(0.f);
+    if(!vertices.empty())
+        minimum = maximum = vertices[0].Position;
+    for(const Vertex &vertex : vertices)
+    {
+        minimum = glm::min(minimum, vertex.Position);
+        maximum = glm::max(maximum, vertex.Position);
+    }
+    positionOffset = minimum;
+    // flat boxes keep a size to avoid dividing by 0
+    positionScale = glm::max(maximum - minimum, glm::vec3(1e-20f));
+
+    positions.resize(vertices.size());
+    attributes.resize(vertices.size());
+    compressionError = CompressionError{0.f, 0.f, 0.f, 0.f};
+    for(unsigned int i = 0; i < vertices.size(); i++)
+    {
+        const Vertex &vertex = vertices[i];
+        CompressedPosition &position = positions[i];
+        CompressedAttributes &attribute = attributes[i];
+
+        glm::vec3 quantized = glm::round((vertex.Position - positionOffset) / positionScale * 65535.f);
+        for(int axis = 0; axis < 3; axis++)
+            position.Position[axis] = (unsigned short) quantized[axis];
+        // right handed when the bitangent is cross(normal, tangent)
+        bool rightHanded = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) >= 0.f;
+        position.Position[3] = rightHanded ? 65535 : 0;
+
+        octahedralEncode(vertex.Normal, attribute.Normal);
+        // meshes without tangents keep an arbitrary one
+        glm::vec3 tangent = glm::length(vertex.Tangent) > 0.f ? vertex.Tangent : glm::vec3(1.f, 0.f, 0.f);
+        octahedralEncode(tangent, attribute.Tangent);
+        attribute.TexCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+        attribute.TexCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+
+        // measure what the shaders will decode
+        glm::vec3 decodedPosition = positionOffset + quantized / 65535.f * positionScale;
+        glm::vec2 decodedTexCoords(glm::unpackHalf1x16(attribute.TexCoords[0]), glm::unpackHalf1x16(attribute.TexCoords[1]));
+        compressionError.position = std::max(compressionError.position, glm::length(decodedPosition - vertex.Position));
+        if(glm::length(vertex.Normal) > 0.f)
+            compressionError.normal = std::max(compressionError.normal, angleBetween(octahedralDecode(attribute.Normal), vertex.Normal));
+        if(glm::length(vertex.Tangent) > 0.f)
+            compressionError.tangent = std::max(compressionError.tangent, angleBetween(octahedralDecode(attribute.Tangent), vertex.Tangent));
+        compressionError.texCoords = std::max(compressionError.texCoords,
+                                              std::max(std::abs(decodedTexCoords.x - vertex.TexCoords.x),
+                                                       std::abs(decodedTexCoords.y - vertex.TexCoords.y)));
+    }
+}
+
 void Mesh::setupMesh()
 {
-    // create buffers/arrays
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    // load data into vertex buffers
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    // A great thing about structs is that their memory layout is sequential for all its items.
-    // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-    // again translates to 3/2 floats which translates to a byte array.
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-    // set the vertex attribute pointers
-    // vertex Positions
-    glEnableVertexAttribArray(0);	
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    // vertex normals
-    glEnableVertexAttribArray(1);	
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    // vertex texture coords
-    glEnableVertexAttribArray(2);	
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-    // vertex tangent
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-    // vertex bitangent
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+    // half the index memory and bandwidth when the vertices fit in 16 bits (the draws add the base vertex of the mesh)
+    indexType = vertices.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    vector<unsigned short> shortIndices;
+    const void *indexData = indices.data();
+    if(indexType == GL_UNSIGNED_SHORT)
+    {
+        shortIndices.assign(indices.begin(), indices.end());
+        indexData = shortIndices.data();
+    }
 
-    glBindVertexArray(0);
-}
\ No newline at end of file
+    compressed = compressVertices && uploadToGpu;
+    positionOffset = glm::vec3(0.f);
+    positionScale = glm::vec3(1.f);
+    compressionError = CompressionError{0.f, 0.f, 0.f, 0.f};
+
+    // nothing is allocated, freeing the empty allocation does nothing
+    if(!uploadToGpu)
+    {
+        geometry = GeometryAllocation{0, 0, 0, 0, 0};
+        return;
+    }
+
+    GeometryArena &arena = GeometryArena::global();
+    if(compressed)
+    {
+        vector<CompressedPosition> positions;
+        vector<CompressedAttributes> attributes;
+        compress(positions, attributes);
+        geometry = arena.allocate(COMPRESSED_VERTICES, indexType, vertices.size(), indices.size());
+        arena.upload(geometry, positions.data(), attributes.data(), indexData);
+    }
+    else if(splitVertexStreams)
+    {
+        // positions tightly packed
+        vector<glm::vec3> positions(vertices.size());
+        // the other attributes in the second stream
+        vector<VertexAttributes> attributes(vertices.size());
+        for(unsigned int i = 0; i < vertices.size(); i++)
+        {
+            positions[i] = vertices[i].Position;
+            attributes[i].Normal = vertices[i].Normal;
+            attributes[i].TexCoords = vertices[i].TexCoords;
+            attributes[i].Tangent = vertices[i].Tangent;
+            attributes[i].Bitangent = vertices[i].Bitangent;
+        }
+        geometry = arena.allocate(SPLIT_VERTICES, indexType, vertices.size(), indices.size());
+        arena.upload(geometry, positions.data(), attributes.data(), indexData);
+    }
+    else
+    {
+        // A great thing about structs is that their memory layout is sequential for all its items.
+        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+        // again translates to 3/2 floats which translates to a byte array.
+        geometry = arena.allocate(INTERLEAVED_VERTICES, indexType, vertices.size(), indices.size());
+        arena.upload(geometry, vertices.data(), NULL, indexData);
+    }
+}
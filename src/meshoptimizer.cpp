@@ -0,0 +1,901 @@
+#include <meshoptimizer.hpp>
+#include <threadpool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+namespace meshoptimizer {
+
+    VertexCacheStatistics::VertexCacheStatistics(){
+        transformedVertices = 0;
+        triangles = 0;
+        vertices = 0;
+    }
+
+    VertexCacheStatistics& VertexCacheStatistics::operator+=(const VertexCacheStatistics &other){
+        transformedVertices += other.transformedVertices;
+        triangles += other.triangles;
+        vertices += other.vertices;
+        return *this;
+    }
+
+    float VertexCacheStatistics::acmr() const{
+        return triangles ? (float) transformedVertices / triangles : 0.f;
+    }
+
+    float VertexCacheStatistics::atvr() const{
+        return vertices ? (float) transformedVertices / vertices : 0.f;
+    }
+
+    //number the distinct positions, the copies of a vertex on a seam or a crease get the same group
+    static size_t groupPositions(const std::vector<Vertex> &vertices, std::vector<unsigned int> &positionGroup){
+        auto hash = [](const glm::vec3 &p){
+            unsigned int bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return (size_t) (bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+        };
+        std::unordered_map<glm::vec3, unsigned int, decltype(hash)> groups(vertices.size(), hash);
+        positionGroup.resize(vertices.size());
+        for(size_t v = 0; v < vertices.size(); v++)
+            positionGroup[v] = groups.emplace(vertices[v].Position, (unsigned int) groups.size()).first->second;
+        return groups.size();
+    }
+
+    //the corners (positions in the index buffer) of each key, listed from offsets[key] to offsets[key + 1]
+    static void groupCorners(const std::vector<unsigned int> &cornerKeys, size_t keyCount,
+                             std::vector<unsigned int> &offsets, std::vector<unsigned int> &corners){
+        offsets.assign(keyCount + 1, 0);
+        for(unsigned int key : cornerKeys)
+            offsets[key + 1]++;
+        for(size_t k = 0; k < keyCount; k++)
+            offsets[k + 1] += offsets[k];
+        corners.resize(cornerKeys.size());
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for(size_t i = 0; i < cornerKeys.size(); i++)
+            corners[fill[cornerKeys[i]]++] = i;
+    }
+
+    //angle of the triangle at the corner a
+    static float cornerAngle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c){
+        glm::vec3 u = b - a, v = c - a;
+        float lengths = glm::length(u) * glm::length(v);
+        if(lengths <= 0.f)
+            return 0.f;
+        return std::acos(glm::clamp(glm::dot(u, v) / lengths, -1.f, 1.f));
+    }
+
+    //give each class of corners of a vertex its own copy of the vertex, sameClass(a, b) tells if the corners a and b
+    //can share one. Returns the number of vertices added
+    template<typename SameClass>
+    static size_t splitVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, SameClass sameClass){
+        std::vector<unsigned int> offsets, corners;
+        groupCorners(indices, vertices.size(), offsets, corners);
+        size_t vertexCount = vertices.size();
+        //the first corner of each class of the vertex and the vertex of the class
+        std::vector<unsigned int> representatives, copies;
+        for(size_t v = 0; v < vertexCount; v++){
+            representatives.clear();
+            copies.clear();
+            for(unsigned int c = offsets[v]; c < offsets[v + 1]; c++){
+                unsigned int corner = corners[c];
+                size_t k = 0;
+                while(k < representatives.size() && !sameClass(representatives[k], corner))
+                    k++;
+                if(k == representatives.size()){
+                    representatives.push_back(corner);
+                    copies.push_back(k == 0 ? v : vertices.size());
+                    if(k > 0){
+                        Vertex copy = vertices[v];
+                        vertices.push_back(copy);
+                    }
+                }
+                indices[corner] = copies[k];
+            }
+        }
+        return vertices.size() - vertexCount;
+    }
+
+    //true if the attributes of two vertices are close enough to weld them
+    static bool sameAttributes(const Vertex &a, const Vertex &b){
+        if(std::abs(a.TexCoords.x - b.TexCoords.x) > WELD_TEXCOORD_TOLERANCE ||
+           std::abs(a.TexCoords.y - b.TexCoords.y) > WELD_TEXCOORD_TOLERANCE)
+            return false;
+        float lengths = glm::length(a.Normal) * glm::length(b.Normal);
+        //the vertices without normals only weld together
+        if(lengths <= 0.f)
+            return glm::length(a.Normal) == glm::length(b.Normal);
+        return glm::dot(a.Normal, b.Normal) >= WELD_NORMAL_COSINE * lengths;
+    }
+
+    size_t weldVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices){
+        if(vertices.empty())
+            return 0;
+        glm::vec3 lower = vertices[0].Position, upper = vertices[0].Position;
+        for(const Vertex &vertex : vertices){
+            lower = glm::min(lower, vertex.Position);
+            upper = glm::max(upper, vertex.Position);
+        }
+        float tolerance = glm::length(upper - lower) * WELD_POSITION_TOLERANCE;
+        //cells twice the tolerance, so the positions close to a vertex are in the cells its tolerance box touches.
+        //The diagonal is at most 1 / (2 * WELD_POSITION_TOLERANCE) cells, the coordinates fit in 21 bits
+        float cellSize = tolerance > 0.f ? 2.f * tolerance : 1.f;
+        auto cellCoordinate = [&](float position, int axis){
+            return (uint64_t) std::max(0.f, std::floor((position - lower[axis]) / cellSize)) & 0x1fffff;
+        };
+
+        //first welded vertex of each cell, and the next one in the same cell
+        std::unordered_map<uint64_t, unsigned int> cellFirst(vertices.size());
+        std::vector<unsigned int> cellNext;
+        const unsigned int none = ~0u;
+        std::vector<unsigned int> remap(vertices.size());
+        std::vector<Vertex> welded;
+        welded.reserve(vertices.size());
+        for(size_t v = 0; v < vertices.size(); v++){
+            const Vertex &vertex = vertices[v];
+            uint64_t low[3], high[3];
+            for(int axis = 0; axis < 3; axis++){
+                low[axis] = cellCoordinate(vertex.Position[axis] - tolerance, axis);
+                high[axis] = cellCoordinate(vertex.Position[axis] + tolerance, axis);
+            }
+            unsigned int match = none;
+            for(uint64_t x = low[0]; x <= high[0] && match == none; x++){
+                for(uint64_t y = low[1]; y <= high[1] && match == none; y++){
+                    for(uint64_t z = low[2]; z <= high[2] && match == none; z++){
+                        auto cell = cellFirst.find(x << 42 | y << 21 | z);
+                        for(unsigned int w = cell == cellFirst.end() ? none : cell->second; w != none; w = cellNext[w]){
+                            if(glm::length(welded[w].Position - vertex.Position) <= tolerance && sameAttributes(welded[w], vertex)){
+                                match = w;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+            if(match != none){
+                remap[v] = match;
+                continue;
+            }
+            remap[v] = welded.size();
+            uint64_t key = cellCoordinate(vertex.Position.x, 0) << 42 | cellCoordinate(vertex.Position.y, 1) << 21 |
+                           cellCoordinate(vertex.Position.z, 2);
+            auto inserted = cellFirst.emplace(key, (unsigned int) welded.size());
+            cellNext.push_back(inserted.second ? none : inserted.first->second);
+            inserted.first->second = welded.size();
+            welded.push_back(vertex);
+        }
+
+        //the triangles with two corners welded together have no area left
+        size_t kept = 0;
+        for(size_t i = 0; i + 2 < indices.size(); i += 3){
+            unsigned int a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+            if(a == b || b == c || a == c)
+                continue;
+            indices[kept++] = a;
+            indices[kept++] = b;
+            indices[kept++] = c;
+        }
+        indices.resize(kept);
+
+        size_t removed = vertices.size() - welded.size();
+        vertices.swap(welded);
+        return removed;
+    }
+
+    void generateNormals(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices){
+        //unit normal of each triangle and angle of each corner
+        std::vector<glm::vec3> faceNormals(indices.size() / 3);
+        std::vector<float> cornerAngles(indices.size());
+        ThreadPool::global().parallelFor(0, indices.size() / 3, 1024, [&](int first, int last){
+            for(int t = first; t < last; t++){
+                glm::vec3 p[3];
+                for(int k = 0; k < 3; k++)
+                    p[k] = vertices[indices[3 * t + k]].Position;
+                glm::vec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+                float length = glm::length(normal);
+                faceNormals[t] = length > 0.f ? normal / length : glm::vec3(0.f);
+                for(int k = 0; k < 3; k++)
+                    cornerAngles[3 * t + k] = cornerAngle(p[k], p[(k + 1) % 3], p[(k + 2) % 3]);
+            }
+        });
+
+        //the copies of a position share the normals of the triangles around it that are within the crease angle
+        std::vector<unsigned int> positionGroup;
+        size_t groupCount = groupPositions(vertices, positionGroup);
+        std::vector<unsigned int> cornerKeys(indices.size());
+        for(size_t i = 0; i < indices.size(); i++)
+            cornerKeys[i] = positionGroup[indices[i]];
+        std::vector<unsigned int> offsets, corners;
+        groupCorners(cornerKeys, groupCount, offsets, corners);
+
+        std::vector<glm::vec3> cornerNormals(indices.size());
+        ThreadPool::global().parallelFor(0, groupCount, 1024, [&](int first, int last){
+            for(int g = first; g < last; g++){
+                for(unsigned int c = offsets[g]; c < offsets[g + 1]; c++){
+                    const glm::vec3 &faceNormal = faceNormals[corners[c] / 3];
+                    bool degenerate = faceNormal == glm::vec3(0.f);
+                    glm::vec3 sum(0.f);
+                    for(unsigned int other = offsets[g]; other < offsets[g + 1]; other++){
+                        const glm::vec3 &otherNormal = faceNormals[corners[other] / 3];
+                        //a degenerate triangle takes the normals of all the triangles around it
+                        if(degenerate || glm::dot(faceNormal, otherNormal) >= NORMAL_CREASE_COSINE)
+                            sum += otherNormal * cornerAngles[corners[other]];
+                    }
+                    float length = glm::length(sum);
+                    //the positions of degenerate triangles only keep an arbitrary unit normal
+                    cornerNormals[corners[c]] = length > 0.f ? sum / length : glm::vec3(0.f, 0.f, 1.f);
+                }
+            }
+        });
+
+        //the corners of a vertex on a crease get their own copies of it
+        splitVertices(vertices, indices, [&](unsigned int a, unsigned int b){
+            return glm::dot(cornerNormals[a], cornerNormals[b]) >= WELD_NORMAL_COSINE;
+        });
+        for(size_t i = 0; i < indices.size(); i++)
+            vertices[indices[i]].Normal = cornerNormals[i];
+    }
+
+    void generateTangents(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices){
+        //the direction of growing u (tangent) of each corner on the tangent plane of its vertex, weighted by the angle
+        //of the corner, and the handedness of the texture mapping of the corner (0 without one)
+        std::vector<glm::vec3> cornerTangents(indices.size());
+        std::vector<float> cornerHandedness(indices.size());
+        ThreadPool::global().parallelFor(0, indices.size() / 3, 1024, [&](int first, int last){
+            for(int t = first; t < last; t++){
+                const Vertex *corner[3];
+                for(int k = 0; k < 3; k++)
+                    corner[k] = &vertices[indices[3 * t + k]];
+                glm::vec3 edge1 = corner[1]->Position - corner[0]->Position, edge2 = corner[2]->Position - corner[0]->Position;
+                glm::vec2 uv1 = corner[1]->TexCoords - corner[0]->TexCoords, uv2 = corner[2]->TexCoords - corner[0]->TexCoords;
+                float determinant = uv1.x * uv2.y - uv2.x * uv1.y;
+                glm::vec3 tangent(0.f), bitangent(0.f);
+                //a triangle without texture area has no tangent space
+                if(std::abs(determinant) > 1e-20f){
+                    tangent = (edge1 * uv2.y - edge2 * uv1.y) / determinant;
+                    bitangent = (edge2 * uv1.x - edge1 * uv2.x) / determinant;
+                }
+                for(int k = 0; k < 3; k++){
+                    glm::vec3 normal = corner[k]->Normal;
+                    float angle = cornerAngle(corner[k]->Position, corner[(k + 1) % 3]->Position, corner[(k + 2) % 3]->Position);
+                    glm::vec3 projectedTangent = tangent - normal * glm::dot(normal, tangent);
+                    glm::vec3 projectedBitangent = bitangent - normal * glm::dot(normal, bitangent);
+                    float tangentLength = glm::length(projectedTangent);
+                    cornerTangents[3 * t + k] = tangentLength > 0.f ? projectedTangent / tangentLength * angle : glm::vec3(0.f);
+                    float orientation = glm::dot(glm::cross(normal, projectedTangent), projectedBitangent);
+                    cornerHandedness[3 * t + k] = orientation > 0.f ? 1.f : orientation < 0.f ? -1.f : 0.f;
+                }
+            }
+        });
+
+        //the corners without a texture mapping go with the handedness of the others of their vertex
+        std::vector<unsigned int> offsets, corners;
+        groupCorners(indices, vertices.size(), offsets, corners);
+        for(size_t v = 0; v < vertices.size(); v++){
+            float handedness = 1.f;
+            for(unsigned int c = offsets[v]; c < offsets[v + 1]; c++){
+                if(cornerHandedness[corners[c]] != 0.f){
+                    handedness = cornerHandedness[corners[c]];
+                    break;
+                }
+            }
+            for(unsigned int c = offsets[v]; c < offsets[v + 1]; c++){
+                if(cornerHandedness[corners[c]] == 0.f)
+                    cornerHandedness[corners[c]] = handedness;
+            }
+        }
+        //a vertex on a mirrored seam gets a copy for each handedness, the sum of opposite texture directions is meaningless
+        splitVertices(vertices, indices, [&](unsigned int a, unsigned int b){
+            return cornerHandedness[a] == cornerHandedness[b];
+        });
+
+        groupCorners(indices, vertices.size(), offsets, corners);
+        ThreadPool::global().parallelFor(0, vertices.size(), 1024, [&](int first, int last){
+            for(int v = first; v < last; v++){
+                Vertex &vertex = vertices[v];
+                glm::vec3 tangent(0.f);
+                for(unsigned int c = offsets[v]; c < offsets[v + 1]; c++)
+                    tangent += cornerTangents[corners[c]];
+                glm::vec3 normal = vertex.Normal;
+                tangent -= normal * glm::dot(normal, tangent);
+                //without a texture direction any vector perpendicular to the normal does
+                if(glm::length(tangent) <= 1e-20f){
+                    tangent = glm::cross(std::abs(normal.x) < 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f), normal);
+                }
+                float length = glm::length(tangent);
+                vertex.Tangent = length > 0.f ? tangent / length : glm::vec3(1.f, 0.f, 0.f);
+                float handedness = offsets[v] < offsets[v + 1] ? cornerHandedness[corners[offsets[v]]] : 1.f;
+                vertex.Bitangent = glm::cross(normal, vertex.Tangent) * handedness;
+            }
+        });
+    }
+
+    VertexCacheStatistics analyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                             unsigned int cacheSize){
+        VertexCacheStatistics statistics;
+        statistics.triangles = indices.size() / 3;
+        statistics.vertices = vertexCount;
+
+        //the time each vertex entered the cache, it's still there while less than cacheSize entered after it
+        std::vector<size_t> entry(vertexCount, 0);
+        size_t time = cacheSize + 1;
+        for(unsigned int index : indices){
+            if(time - entry[index] > cacheSize){
+                entry[index] = time++;
+                statistics.transformedVertices++;
+            }
+        }
+        return statistics;
+    }
+
+    //score of a vertex from its position in the LRU cache and the number of triangles still using it.
+    //The vertices of the last triangle get a fixed score, lower than the next positions, so the order
+    //doesn't keep turning around the same edge, and the vertices with few triangles left get a boost,
+    //so they are finished instead of being left alone to be transformed again later
+    static float vertexScore(int cachePosition, unsigned int remainingTriangles){
+        if(remainingTriangles == 0)
+            return -1.f;
+
+        float score = 0.f;
+        if(cachePosition >= 0){
+            if(cachePosition < 3){
+                score = 0.75f;
+            }else{
+                float scale = 1.f / (OPTIMIZER_CACHE_SIZE - 3);
+                score = std::pow(1.f - (cachePosition - 3) * scale, 1.5f);
+            }
+        }
+        score += 2.f / std::sqrt((float) remainingTriangles);
+        return score;
+    }
+
+    void optimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount){
+        size_t triangleCount = indices.size() / 3;
+        if(triangleCount == 0)
+            return;
+
+        //triangles of each vertex, the ones not emitted yet are in [begin, begin + remaining)
+        std::vector<unsigned int> remaining(vertexCount, 0);
+        for(size_t i = 0; i < triangleCount * 3; i++)
+            remaining[indices[i]]++;
+        std::vector<size_t> begin(vertexCount + 1, 0);
+        for(size_t v = 0; v < vertexCount; v++)
+            begin[v + 1] = begin[v] + remaining[v];
+        std::vector<unsigned int> adjacency(begin[vertexCount]);
+        std::vector<size_t> filled(begin.begin(), begin.end() - 1);
+        for(size_t t = 0; t < triangleCount; t++)
+            for(int k = 0; k < 3; k++)
+                adjacency[filled[indices[3 * t + k]]++] = t;
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> score(vertexCount);
+        for(size_t v = 0; v < vertexCount; v++)
+            score[v] = vertexScore(-1, remaining[v]);
+
+        //the first triangle is the best one of the whole mesh
+        std::vector<bool> emitted(triangleCount, false);
+        long bestTriangle = 0;
+        float bestScore = -1.f;
+        for(size_t t = 0; t < triangleCount; t++){
+            float triangleScore = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+            if(triangleScore > bestScore){
+                bestScore = triangleScore;
+                bestTriangle = t;
+            }
+        }
+
+        std::vector<unsigned int> optimized;
+        optimized.reserve(triangleCount * 3);
+        std::vector<unsigned int> cache, newCache;
+        cache.reserve(OPTIMIZER_CACHE_SIZE + 3);
+        newCache.reserve(OPTIMIZER_CACHE_SIZE + 3);
+        //where to look for a triangle when the cache has none left
+        size_t nextUnemitted = 0;
+
+        while(optimized.size() < triangleCount * 3){
+            if(bestTriangle < 0){
+                while(emitted[nextUnemitted])
+                    nextUnemitted++;
+                bestTriangle = nextUnemitted;
+            }
+
+            //emit it and remove it from the triangles of its vertices
+            const unsigned int* triangle = &indices[3 * bestTriangle];
+            emitted[bestTriangle] = true;
+            newCache.clear();
+            for(int k = 0; k < 3; k++){
+                unsigned int v = triangle[k];
+                optimized.push_back(v);
+                unsigned int* trianglesOfVertex = &adjacency[begin[v]];
+                for(unsigned int i = 0; i < remaining[v]; i++){
+                    if(trianglesOfVertex[i] == (unsigned int) bestTriangle){
+                        std::swap(trianglesOfVertex[i], trianglesOfVertex[remaining[v] - 1]);
+                        break;
+                    }
+                }
+                remaining[v]--;
+                //degenerate triangles repeat a vertex
+                if(std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+                    newCache.push_back(v);
+            }
+
+            //its vertices go to the front of the cache
+            for(unsigned int v : cache)
+                if(v != triangle[0] && v != triangle[1] && v != triangle[2])
+                    newCache.push_back(v);
+            for(unsigned int i = 0; i < newCache.size(); i++){
+                unsigned int v = newCache[i];
+                cachePosition[v] = i < OPTIMIZER_CACHE_SIZE ? (int) i : -1;
+                score[v] = vertexScore(cachePosition[v], remaining[v]);
+            }
+            if(newCache.size() > OPTIMIZER_CACHE_SIZE)
+                newCache.resize(OPTIMIZER_CACHE_SIZE);
+            cache.swap(newCache);
+
+            //the next triangle is the best one that uses a vertex of the cache
+            bestTriangle = -1;
+            bestScore = -1.f;
+            for(unsigned int v : cache){
+                for(unsigned int i = 0; i < remaining[v]; i++){
+                    unsigned int t = adjacency[begin[v] + i];
+                    float triangleScore = score[indices[3 * t]] + score[indices[3 * t + 1]] + score[indices[3 * t + 2]];
+                    if(triangleScore > bestScore){
+                        bestScore = triangleScore;
+                        bestTriangle = t;
+                    }
+                }
+            }
+        }
+
+        indices.swap(optimized);
+    }
+
+    //sum of the squared distances to a set of planes, as the symmetric matrix of the plane equations
+    //(a, b, c, d) added up, each plane with a weight
+    struct Quadric{
+        double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+        double weight;
+
+        Quadric(){
+            a2 = ab = ac = ad = b2 = bc = bd = c2 = cd = d2 = weight = 0.0;
+        }
+
+        //the plane through point with this unit normal
+        Quadric(const glm::dvec3 &normal, const glm::dvec3 &point, double planeWeight){
+            double a = normal.x, b = normal.y, c = normal.z, d = -glm::dot(normal, point);
+            weight = planeWeight;
+            a2 = a * a * weight; ab = a * b * weight; ac = a * c * weight; ad = a * d * weight;
+            b2 = b * b * weight; bc = b * c * weight; bd = b * d * weight;
+            c2 = c * c * weight; cd = c * d * weight; d2 = d * d * weight;
+        }
+
+        Quadric& operator+=(const Quadric &q){
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2; bc += q.bc; bd += q.bd;
+            c2 += q.c2; cd += q.cd; d2 += q.d2; weight += q.weight;
+            return *this;
+        }
+
+        //mean squared distance of p to the planes
+        double error(const glm::vec3 &p) const{
+            double x = p.x, y = p.y, z = p.z;
+            double sum = x * x * a2 + y * y * b2 + z * z * c2 + d2
+                       + 2.0 * (x * y * ab + x * z * ac + y * z * bc + x * ad + y * bd + z * cd);
+            return weight > 0.0 ? std::max(sum / weight, 0.0) : 0.0;
+        }
+    };
+
+    //a position that moves to a neighbor position and the error it adds
+    struct Collapse{
+        unsigned int from, to;
+        double error;
+    };
+
+    //an edge as a key of the hash maps
+    static unsigned long long edgeKey(unsigned long long a, unsigned long long b){
+        return std::min(a, b) << 32 | std::max(a, b);
+    }
+
+    std::vector<unsigned int> simplify(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                       size_t targetIndexCount, float &error){
+        size_t vertexCount = vertices.size();
+        error = 0.f;
+
+        //the vertices with the same position (the copies on a seam) collapse together, as a group
+        std::vector<unsigned int> positionGroup;
+        size_t groupCount = groupPositions(vertices, positionGroup);
+        std::vector<unsigned int> groupBegin(groupCount + 1, 0), groupVertices(vertexCount);
+        for(size_t v = 0; v < vertexCount; v++)
+            groupBegin[positionGroup[v] + 1]++;
+        for(size_t g = 0; g < groupCount; g++)
+            groupBegin[g + 1] += groupBegin[g];
+        {
+            std::vector<unsigned int> filled(groupBegin.begin(), groupBegin.end() - 1);
+            for(size_t v = 0; v < vertexCount; v++)
+                groupVertices[filled[positionGroup[v]]++] = v;
+        }
+
+        //the edges of a single triangle are open: the borders of the mesh, and the UV seams and creases,
+        //where each side has its own copies of the vertices
+        std::unordered_map<unsigned long long, int> edgeTriangles;
+        for(size_t i = 0; i + 2 < indices.size(); i += 3)
+            for(int k = 0; k < 3; k++)
+                edgeTriangles[edgeKey(indices[i + k], indices[i + (k + 1) % 3])]++;
+
+        //the planes of the triangles around each position. The open edges also get a plane perpendicular
+        //to their triangle, so the borders and the seams keep their shape
+        std::vector<Quadric> quadrics(groupCount);
+        //the positions at the other end of the open edges, a position on an open line only moves along it
+        std::vector<std::vector<unsigned int>> openNeighbors(groupCount);
+        for(size_t i = 0; i + 2 < indices.size(); i += 3){
+            glm::dvec3 p[3];
+            for(int k = 0; k < 3; k++)
+                p[k] = glm::dvec3(vertices[indices[i + k]].Position);
+            glm::dvec3 normal = glm::cross(p[1] - p[0], p[2] - p[0]);
+            double doubleArea = glm::length(normal);
+            if(doubleArea == 0.0)
+                continue;
+            normal /= doubleArea;
+            Quadric plane(normal, p[0], doubleArea * 0.5);
+            for(int k = 0; k < 3; k++){
+                quadrics[positionGroup[indices[i + k]]] += plane;
+
+                unsigned int a = indices[i + k], b = indices[i + (k + 1) % 3];
+                if(edgeTriangles[edgeKey(a, b)] == 1){
+                    glm::dvec3 edge = p[(k + 1) % 3] - p[k];
+                    double length = glm::length(edge);
+                    Quadric border(glm::normalize(glm::cross(edge, normal)), p[k], SIMPLIFY_BORDER_WEIGHT * length * length);
+                    unsigned int ga = positionGroup[a], gb = positionGroup[b];
+                    quadrics[ga] += border;
+                    quadrics[gb] += border;
+                    for(unsigned int g : {ga, gb}){
+                        unsigned int other = g == ga ? gb : ga;
+                        std::vector<unsigned int> &neighbors = openNeighbors[g];
+                        if(std::find(neighbors.begin(), neighbors.end(), other) == neighbors.end())
+                            neighbors.push_back(other);
+                    }
+                }
+            }
+        }
+        //the corners, where open lines meet or end, are locked
+        std::vector<bool> locked(groupCount);
+        for(size_t g = 0; g < groupCount; g++)
+            locked[g] = openNeighbors[g].size() != 0 && openNeighbors[g].size() != 2;
+
+        std::vector<unsigned int> result = indices;
+        std::vector<unsigned int> remap(vertexCount);
+        std::vector<bool> touched(groupCount);
+        std::vector<unsigned int> remaining(vertexCount), begin(vertexCount + 1), adjacency;
+        std::vector<Collapse> collapses;
+        std::vector<unsigned int> targets;
+        double maximumError = 0.0;
+
+        //each pass collapses the cheapest edges, with each position in one collapse at most
+        while(result.size() > targetIndexCount){
+            size_t triangleCount = result.size() / 3;
+
+            //triangles of each vertex
+            std::fill(remaining.begin(), remaining.end(), 0);
+            for(unsigned int index : result)
+                remaining[index]++;
+            begin[0] = 0;
+            for(size_t v = 0; v < vertexCount; v++)
+                begin[v + 1] = begin[v] + remaining[v];
+            adjacency.resize(result.size());
+            std::vector<unsigned int> filled(begin.begin(), begin.end() - 1);
+            for(size_t t = 0; t < triangleCount; t++)
+                for(int k = 0; k < 3; k++)
+                    adjacency[filled[result[3 * t + k]]++] = t;
+
+            //the cheapest direction of each edge, each edge is seen from its 2 triangles
+            auto canMove = [&](unsigned int from, unsigned int to){
+                const std::vector<unsigned int> &neighbors = openNeighbors[from];
+                return !locked[from] && (neighbors.empty() || neighbors[0] == to || neighbors[1] == to);
+            };
+            collapses.clear();
+            for(size_t i = 0; i < result.size(); i += 3){
+                for(int k = 0; k < 3; k++){
+                    unsigned int a = positionGroup[result[i + k]], b = positionGroup[result[i + (k + 1) % 3]];
+                    Quadric q = quadrics[a];
+                    q += quadrics[b];
+                    Collapse collapse = {0, 0, -1.0};
+                    if(canMove(a, b))
+                        collapse = Collapse{a, b, q.error(vertices[groupVertices[groupBegin[b]]].Position)};
+                    if(canMove(b, a)){
+                        double bToA = q.error(vertices[groupVertices[groupBegin[a]]].Position);
+                        if(collapse.error < 0.0 || bToA < collapse.error)
+                            collapse = Collapse{b, a, bToA};
+                    }
+                    if(collapse.error >= 0.0)
+                        collapses.push_back(collapse);
+                }
+            }
+            if(collapses.empty())
+                break;
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y){
+                return x.error < y.error;
+            });
+            //only the cheapest part of the edges in a pass, the rest is ranked again with the new quadrics
+            collapses.resize(std::max<size_t>(collapses.size() / SIMPLIFY_PASS_FRACTION, 1));
+
+            //a collapse removes 2 triangles, stop when they're enough
+            size_t trianglesToRemove = (result.size() - targetIndexCount + 2) / 3;
+            size_t removed = 0;
+            for(size_t v = 0; v < vertexCount; v++)
+                remap[v] = v;
+            std::fill(touched.begin(), touched.end(), false);
+            for(const Collapse &collapse : collapses){
+                if(removed >= trianglesToRemove)
+                    break;
+                if(touched[collapse.from] || touched[collapse.to])
+                    continue;
+
+                //each copy of the position moves to the copy of the other position it has an edge with
+                bool valid = true;
+                targets.clear();
+                for(unsigned int c = groupBegin[collapse.from]; c < groupBegin[collapse.from + 1] && valid; c++){
+                    unsigned int from = groupVertices[c];
+                    unsigned int to = ~0u;
+                    for(unsigned int i = begin[from]; i < begin[from + 1]; i++){
+                        for(int k = 0; k < 3; k++){
+                            unsigned int v = result[3 * adjacency[i] + k];
+                            if(positionGroup[v] == collapse.to){
+                                //a copy between two copies of the other position would tear the seam
+                                valid = valid && (to == ~0u || to == v);
+                                to = v;
+                            }
+                        }
+                    }
+                    //unused copies don't matter, the others need a copy to go to
+                    if(begin[from] != begin[from + 1] && to == ~0u)
+                        valid = false;
+                    targets.push_back(to);
+                    if(!valid || to == ~0u)
+                        continue;
+
+                    //keep the shading and the orientation of the triangles around the vertex
+                    const Vertex &fromVertex = vertices[from], &toVertex = vertices[to];
+                    if(glm::dot(glm::normalize(fromVertex.Normal), glm::normalize(toVertex.Normal)) < SIMPLIFY_NORMAL_COSINE)
+                        valid = false;
+                    for(unsigned int i = begin[from]; i < begin[from + 1] && valid; i++){
+                        const unsigned int* triangle = &result[3 * adjacency[i]];
+                        if(triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                            continue;
+                        glm::vec3 p[3], moved[3];
+                        for(int k = 0; k < 3; k++){
+                            p[k] = vertices[triangle[k]].Position;
+                            moved[k] = triangle[k] == from ? toVertex.Position : p[k];
+                        }
+                        glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                        glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                        valid = glm::dot(before, after) > SIMPLIFY_TRIANGLE_COSINE * glm::length(before) * glm::length(after);
+                    }
+                }
+                if(!valid)
+                    continue;
+
+                for(unsigned int c = groupBegin[collapse.from]; c < groupBegin[collapse.from + 1]; c++){
+                    unsigned int from = groupVertices[c], to = targets[c - groupBegin[collapse.from]];
+                    if(to == ~0u)
+                        continue;
+                    remap[from] = to;
+                    //the triangles that had the edge disappear. The others change, so their vertices wait for
+                    //the next pass, otherwise two collapses could flip a triangle that each one alone doesn't
+                    for(unsigned int i = begin[from]; i < begin[from + 1]; i++){
+                        const unsigned int* triangle = &result[3 * adjacency[i]];
+                        removed += triangle[0] == to || triangle[1] == to || triangle[2] == to;
+                        for(int k = 0; k < 3; k++)
+                            touched[positionGroup[triangle[k]]] = true;
+                    }
+                }
+                quadrics[collapse.to] += quadrics[collapse.from];
+                maximumError = std::max(maximumError, collapse.error);
+            }
+            if(removed == 0)
+                break;
+
+            //move the indices and drop the triangles that became degenerate (two corners at the same position)
+            size_t kept = 0;
+            for(size_t i = 0; i < result.size(); i += 3){
+                unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+                unsigned int ga = positionGroup[a], gb = positionGroup[b], gc = positionGroup[c];
+                if(ga != gb && gb != gc && ga != gc){
+                    result[kept++] = a;
+                    result[kept++] = b;
+                    result[kept++] = c;
+                }
+            }
+            result.resize(kept);
+        }
+
+        error = (float) std::sqrt(maximumError);
+        return result;
+    }
+
+    std::vector<MeshLod> generateLods(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                      bool optimizeCache){
+        std::vector<MeshLod> lods(1, MeshLod{0, (unsigned int) indices.size(), 0.f});
+        std::vector<unsigned int> fullIndices = indices;
+        while(lods.size() < LOD_COUNT && lods.back().indexCount / 3 >= 2 * LOD_MIN_TRIANGLES){
+            float error;
+            std::vector<unsigned int> lodIndices = simplify(vertices, fullIndices, lods.back().indexCount / 2, error);
+            if(lodIndices.size() > lods.back().indexCount * LOD_MIN_REDUCTION)
+                break;
+            if(optimizeCache)
+                optimizeVertexCache(lodIndices, vertices.size());
+            lods.push_back(MeshLod{(unsigned int) indices.size(), (unsigned int) lodIndices.size(), error});
+            indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+        }
+        return lods;
+    }
+
+    //bounding sphere and normal cone of the triangles of a meshlet
+    static void computeMeshletBounds(const std::vector<Vertex> &vertices, const unsigned int *indices, Meshlet &meshlet){
+        glm::vec3 lower(INFINITY), upper(-INFINITY);
+        for(unsigned int i = 0; i < meshlet.indexCount; i++){
+            lower = glm::min(lower, vertices[indices[i]].Position);
+            upper = glm::max(upper, vertices[indices[i]].Position);
+        }
+        meshlet.center = (lower + upper) * 0.5f;
+        meshlet.radius = 0.f;
+        for(unsigned int i = 0; i < meshlet.indexCount; i++){
+            meshlet.radius = std::max(meshlet.radius, glm::length(vertices[indices[i]].Position - meshlet.center));
+        }
+
+        //the axis is the sum of the normals weighted by the areas
+        glm::vec3 axis(0.f);
+        for(unsigned int i = 0; i < meshlet.indexCount; i += 3){
+            const glm::vec3 &a = vertices[indices[i]].Position;
+            axis += glm::cross(vertices[indices[i + 1]].Position - a, vertices[indices[i + 2]].Position - a);
+        }
+        float length = glm::length(axis);
+        meshlet.coneAxis = length > 0.f ? axis / length : glm::vec3(0.f, 0.f, 1.f);
+        meshlet.coneCutoff = 1.f;
+        if(length <= 0.f)
+            return;
+        float minimumCosine = 1.f;
+        for(unsigned int i = 0; i < meshlet.indexCount; i += 3){
+            const glm::vec3 &a = vertices[indices[i]].Position;
+            glm::vec3 normal = glm::cross(vertices[indices[i + 1]].Position - a, vertices[indices[i + 2]].Position - a);
+            float area = glm::length(normal);
+            if(area > 0.f)
+                minimumCosine = std::min(minimumCosine, glm::dot(normal, meshlet.coneAxis) / area);
+        }
+        //with a normal at 90 degrees or more from the axis, some triangle faces every camera position
+        if(minimumCosine > 0.f)
+            meshlet.coneCutoff = std::sqrt(std::max(0.f, 1.f - minimumCosine * minimumCosine));
+    }
+
+    std::vector<Meshlet> buildMeshlets(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices){
+        size_t triangleCount = indices.size() / 3;
+        std::vector<Meshlet> meshlets;
+        if(!triangleCount)
+            return meshlets;
+
+        //unit normal of each triangle, zero for the degenerate ones
+        std::vector<glm::vec3> normals(triangleCount);
+        for(size_t t = 0; t < triangleCount; t++){
+            const glm::vec3 &a = vertices[indices[3 * t]].Position;
+            glm::vec3 normal = glm::cross(vertices[indices[3 * t + 1]].Position - a, vertices[indices[3 * t + 2]].Position - a);
+            float length = glm::length(normal);
+            normals[t] = length > 0.f ? normal / length : glm::vec3(0.f);
+        }
+
+        //triangles around each position, so the meshlets also grow across the seams
+        std::vector<unsigned int> positionGroup;
+        size_t groupCount = groupPositions(vertices, positionGroup);
+        std::vector<unsigned int> cornerKeys(indices.size());
+        for(size_t i = 0; i < indices.size(); i++){
+            cornerKeys[i] = positionGroup[indices[i]];
+        }
+        //the corners of the triangles around each position
+        std::vector<unsigned int> adjacencyOffsets, adjacency;
+        groupCorners(cornerKeys, groupCount, adjacencyOffsets, adjacency);
+
+        std::vector<bool> emitted(triangleCount, false);
+        //meshlet that the vertex was last added to, plus 1, and its index in that meshlet
+        std::vector<unsigned int> vertexMeshlet(vertices.size(), 0), localIndex(vertices.size());
+        std::vector<unsigned int> meshletVertices, localIndices, reordered;
+        reordered.reserve(indices.size());
+        size_t seed = 0;
+        while(true){
+            while(seed < triangleCount && emitted[seed]){
+                seed++;
+            }
+            if(seed == triangleCount)
+                break;
+
+            Meshlet meshlet;
+            meshlet.indexOffset = reordered.size();
+            unsigned int meshletId = meshlets.size() + 1;
+            meshletVertices.clear();
+            glm::vec3 normalSum(0.f);
+            size_t next = seed;
+            unsigned int triangles = 0;
+            while(next != triangleCount){
+                emitted[next] = true;
+                triangles++;
+                normalSum += normals[next];
+                for(unsigned int k = 0; k < 3; k++){
+                    unsigned int index = indices[3 * next + k];
+                    reordered.push_back(index);
+                    if(vertexMeshlet[index] != meshletId){
+                        vertexMeshlet[index] = meshletId;
+                        localIndex[index] = meshletVertices.size();
+                        meshletVertices.push_back(index);
+                    }
+                }
+                if(triangles == MESHLET_MAX_TRIANGLES)
+                    break;
+
+                //the free triangle around the meshlet that adds the least vertices and bends its normals the least
+                float normalLength = glm::length(normalSum);
+                glm::vec3 axis = normalLength > 0.f ? normalSum / normalLength : glm::vec3(0.f);
+                float bestScore = INFINITY;
+                next = triangleCount;
+                for(unsigned int vertex : meshletVertices){
+                    unsigned int group = positionGroup[vertex];
+                    for(unsigned int a = adjacencyOffsets[group]; a < adjacencyOffsets[group + 1]; a++){
+                        unsigned int candidate = adjacency[a] / 3;
+                        if(emitted[candidate])
+                            continue;
+                        unsigned int newVertices = 0;
+                        for(unsigned int k = 0; k < 3; k++){
+                            newVertices += vertexMeshlet[indices[3 * candidate + k]] != meshletId;
+                        }
+                        if(meshletVertices.size() + newVertices > MESHLET_MAX_VERTICES)
+                            continue;
+                        float score = newVertices + MESHLET_CONE_WEIGHT * (1.f - glm::dot(normals[candidate], axis));
+                        if(score < bestScore){
+                            bestScore = score;
+                            next = candidate;
+                        }
+                    }
+                }
+            }
+
+            meshlet.indexCount = reordered.size() - meshlet.indexOffset;
+            //the growth order jumps around the meshlet, reorder its triangles for the vertex cache
+            localIndices.clear();
+            for(unsigned int i = meshlet.indexOffset; i < reordered.size(); i++){
+                localIndices.push_back(localIndex[reordered[i]]);
+            }
+            optimizeVertexCache(localIndices, meshletVertices.size());
+            for(unsigned int i = 0; i < meshlet.indexCount; i++){
+                reordered[meshlet.indexOffset + i] = meshletVertices[localIndices[i]];
+            }
+            computeMeshletBounds(vertices, reordered.data() + meshlet.indexOffset, meshlet);
+            meshlets.push_back(meshlet);
+        }
+        indices.swap(reordered);
+        return meshlets;
+    }
+
+    bool meshletVisible(const Meshlet &meshlet, const glm::vec3 &cameraPosition, const glm::vec4 planes[6]){
+        for(unsigned int p = 0; p < 6; p++){
+            if(glm::dot(glm::vec3(planes[p]), meshlet.center) + planes[p].w < -meshlet.radius)
+                return false;
+        }
+        //every point of the sphere is seen from behind all the normals of the cone
+        glm::vec3 direction = meshlet.center - cameraPosition;
+        return glm::dot(direction, meshlet.coneAxis) <
+               meshlet.coneCutoff * (glm::length(direction) + meshlet.radius) + meshlet.radius;
+    }
+
+    void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices){
+        //new index of each vertex, in the order of the first use
+        const unsigned int unused = ~0u;
+        std::vector<unsigned int> remap(vertices.size(), unused);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+        for(unsigned int &index : indices){
+            if(remap[index] == unused){
+                remap[index] = reordered.size();
+                reordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(reordered);
+    }
+}
@@ -1,6 +1,11 @@
 #include <model.hpp>
+#include <ambientocclusion.hpp>
+#include <texturestreamer.hpp>
+#include <threadpool.hpp>
 
 #include <glad/glad.h> 
+//the implementation of stb_image is compiled here only
+#define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -10,14 +15,63 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+ImportStatistics::ImportStatistics()
+{
+    importedVertices = 0;
+    weldedVertices = 0;
+    meshesWithoutNormals = 0;
+    weldMilliseconds = 0.0;
+    normalMilliseconds = 0.0;
+    tangentMilliseconds = 0.0;
+    occlusionMilliseconds = 0.0;
+    occlusionRays = 0;
+}
+
+ImportStatistics& ImportStatistics::operator+=(const ImportStatistics &other)
+{
+    importedVertices += other.importedVertices;
+    weldedVertices += other.weldedVertices;
+    meshesWithoutNormals += other.meshesWithoutNormals;
+    weldMilliseconds += other.weldMilliseconds;
+    normalMilliseconds += other.normalMilliseconds;
+    tangentMilliseconds += other.tangentMilliseconds;
+    occlusionMilliseconds += other.occlusionMilliseconds;
+    occlusionRays += other.occlusionRays;
+    return *this;
+}
+
+bool Model::optimizeMeshes = true;
+bool Model::generateLods = true;
+bool Model::generateMeshlets = true;
+bool Model::mergeDraws = true;
+int Model::ambientOcclusionSamples = AMBIENT_OCCLUSION_SAMPLES;
+bool Model::conditionedTextures = true;
+bool Model::textureArrays = false;
+
+unsigned int TextureFromFile(const char *path, const string &directory, bool gamma, texturecompressor::TextureKind kind)
 {
     string filename = string(path);
     filename = directory + '/' + filename;
 
+    // the blocks and the mipmaps of the conditioned texture are uploaded as they are, if the GPU can sample them.
+    // When they're streamed only the coarse levels are loaded here
+    if (Model::conditionedTextures)
+    {
+        string container = texturecompressor::containerPath(filename, kind);
+        texturecompressor::CompressedTexture compressed;
+        unsigned int compressedID = 0;
+        if (!container.empty() && TextureStreamer::enabled)
+            compressedID = TextureStreamer::global().load(container);
+        else if (!container.empty() && texturecompressor::readContainer(container, compressed))
+            compressedID = texturecompressor::upload(compressed);
+        if (compressedID != 0)
+            return compressedID;
+    }
+
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
@@ -28,9 +82,11 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
         GLenum format;
         if (nrComponents == 1)
             format = GL_RED;
+        else if (nrComponents == 2)
+            format = GL_RG;
         else if (nrComponents == 3)
             format = GL_RGB;
-        else if (nrComponents == 4)
+        else
             format = GL_RGBA;
 
         glBindTexture(GL_TEXTURE_2D, textureID);
@@ -53,15 +109,349 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     return textureID;
 }
 
-Model::Model(string const &path, bool gamma) : gammaCorrection(gamma)
+// create a texture array with the conditioned textures of some containers as its layers, all of them with the same
+// format and size. Returns 0 if one of them can't be read
+static unsigned int compressedTextureArray(const vector<string> &containers)
+{
+    texturecompressor::CompressedTexture texture;
+    if (!texturecompressor::readContainer(containers[0], texture))
+        return 0;
+    GLenum format = texturecompressor::internalFormat(texture.format);
+    GLsizei layers = containers.size();
+    size_t levels = texture.levels.size();
+
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    // the storage of all the layers first, then the blocks of each layer
+    for (unsigned int l = 0; l < texture.levels.size(); l++)
+    {
+        const texturecompressor::CompressedTexture::Level &level = texture.levels[l];
+        glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, l, format, level.width, level.height, layers, 0,
+                               level.size * layers, NULL);
+    }
+    for (GLsizei layer = 0; layer < layers; layer++)
+    {
+        if (layer > 0 && (!texturecompressor::readContainer(containers[layer], texture) ||
+                          texture.levels.size() != levels))
+        {
+            std::cerr << "ERROR::TEXTURE_ARRAY::CONTAINER_NOT_READ " << containers[layer] << std::endl;
+            glDeleteTextures(1, &textureID);
+            return 0;
+        }
+        for (unsigned int l = 0; l < texture.levels.size(); l++)
+        {
+            const texturecompressor::CompressedTexture::Level &level = texture.levels[l];
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, l, 0, 0, layer, level.width, level.height, 1, format,
+                                      level.size, &texture.data[level.offset]);
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return textureID;
+}
+
+// create a texture array with some images as its layers, all of them with the same components and size.
+// The mipmaps are generated by the driver, like in TextureFromFile
+static unsigned int textureArrayFromFiles(const vector<string> &filenames, int width, int height, int components)
+{
+    // the grey and alpha images are expanded to RGBA
+    GLenum format = components == 1 ? GL_RED : components == 3 ? GL_RGB : GL_RGBA;
+    int loadedComponents = format == GL_RGBA ? 4 : components;
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, width, height, filenames.size(), 0, format, GL_UNSIGNED_BYTE, NULL);
+    for (unsigned int layer = 0; layer < filenames.size(); layer++)
+    {
+        int imageWidth, imageHeight, nrComponents;
+        unsigned char *data = stbi_load(filenames[layer].c_str(), &imageWidth, &imageHeight, &nrComponents, loadedComponents);
+        if (data && imageWidth == width && imageHeight == height)
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, GL_UNSIGNED_BYTE, data);
+        else
+            std::cerr << "Texture failed to load at path: " << filenames[layer] << std::endl;
+        stbi_image_free(data);
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    return textureID;
+}
+
+Model::Model(string const &path, bool gamma) : gammaCorrection(gamma), numberOfTextureArrays(0), bakedLightingId(0)
 {
     loadModel(path);
 }
 
-void Model::Draw(Shader shader)
+Model::~Model()
 {
+    for(const Mesh &mesh : meshes)
+        GeometryArena::global().free(mesh.geometry);
+
+    // the layers of a texture array share its id, each texture is deleted once
+    vector<unsigned int> textureIds;
+    for(const Texture &texture : textures_loaded)
+        if(texture.id != 0 && std::find(textureIds.begin(), textureIds.end(), texture.id) == textureIds.end())
+            textureIds.push_back(texture.id);
+    if(textureIds.empty())
+        return;
+    if(TextureStreamer::enabled)
+        for(unsigned int id : textureIds)
+            TextureStreamer::global().release(id);
+    glDeleteTextures(textureIds.size(), textureIds.data());
+}
+
+// the visible meshlets of a mesh, NULL when the object draws all the triangles
+static const MeshletVisibility* meshVisibility(const vector<MeshletVisibility> *visible, unsigned int mesh)
+{
+    return visible && mesh < visible->size() ? &(*visible)[mesh] : NULL;
+}
+
+void Model::Draw(Shader shader, unsigned int lod, const vector<MeshletVisibility> *visible)
+{
+    if(!mergeDraws)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader, lod, meshVisibility(visible, i));
+        return;
+    }
+    for(const vector<unsigned int> &batch : drawBatches)
+    {
+        // the meshes of the batch have the same textures and decoding
+        Mesh &first = meshes[batch[0]];
+        first.bindTextures(shader);
+        first.setDecoding(shader);
+        glBindVertexArray(first.vertexArray());
+        drawBatch(batch, lod, visible);
+    }
+    glBindVertexArray(0);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void Model::DrawGeometry(Shader &shader, unsigned int lod, const vector<MeshletVisibility> *visible)
+{
+    if(!mergeDraws)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].DrawGeometry(shader, lod, meshVisibility(visible, i));
+        return;
+    }
+    for(const vector<unsigned int> &batch : depthBatches)
+    {
+        Mesh &first = meshes[batch[0]];
+        first.setDecoding(shader);
+        glBindVertexArray(first.depthVertexArray());
+        drawBatch(batch, lod, visible);
+    }
+    glBindVertexArray(0);
+}
+
+void Model::drawBatch(const vector<unsigned int> &batch, unsigned int lod, const vector<MeshletVisibility> *visible)
+{
+    batchCounts.clear();
+    batchOffsets.clear();
+    batchBaseVertices.clear();
+    for(unsigned int i : batch)
+        meshes[i].appendDraws(lod, batchCounts, batchOffsets, batchBaseVertices, meshVisibility(visible, i));
+    if(!batchCounts.empty())
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, batchCounts.data(), meshes[batch[0]].indexType, batchOffsets.data(),
+                                      batchCounts.size(), batchBaseVertices.data());
+}
+
+void Model::buildDrawBatches()
+{
+    drawBatches.clear();
+    depthBatches.clear();
     for(unsigned int i = 0; i < meshes.size(); i++)
-        meshes[i].Draw(shader);
+    {
+        const Mesh &mesh = meshes[i];
+        bool merged = false;
+        for(vector<unsigned int> &batch : depthBatches)
+        {
+            const Mesh &first = meshes[batch[0]];
+            if(first.geometry.page == mesh.geometry.page && first.sameDecoding(mesh))
+            {
+                batch.push_back(i);
+                merged = true;
+                break;
+            }
+        }
+        if(!merged)
+            depthBatches.push_back(vector<unsigned int>(1, i));
+
+        merged = false;
+        for(vector<unsigned int> &batch : drawBatches)
+        {
+            const Mesh &first = meshes[batch[0]];
+            bool sameTextures = first.textures.size() == mesh.textures.size();
+            for(unsigned int t = 0; sameTextures && t < mesh.textures.size(); t++)
+                sameTextures = first.textures[t].id == mesh.textures[t].id && first.textures[t].type == mesh.textures[t].type;
+            if(sameTextures && first.geometry.page == mesh.geometry.page && first.sameDecoding(mesh))
+            {
+                batch.push_back(i);
+                merged = true;
+                break;
+            }
+        }
+        if(!merged)
+            drawBatches.push_back(vector<unsigned int>(1, i));
+    }
+}
+
+unsigned int Model::drawCallCount()
+{
+    return mergeDraws ? drawBatches.size() : meshes.size();
+}
+
+void Model::printImportReport(string const &path, double milliseconds)
+{
+    const ImportStatistics &statistics = importStatistics;
+    float removed = statistics.importedVertices ?
+        100.f * (statistics.importedVertices - statistics.weldedVertices) / statistics.importedVertices : 0.f;
+    std::cout << path << ": " << statistics.importedVertices << " vertices read in " << milliseconds << " ms, "
+              << statistics.weldedVertices << " after welding (" << removed << "% removed) in " << statistics.weldMilliseconds
+              << " ms, normals of " << statistics.meshesWithoutNormals << " meshes in " << statistics.normalMilliseconds
+              << " ms, tangents in " << statistics.tangentMilliseconds << " ms";
+    if(hasAmbientOcclusion())
+        std::cout << ", ambient occlusion in " << statistics.occlusionMilliseconds << " ms (" << statistics.occlusionRays
+                  << " rays)";
+    std::cout << endl;
+}
+
+vector<vector<unsigned int>> Model::groupTextureArrays(const vector<TextureLayout> &layouts, int maxLayers)
+{
+    vector<vector<unsigned int>> groups;
+    // the group that is being filled for each layout, in the order the layouts first appear
+    vector<unsigned int> open;
+    for(unsigned int t = 0; t < layouts.size(); t++)
+    {
+        const TextureLayout &layout = layouts[t];
+        if(layout.blockFormat < 0 && layout.components == 0)
+            continue;
+        auto found = std::find_if(open.begin(), open.end(), [&](unsigned int group)
+        {
+            const TextureLayout &other = layouts[groups[group][0]];
+            return other.type == layout.type && other.width == layout.width && other.height == layout.height &&
+                   other.blockFormat == layout.blockFormat && other.components == layout.components;
+        });
+        if(found != open.end() && (int) groups[*found].size() < maxLayers)
+        {
+            groups[*found].push_back(t);
+            continue;
+        }
+        // a full group stays full, the next textures go in a new one
+        if(found != open.end())
+            *found = groups.size();
+        else
+            open.push_back(groups.size());
+        groups.push_back(vector<unsigned int>(1, t));
+    }
+    return groups;
+}
+
+void Model::packTextureArrays()
+{
+    // the conditioned texture when there is one the GPU can sample, its format is read from the coarsest level
+    vector<TextureLayout> layouts(textures_loaded.size());
+    vector<string> sources(textures_loaded.size());
+    for(unsigned int t = 0; t < textures_loaded.size(); t++)
+    {
+        TextureLayout &layout = layouts[t];
+        layout.type = textures_loaded[t].type;
+        layout.blockFormat = -1;
+        layout.components = 0;
+        sources[t] = directory + '/' + textures_loaded[t].path;
+        if(conditionedTextures)
+        {
+            string container = texturecompressor::containerPath(sources[t], texturecompressor::kindOf(layout.type));
+            texturecompressor::CompressedTexture coarse;
+            if(!container.empty() && texturecompressor::readContainer(container, coarse, 1) &&
+               texturecompressor::isSupported(coarse.format))
+            {
+                layout.width = coarse.levels[0].width;
+                layout.height = coarse.levels[0].height;
+                layout.blockFormat = coarse.format;
+                sources[t] = container;
+                continue;
+            }
+        }
+        if(!stbi_info(sources[t].c_str(), &layout.width, &layout.height, &layout.components))
+        {
+            layout.components = 0;
+            std::cerr << "Texture failed to load at path: " << textures_loaded[t].path << std::endl;
+        }
+    }
+
+    GLint maxLayers;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    vector<vector<unsigned int>> groups = groupTextureArrays(layouts, std::min(maxLayers, 65536));
+    for(const vector<unsigned int> &group : groups)
+    {
+        const TextureLayout &layout = layouts[group[0]];
+        vector<string> files;
+        for(unsigned int t : group)
+            files.push_back(sources[t]);
+        unsigned int id = layout.blockFormat >= 0 ? compressedTextureArray(files) :
+                          textureArrayFromFiles(files, layout.width, layout.height, layout.components);
+        if(id == 0)
+            continue;
+        numberOfTextureArrays++;
+        for(unsigned int layer = 0; layer < group.size(); layer++)
+        {
+            textures_loaded[group[layer]].id = id;
+            textures_loaded[group[layer]].layer = layer;
+        }
+    }
+
+    // the textures of the meshes are copies of the ones loaded
+    for(Mesh &mesh : meshes)
+    {
+        for(Texture &texture : mesh.textures)
+        {
+            for(const Texture &loaded : textures_loaded)
+            {
+                if(loaded.path == texture.path)
+                {
+                    texture.id = loaded.id;
+                    texture.layer = loaded.layer;
+                    break;
+                }
+            }
+        }
+        mesh.setTextureLayers();
+    }
+}
+
+void Model::bakeAmbientOcclusion()
+{
+    if(ambientOcclusionSamples <= 0)
+        return;
+    auto start = std::chrono::steady_clock::now();
+    vector<const Mesh*> bakedMeshes;
+    for(Mesh &mesh : meshes)
+        bakedMeshes.push_back(&mesh);
+    vector<vector<float>> occlusion;
+    importStatistics.occlusionRays = ambientocclusion::bake(bakedMeshes, ambientOcclusionSamples, occlusion, ThreadPool::global());
+    for(size_t m = 0; m < meshes.size(); m++)
+        meshes[m].setAmbientOcclusion(std::move(occlusion[m]));
+    importStatistics.occlusionMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Model::printDrawReport(string const &path)
+{
+    const GeometryArena &arena = GeometryArena::global();
+    std::cout << path << ": " << meshes.size() << " meshes drawn with " << drawBatches.size() << " calls ("
+              << depthBatches.size() << " in the depth passes), geometry arena " << arena.usedBytes() / 1024
+              << " KiB used of " << arena.reservedBytes() / 1024 << " KiB in " << arena.numberOfPages() << " pages";
+    if(hasTextureArrays())
+        std::cout << ", " << textures_loaded.size() << " textures in " << numberOfTextureArrays << " texture arrays";
+    std::cout << endl;
 }
 
 void Model::calcBoundingBox()
@@ -91,7 +481,9 @@ void Model::loadModel(string const &path)
 {
     // read file via ASSIMP
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+    auto start = std::chrono::steady_clock::now();
+    const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
+    double readMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
     // check for errors
     if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
     {
@@ -103,6 +495,151 @@ void Model::loadModel(string const &path)
 
     // process ASSIMP's root node recursively
     processNode(scene->mRootNode, scene);
+    bakeAmbientOcclusion();
+    if(textureArrays && Mesh::uploadToGpu)
+        packTextureArrays();
+
+    printImportReport(path, readMilliseconds);
+    buildDrawBatches();
+    printDrawReport(path);
+    printVertexCacheReport(path);
+    // the errors are relative to the bounding box
+    calcBoundingBox();
+    printLodReport(path);
+    if(generateMeshlets)
+        printMeshletReport(path);
+    if(hasCompressedVertices())
+        printCompressionReport(path);
+}
+
+void Model::printCompressionReport(string const &path)
+{
+    size_t compressedBytes = 0, originalBytes = 0;
+    for(unsigned int i = 0; i < meshes.size(); i++)
+    {
+        const Mesh &mesh = meshes[i];
+        const CompressionError &error = mesh.compressionError;
+        // the position error relative to the size of the mesh
+        float diagonal = glm::length(mesh.positionScale);
+        std::cout << path << " mesh " << i << ": " << mesh.vertices.size() << " vertices, position error "
+                  << error.position << " (" << (diagonal > 0.f ? error.position / diagonal * 100.f : 0.f)
+                  << "% of the box diagonal), normal " << error.normal << " deg, tangent " << error.tangent
+                  << " deg, uv " << error.texCoords << endl;
+        compressedBytes += mesh.vertexBytes();
+        originalBytes += mesh.vertices.size() * sizeof(Vertex);
+    }
+    std::cout << path << ": " << originalBytes / 1024 << " KiB of vertices compressed to " << compressedBytes / 1024
+              << " KiB" << endl;
+}
+
+void Model::printVertexCacheReport(string const &path)
+{
+    size_t shortIndexMeshes = 0, indexBytes = 0, triangles = 0;
+    for(const Mesh &mesh : meshes)
+    {
+        shortIndexMeshes += mesh.indexType == GL_UNSIGNED_SHORT;
+        indexBytes += mesh.indexBytes();
+        triangles += mesh.lods[0].indexCount / 3;
+    }
+    std::cout << path << ": ACMR " << importedCacheStatistics.acmr() << " -> " << optimizedCacheStatistics.acmr()
+              << ", ATVR " << importedCacheStatistics.atvr() << " -> " << optimizedCacheStatistics.atvr()
+              << " (FIFO " << FIFO_CACHE_SIZE << "), " << shortIndexMeshes << " of " << meshes.size()
+              << " meshes with 16 bit indices, " << indexBytes / 1024 << " KiB of indices with the levels of detail ("
+              << triangles * 3 * sizeof(unsigned int) / 1024 << " KiB for the full meshes in 32 bits)" << endl;
+}
+
+void Model::printLodReport(string const &path)
+{
+    std::cout << path << ": levels of detail";
+    for(unsigned int lod = 0; lod < numberOfLods(); lod++)
+    {
+        std::cout << (lod ? ", " : " ") << triangleCount(lod) << " triangles (error "
+                  << lodError(lod) / boundingRadius() * 100.f << "% of the radius)";
+    }
+    std::cout << endl;
+}
+
+void Model::printMeshletReport(string const &path)
+{
+    size_t meshlets = 0, triangles = 0, vertices = 0;
+    for(const Mesh &mesh : meshes)
+    {
+        meshlets += mesh.meshlets.size();
+        for(const Meshlet &meshlet : mesh.meshlets)
+        {
+            triangles += meshlet.indexCount / 3;
+            vector<unsigned int> meshletIndices(mesh.indices.begin() + meshlet.indexOffset,
+                                                mesh.indices.begin() + meshlet.indexOffset + meshlet.indexCount);
+            std::sort(meshletIndices.begin(), meshletIndices.end());
+            vertices += std::unique(meshletIndices.begin(), meshletIndices.end()) - meshletIndices.begin();
+        }
+    }
+    if(!meshlets)
+        return;
+    std::cout << path << ": " << meshlets << " meshlets, " << (float) triangles / meshlets << " triangles and "
+              << (float) vertices / meshlets << " vertices on average" << endl;
+}
+
+size_t Model::cullMeshlets(const glm::vec3 &cameraPosition, const glm::vec4 planes[6], vector<MeshletVisibility> &visible) const
+{
+    visible.resize(meshes.size());
+    size_t triangles = 0;
+    for(unsigned int i = 0; i < meshes.size(); i++)
+        triangles += meshes[i].cullMeshlets(cameraPosition, planes, visible[i]);
+    return triangles;
+}
+
+void Model::setBakedLighting(unsigned int id, const vector<vector<BakedLighting>> &lighting)
+{
+    if(id == bakedLightingId || lighting.size() != meshes.size())
+        return;
+    for(unsigned int i = 0; i < meshes.size(); i++)
+        meshes[i].setBakedLighting(lighting[i]);
+    bakedLightingId = id;
+}
+
+unsigned int Model::numberOfLods()
+{
+    size_t lods = 1;
+    for(const Mesh &mesh : meshes)
+        lods = std::max(lods, mesh.lods.size());
+    return lods;
+}
+
+float Model::lodError(unsigned int lod)
+{
+    float error = 0.f;
+    for(const Mesh &mesh : meshes)
+        error = std::max(error, mesh.getLod(lod).error);
+    return error;
+}
+
+size_t Model::triangleCount(unsigned int lod)
+{
+    size_t triangles = 0;
+    for(const Mesh &mesh : meshes)
+        triangles += mesh.getLod(lod).indexCount / 3;
+    return triangles;
+}
+
+float Model::boundingRadius()
+{
+    return 0.5f * std::sqrt(boundingBox.x.size * boundingBox.x.size + boundingBox.y.size * boundingBox.y.size +
+                            boundingBox.z.size * boundingBox.z.size);
+}
+
+unsigned int Model::selectLod(unsigned int currentLod, float projectedRadius)
+{
+    // pixels covered by a unit of the model
+    float pixelsPerUnit = projectedRadius / boundingRadius();
+    unsigned int lod = std::min(currentLod, numberOfLods() - 1);
+    // a finer level as soon as the error is visible
+    while(lod > 0 && lodError(lod) * pixelsPerUnit > LOD_PIXEL_ERROR)
+        lod--;
+    // a coarser one only when its error is well below a pixel, so a model near the limit doesn't keep switching
+    while(lod + 1 < numberOfLods() && lodError(lod + 1) * pixelsPerUnit < LOD_PIXEL_ERROR * (1.f - LOD_HYSTERESIS))
+        lod++;
+    return lod;
 }
 
 void Model::processNode(aiNode *node, const aiScene *scene)
@@ -123,66 +660,73 @@ void Model::processNode(aiNode *node, const aiScene *scene)
 
 }
 
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
+void Model::readMesh(const aiMesh *mesh, vector<Vertex> &vertices, vector<unsigned int> &indices,
+                     ImportStatistics &statistics)
 {
-    // data to fill
-    vector<Vertex> vertices;
-    vector<unsigned int> indices;
-    vector<Texture> textures;
-
-    // Walk through each of the mesh's vertices
+    vertices.resize(mesh->mNumVertices);
     for(unsigned int i = 0; i < mesh->mNumVertices; i++)
     {
-        Vertex vertex;
-        glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
-        // positions
-        vector.x = mesh->mVertices[i].x;
-        vector.y = mesh->mVertices[i].y;
-        vector.z = mesh->mVertices[i].z;
-        vertex.Position = vector;
-        // normals
-        vector.x = mesh->mNormals[i].x;
-        vector.y = mesh->mNormals[i].y;
-        vector.z = mesh->mNormals[i].z;
-        vertex.Normal = vector;
-        // texture coordinates
-        if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
-        {
-            glm::vec2 vec;
-            // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't 
-            // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-            vec.x = mesh->mTextureCoords[0][i].x; 
-            vec.y = mesh->mTextureCoords[0][i].y;
-            vertex.TexCoords = vec;
-        }
-        else
-            vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-        // tangent
-        if(mesh->mTangents != NULL)
-        {
-            vector.x = mesh->mTangents[i].x;
-            vector.y = mesh->mTangents[i].y;
-            vector.z = mesh->mTangents[i].z;
-            vertex.Tangent = vector;
-        }
-        // bitangent
-        if(mesh->mBitangents != NULL)
-        {
-            vector.x = mesh->mBitangents[i].x;
-            vector.y = mesh->mBitangents[i].y;
-            vector.z = mesh->mBitangents[i].z;
-            vertex.Bitangent = vector;
-        }
-        vertices.push_back(vertex);
+        Vertex &vertex = vertices[i];
+        vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+        // the meshes without normals get them after the welding
+        vertex.Normal = mesh->mNormals ? glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z) : glm::vec3(0.f);
+        // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
+        // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
+        vertex.TexCoords = mesh->mTextureCoords[0] ? glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y)
+                                                   : glm::vec2(0.f);
+        vertex.Tangent = glm::vec3(0.f);
+        vertex.Bitangent = glm::vec3(0.f);
     }
-    // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+    indices.clear();
     for(unsigned int i = 0; i < mesh->mNumFaces; i++)
     {
-        aiFace face = mesh->mFaces[i];
-        // retrieve all indices of the face and store them in the indices vector
-        for(unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j]);
+        if(mesh->mFaces[i].mNumIndices == 3)
+            indices.insert(indices.end(), mesh->mFaces[i].mIndices, mesh->mFaces[i].mIndices + 3);
+    }
+    statistics.importedVertices += vertices.size();
+
+    auto start = std::chrono::steady_clock::now();
+    meshoptimizer::weldVertices(vertices, indices);
+    auto welded = std::chrono::steady_clock::now();
+    statistics.weldMilliseconds += std::chrono::duration<double, std::milli>(welded - start).count();
+    statistics.weldedVertices += vertices.size();
+
+    if(!mesh->mNormals)
+    {
+        meshoptimizer::generateNormals(vertices, indices);
+        statistics.meshesWithoutNormals++;
     }
+    auto normals = std::chrono::steady_clock::now();
+    statistics.normalMilliseconds += std::chrono::duration<double, std::milli>(normals - welded).count();
+
+    meshoptimizer::generateTangents(vertices, indices);
+    statistics.tangentMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - normals).count();
+}
+
+Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
+{
+    // data to fill
+    vector<Vertex> vertices;
+    vector<unsigned int> indices;
+    vector<Texture> textures;
+
+    readMesh(mesh, vertices, indices, importStatistics);
+    // reorder the triangles for the post-transform cache, then the vertices in the order the triangles read them
+    importedCacheStatistics += meshoptimizer::analyzeVertexCache(indices, vertices.size());
+    // the meshlets grow in the cache order, before the vertices are renumbered in the order of the meshlets
+    if(optimizeMeshes)
+        meshoptimizer::optimizeVertexCache(indices, vertices.size());
+    vector<Meshlet> meshlets;
+    if(generateMeshlets)
+        meshlets = meshoptimizer::buildMeshlets(vertices, indices);
+    if(optimizeMeshes)
+        meshoptimizer::optimizeVertexFetch(vertices, indices);
+    optimizedCacheStatistics += meshoptimizer::analyzeVertexCache(indices, vertices.size());
+
+    // the simplified levels of detail go after the full mesh in the index buffer
+    vector<MeshLod> lods;
+    if(generateLods)
+        lods = meshoptimizer::generateLods(vertices, indices, optimizeMeshes);
     // process materials
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
     // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -206,7 +750,7 @@ Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene)
     textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
     
     // return a mesh object created from the extracted mesh data
-    return Mesh(vertices, indices, textures);
+    return Mesh(vertices, indices, textures, lods, meshlets);
 }
 
 vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
@@ -230,7 +774,11 @@ vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type,
         if(!skip)
         {   // if texture hasn't been loaded already, load it
             Texture texture;
-            texture.id = TextureFromFile(str.C_Str(), this->directory);
+            // without OpenGL only the path is kept, the software renderer reads the image itself. The textures
+            // packed in arrays are uploaded by packTextureArrays
+            texture.id = Mesh::uploadToGpu && !textureArrays ? TextureFromFile(str.C_Str(), this->directory, false,
+                                                                                 texturecompressor::kindOf(typeName)) : 0;
+            texture.layer = -1;
             texture.type = typeName;
             texture.path = str.C_Str();
             textures.push_back(texture);
@@ -303,3 +851,33 @@ Dimension Model::zLimits()
 int Model::getNumberOfTexturesLoaded(){
     return textures_loaded.size();
 }
+
+bool Model::hasCompressedVertices()
+{
+    return !meshes.empty() && meshes[0].compressed;
+}
+
+bool Model::hasAmbientOcclusion()
+{
+    return !meshes.empty() && !meshes[0].ambientOcclusion.empty();
+}
+
+bool Model::hasTextureArrays()
+{
+    for(const Texture &texture : textures_loaded)
+    {
+        if(texture.layer >= 0)
+            return true;
+    }
+    return false;
+}
+
+bool Model::hasTextureType(const string &type)
+{
+    for(auto &texture : textures_loaded)
+    {
+        if(texture.type == type)
+            return true;
+    }
+    return false;
+}
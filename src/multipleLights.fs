@@ -0,0 +1,69 @@
+#version 330 core
+// lighting fragment shader, compiled with the same defines of multipleLights.vs
+
+#if defined(HAS_DIFFUSE_TEX) || defined(HAS_SPECULAR_TEX)
+#define HAS_TEX_COORDS
+#endif
+
+out vec4 FragColor;
+
+#include "materialTextures.glsl"
+
+#include "pointLight.glsl"
+
+#if defined(PHONG) || defined(BAKED)
+in vec3 FragPos;
+in vec3 Normal;
+in float Occlusion;
+#ifdef CLUSTERED
+in float ViewDepth;
+#endif
+#ifdef BAKED
+in vec3 BakedDiffuse;
+in vec3 BakedSpecular;
+in vec3 BakedLightDirection;
+#endif
+
+uniform vec3 viewPos;
+#else
+in vec3 LightingColor;
+#endif
+
+void main()
+{
+#if defined(PHONG) || defined(BAKED)
+    // properties
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    // material colors, fetched once for all the lights
+#ifdef HAS_DIFFUSE_TEX
+    vec3 diffuseColor = vec3(DiffuseTexel());
+#else
+    vec3 diffuseColor = objectColor;
+#endif
+#ifdef HAS_SPECULAR_TEX
+    vec3 specularColor = vec3(SpecularTexel());
+#else
+    vec3 specularColor = diffuseColor;
+#endif
+
+#if defined(BAKED)
+    // the specular term of CalcPointLight for the direction of the baked light, the rest is baked
+    vec3 reflectDir = reflect(-normalize(BakedLightDirection), norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+    FragColor = vec4(BakedDiffuse * diffuseColor + BakedSpecular * spec * specularColor, 1.0);
+#elif defined(CLUSTERED)
+    int cluster = ClusterIndex(gl_FragCoord.xy, ViewDepth);
+    FragColor = vec4(SumClusterLights(cluster, norm, FragPos, viewDir, diffuseColor, specularColor, Occlusion, objectColor), 1.0);
+#else
+    FragColor = vec4(SumPointLights(norm, FragPos, viewDir, diffuseColor, specularColor, Occlusion, objectColor), 1.0);
+#endif
+#else
+#ifdef HAS_DIFFUSE_TEX
+    FragColor = vec4(LightingColor, 1.0) * DiffuseTexel();
+#else
+    FragColor = vec4(LightingColor * objectColor, 1.0);
+#endif
+#endif
+}
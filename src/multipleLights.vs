@@ -0,0 +1,99 @@
+#version 330 core
+// lighting vertex shader, compiled with these defines:
+// PHONG: per fragment lighting, otherwise the lights are computed here (Gouraud)
+// HAS_DIFFUSE_TEX, HAS_SPECULAR_TEX: the model has these textures
+// NUM_POINT_LIGHTS: number of point lights in the scene
+// CLUSTERED: the lights come from the clusters of LightClusters
+// COMPRESSED_VERTICES: the mesh uses the compressed vertex layout (see vertexInput.glsl)
+// BAKED: the lights come baked in the vertices, only the specular term is computed, per fragment
+// AMBIENT_OCCLUSION: the vertices have their ambient occlusion, which darkens the ambient term
+// TEXTURE_ARRAYS: the textures are layers of texture arrays, the vertices have the layers (see materialTextures.glsl)
+
+#if defined(HAS_DIFFUSE_TEX) || defined(HAS_SPECULAR_TEX)
+#define HAS_TEX_COORDS
+#endif
+
+#include "vertexInput.glsl"
+
+#ifdef HAS_TEX_COORDS
+out vec2 TexCoords;
+#ifdef TEXTURE_ARRAYS
+flat out vec2 TextureLayers;
+#endif
+#endif
+
+#if defined(PHONG) || defined(BAKED)
+out vec3 FragPos;
+out vec3 Normal;
+out float Occlusion;
+#else
+out vec3 LightingColor; // resulting color from lighting calculations
+#endif
+#if defined(PHONG) && defined(CLUSTERED)
+out float ViewDepth; // distance in front of the camera, selects the depth slice of the cluster
+#endif
+#ifdef BAKED
+out vec3 BakedDiffuse;
+out vec3 BakedSpecular;
+out vec3 BakedLightDirection;
+#endif
+
+#include "pointLight.glsl"
+
+// the same depth of depth.vs, for the GL_EQUAL test after the depth pre-pass
+invariant gl_Position;
+
+uniform vec3 viewPos;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// transpose(inverse(mat3(model))), computed on the CPU once per object
+uniform mat3 normalMatrix;
+// false when the normal matrix isn't sent (instanced paths), then it's computed here
+uniform bool hasNormalMatrix;
+
+void main()
+{
+    vec3 pos = vec3(model * vec4(VertexPosition(), 1.0));
+    vec3 normal;
+    if(hasNormalMatrix)
+        normal = normalMatrix * VertexNormal();
+    else
+        normal = mat3(transpose(inverse(model))) * VertexNormal();
+
+#ifdef HAS_TEX_COORDS
+    TexCoords = aTexCoords;
+#ifdef TEXTURE_ARRAYS
+    TextureLayers = aTextureLayers;
+#endif
+#endif
+
+    vec4 viewPosition = view * vec4(pos, 1.0);
+    gl_Position = projection * viewPosition;
+
+#if defined(PHONG) || defined(BAKED)
+    FragPos = pos;
+    Normal = normal;
+    Occlusion = VertexOcclusion();
+#ifdef CLUSTERED
+    ViewDepth = -viewPosition.z;
+#endif
+#ifdef BAKED
+    BakedDiffuse = aBakedDiffuse.rgb;
+    BakedSpecular = aBakedSpecular;
+    BakedLightDirection = aBakedLightDirection;
+#endif
+#else
+    vec3 norm = normalize(normal);
+    vec3 viewDir = normalize(viewPos - pos);
+    // the material color is applied in the fragment shader
+#ifdef CLUSTERED
+    vec2 windowPos = (gl_Position.xy / gl_Position.w * 0.5 + 0.5) * clusterViewport;
+    LightingColor = SumClusterLights(ClusterIndex(windowPos, -viewPosition.z), norm, pos, viewDir, vec3(1.0), vec3(1.0), VertexOcclusion(), vec3(1.0));
+#else
+    LightingColor = SumPointLights(norm, pos, viewDir, vec3(1.0), vec3(1.0), VertexOcclusion(), vec3(1.0));
+#endif
+#endif
+}
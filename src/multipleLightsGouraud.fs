@@ -1,13 +0,0 @@
-#version 330 core
-out vec4 FragColor;
-
-in vec3 LightingColor;
-
-uniform vec3 objectColor;
-
-void main()
-{
-   FragColor = vec4(LightingColor * objectColor, 1.0);
-}
-
-
@@ -1,22 +0,0 @@
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-//layout (location = 2) in vec2 aTexCoords;
-
-out vec3 FragPos;
-out vec3 Normal;
-//out vec2 TexCoords;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;  
-    //TexCoords = aTexCoords;
-    //TexCoords = vec3(1.0, 0.5, 0.31);
-    
-    gl_Position = projection * view * vec4(FragPos, 1.0); //TODO shoud I multiply the model matrix here too?
-}
\ No newline at end of file
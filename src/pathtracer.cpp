@@ -0,0 +1,295 @@
+#include <pathtracer.hpp>
+#include <camera.hpp>
+#include <lightclusters.hpp>
+#include <matrixlib.hpp>
+#include <mesh.hpp>
+#include <model.hpp>
+#include <threadpool.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+using namespace graphicslib;
+
+//objectColor of pointLight.glsl, the shininess sent by Window and the clear color of Window::run
+static const glm::vec3 OBJECT_COLOR(1.f, 0.5f, 0.31f);
+static const float SHININESS = 32.f;
+static const float CLEAR_COLOR = 0.05f;
+static const float PI = 3.14159265f;
+
+//a well mixed 32 bits number from another (the hash of PCG)
+static unsigned int mixBits(unsigned int value){
+    unsigned int state = value * 747796405u + 2891336453u;
+    unsigned int word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+//next number of a sequence in [0, 1)
+static float random(unsigned int &state){
+    state = mixBits(state);
+    return (state >> 8) * (1.f / 16777216.f);
+}
+
+//a color in [0, 1] to 8 bits, as it's written to the default framebuffer
+static unsigned char toByte(float value){
+    return (unsigned char) std::lround(std::min(std::max(value, 0.f), 1.f) * 255.f);
+}
+
+PathTracer::PathTracer(int width, int height, ThreadPool &pool) : pool(pool){
+    this->width = std::max(width, 1);
+    this->height = std::max(height, 1);
+    tilesX = (this->width + PATH_TRACER_TILE_SIZE - 1) / PATH_TRACER_TILE_SIZE;
+    tilesY = (this->height + PATH_TRACER_TILE_SIZE - 1) / PATH_TRACER_TILE_SIZE;
+    rayOffset = 0.f;
+    inverseViewProjection = glm::mat4(1.f);
+    viewPosition = glm::vec3(0.f);
+    rays = 0;
+    buildTime = 0.0;
+    clear();
+}
+
+PathTracer::PathTracer(int width, int height) : PathTracer(width, height, ThreadPool::global()){
+}
+
+void PathTracer::setScene(SceneObjects &objects, const LightingInformation &lightingInformation, Camera &camera){
+    //the matrices OpenGL uses are the transposes of the view and the projection, and the model matrix itself
+    ml::matrix<float> projection = getProjectionMatrix();
+    ml::matrix<float> view = camera.GetViewMatrix();
+    ml::matrix<float> worldToClip = projection.transpose() * view.transpose();
+    std::vector<const Mesh*> meshes;
+    std::vector<glm::mat4> modelMatrices;
+    std::vector<std::string> directories;
+    for(unsigned int object = 0; object < objects.size(); object++){
+        const Model &model = *objects.model(object).model;
+        for(const Mesh &mesh : model.meshes){
+            meshes.push_back(&mesh);
+            modelMatrices.push_back(objects.worldMatrix(object));
+            directories.push_back(model.directory);
+        }
+    }
+    setScene(meshes, modelMatrices, directories, lightingInformation, toGlm(worldToClip), camera.Position);
+}
+
+void PathTracer::setScene(const std::vector<const Mesh*> &meshes, const std::vector<glm::mat4> &modelMatrices,
+                          const std::vector<std::string> &directories, const LightingInformation &lightingInformation,
+                          const glm::mat4 &viewProjection, const glm::vec3 &viewPosition){
+    lighting = lightingInformation;
+    inverseViewProjection = glm::inverse(viewProjection);
+    this->viewPosition = viewPosition;
+    positions.clear();
+    normals.clear();
+    texCoords.clear();
+    indices.clear();
+    triangleMaterials.clear();
+    materials.clear();
+
+    //the full detail triangles of every mesh, in the world
+    for(size_t m = 0; m < meshes.size(); m++){
+        const Mesh &mesh = *meshes[m];
+        const glm::mat4 &model = modelMatrices[m];
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+        unsigned int firstVertex = positions.size();
+        for(const ::Vertex &vertex : mesh.vertices){
+            positions.push_back(glm::vec3(model * glm::vec4(vertex.Position, 1.f)));
+            normals.push_back(glm::normalize(normalMatrix * vertex.Normal));
+            texCoords.push_back(vertex.TexCoords);
+        }
+        const MeshLod &level = mesh.getLod(0);
+        for(unsigned int i = level.indexOffset; i < level.indexOffset + level.indexCount; i++){
+            indices.push_back(firstVertex + mesh.indices[i]);
+        }
+        triangleMaterials.insert(triangleMaterials.end(), level.indexCount / 3, materials.size());
+
+        //the first texture of each type is the one the shaders sample (texture_diffuse1 and texture_specular1)
+        Material material{NULL, NULL};
+        for(const Texture &texture : mesh.textures){
+            if(texture.type == "texture_diffuse" && !material.diffuse){
+                material.diffuse = textures.get(directories[m], texture.path);
+            }else if(texture.type == "texture_specular" && !material.specular){
+                material.specular = textures.get(directories[m], texture.path);
+            }
+        }
+        materials.push_back(material);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bvh.build(positions, indices, pool);
+    buildTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    rayOffset = 1e-5f * glm::length(bvh.boundsMax() - bvh.boundsMin()) + 1e-6f;
+    clear();
+}
+
+glm::vec3 PathTracer::tracePath(glm::vec3 origin, glm::vec3 direction, unsigned int &randomState,
+                                size_t &rayCount) const{
+    glm::vec3 color(0.f), throughput(1.f);
+    for(int bounce = 0; bounce <= PATH_TRACER_MAX_BOUNCES; bounce++){
+        BvhHit hit;
+        rayCount++;
+        if(!bvh.intersect(origin, direction, FLT_MAX, hit)){
+            //the clear color is seen behind the models, it doesn't light them
+            if(bounce == 0){
+                color += glm::vec3(CLEAR_COLOR);
+            }
+            break;
+        }
+
+        unsigned int i0 = indices[3 * hit.triangle], i1 = indices[3 * hit.triangle + 1], i2 = indices[3 * hit.triangle + 2];
+        float w = 1.f - hit.u - hit.v;
+        glm::vec3 position = origin + direction * hit.distance;
+        //the side of the triangle the ray comes from is lit
+        glm::vec3 faceNormal = glm::normalize(glm::cross(positions[i1] - positions[i0], positions[i2] - positions[i0]));
+        if(glm::dot(faceNormal, direction) > 0.f){
+            faceNormal = -faceNormal;
+        }
+        glm::vec3 normal = w * normals[i0] + hit.u * normals[i1] + hit.v * normals[i2];
+        normal = glm::length(normal) > 0.f ? glm::normalize(normal) : faceNormal;
+        if(glm::dot(normal, faceNormal) < 0.f){
+            normal = -normal;
+        }
+
+        const Material &material = materials[triangleMaterials[hit.triangle]];
+        glm::vec2 coordinates = w * texCoords[i0] + hit.u * texCoords[i1] + hit.v * texCoords[i2];
+        glm::vec3 diffuseColor = material.diffuse ? material.diffuse->sampleLevel(0, coordinates) : OBJECT_COLOR;
+        glm::vec3 specularColor = material.specular ? material.specular->sampleLevel(0, coordinates) : diffuseColor;
+
+        //CalcPointLight of pointLight.glsl without the ambient term, for the lights that aren't blocked
+        glm::vec3 surface = position + faceNormal * rayOffset;
+        glm::vec3 viewDirection = -direction;
+        for(const PointLight &light : lighting.pointLights){
+            glm::vec3 toLight = light.position - surface;
+            float distance = glm::length(toLight);
+            glm::vec3 lightDirection = toLight / distance;
+            float diffuse = glm::dot(normal, lightDirection);
+            if(diffuse <= 0.f || glm::dot(faceNormal, lightDirection) <= 0.f){
+                continue;
+            }
+            rayCount++;
+            if(bvh.occluded(surface, lightDirection, distance)){
+                continue;
+            }
+            float specular = std::pow(std::max(glm::dot(viewDirection, glm::reflect(-lightDirection, normal)), 0.f), SHININESS);
+            float attenuation = 1.f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+            color += throughput * attenuation * (POINT_LIGHT_KD * light.diffuse * diffuse * diffuseColor +
+                                                 POINT_LIGHT_KS * light.specular * specular * specularColor);
+        }
+
+        //the diffuse term reflects KD times the diffuse color of the light that arrives, from any direction.
+        //The directions are drawn with the density of the cosine, so the albedo is the weight of the path
+        throughput *= POINT_LIGHT_KD * diffuseColor;
+        if(bounce >= PATH_TRACER_ROULETTE_BOUNCE){
+            float survival = std::min(std::max(std::max(throughput.x, throughput.y), throughput.z), 0.95f);
+            if(random(randomState) >= survival){
+                break;
+            }
+            throughput /= survival;
+        }
+        float angle = 2.f * PI * random(randomState);
+        float radius2 = random(randomState);
+        float radius = std::sqrt(radius2);
+        glm::vec3 tangent = glm::normalize(glm::cross(std::abs(normal.x) > 0.5f ? glm::vec3(0.f, 1.f, 0.f) : glm::vec3(1.f, 0.f, 0.f), normal));
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+        direction = tangent * (radius * std::cos(angle)) + bitangent * (radius * std::sin(angle)) +
+                    normal * std::sqrt(std::max(1.f - radius2, 0.f));
+        //the shading normal can point the direction under the triangle
+        if(glm::dot(direction, faceNormal) <= 0.f){
+            break;
+        }
+        origin = surface;
+    }
+    return color;
+}
+
+void PathTracer::traceTile(int tile, int firstSample, int samplesPerPixel, size_t &rayCount){
+    int minX = (tile % tilesX) * PATH_TRACER_TILE_SIZE, minY = (tile / tilesX) * PATH_TRACER_TILE_SIZE;
+    int maxX = std::min(minX + PATH_TRACER_TILE_SIZE, width), maxY = std::min(minY + PATH_TRACER_TILE_SIZE, height);
+    for(int y = minY; y < maxY; y++){
+        for(int x = minX; x < maxX; x++){
+            glm::vec3 sum(0.f);
+            unsigned int pixelSeed = mixBits((unsigned int) (y * width + x) * 0x9E3779B9u);
+            for(int s = firstSample; s < firstSample + samplesPerPixel; s++){
+                unsigned int randomState = mixBits(pixelSeed ^ mixBits(s));
+                //from the eye through a random point of the pixel. The point of the far plane is in homogeneous
+                //coordinates, when w is negative it's behind the eye (the projection of the window does that)
+                float ndcX = (x + random(randomState)) / width * 2.f - 1.f;
+                float ndcY = (y + random(randomState)) / height * 2.f - 1.f;
+                glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.f, 1.f);
+                glm::vec3 direction = glm::normalize(glm::vec3(farPoint) - viewPosition * farPoint.w);
+                sum += tracePath(viewPosition, direction, randomState, rayCount);
+            }
+            accumulated[(size_t) y * width + x] += sum;
+        }
+    }
+}
+
+void PathTracer::addSamples(int samplesPerPixel){
+    std::vector<size_t> tileRays(tilesX * tilesY, 0);
+    //one tile at a time, the threads that finish first take the next ones
+    pool.parallelFor(0, tilesX * tilesY, 1, [&](int begin, int end){
+        for(int tile = begin; tile < end; tile++){
+            traceTile(tile, sampleCount, samplesPerPixel, tileRays[tile]);
+        }
+    });
+    rays = 0;
+    for(size_t count : tileRays){
+        rays += count;
+    }
+    sampleCount += samplesPerPixel;
+}
+
+void PathTracer::clear(){
+    accumulated.assign((size_t) width * height, glm::vec3(0.f));
+    sampleCount = 0;
+}
+
+bool PathTracer::writeImage(const std::string &path) const{
+    std::ofstream file(path, std::ios::binary);
+    if(!file){
+        std::cerr << "ERROR::PATH_TRACER::IMAGE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    //the rows of the file go from the top
+    file << "P6\n" << width << " " << height << "\n255\n";
+    std::vector<unsigned char> row((size_t) width * 3);
+    for(int y = height - 1; y >= 0; y--){
+        for(int x = 0; x < width; x++){
+            glm::vec3 color = pixel(x, y);
+            for(int c = 0; c < 3; c++){
+                row[3 * x + c] = toByte(color[c]);
+            }
+        }
+        file.write((const char*) row.data(), row.size());
+    }
+    return (bool) file;
+}
+
+glm::vec3 PathTracer::pixel(int x, int y) const{
+    return sampleCount ? accumulated[(size_t) y * width + x] / (float) sampleCount : glm::vec3(0.f);
+}
+
+int PathTracer::getWidth() const{
+    return width;
+}
+
+int PathTracer::getHeight() const{
+    return height;
+}
+
+int PathTracer::samples() const{
+    return sampleCount;
+}
+
+size_t PathTracer::raysTraced() const{
+    return rays;
+}
+
+double PathTracer::buildMilliseconds() const{
+    return buildTime;
+}
+
+const Bvh& PathTracer::getBvh() const{
+    return bvh;
+}
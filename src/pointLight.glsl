@@ -0,0 +1,128 @@
+// point lights and the lighting model shared by the lighting shaders.
+// NUM_POINT_LIGHTS is injected by the program when it compiles the variant, so the loops unroll.
+// Without it, the number of lights comes from a uniform, limited to MAX_POINT_LIGHT_NUMBER.
+// With CLUSTERED, the lights come from texture buffers filled by LightClusters and each
+// fragment only uses the lights of its cluster (SumClusterLights), without a limit.
+
+struct PointLight {
+    vec3 position;
+
+    float constant;
+    float linear;
+    float quadratic;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+#if defined(CLUSTERED)
+// 4 texels per light: position and constant, ambient and linear, diffuse and quadratic, specular and radius
+uniform samplerBuffer lightData;
+// offset and count of the lights of each cluster in lightIndices
+uniform usamplerBuffer clusterLights;
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterGridSize;
+uniform vec2 clusterViewport;
+// depth slice = log(view depth) * clusterSliceScale - clusterSliceBias
+uniform float clusterSliceScale;
+uniform float clusterSliceBias;
+uniform int numberOfPointLights;
+#elif defined(NUM_POINT_LIGHTS)
+    #define POINT_LIGHT_COUNT NUM_POINT_LIGHTS
+    #if NUM_POINT_LIGHTS > 0
+uniform PointLight pointLights[NUM_POINT_LIGHTS];
+    #else
+        #define NO_POINT_LIGHTS
+    #endif
+#else
+    #define MAX_POINT_LIGHT_NUMBER 100
+    #define POINT_LIGHT_COUNT numberOfPointLights
+uniform PointLight pointLights[MAX_POINT_LIGHT_NUMBER];
+uniform int numberOfPointLights;
+#endif
+
+uniform float shininess; //ns
+
+// color of the objects without diffuse texture
+const vec3 objectColor = vec3(1.0, 0.5, 0.31);
+
+// reflection coefficients
+const float ka = 0.01;
+const float kd = 0.1;
+const float ks = 0.1;
+
+// calculates the color when using a point light, occlusion is the ambient occlusion of the surface (1 when unoccluded).
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 pos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float occlusion){
+    // L (Light vector)
+    vec3 lightDir = normalize(light.position - pos);
+    // N * L (diffuse shading)
+    float diff = max(dot(normal, lightDir), 0.0);
+    // R (reflection vector)
+    vec3 reflectDir = reflect(-lightDir, normal);
+    // (N * R)^ns (specular shading)
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), shininess);
+
+    // calculate the distance between the light and the fragment
+    float distance = length(light.position - pos);
+    // calculate attenuation
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    // combine results
+    vec3 ambient = ka * light.ambient * diffuseColor * occlusion;
+    vec3 diffuse = kd * light.diffuse * diff * diffuseColor;
+    vec3 specular = ks * light.specular * spec * specularColor;
+
+    return (ambient + diffuse + specular) * attenuation;
+}
+
+#ifdef CLUSTERED
+PointLight FetchPointLight(int index){
+    vec4 positionConstant = texelFetch(lightData, 4 * index);
+    vec4 ambientLinear = texelFetch(lightData, 4 * index + 1);
+    vec4 diffuseQuadratic = texelFetch(lightData, 4 * index + 2);
+    vec4 specular = texelFetch(lightData, 4 * index + 3);
+    return PointLight(positionConstant.xyz, positionConstant.w, ambientLinear.w, diffuseQuadratic.w,
+                      ambientLinear.xyz, diffuseQuadratic.xyz, specular.xyz);
+}
+
+// cluster of a point from its window position and its distance in front of the camera
+int ClusterIndex(vec2 windowPos, float viewDepth){
+    ivec2 tile = clamp(ivec2(windowPos / clusterViewport * vec2(clusterGridSize.xy)), ivec2(0), clusterGridSize.xy - 1);
+    int slice = clamp(int(log(max(viewDepth, 1e-6)) * clusterSliceScale - clusterSliceBias), 0, clusterGridSize.z - 1);
+    return (slice * clusterGridSize.y + tile.y) * clusterGridSize.x + tile.x;
+}
+
+// sum the contribution of the lights of a cluster, noLightColor is used when the scene has no lights
+vec3 SumClusterLights(int cluster, vec3 normal, vec3 pos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float occlusion,
+                      vec3 noLightColor){
+    if(numberOfPointLights == 0){
+        return noLightColor;
+    }
+
+    uvec2 range = texelFetch(clusterLights, cluster).xy;
+    vec3 result = vec3(0.0);
+    for(uint i = 0u; i < range.y; i++){
+        int index = int(texelFetch(lightIndices, int(range.x + i)).x);
+        result += CalcPointLight(FetchPointLight(index), normal, pos, viewDir, diffuseColor, specularColor, occlusion);
+    }
+    return result;
+}
+#else
+// sum the point lights contribution, noLightColor is used when the scene has no lights
+vec3 SumPointLights(vec3 normal, vec3 pos, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float occlusion, vec3 noLightColor){
+#ifdef NO_POINT_LIGHTS
+    return noLightColor;
+#else
+    if(POINT_LIGHT_COUNT == 0){
+        return noLightColor;
+    }
+
+    vec3 result = vec3(0.0);
+    for(int i = 0; i < POINT_LIGHT_COUNT; i++){
+        result += CalcPointLight(pointLights[i], normal, pos, viewDir, diffuseColor, specularColor, occlusion);
+    }
+    return result;
+#endif
+}
+#endif
@@ -0,0 +1,314 @@
+#include <scenefile.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace scenefile {
+
+    //the characters between the words of a line
+    static bool isBlank(char c){
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    //the words and the numbers of a line, read in place
+    struct LineReader{
+        const char *current;
+        const char *end;
+
+        void skipBlanks(){
+            while(current < end && isBlank(*current)){
+                current++;
+            }
+        }
+
+        //the next word, empty at the end of the line
+        std::string_view word(){
+            skipBlanks();
+            const char *start = current;
+            while(current < end && !isBlank(*current)){
+                current++;
+            }
+            return std::string_view(start, current - start);
+        }
+
+        //false if the next word isn't a number
+        bool number(float &value){
+            skipBlanks();
+            //from_chars doesn't take the sign +, the stream the files were read with did
+            const char *start = current < end && *current == '+' ? current + 1 : current;
+            if(start != current && start < end && *start == '-'){
+                return false;
+            }
+            std::from_chars_result result = std::from_chars(start, end, value);
+            if(result.ec != std::errc() || (result.ptr < end && !isBlank(*result.ptr))){
+                return false;
+            }
+            current = result.ptr;
+            return true;
+        }
+
+        bool vector(glm::vec3 &value){
+            return number(value.x) && number(value.y) && number(value.z);
+        }
+    };
+
+    bool SceneLight::operator==(const SceneLight &other) const{
+        return position == other.position && color == other.color && linear == other.linear &&
+               constant == other.constant && quadratic == other.quadratic;
+    }
+
+    bool SceneDiff::empty() const{
+        return movedObjects.empty() && addedObjects.empty() && removedObjects.empty() && changedLights.empty() &&
+               removedLights == 0 && !cameraChanged;
+    }
+
+    size_t parse(const char *begin, const char *end, Scene &scene){
+        scene = Scene();
+        //the paths are looked up in the text, only the new ones are copied
+        std::unordered_map<std::string_view, unsigned int> pathIndices;
+        size_t skipped = 0;
+        size_t lineNumber = 0;
+        const char *line = begin;
+        while(line < end){
+            const char *lineEnd = (const char*) std::memchr(line, '\n', end - line);
+            if(!lineEnd){
+                lineEnd = end;
+            }
+            lineNumber++;
+
+            LineReader reader = {line, lineEnd};
+            std::string_view firstWord = reader.word();
+            bool read = true;
+            if(firstWord == "object"){
+                std::string_view path = reader.word();
+                SceneObject object;
+                read = !path.empty() && reader.vector(object.position);
+                if(read){
+                    auto found = pathIndices.find(path);
+                    if(found == pathIndices.end()){
+                        found = pathIndices.emplace(path, scene.paths.size()).first;
+                        scene.paths.emplace_back(path);
+                    }
+                    object.path = found->second;
+                    scene.objects.push_back(object);
+                }
+            }else if(firstWord == "light"){
+                SceneLight light;
+                read = reader.vector(light.position) && reader.vector(light.color) && reader.number(light.linear) &&
+                       reader.number(light.constant) && reader.number(light.quadratic);
+                if(read){
+                    scene.lights.push_back(light);
+                }
+            }else if(firstWord == "camera"){
+                glm::vec3 position, lookAt, up;
+                read = reader.vector(position) && reader.vector(lookAt) && reader.vector(up);
+                if(read){
+                    scene.hasCamera = true;
+                    scene.cameraPosition = position;
+                    scene.cameraLookAt = lookAt;
+                    scene.cameraUp = up;
+                }
+            }
+            if(!read){
+                std::cerr << "ERROR::SCENEFILE::LINE_NOT_READ " << lineNumber << ": "
+                          << std::string_view(line, lineEnd - line) << std::endl;
+                skipped++;
+            }
+            line = lineEnd < end ? lineEnd + 1 : end;
+        }
+        return skipped;
+    }
+
+    bool read(const std::string &path, Scene &scene){
+        int file = open(path.c_str(), O_RDONLY);
+        if(file < 0){
+            return false;
+        }
+        struct stat status;
+        if(fstat(file, &status) != 0){
+            close(file);
+            return false;
+        }
+        size_t size = status.st_size;
+        //an empty file can't be mapped
+        if(size == 0){
+            close(file);
+            parse(NULL, NULL, scene);
+            return true;
+        }
+        void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+        //the mapping stays after the file is closed
+        close(file);
+        if(data == MAP_FAILED){
+            return false;
+        }
+        madvise(data, size, MADV_SEQUENTIAL);
+        parse((const char*) data, (const char*) data + size, scene);
+        munmap(data, size);
+        return true;
+    }
+
+    //an object as the diff compares it: the path in the indices of the next scene and the bits of the position,
+    //so the positions that are the same compare equal whatever they are (NaN included)
+    struct ObjectKey{
+        std::array<unsigned int, 4> key;
+        unsigned int object;
+
+        bool operator<(const ObjectKey &other) const{
+            return key < other.key;
+        }
+    };
+
+    static ObjectKey objectKey(const SceneObject &object, unsigned int path, unsigned int index){
+        ObjectKey key;
+        key.key[0] = path;
+        std::memcpy(&key.key[1], &object.position, sizeof(glm::vec3));
+        key.object = index;
+        return key;
+    }
+
+    SceneDiff diff(const Scene &previous, const Scene &next){
+        SceneDiff result;
+        result.previousObjects.assign(next.objects.size(), -1);
+
+        //the paths of the previous scene in the indices of the next one, the ones it doesn't have after them
+        std::unordered_map<std::string_view, unsigned int> nextPaths;
+        for(unsigned int p = 0; p < next.paths.size(); p++){
+            nextPaths.emplace(next.paths[p], p);
+        }
+        std::vector<unsigned int> previousPaths(previous.paths.size());
+        for(unsigned int p = 0; p < previous.paths.size(); p++){
+            auto found = nextPaths.find(previous.paths[p]);
+            previousPaths[p] = found != nextPaths.end() ? found->second : next.paths.size() + p;
+        }
+
+        //an edit changes a few lines: the objects before and after them are the same in both scenes, at the same
+        //distance from the start and from the end
+        auto sameObject = [&](unsigned int p, unsigned int n){
+            return previousPaths[previous.objects[p].path] == next.objects[n].path &&
+                   std::memcmp(&previous.objects[p].position, &next.objects[n].position, sizeof(glm::vec3)) == 0;
+        };
+        unsigned int first = 0;
+        unsigned int common = std::min(previous.objects.size(), next.objects.size());
+        while(first < common && sameObject(first, first)){
+            result.previousObjects[first] = first;
+            first++;
+        }
+        unsigned int previousEnd = previous.objects.size(), nextEnd = next.objects.size();
+        while(previousEnd > first && nextEnd > first && sameObject(previousEnd - 1, nextEnd - 1)){
+            result.previousObjects[--nextEnd] = --previousEnd;
+        }
+
+        //the objects between them sorted by path and position, the ones that are in both meet in the merge
+        std::vector<ObjectKey> previousKeys;
+        for(unsigned int o = first; o < previousEnd; o++){
+            previousKeys.push_back(objectKey(previous.objects[o], previousPaths[previous.objects[o].path], o));
+        }
+        std::vector<ObjectKey> nextKeys;
+        for(unsigned int o = first; o < nextEnd; o++){
+            nextKeys.push_back(objectKey(next.objects[o], next.objects[o].path, o));
+        }
+        std::sort(previousKeys.begin(), previousKeys.end());
+        std::sort(nextKeys.begin(), nextKeys.end());
+
+        //what is left of each one, still sorted by path
+        std::vector<ObjectKey> previousLeft, nextLeft;
+        size_t p = 0, n = 0;
+        while(p < previousKeys.size() || n < nextKeys.size()){
+            if(n == nextKeys.size() || (p < previousKeys.size() && previousKeys[p] < nextKeys[n])){
+                previousLeft.push_back(previousKeys[p++]);
+            }else if(p == previousKeys.size() || nextKeys[n] < previousKeys[p]){
+                nextLeft.push_back(nextKeys[n++]);
+            }else{
+                result.previousObjects[nextKeys[n++].object] = previousKeys[p++].object;
+            }
+        }
+
+        //the objects left of the same model are moved, the others are added or removed
+        p = 0;
+        n = 0;
+        while(p < previousLeft.size() || n < nextLeft.size()){
+            if(n == nextLeft.size() || (p < previousLeft.size() && previousLeft[p].key[0] < nextLeft[n].key[0])){
+                result.removedObjects.push_back(previousLeft[p++].object);
+            }else if(p == previousLeft.size() || nextLeft[n].key[0] < previousLeft[p].key[0]){
+                result.addedObjects.push_back(nextLeft[n++].object);
+            }else{
+                result.previousObjects[nextLeft[n].object] = previousLeft[p++].object;
+                result.movedObjects.push_back(nextLeft[n++].object);
+            }
+        }
+        std::sort(result.movedObjects.begin(), result.movedObjects.end());
+        std::sort(result.addedObjects.begin(), result.addedObjects.end());
+        std::sort(result.removedObjects.begin(), result.removedObjects.end());
+
+        for(unsigned int l = 0; l < next.lights.size(); l++){
+            if(l >= previous.lights.size() || !(previous.lights[l] == next.lights[l])){
+                result.changedLights.push_back(l);
+            }
+        }
+        result.removedLights = previous.lights.size() > next.lights.size() ? previous.lights.size() - next.lights.size() : 0;
+
+        result.cameraChanged = next.hasCamera && (!previous.hasCamera || previous.cameraPosition != next.cameraPosition ||
+                                                  previous.cameraLookAt != next.cameraLookAt || previous.cameraUp != next.cameraUp);
+        return result;
+    }
+}
+
+SceneWatcher::SceneWatcher(const std::string &path){
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    fileName = slash == std::string::npos ? path : path.substr(slash + 1);
+    notifier = -1;
+#ifdef __linux__
+    notifier = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    //the directory is watched, the file itself may be replaced by another one
+    if(notifier >= 0 && inotify_add_watch(notifier, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0){
+        close(notifier);
+        notifier = -1;
+    }
+#endif
+    if(notifier < 0){
+        std::cerr << "ERROR::SCENEFILE::NOT_WATCHED " << path << std::endl;
+    }
+}
+
+SceneWatcher::~SceneWatcher(){
+    if(notifier >= 0){
+        close(notifier);
+    }
+}
+
+bool SceneWatcher::changed(){
+    bool written = false;
+#ifdef __linux__
+    if(notifier < 0){
+        return false;
+    }
+    //the events of the directory since the last call, aligned for the struct
+    alignas(struct inotify_event) char events[4096];
+    ssize_t size;
+    while((size = ::read(notifier, events, sizeof(events))) > 0){
+        for(char *event = events; event < events + size;){
+            const struct inotify_event *notification = (const struct inotify_event*) event;
+            if(notification->len && fileName == notification->name){
+                written = true;
+            }
+            event += sizeof(struct inotify_event) + notification->len;
+        }
+    }
+#endif
+    return written;
+}
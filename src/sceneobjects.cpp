@@ -0,0 +1,299 @@
+#include <sceneobjects.hpp>
+#include <graphicslib.hpp>
+#include <model.hpp>
+#include <threadpool.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+bool ObjectHandle::operator==(const ObjectHandle &other) const{
+    return slot == other.slot && generation == other.generation;
+}
+
+bool ObjectHandle::operator!=(const ObjectHandle &other) const{
+    return !(*this == other);
+}
+
+ObjectHandle SceneObjects::add(const graphicslib::ModelInformation &modelInfo, const Transform &transform){
+    std::uint32_t slot;
+    if(freeSlots.empty()){
+        slot = slotIndices.size();
+        slotIndices.push_back(0);
+        slotGenerations.push_back(0);
+    }else{
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    unsigned int index = models.size();
+    slotIndices[slot] = index;
+    objectSlots.push_back(slot);
+    models.push_back(modelInfo);
+    resize(models.size());
+
+    //the bounding sphere of the box of the model
+    Model *model = modelInfo.model.get();
+    components[MODEL_CENTER_X][index] = model ? model->boundingBox.x.center : 0.f;
+    components[MODEL_CENTER_Y][index] = model ? model->boundingBox.y.center : 0.f;
+    components[MODEL_CENTER_Z][index] = model ? model->boundingBox.z.center : 0.f;
+    components[MODEL_RADIUS][index] = model ? model->boundingRadius() : 0.f;
+    setTransform(index, transform);
+    return ObjectHandle{slot, slotGenerations[slot]};
+}
+
+void SceneObjects::remove(ObjectHandle handle){
+    if(!contains(handle)){
+        return;
+    }
+    //the last object fills the hole, so the arrays stay dense
+    unsigned int index = slotIndices[handle.slot];
+    unsigned int last = models.size() - 1;
+    if(index != last){
+        models[index] = models[last];
+        for(std::vector<float> &array : components){
+            array[index] = array[last];
+        }
+        worldMatrices[index] = worldMatrices[last];
+        objectSlots[index] = objectSlots[last];
+        slotIndices[objectSlots[index]] = index;
+    }
+    models.pop_back();
+    objectSlots.pop_back();
+    resize(models.size());
+
+    slotGenerations[handle.slot]++;
+    freeSlots.push_back(handle.slot);
+}
+
+void SceneObjects::clear(){
+    for(std::uint32_t slot : objectSlots){
+        slotGenerations[slot]++;
+        freeSlots.push_back(slot);
+    }
+    models.clear();
+    objectSlots.clear();
+    resize(0);
+}
+
+bool SceneObjects::contains(ObjectHandle handle) const{
+    return handle.slot < slotGenerations.size() && slotGenerations[handle.slot] == handle.generation &&
+           slotIndices[handle.slot] < objectSlots.size() && objectSlots[slotIndices[handle.slot]] == handle.slot;
+}
+
+size_t SceneObjects::size() const{
+    return models.size();
+}
+
+bool SceneObjects::empty() const{
+    return models.empty();
+}
+
+unsigned int SceneObjects::index(ObjectHandle handle) const{
+    return slotIndices[handle.slot];
+}
+
+ObjectHandle SceneObjects::handle(unsigned int index) const{
+    std::uint32_t slot = objectSlots[index];
+    return ObjectHandle{slot, slotGenerations[slot]};
+}
+
+graphicslib::ModelInformation& SceneObjects::model(unsigned int index){
+    return models[index];
+}
+
+const graphicslib::ModelInformation& SceneObjects::model(unsigned int index) const{
+    return models[index];
+}
+
+SceneObjects::Transform SceneObjects::transform(unsigned int index) const{
+    Transform transform;
+    for(int axis = 0; axis < 3; axis++){
+        transform.offset[axis] = components[OFFSET_X + axis][index];
+        transform.scale[axis] = components[SCALE_X + axis][index];
+        transform.rotation[axis] = components[ROTATION_X + axis][index];
+        transform.position[axis] = components[POSITION_X + axis][index];
+    }
+    return transform;
+}
+
+void SceneObjects::setTransform(unsigned int index, const Transform &transform){
+    for(int axis = 0; axis < 3; axis++){
+        components[OFFSET_X + axis][index] = transform.offset[axis];
+        components[SCALE_X + axis][index] = transform.scale[axis];
+        components[ROTATION_X + axis][index] = transform.rotation[axis];
+        components[SINE_X + axis][index] = std::sin(transform.rotation[axis]);
+        components[COSINE_X + axis][index] = std::cos(transform.rotation[axis]);
+        components[POSITION_X + axis][index] = transform.position[axis];
+    }
+}
+
+float* SceneObjects::component(Component component){
+    return components[component].data();
+}
+
+const float* SceneObjects::component(Component component) const{
+    return components[component].data();
+}
+
+const glm::mat4& SceneObjects::worldMatrix(unsigned int index) const{
+    return worldMatrices[index];
+}
+
+void SceneObjects::resize(size_t numberOfObjects){
+    size_t padded = (numberOfObjects + OBJECT_BATCH - 1) / OBJECT_BATCH * OBJECT_BATCH;
+    for(std::vector<float> &array : components){
+        array.resize(padded, 0.f);
+    }
+    worldMatrices.resize(padded, glm::mat4(1.f));
+}
+
+void SceneObjects::updateTransforms(){
+    updateTransforms(ThreadPool::global());
+}
+
+void SceneObjects::updateTransforms(ThreadPool &pool){
+    pool.parallelFor(0, (int) size(), OBJECT_TRANSFORM_GRAIN, [&](int first, int last){
+        updateTransformRange(first, last);
+    });
+}
+
+void SceneObjects::updateTransformRange(size_t first, size_t last){
+    //T(position) * Rx * Ry * Rz * S * T(offset), as getModelMatrix multiplies them: the columns of the rotation
+    //times the scales, and the offset taken through them to the translation
+#ifdef __SSE2__
+    const float *c[NUMBER_OF_COMPONENTS];
+    for(int i = 0; i < NUMBER_OF_COMPONENTS; i++){
+        c[i] = components[i].data();
+    }
+    for(size_t i = first; i < last; i += OBJECT_BATCH){
+        __m128 sx = _mm_loadu_ps(c[SINE_X] + i), sy = _mm_loadu_ps(c[SINE_Y] + i), sz = _mm_loadu_ps(c[SINE_Z] + i);
+        __m128 cx = _mm_loadu_ps(c[COSINE_X] + i), cy = _mm_loadu_ps(c[COSINE_Y] + i), cz = _mm_loadu_ps(c[COSINE_Z] + i);
+        __m128 scale[3] = {_mm_loadu_ps(c[SCALE_X] + i), _mm_loadu_ps(c[SCALE_Y] + i), _mm_loadu_ps(c[SCALE_Z] + i)};
+        __m128 sxsy = _mm_mul_ps(sx, sy), cxsy = _mm_mul_ps(cx, sy);
+        //the rows of the rotation
+        __m128 m[3][3] = {
+            {_mm_mul_ps(cy, cz), _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(cy, sz)), sy},
+            {_mm_add_ps(_mm_mul_ps(cx, sz), _mm_mul_ps(sxsy, cz)), _mm_sub_ps(_mm_mul_ps(cx, cz), _mm_mul_ps(sxsy, sz)),
+             _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sx, cy))},
+            {_mm_sub_ps(_mm_mul_ps(sx, sz), _mm_mul_ps(cxsy, cz)), _mm_add_ps(_mm_mul_ps(sx, cz), _mm_mul_ps(cxsy, sz)),
+             _mm_mul_ps(cx, cy)}
+        };
+        __m128 offset[3] = {_mm_loadu_ps(c[OFFSET_X] + i), _mm_loadu_ps(c[OFFSET_Y] + i), _mm_loadu_ps(c[OFFSET_Z] + i)};
+        __m128 modelCenter[3] = {_mm_loadu_ps(c[MODEL_CENTER_X] + i), _mm_loadu_ps(c[MODEL_CENTER_Y] + i),
+                                 _mm_loadu_ps(c[MODEL_CENTER_Z] + i)};
+        __m128 translation[3], center[3];
+        for(int row = 0; row < 3; row++){
+            for(int column = 0; column < 3; column++){
+                m[row][column] = _mm_mul_ps(m[row][column], scale[column]);
+            }
+            translation[row] = _mm_add_ps(_mm_loadu_ps(c[POSITION_X + row] + i),
+                                          _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[row][0], offset[0]), _mm_mul_ps(m[row][1], offset[1])),
+                                                     _mm_mul_ps(m[row][2], offset[2])));
+            center[row] = _mm_add_ps(translation[row],
+                                     _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[row][0], modelCenter[0]), _mm_mul_ps(m[row][1], modelCenter[1])),
+                                                _mm_mul_ps(m[row][2], modelCenter[2])));
+            _mm_storeu_ps(components[CENTER_X + row].data() + i, center[row]);
+        }
+        //the largest scale, without the sign
+        __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        __m128 largestScale = _mm_max_ps(_mm_max_ps(_mm_and_ps(scale[0], signMask), _mm_and_ps(scale[1], signMask)),
+                                         _mm_and_ps(scale[2], signMask));
+        _mm_storeu_ps(components[RADIUS].data() + i, _mm_mul_ps(_mm_loadu_ps(c[MODEL_RADIUS] + i), largestScale));
+
+        //the columns of 4 objects in the lanes, transposed to a column of each object
+        for(int column = 0; column < 4; column++){
+            __m128 x = column < 3 ? m[0][column] : translation[0];
+            __m128 y = column < 3 ? m[1][column] : translation[1];
+            __m128 z = column < 3 ? m[2][column] : translation[2];
+            __m128 w = _mm_set1_ps(column < 3 ? 0.f : 1.f);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            _mm_storeu_ps(&worldMatrices[i][column][0], x);
+            _mm_storeu_ps(&worldMatrices[i + 1][column][0], y);
+            _mm_storeu_ps(&worldMatrices[i + 2][column][0], z);
+            _mm_storeu_ps(&worldMatrices[i + 3][column][0], w);
+        }
+    }
+#else
+    for(size_t i = first; i < last; i++){
+        float sx = components[SINE_X][i], sy = components[SINE_Y][i], sz = components[SINE_Z][i];
+        float cx = components[COSINE_X][i], cy = components[COSINE_Y][i], cz = components[COSINE_Z][i];
+        float m[3][3] = {
+            {cy * cz, -cy * sz, sy},
+            {cx * sz + sx * sy * cz, cx * cz - sx * sy * sz, -sx * cy},
+            {sx * sz - cx * sy * cz, sx * cz + cx * sy * sz, cx * cy}
+        };
+        glm::mat4 &world = worldMatrices[i];
+        for(int row = 0; row < 3; row++){
+            float translation = components[POSITION_X + row][i];
+            float center = 0.f;
+            for(int column = 0; column < 3; column++){
+                m[row][column] *= components[SCALE_X + column][i];
+                world[column][row] = m[row][column];
+                translation += m[row][column] * components[OFFSET_X + column][i];
+                center += m[row][column] * components[MODEL_CENTER_X + column][i];
+            }
+            world[3][row] = translation;
+            world[row][3] = 0.f;
+            components[CENTER_X + row][i] = translation + center;
+        }
+        world[3][3] = 1.f;
+        float largestScale = std::max(std::max(std::abs(components[SCALE_X][i]), std::abs(components[SCALE_Y][i])),
+                                      std::abs(components[SCALE_Z][i]));
+        components[RADIUS][i] = components[MODEL_RADIUS][i] * largestScale;
+    }
+#endif
+}
+
+void SceneObjects::cull(const glm::mat4 &viewProjection, std::vector<unsigned int> &visible) const{
+    visible.clear();
+    //the frustum planes (Gribb and Hartmann): the last row of the matrix plus and minus each of the others
+    glm::vec4 planes[6];
+    for(int axis = 0; axis < 3; axis++){
+        for(int side = 0; side < 2; side++){
+            float sign = side ? -1.f : 1.f;
+            glm::vec4 plane;
+            for(int column = 0; column < 4; column++){
+                plane[column] = viewProjection[column][3] + sign * viewProjection[column][axis];
+            }
+            float length = glm::length(glm::vec3(plane));
+            planes[2 * axis + side] = length > 0.f ? plane / length : glm::vec4(0.f, 0.f, 0.f, 1.f);
+        }
+    }
+
+    const float *x = components[CENTER_X].data(), *y = components[CENTER_Y].data(), *z = components[CENTER_Z].data();
+    const float *radius = components[RADIUS].data();
+#ifdef __SSE2__
+    //the spheres of 4 objects against each plane, an object is out if it's behind one of them
+    for(size_t i = 0; i < size(); i += OBJECT_BATCH){
+        __m128 cx = _mm_loadu_ps(x + i), cy = _mm_loadu_ps(y + i), cz = _mm_loadu_ps(z + i);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(const glm::vec4 &plane : planes){
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+                                         _mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        int mask = _mm_movemask_ps(inside);
+        while(mask){
+            int lane = __builtin_ctz(mask);
+            mask &= mask - 1;
+            if(i + lane < size()){
+                visible.push_back(i + lane);
+            }
+        }
+    }
+#else
+    for(size_t i = 0; i < size(); i++){
+        bool inside = true;
+        for(const glm::vec4 &plane : planes){
+            inside = inside && plane.x * x[i] + plane.y * y[i] + plane.z * z[i] + plane.w >= -radius[i];
+        }
+        if(inside){
+            visible.push_back(i);
+        }
+    }
+#endif
+}
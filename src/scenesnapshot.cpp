@@ -0,0 +1,226 @@
+#include <scenesnapshot.hpp>
+#include <scenefile.hpp>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool SceneSnapshot::enabled = true;
+bool SceneSnapshot::writeAfterLoad = false;
+std::string SceneSnapshot::file = SCENE_SNAPSHOT_FILE;
+
+//size and modification time of a file, false if it isn't there
+static bool fileStamp(const std::string &path, std::uint64_t &size, std::int64_t &time){
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if(error){
+        return false;
+    }
+    time = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+    return !error;
+}
+
+bool SceneSnapshot::write(const std::string &path, const std::string &sourcePath, const scenefile::Scene &scene,
+                          const graphicslib::LightingInformation &lightingInformation, const SceneObjects &objects){
+    if(objects.size() != scene.objects.size() || lightingInformation.pointLights.size() != scene.lights.size()){
+        return false;
+    }
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = SCENE_SNAPSHOT_MAGIC;
+    header.version = SCENE_SNAPSHOT_VERSION;
+    header.modelRecordSize = sizeof(ModelRecord);
+    header.objectRecordSize = sizeof(ObjectRecord);
+    header.lightRecordSize = sizeof(graphicslib::PointLight);
+    if(!fileStamp(sourcePath, header.sourceSize, header.sourceTime)){
+        return false;
+    }
+    header.numberOfModels = scene.paths.size();
+    header.numberOfObjects = scene.objects.size();
+    header.numberOfLights = scene.lights.size();
+    header.hasCamera = scene.hasCamera;
+    const glm::vec3 *camera[3] = {&scene.cameraPosition, &scene.cameraLookAt, &scene.cameraUp};
+    for(int v = 0; v < 3; v++){
+        for(int c = 0; c < 3; c++){
+            header.camera[v * 3 + c] = (*camera[v])[c];
+        }
+    }
+
+    std::vector<ModelRecord> modelRecords(scene.paths.size());
+    for(size_t m = 0; m < scene.paths.size(); m++){
+        ModelRecord &record = modelRecords[m];
+        record.pathOffset = header.pathBytes;
+        record.pathLength = scene.paths[m].size();
+        header.pathBytes += record.pathLength;
+        if(!fileStamp(scene.paths[m], record.fileSize, record.fileTime)){
+            return false;
+        }
+    }
+
+    std::vector<ObjectRecord> objectRecords(scene.objects.size());
+    for(size_t o = 0; o < scene.objects.size(); o++){
+        ObjectRecord &record = objectRecords[o];
+        SceneObjects::Transform transform = objects.transform(o);
+        record.model = scene.objects[o].path;
+        std::memcpy(record.offset, &transform.offset, sizeof(record.offset));
+        std::memcpy(record.rotation, &transform.rotation, sizeof(record.rotation));
+        std::memcpy(record.scale, &transform.scale, sizeof(record.scale));
+        std::memcpy(record.position, &transform.position, sizeof(record.position));
+    }
+
+    //written next to the snapshot and renamed over it, a snapshot that is mapped never changes
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if(!parent.empty()){
+        std::filesystem::create_directories(parent, error);
+    }
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write((const char*) &header, sizeof(header));
+        file.write((const char*) modelRecords.data(), modelRecords.size() * sizeof(ModelRecord));
+        file.write((const char*) objectRecords.data(), objectRecords.size() * sizeof(ObjectRecord));
+        file.write((const char*) lightingInformation.pointLights.data(),
+                   lightingInformation.pointLights.size() * sizeof(graphicslib::PointLight));
+        for(const std::string &modelPath : scene.paths){
+            file.write(modelPath.data(), modelPath.size());
+        }
+        if(!file){
+            return false;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+SceneSnapshot::SceneSnapshot(){
+    data = NULL;
+    size = 0;
+    header = NULL;
+}
+
+SceneSnapshot::~SceneSnapshot(){
+    close();
+}
+
+void SceneSnapshot::close(){
+    if(data){
+        munmap((void*) data, size);
+    }
+    data = NULL;
+    size = 0;
+    header = NULL;
+}
+
+bool SceneSnapshot::open(const std::string &path, const std::string &sourcePath){
+    close();
+    int file = ::open(path.c_str(), O_RDONLY);
+    if(file < 0){
+        return false;
+    }
+    struct stat status;
+    if(fstat(file, &status) != 0 || (size_t) status.st_size < sizeof(Header)){
+        ::close(file);
+        return false;
+    }
+    size = status.st_size;
+    void *mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if(mapping == MAP_FAILED){
+        size = 0;
+        return false;
+    }
+    data = (const unsigned char*) mapping;
+    header = (const Header*) data;
+
+    //the records of this build, and exactly the bytes they take
+    bool valid = header->magic == SCENE_SNAPSHOT_MAGIC && header->version == SCENE_SNAPSHOT_VERSION &&
+                 header->modelRecordSize == sizeof(ModelRecord) && header->objectRecordSize == sizeof(ObjectRecord) &&
+                 header->lightRecordSize == sizeof(graphicslib::PointLight);
+    size_t left = size - sizeof(Header);
+    valid = valid && header->numberOfModels <= left / sizeof(ModelRecord);
+    left -= valid ? header->numberOfModels * sizeof(ModelRecord) : 0;
+    valid = valid && header->numberOfObjects <= left / sizeof(ObjectRecord);
+    left -= valid ? header->numberOfObjects * sizeof(ObjectRecord) : 0;
+    valid = valid && header->numberOfLights <= left / sizeof(graphicslib::PointLight);
+    left -= valid ? header->numberOfLights * sizeof(graphicslib::PointLight) : 0;
+    valid = valid && header->pathBytes == left;
+
+    //and the files it was written from haven't changed
+    std::uint64_t fileSize;
+    std::int64_t fileTime;
+    valid = valid && fileStamp(sourcePath, fileSize, fileTime) && fileSize == header->sourceSize &&
+            fileTime == header->sourceTime;
+    for(size_t m = 0; valid && m < numberOfModels(); m++){
+        const ModelRecord &record = model(m);
+        valid = record.pathOffset <= header->pathBytes && record.pathLength <= header->pathBytes - record.pathOffset &&
+                fileStamp(std::string(modelPath(m)), fileSize, fileTime) && fileSize == record.fileSize &&
+                fileTime == record.fileTime;
+    }
+    for(size_t o = 0; valid && o < numberOfObjects(); o++){
+        valid = objects()[o].model < numberOfModels();
+    }
+    if(!valid){
+        close();
+    }
+    return valid;
+}
+
+size_t SceneSnapshot::numberOfModels() const{
+    return header ? header->numberOfModels : 0;
+}
+
+const SceneSnapshot::ModelRecord& SceneSnapshot::model(size_t index) const{
+    return ((const ModelRecord*) (data + sizeof(Header)))[index];
+}
+
+std::string_view SceneSnapshot::modelPath(size_t index) const{
+    const char *paths = (const char*) (lights() + numberOfLights());
+    const ModelRecord &record = model(index);
+    return std::string_view(paths + record.pathOffset, record.pathLength);
+}
+
+size_t SceneSnapshot::numberOfObjects() const{
+    return header ? header->numberOfObjects : 0;
+}
+
+const SceneSnapshot::ObjectRecord* SceneSnapshot::objects() const{
+    return (const ObjectRecord*) (data + sizeof(Header) + numberOfModels() * sizeof(ModelRecord));
+}
+
+size_t SceneSnapshot::numberOfLights() const{
+    return header ? header->numberOfLights : 0;
+}
+
+const graphicslib::PointLight* SceneSnapshot::lights() const{
+    return (const graphicslib::PointLight*) (objects() + numberOfObjects());
+}
+
+void SceneSnapshot::scene(scenefile::Scene &scene) const{
+    scene = scenefile::Scene();
+    for(size_t m = 0; m < numberOfModels(); m++){
+        scene.paths.emplace_back(modelPath(m));
+    }
+    scene.objects.resize(numberOfObjects());
+    for(size_t o = 0; o < numberOfObjects(); o++){
+        const ObjectRecord &record = objects()[o];
+        scene.objects[o].path = record.model;
+        scene.objects[o].position = glm::vec3(record.position[0], record.position[1], record.position[2]);
+    }
+    scene.lights.resize(numberOfLights());
+    for(size_t l = 0; l < numberOfLights(); l++){
+        const graphicslib::PointLight &light = lights()[l];
+        scene.lights[l] = scenefile::SceneLight{light.position, light.ambient, light.linear, light.constant, light.quadratic};
+    }
+    if(header && header->hasCamera){
+        scene.hasCamera = true;
+        scene.cameraPosition = glm::vec3(header->camera[0], header->camera[1], header->camera[2]);
+        scene.cameraLookAt = glm::vec3(header->camera[3], header->camera[4], header->camera[5]);
+        scene.cameraUp = glm::vec3(header->camera[6], header->camera[7], header->camera[8]);
+    }
+}
@@ -7,39 +7,27 @@
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath)
+#include <unistd.h>
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string> &defines)
 {
-    // 1. retrieve the vertex/fragment source code from filePath
-    std::string vertexCode;
-    std::string fragmentCode;
-    std::ifstream vShaderFile;
-    std::ifstream fShaderFile;
-    // ensure ifstream objects can throw exceptions:
-    vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+    // 1. retrieve the vertex/fragment source code from filePath, with the defines and the includes
+    std::string vertexCode = preprocess(vertexPath, defines);
+    std::string fragmentCode = preprocess(fragmentPath, defines);
 
-    try 
-    {
-        // open files
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vShaderStream, fShaderStream;
-        // read file's buffer contents into streams
-        vShaderStream << vShaderFile.rdbuf();
-        fShaderStream << fShaderFile.rdbuf();		
-        // close file handlers
-        vShaderFile.close();
-        fShaderFile.close();
-        // convert stream into string
-        vertexCode = vShaderStream.str();
-        fragmentCode = fShaderStream.str();			
-    }
-    catch (std::ifstream::failure& e)
+    // try the program linked by a previous run
+    loadedFromCache = false;
+    std::string cachePath = binaryCachePath(vertexCode, fragmentCode, defines);
+    if(!cachePath.empty() && loadBinary(cachePath))
     {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        loadedFromCache = true;
+        return;
     }
-    
+
     const char* vShaderCode = vertexCode.c_str();
     const char * fShaderCode = fragmentCode.c_str();
     // 2. compile shaders
@@ -58,12 +46,208 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath)
     ID = glCreateProgram();
     glAttachShader(ID, vertex);
     glAttachShader(ID, fragment);
+    if(!cachePath.empty())
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     glLinkProgram(ID);
     checkCompileErrors(ID, "PROGRAM");
     // delete the shaders as they're linked into our program now and no longer necessery
     glDeleteShader(vertex);
     glDeleteShader(fragment);
 
+    // 3. save the program for the next runs
+    GLint linked = GL_FALSE;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    if(linked && !cachePath.empty())
+        saveBinary(cachePath);
+
+}
+
+std::string Shader::preprocess(const std::string &path, const std::vector<std::string> &defines)
+{
+    std::string output;
+    std::vector<std::string> files;
+    if(!appendSource(path, output, files, defines, 0))
+    {
+        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+    }
+    return output;
+}
+
+bool Shader::appendSource(const std::string &path, std::string &output, std::vector<std::string> &files,
+                          const std::vector<std::string> &defines, int depth)
+{
+    // protect against includes that include themselves
+    if(depth > 16)
+    {
+        std::cerr << "ERROR::SHADER::INCLUDE_TOO_DEEP " << path << std::endl;
+        return false;
+    }
+
+    std::ifstream file(path);
+    if(!file.is_open())
+        return false;
+
+    int fileNumber = files.size();
+    files.push_back(path);
+    std::string directory = path.substr(0, path.find_last_of('/') + 1);
+
+    std::string line;
+    int lineNumber = 0;
+    while(std::getline(file, line))
+    {
+        lineNumber++;
+        std::istringstream lineStream(line);
+        std::string directive;
+        lineStream >> directive;
+
+        if(directive == "#version" && depth == 0)
+        {
+            // the defines must come right after the version
+            output += line + "\n";
+            for(auto &define : defines)
+                output += "#define " + define + "\n";
+            output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileNumber) + "\n";
+        }
+        else if(directive == "#include")
+        {
+            // #include "file", relative to the current file
+            size_t open = line.find('"');
+            size_t close = line.find('"', open + 1);
+            if(open == std::string::npos || close == std::string::npos)
+            {
+                std::cerr << "ERROR::SHADER::BAD_INCLUDE " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+            std::string includePath = directory + line.substr(open + 1, close - open - 1);
+            output += "#line 1 " + std::to_string(files.size()) + "\n";
+            if(!appendSource(includePath, output, files, defines, depth + 1))
+            {
+                std::cerr << "ERROR::SHADER::INCLUDE_NOT_FOUND " << includePath << std::endl;
+                return false;
+            }
+            output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileNumber) + "\n";
+        }
+        else
+        {
+            output += line + "\n";
+        }
+    }
+    return true;
+}
+
+std::string Shader::binaryCacheDirectory = "cache/shaders";
+
+std::string Shader::binaryCachePath(const std::string &vertexCode, const std::string &fragmentCode,
+                                    const std::vector<std::string> &defines)
+{
+    if(binaryCacheDirectory.empty())
+        return "";
+
+    // program binaries are core since 4.1, older contexts don't load these functions
+    if(!glad_glProgramBinary || !glad_glGetProgramBinary || !glad_glProgramParameteri)
+        return "";
+    GLint numberOfFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numberOfFormats);
+    if(numberOfFormats <= 0)
+        return "";
+
+    // FNV-1a of everything that changes the binary
+    unsigned long long hash = 14695981039346656037ULL;
+    auto add = [&hash](const std::string &text)
+    {
+        for(unsigned char c : text)
+        {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        // separator, so "ab"+"c" and "a"+"bc" differ
+        hash ^= 0xff;
+        hash *= 1099511628211ULL;
+    };
+    add(vertexCode);
+    add(fragmentCode);
+    for(auto &define : defines)
+        add(define);
+    GLenum driverStrings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION};
+    for(GLenum name : driverStrings)
+    {
+        const GLubyte* value = glGetString(name);
+        add(value ? (const char*)value : "");
+    }
+
+    std::ostringstream path;
+    path << binaryCacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return path.str();
+}
+
+bool Shader::loadBinary(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if(!file.is_open())
+        return false;
+
+    // header: format and size of the binary
+    GLenum format;
+    GLint length;
+    file.read((char*)&format, sizeof(format));
+    file.read((char*)&length, sizeof(length));
+    if(!file || length <= 0)
+        return false;
+    std::vector<char> binary(length);
+    file.read(binary.data(), length);
+    if(!file)
+        return false;
+
+    ID = glCreateProgram();
+    glProgramBinary(ID, format, binary.data(), length);
+
+    // the driver may reject binaries from other versions, then we compile from the source
+    GLint linked = GL_FALSE;
+    glGetProgramiv(ID, GL_LINK_STATUS, &linked);
+    if(!linked)
+    {
+        glDeleteProgram(ID);
+        ID = 0;
+        return false;
+    }
+    return true;
+}
+
+void Shader::saveBinary(const std::string &path) const
+{
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if(length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format;
+    glGetProgramBinary(ID, length, &length, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(binaryCacheDirectory, error);
+    // written next to the binary and renamed over it, so a crash or another instance writing the same program
+    // never leaves a truncated binary (the name of the temporary file has the process)
+    std::string temporary = path + "." + std::to_string(getpid()) + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        file.write((const char*)&format, sizeof(format));
+        file.write((const char*)&length, sizeof(length));
+        file.write(binary.data(), length);
+        if(!file)
+        {
+            std::cerr << "ERROR::SHADER::BINARY_CACHE_NOT_WRITABLE " << path << std::endl;
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if(error)
+    {
+        std::cerr << "ERROR::SHADER::BINARY_CACHE_NOT_WRITABLE " << path << std::endl;
+        std::filesystem::remove(temporary, error);
+    }
 }
 
 void Shader::use() const
@@ -126,6 +310,11 @@ void Shader::setMat3(const std::string &name, const glm::mat3 &mat) const
     glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
 }
 
+void Shader::setMat3(const std::string &name, float** mat) const
+{
+    glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, *mat);
+}
+
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
 {
     glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
@@ -159,3 +348,39 @@ void Shader::checkCompileErrors(GLuint shader, std::string type)
         }
     }
 }
+
+ShaderCache::~ShaderCache()
+{
+    for(auto &variant : variants)
+        glDeleteProgram(variant.second->ID);
+}
+
+Shader* ShaderCache::get(const std::string &vertexPath, const std::string &fragmentPath, std::vector<std::string> defines)
+{
+    // the order of the defines doesn't change the program
+    std::sort(defines.begin(), defines.end());
+    std::string key = vertexPath + "|" + fragmentPath;
+    for(auto &define : defines)
+        key += "|" + define;
+
+    auto found = variants.find(key);
+    if(found != variants.end())
+        return found->second.get();
+
+    Shader* shader = new Shader(vertexPath.c_str(), fragmentPath.c_str(), defines);
+    variants[key] = std::unique_ptr<Shader>(shader);
+    return shader;
+}
+
+size_t ShaderCache::size() const
+{
+    return variants.size();
+}
+
+size_t ShaderCache::loadedFromCache() const
+{
+    size_t count = 0;
+    for(auto &variant : variants)
+        count += variant.second->loadedFromCache;
+    return count;
+}
@@ -0,0 +1,654 @@
+#include <softwarerenderer.hpp>
+#include <camera.hpp>
+#include <lightclusters.hpp>
+#include <matrixlib.hpp>
+#include <mesh.hpp>
+#include <threadpool.hpp>
+#include <model.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace graphicslib;
+
+//objectColor of pointLight.glsl, the shininess sent by Window and the clear color of Window::run
+static const glm::vec3 OBJECT_COLOR(1.f, 0.5f, 0.31f);
+static const float SHININESS = 32.f;
+static const float CLEAR_COLOR = 0.05f;
+
+//the 6 planes of the view volume in clip coordinates: w + x, w - x, w + y, w - y, w + z, w - z >= 0
+static const int NUMBER_OF_CLIP_PLANES = 6;
+
+//CalcPointLight of pointLight.glsl
+static glm::vec3 pointLight(const PointLight &light, const glm::vec3 &normal, const glm::vec3 &position,
+                            const glm::vec3 &viewDirection, const glm::vec3 &diffuseColor, const glm::vec3 &specularColor,
+                            float occlusion){
+    glm::vec3 lightDirection = glm::normalize(light.position - position);
+    float diffuse = std::max(glm::dot(normal, lightDirection), 0.f);
+    glm::vec3 reflectDirection = glm::reflect(-lightDirection, normal);
+    float specular = std::pow(std::max(glm::dot(viewDirection, reflectDirection), 0.f), SHININESS);
+
+    float distance = glm::length(light.position - position);
+    float attenuation = 1.f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+
+    glm::vec3 ambient = POINT_LIGHT_KA * light.ambient * diffuseColor * occlusion;
+    glm::vec3 diffuseLight = POINT_LIGHT_KD * light.diffuse * diffuse * diffuseColor;
+    glm::vec3 specularLight = POINT_LIGHT_KS * light.specular * specular * specularColor;
+    return (ambient + diffuseLight + specularLight) * attenuation;
+}
+
+//SumPointLights of pointLight.glsl
+static glm::vec3 sumPointLights(const LightingInformation &lighting, const glm::vec3 &normal, const glm::vec3 &position,
+                                const glm::vec3 &viewDirection, const glm::vec3 &diffuseColor,
+                                const glm::vec3 &specularColor, float occlusion, const glm::vec3 &noLightColor){
+    if(lighting.pointLights.empty()){
+        return noLightColor;
+    }
+    glm::vec3 result(0.f);
+    for(const PointLight &light : lighting.pointLights){
+        result += pointLight(light, normal, position, viewDirection, diffuseColor, specularColor, occlusion);
+    }
+    return result;
+}
+
+//a color in [0, 1] to 8 bits, as it's written to the default framebuffer
+static unsigned char toByte(float value){
+    return (unsigned char) std::lround(std::min(std::max(value, 0.f), 1.f) * 255.f);
+}
+
+//signed distance (times w) of a point in clip coordinates to a plane of the view volume
+static float planeDistance(const glm::vec4 &position, int plane){
+    float coordinate = position[plane / 2];
+    return plane % 2 ? position.w - coordinate : position.w + coordinate;
+}
+
+//bit of each plane of the view volume the point is outside of
+static int outcode(const glm::vec4 &position){
+    int code = 0;
+    for(int plane = 0; plane < NUMBER_OF_CLIP_PLANES; plane++){
+        if(planeDistance(position, plane) < 0.f){
+            code |= 1 << plane;
+        }
+    }
+    return code;
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, ThreadPool &pool) : pool(pool){
+    this->width = std::min(std::max(width, 1), SOFTWARE_MAX_SIZE);
+    this->height = std::min(std::max(height, 1), SOFTWARE_MAX_SIZE);
+    stride = (this->width + 3) & ~3;
+    tilesX = (this->width + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    tilesY = (this->height + SOFTWARE_TILE_SIZE - 1) / SOFTWARE_TILE_SIZE;
+    color.assign((size_t) stride * this->height * 3, toByte(CLEAR_COLOR));
+    depth.assign((size_t) stride * this->height, 1.f);
+    tileCovered.assign(tilesX * tilesY, 0);
+    tileShaded.assign(tilesX * tilesY, 0);
+    viewProjection = glm::mat4(1.f);
+    viewPosition = glm::vec3(0.f);
+    shadingMode = PHONG_SHADING;
+    vertexCount = 0;
+    triangleCount = 0;
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height) : SoftwareRenderer(width, height, ThreadPool::global()){
+}
+
+void SoftwareRenderer::beginFrame(const LightingInformation &lightingInformation, const glm::mat4 &viewProjection,
+                                  const glm::vec3 &viewPosition, ShadingMode shadingMode){
+    lighting = lightingInformation;
+    this->viewProjection = viewProjection;
+    this->viewPosition = viewPosition;
+    //the deferred shading computes the Phong lighting from the G-buffer
+    this->shadingMode = shadingMode == GOURAUD_SHADING ? GOURAUD_SHADING : PHONG_SHADING;
+    draws.clear();
+    vertexCount = 0;
+    triangleCount = 0;
+
+    std::fill(color.begin(), color.end(), toByte(CLEAR_COLOR));
+    std::fill(depth.begin(), depth.end(), 1.f);
+}
+
+void SoftwareRenderer::draw(const Mesh &mesh, const glm::mat4 &clip, const glm::mat4 &model,
+                            const std::string &directory, unsigned int lod){
+    const MeshLod &level = mesh.getLod(lod);
+    Draw draw;
+    draw.mesh = &mesh;
+    draw.clip = clip;
+    draw.model = model;
+    //the normal matrix of the shaders
+    draw.normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+    draw.indices = mesh.indices.data() + level.indexOffset;
+    draw.triangleCount = level.indexCount / 3;
+    draw.firstVertex = vertexCount;
+    draw.firstTriangle = triangleCount;
+    //the first texture of each type is the one the shaders sample (texture_diffuse1 and texture_specular1)
+    draw.diffuse = NULL;
+    draw.specular = NULL;
+    for(const Texture &texture : mesh.textures){
+        if(texture.type == "texture_diffuse" && !draw.diffuse){
+            draw.diffuse = textures.get(directory, texture.path);
+        }else if(texture.type == "texture_specular" && !draw.specular){
+            draw.specular = textures.get(directory, texture.path);
+        }
+    }
+    draws.push_back(draw);
+    vertexCount += mesh.vertices.size();
+    triangleCount += draw.triangleCount;
+}
+
+void SoftwareRenderer::render(SceneObjects &objects, const LightingInformation &lightingInformation, Camera &camera,
+                              ShadingMode shadingMode){
+    //the matrices OpenGL uses are the transposes of the view and the projection, and the model matrix itself
+    ml::matrix<float> projection = getProjectionMatrix();
+    ml::matrix<float> view = camera.GetViewMatrix();
+    ml::matrix<float> worldToClip = projection.transpose() * view.transpose();
+    glm::mat4 worldToClipMatrix = toGlm(worldToClip);
+    beginFrame(lightingInformation, worldToClipMatrix, camera.Position, shadingMode);
+    for(unsigned int object = 0; object < objects.size(); object++){
+        const ModelInformation &modelInfo = objects.model(object);
+        const glm::mat4 &model = objects.worldMatrix(object);
+        glm::mat4 modelToClip = worldToClipMatrix * model;
+        for(const Mesh &mesh : modelInfo.model->meshes){
+            draw(mesh, modelToClip, model, modelInfo.model->directory, modelInfo.lod);
+        }
+    }
+    endFrame();
+}
+
+void SoftwareRenderer::endFrame(){
+    vertexStage();
+
+    //the triangles are split in jobs of a fixed size, so the bins don't depend on the threads
+    int jobs = (int) ((triangleCount + SOFTWARE_TRIANGLE_GRAIN - 1) / SOFTWARE_TRIANGLE_GRAIN);
+    if((int) bins.size() < jobs){
+        bins.resize(jobs);
+    }
+    pool.parallelFor(0, jobs, 1, [&](int begin, int end){
+        for(int job = begin; job < end; job++){
+            size_t first = (size_t) job * SOFTWARE_TRIANGLE_GRAIN;
+            setupTriangles(first, std::min(first + SOFTWARE_TRIANGLE_GRAIN, triangleCount), bins[job]);
+        }
+    });
+    //the bins of the jobs of bigger frames stay allocated but empty
+    for(size_t job = jobs; job < bins.size(); job++){
+        bins[job].triangles.clear();
+        for(std::vector<unsigned int> &tile : bins[job].tiles){
+            tile.clear();
+        }
+    }
+
+    //the lamps are drawn as points with the identity model matrix
+    lamps.clear();
+    for(const PointLightForBuffer &light : lighting.bufferOfPointLights){
+        glm::vec4 clip = viewProjection * glm::vec4(light.position, 1.f);
+        //the points are clipped by their center
+        if(outcode(clip) || clip.w <= 0.f){
+            continue;
+        }
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        lamps.push_back(Lamp{(ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f,
+                             glm::u8vec3(toByte(light.color.r), toByte(light.color.g), toByte(light.color.b))});
+    }
+
+    pool.parallelFor(0, tilesX * tilesY, 1, [&](int begin, int end){
+        for(int tile = begin; tile < end; tile++){
+            rasterizeTile(tile);
+        }
+    });
+}
+
+void SoftwareRenderer::vertexStage(){
+    clipPositions.resize(vertexCount);
+    worldPositions.resize(vertexCount);
+    worldNormals.resize(vertexCount);
+    texCoords.resize(vertexCount);
+    occlusions.resize(vertexCount);
+    vertexLighting.resize(shadingMode == GOURAUD_SHADING ? vertexCount : 0);
+    if(draws.empty()){
+        return;
+    }
+
+    pool.parallelFor(0, (int) vertexCount, 4096, [&](int begin, int end){
+        //the draw of the first vertex of the chunk
+        size_t d = std::upper_bound(draws.begin(), draws.end(), (size_t) begin, [](size_t vertex, const Draw &draw){
+            return vertex < draw.firstVertex;
+        }) - draws.begin() - 1;
+        for(int i = begin; i < end; i++){
+            while(d + 1 < draws.size() && draws[d + 1].firstVertex <= (size_t) i){
+                d++;
+            }
+            const Draw &draw = draws[d];
+            const ::Vertex &vertex = draw.mesh->vertices[i - draw.firstVertex];
+            glm::vec4 position(vertex.Position, 1.f);
+            clipPositions[i] = draw.clip * position;
+            worldPositions[i] = glm::vec3(draw.model * position);
+            worldNormals[i] = draw.normalMatrix * vertex.Normal;
+            texCoords[i] = vertex.TexCoords;
+            //VertexOcclusion of vertexInput.glsl
+            occlusions[i] = draw.mesh->ambientOcclusion.empty() ? 1.f : draw.mesh->ambientOcclusion[i - draw.firstVertex];
+            //multipleLights.vs without PHONG
+            if(shadingMode == GOURAUD_SHADING){
+                glm::vec3 normal = glm::normalize(worldNormals[i]);
+                glm::vec3 viewDirection = glm::normalize(viewPosition - worldPositions[i]);
+                vertexLighting[i] = sumPointLights(lighting, normal, worldPositions[i], viewDirection, glm::vec3(1.f),
+                                                   glm::vec3(1.f), occlusions[i], glm::vec3(1.f));
+            }
+        }
+    });
+}
+
+void SoftwareRenderer::setupTriangles(size_t first, size_t last, TriangleBins &jobBins){
+    jobBins.triangles.clear();
+    jobBins.tiles.resize(tilesX * tilesY);
+    for(std::vector<unsigned int> &tile : jobBins.tiles){
+        tile.clear();
+    }
+
+    //a corner of the polygon left by the clipping, with its barycentric coordinates in the triangle
+    struct ClipVertex
+    {
+        glm::vec4 position;
+        glm::vec3 barycentric;
+    };
+    static const glm::mat3 IDENTITY(1.f);
+
+    size_t d = std::upper_bound(draws.begin(), draws.end(), first, [](size_t triangle, const Draw &draw){
+        return triangle < draw.firstTriangle;
+    }) - draws.begin() - 1;
+    for(size_t t = first; t < last; t++){
+        while(d + 1 < draws.size() && draws[d + 1].firstTriangle <= t){
+            d++;
+        }
+        const Draw &draw = draws[d];
+        const unsigned int *indices = draw.indices + 3 * (t - draw.firstTriangle);
+        size_t vertex[3];
+        glm::vec4 clip[3];
+        int outside[3];
+        for(int k = 0; k < 3; k++){
+            vertex[k] = draw.firstVertex + indices[k];
+            clip[k] = clipPositions[vertex[k]];
+            outside[k] = outcode(clip[k]);
+        }
+        //all the corners out of the same plane
+        if(outside[0] & outside[1] & outside[2]){
+            continue;
+        }
+        int planes = outside[0] | outside[1] | outside[2];
+        if(!planes){
+            addTriangle(clip, IDENTITY, vertex, d, jobBins);
+            continue;
+        }
+
+        //Sutherland-Hodgman against the planes the triangle crosses, each plane adds at most 1 corner
+        ClipVertex polygon[3 + NUMBER_OF_CLIP_PLANES], clipped[3 + NUMBER_OF_CLIP_PLANES];
+        int corners = 3;
+        for(int k = 0; k < 3; k++){
+            polygon[k] = ClipVertex{clip[k], IDENTITY[k]};
+        }
+        for(int plane = 0; plane < NUMBER_OF_CLIP_PLANES && corners >= 3; plane++){
+            if(!(planes & (1 << plane))){
+                continue;
+            }
+            int kept = 0;
+            for(int k = 0; k < corners; k++){
+                const ClipVertex &current = polygon[k];
+                const ClipVertex &next = polygon[(k + 1) % corners];
+                float currentDistance = planeDistance(current.position, plane);
+                float nextDistance = planeDistance(next.position, plane);
+                if(currentDistance >= 0.f){
+                    clipped[kept++] = current;
+                }
+                if((currentDistance >= 0.f) != (nextDistance >= 0.f)){
+                    float s = currentDistance / (currentDistance - nextDistance);
+                    clipped[kept++] = ClipVertex{glm::mix(current.position, next.position, s),
+                                                 glm::mix(current.barycentric, next.barycentric, s)};
+                }
+            }
+            corners = kept;
+            std::copy(clipped, clipped + corners, polygon);
+        }
+
+        //a fan of the corners of the polygon
+        for(int k = 1; k + 1 < corners; k++){
+            glm::vec4 fan[3] = {polygon[0].position, polygon[k].position, polygon[k + 1].position};
+            addTriangle(fan, glm::mat3(polygon[0].barycentric, polygon[k].barycentric, polygon[k + 1].barycentric),
+                        vertex, d, jobBins);
+        }
+    }
+}
+
+void SoftwareRenderer::addTriangle(const glm::vec4 clip[3], const glm::mat3 &corners, const size_t vertex[3],
+                                   unsigned int draw, TriangleBins &jobBins){
+    RasterTriangle triangle;
+    const float subpixels = (float) (1 << SOFTWARE_SUBPIXEL_BITS);
+    for(int k = 0; k < 3; k++){
+        if(clip[k].w <= 0.f){
+            return;
+        }
+        float inverseW = 1.f / clip[k].w;
+        glm::vec3 ndc = glm::vec3(clip[k]) * inverseW;
+        //viewport transform, the clipping keeps the corners inside the frame
+        float x = (ndc.x * 0.5f + 0.5f) * width * subpixels;
+        float y = (ndc.y * 0.5f + 0.5f) * height * subpixels;
+        triangle.x[k] = std::min(std::max((int) std::lround(x), 0), width << SOFTWARE_SUBPIXEL_BITS);
+        triangle.y[k] = std::min(std::max((int) std::lround(y), 0), height << SOFTWARE_SUBPIXEL_BITS);
+        triangle.depth[k] = ndc.z * 0.5f + 0.5f;
+        triangle.inverseW[k] = inverseW;
+        triangle.vertex[k] = vertex[k];
+    }
+    triangle.corners = corners;
+    triangle.draw = draw;
+
+    //both faces are drawn, the clockwise ones are turned
+    int64_t area = (int64_t) (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+                   (int64_t) (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+    if(area == 0){
+        return;
+    }
+    if(area < 0){
+        std::swap(triangle.x[1], triangle.x[2]);
+        std::swap(triangle.y[1], triangle.y[2]);
+        std::swap(triangle.depth[1], triangle.depth[2]);
+        std::swap(triangle.inverseW[1], triangle.inverseW[2]);
+        std::swap(triangle.corners[1], triangle.corners[2]);
+    }
+
+    //the pixels whose centers are in the bounding box
+    const int half = 1 << (SOFTWARE_SUBPIXEL_BITS - 1);
+    int minX = std::min(std::min(triangle.x[0], triangle.x[1]), triangle.x[2]);
+    int maxX = std::max(std::max(triangle.x[0], triangle.x[1]), triangle.x[2]);
+    int minY = std::min(std::min(triangle.y[0], triangle.y[1]), triangle.y[2]);
+    int maxY = std::max(std::max(triangle.y[0], triangle.y[1]), triangle.y[2]);
+    triangle.minX = std::max((minX - half + (1 << SOFTWARE_SUBPIXEL_BITS) - 1) >> SOFTWARE_SUBPIXEL_BITS, 0);
+    triangle.minY = std::max((minY - half + (1 << SOFTWARE_SUBPIXEL_BITS) - 1) >> SOFTWARE_SUBPIXEL_BITS, 0);
+    triangle.maxX = std::min((maxX - half) >> SOFTWARE_SUBPIXEL_BITS, width - 1);
+    triangle.maxY = std::min((maxY - half) >> SOFTWARE_SUBPIXEL_BITS, height - 1);
+    if(triangle.minX > triangle.maxX || triangle.minY > triangle.maxY){
+        return;
+    }
+
+    unsigned int index = jobBins.triangles.size();
+    jobBins.triangles.push_back(triangle);
+    for(int ty = triangle.minY / SOFTWARE_TILE_SIZE; ty <= triangle.maxY / SOFTWARE_TILE_SIZE; ty++){
+        for(int tx = triangle.minX / SOFTWARE_TILE_SIZE; tx <= triangle.maxX / SOFTWARE_TILE_SIZE; tx++){
+            jobBins.tiles[ty * tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void SoftwareRenderer::rasterizeTile(int tile){
+    int minX = (tile % tilesX) * SOFTWARE_TILE_SIZE;
+    int minY = (tile / tilesX) * SOFTWARE_TILE_SIZE;
+    int maxX = std::min(minX + SOFTWARE_TILE_SIZE, width) - 1;
+    int maxY = std::min(minY + SOFTWARE_TILE_SIZE, height) - 1;
+    size_t covered = 0, shaded = 0;
+
+    //the jobs in order, so the triangles are drawn in the order of the draws
+    for(const TriangleBins &job : bins){
+        if(job.tiles.empty()){
+            continue;
+        }
+        for(unsigned int index : job.tiles[tile]){
+            rasterizeTriangle(job.triangles[index], minX, minY, maxX, maxY, covered, shaded);
+        }
+    }
+
+    //the pixels whose centers are in the square of each lamp
+    const float half = SOFTWARE_LAMP_SIZE * 0.5f;
+    for(const Lamp &lamp : lamps){
+        int x0 = std::max((int) std::ceil(lamp.x - half - 0.5f), minX);
+        int x1 = std::min((int) std::ceil(lamp.x + half - 0.5f) - 1, maxX);
+        int y0 = std::max((int) std::ceil(lamp.y - half - 0.5f), minY);
+        int y1 = std::min((int) std::ceil(lamp.y + half - 0.5f) - 1, maxY);
+        for(int y = y0; y <= y1; y++){
+            for(int x = x0; x <= x1; x++){
+                size_t pixel = (size_t) y * stride + x;
+                covered++;
+                if(lamp.depth < depth[pixel]){
+                    depth[pixel] = lamp.depth;
+                    color[3 * pixel] = lamp.color.r;
+                    color[3 * pixel + 1] = lamp.color.g;
+                    color[3 * pixel + 2] = lamp.color.b;
+                    shaded++;
+                }
+            }
+        }
+    }
+
+    tileCovered[tile] = covered;
+    tileShaded[tile] = shaded;
+}
+
+void SoftwareRenderer::rasterizeTriangle(const RasterTriangle &triangle, int tileMinX, int tileMinY, int tileMaxX,
+                                         int tileMaxY, size_t &covered, size_t &shaded){
+    int minX = std::max(triangle.minX, tileMinX);
+    int maxX = std::min(triangle.maxX, tileMaxX);
+    int minY = std::max(triangle.minY, tileMinY);
+    int maxY = std::min(triangle.maxY, tileMaxY);
+    if(minX > maxX || minY > maxY){
+        return;
+    }
+    //the rows of 4 pixels start at multiples of 4, as the tiles and the stride
+    int startX = minX & ~3;
+
+    //edge k goes between the other 2 corners and is area at corner k and 0 on the edge, so divided by the
+    //area it's the barycentric coordinate of corner k. The pixels on the edges are drawn by one of the
+    //triangles that share them: the ones on the left and on the horizontal top edges (bias 0)
+    const int subpixels = 1 << SOFTWARE_SUBPIXEL_BITS;
+    int64_t centerX = (int64_t) startX * subpixels + subpixels / 2;
+    int64_t centerY = (int64_t) minY * subpixels + subpixels / 2;
+    int32_t rowEdge[3], stepX[3], stepY[3];
+    for(int k = 0; k < 3; k++){
+        int a = (k + 1) % 3, b = (k + 2) % 3;
+        int dx = triangle.x[b] - triangle.x[a];
+        int dy = triangle.y[b] - triangle.y[a];
+        int bias = (dy < 0 || (dy == 0 && dx < 0)) ? 0 : -1;
+        rowEdge[k] = (int32_t) ((int64_t) dx * (centerY - triangle.y[a]) - (int64_t) dy * (centerX - triangle.x[a]) + bias);
+        stepX[k] = -dy * subpixels;
+        stepY[k] = dx * subpixels;
+    }
+    int64_t area = (int64_t) (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) -
+                   (int64_t) (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+    float inverseArea = 1.f / (float) area;
+    //change of the barycentric coordinates to the next pixel on the right and above
+    glm::vec3 dx(stepX[0] * inverseArea, stepX[1] * inverseArea, stepX[2] * inverseArea);
+    glm::vec3 dy(stepY[0] * inverseArea, stepY[1] * inverseArea, stepY[2] * inverseArea);
+    //the window depth is linear on the screen
+    float depth0 = triangle.depth[0];
+    float depth1 = triangle.depth[1] - depth0;
+    float depth2 = triangle.depth[2] - depth0;
+
+#ifdef __SSE2__
+    //lane l of a row of 4 pixels is l steps from the first one
+    __m128i laneStep[3], blockStep[3];
+    for(int k = 0; k < 3; k++){
+        laneStep[k] = _mm_set_epi32(3 * stepX[k], 2 * stepX[k], stepX[k], 0);
+        blockStep[k] = _mm_set1_epi32(4 * stepX[k]);
+    }
+    __m128 inverseAreas = _mm_set1_ps(inverseArea);
+    __m128 depths0 = _mm_set1_ps(depth0), depths1 = _mm_set1_ps(depth1), depths2 = _mm_set1_ps(depth2);
+#endif
+
+    for(int y = minY; y <= maxY; y++){
+#ifdef __SSE2__
+        __m128i edge0 = _mm_add_epi32(_mm_set1_epi32(rowEdge[0]), laneStep[0]);
+        __m128i edge1 = _mm_add_epi32(_mm_set1_epi32(rowEdge[1]), laneStep[1]);
+        __m128i edge2 = _mm_add_epi32(_mm_set1_epi32(rowEdge[2]), laneStep[2]);
+#else
+        int32_t edge[3] = {rowEdge[0], rowEdge[1], rowEdge[2]};
+#endif
+        for(int x = startX; x <= maxX; x += 4){
+            //the lanes of the row inside the bounding box
+            int lanesInside = 0xF;
+            if(x < minX){
+                lanesInside &= 0xF << (minX - x);
+            }
+            if(x + 3 > maxX){
+                lanesInside &= 0xF >> (x + 3 - maxX);
+            }
+            size_t pixel = (size_t) y * stride + x;
+            float barycentric1[4], barycentric2[4], fragmentDepth[4];
+            int inside, passed;
+#ifdef __SSE2__
+            //a pixel is inside when the 3 edges are positive, so the sign of their or is clear
+            __m128i signs = _mm_or_si128(_mm_or_si128(edge0, edge1), edge2);
+            inside = ~_mm_movemask_ps(_mm_castsi128_ps(signs)) & lanesInside;
+            if(inside){
+                __m128 b1 = _mm_mul_ps(_mm_cvtepi32_ps(edge1), inverseAreas);
+                __m128 b2 = _mm_mul_ps(_mm_cvtepi32_ps(edge2), inverseAreas);
+                __m128 z = _mm_add_ps(depths0, _mm_add_ps(_mm_mul_ps(depths1, b1), _mm_mul_ps(depths2, b2)));
+                __m128 stored = _mm_loadu_ps(&depth[pixel]);
+                passed = inside & _mm_movemask_ps(_mm_cmplt_ps(z, stored));
+                _mm_storeu_ps(barycentric1, b1);
+                _mm_storeu_ps(barycentric2, b2);
+                _mm_storeu_ps(fragmentDepth, z);
+            }
+            edge0 = _mm_add_epi32(edge0, blockStep[0]);
+            edge1 = _mm_add_epi32(edge1, blockStep[1]);
+            edge2 = _mm_add_epi32(edge2, blockStep[2]);
+#else
+            inside = 0;
+            passed = 0;
+            for(int lane = 0; lane < 4; lane++){
+                int32_t e0 = edge[0] + lane * stepX[0];
+                int32_t e1 = edge[1] + lane * stepX[1];
+                int32_t e2 = edge[2] + lane * stepX[2];
+                if(!(lanesInside & (1 << lane)) || (e0 | e1 | e2) < 0){
+                    continue;
+                }
+                inside |= 1 << lane;
+                barycentric1[lane] = e1 * inverseArea;
+                barycentric2[lane] = e2 * inverseArea;
+                fragmentDepth[lane] = depth0 + depth1 * barycentric1[lane] + depth2 * barycentric2[lane];
+                if(fragmentDepth[lane] < depth[pixel + lane]){
+                    passed |= 1 << lane;
+                }
+            }
+            for(int k = 0; k < 3; k++){
+                edge[k] += 4 * stepX[k];
+            }
+#endif
+            if(!inside){
+                continue;
+            }
+            covered += __builtin_popcount(inside);
+            shaded += __builtin_popcount(passed);
+            while(passed){
+                int lane = __builtin_ctz(passed);
+                passed &= passed - 1;
+                depth[pixel + lane] = fragmentDepth[lane];
+                glm::vec3 screen(1.f - barycentric1[lane] - barycentric2[lane], barycentric1[lane], barycentric2[lane]);
+                glm::vec3 result = shade(triangle, screen, dx, dy);
+                unsigned char *output = &color[3 * (pixel + lane)];
+                output[0] = toByte(result.r);
+                output[1] = toByte(result.g);
+                output[2] = toByte(result.b);
+            }
+        }
+        for(int k = 0; k < 3; k++){
+            rowEdge[k] += stepY[k];
+        }
+    }
+}
+
+glm::vec3 SoftwareRenderer::shade(const RasterTriangle &triangle, const glm::vec3 &screen, const glm::vec3 &dx,
+                                  const glm::vec3 &dy) const{
+    const Draw &draw = draws[triangle.draw];
+    glm::vec3 inverseW(triangle.inverseW[0], triangle.inverseW[1], triangle.inverseW[2]);
+    //perspective correct barycentric coordinates, in the triangle of the draw the attributes are interpolated in
+    auto weightsAt = [&](const glm::vec3 &barycentric){
+        glm::vec3 perspective = barycentric * inverseW;
+        return triangle.corners * (perspective / (perspective.x + perspective.y + perspective.z));
+    };
+    glm::vec3 weights = weightsAt(screen);
+    size_t v0 = triangle.vertex[0], v1 = triangle.vertex[1], v2 = triangle.vertex[2];
+    auto texCoordsAt = [&](const glm::vec3 &w){
+        return w.x * texCoords[v0] + w.y * texCoords[v1] + w.z * texCoords[v2];
+    };
+    glm::vec3 diffuseColor = OBJECT_COLOR, specularColor = OBJECT_COLOR;
+    if(draw.diffuse || draw.specular){
+        glm::vec2 coordinates = texCoordsAt(weights);
+        glm::vec2 coordinatesDx = texCoordsAt(weightsAt(screen + dx)) - coordinates;
+        glm::vec2 coordinatesDy = texCoordsAt(weightsAt(screen + dy)) - coordinates;
+        if(draw.diffuse){
+            diffuseColor = draw.diffuse->sample(coordinates, coordinatesDx, coordinatesDy);
+        }
+        specularColor = draw.specular ? draw.specular->sample(coordinates, coordinatesDx, coordinatesDy) : diffuseColor;
+    }
+
+    //multipleLights.fs without PHONG
+    if(shadingMode == GOURAUD_SHADING){
+        glm::vec3 light = weights.x * vertexLighting[v0] + weights.y * vertexLighting[v1] + weights.z * vertexLighting[v2];
+        return light * diffuseColor;
+    }
+
+    //multipleLights.fs with PHONG
+    glm::vec3 position = weights.x * worldPositions[v0] + weights.y * worldPositions[v1] + weights.z * worldPositions[v2];
+    glm::vec3 normal = glm::normalize(weights.x * worldNormals[v0] + weights.y * worldNormals[v1] +
+                                      weights.z * worldNormals[v2]);
+    glm::vec3 viewDirection = glm::normalize(viewPosition - position);
+    float occlusion = weights.x * occlusions[v0] + weights.y * occlusions[v1] + weights.z * occlusions[v2];
+    return sumPointLights(lighting, normal, position, viewDirection, diffuseColor, specularColor, occlusion, OBJECT_COLOR);
+}
+
+bool SoftwareRenderer::writeImage(const std::string &path) const{
+    std::ofstream file(path, std::ios::binary);
+    if(!file){
+        std::cerr << "ERROR::SOFTWARE_RENDERER::IMAGE_NOT_WRITTEN " << path << std::endl;
+        return false;
+    }
+    //the rows of the file go from the top
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for(int y = height - 1; y >= 0; y--){
+        file.write((const char*) &color[(size_t) y * stride * 3], (size_t) width * 3);
+    }
+    return (bool) file;
+}
+
+glm::u8vec3 SoftwareRenderer::pixel(int x, int y) const{
+    const unsigned char *rgb = &color[((size_t) y * stride + x) * 3];
+    return glm::u8vec3(rgb[0], rgb[1], rgb[2]);
+}
+
+int SoftwareRenderer::getWidth() const{
+    return width;
+}
+
+int SoftwareRenderer::getHeight() const{
+    return height;
+}
+
+size_t SoftwareRenderer::trianglesSubmitted() const{
+    return triangleCount;
+}
+
+size_t SoftwareRenderer::trianglesRasterized() const{
+    size_t triangles = 0;
+    for(const TriangleBins &job : bins){
+        triangles += job.triangles.size();
+    }
+    return triangles;
+}
+
+size_t SoftwareRenderer::fragmentsCovered() const{
+    size_t fragments = 0;
+    for(size_t tileFragments : tileCovered){
+        fragments += tileFragments;
+    }
+    return fragments;
+}
+
+size_t SoftwareRenderer::fragmentsShaded() const{
+    size_t fragments = 0;
+    for(size_t tileFragments : tileShaded){
+        fragments += tileFragments;
+    }
+    return fragments;
+}
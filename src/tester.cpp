@@ -1,8 +1,77 @@
 #include <utils.hpp>
+#include <ambientocclusion.hpp>
+#include <bvh.hpp>
+#include <camera.hpp>
+#include <environmentlighting.hpp>
 #include <matrixlib.hpp>
+#include <geometryarena.hpp>
+#include <graphicslib.hpp>
+#include <lightbaker.hpp>
+#include <lightclusters.hpp>
+#include <meshoptimizer.hpp>
+#include <model.hpp>
+#include <pathtracer.hpp>
+#include <scenefile.hpp>
+#include <scenesnapshot.hpp>
+#include <softwarerenderer.hpp>
+#include <texturecompressor.hpp>
+#include <texturestreamer.hpp>
+#include <threadpool.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
 
 namespace tester {
 
+    //fill a matrix with reproducible random values in [-1, 1]
+    static void fillRandom(ml::matrix<float> &m, unsigned int seed){
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        for(int i = 0; i < m.getRows(); i++){
+            for(int j = 0; j < m.getCols(); j++){
+                m[i][j] = distribution(generator);
+            }
+        }
+    }
+
+    //biggest absolute difference between two matrices of the same size
+    static float maxDifference(ml::matrix<float> &a, ml::matrix<float> &b){
+        float difference = 0.f;
+        for(int i = 0; i < a.getRows(); i++){
+            for(int j = 0; j < a.getCols(); j++){
+                difference = std::max(difference, std::abs(a[i][j] - b[i][j]));
+            }
+        }
+        return difference;
+    }
+
+    //checks that failed since the start
+    static int failures = 0;
+
+    //print the result of a check
+    static void report(const char* name, bool passed, float error){
+        std::cout << name << ": " << (passed ? "ok" : "FAILED") << " (error " << error << ")" << std::endl;
+        failures += !passed;
+    }
+
+    int failedChecks(){
+        return failures;
+    }
+
     //do the same operations that are executed in the run function, but without transposition
     void matrixOperationsTest(){
         ml::matrix<float> position(3, 1);
@@ -58,4 +127,2230 @@ namespace tester {
         std::cout << "identity:" << std::endl << identityMatrix << std::endl;
         std::cout << "scale matrix:" << std::endl << scaleMatrix << std::endl;
     }
+
+    //compare the blocked multiplication with the naive one and with a known product
+    void multiplicationTest(){
+        //known product:
+        ml::matrix<float> a(2, 3), b(3, 2), expected(2, 2);
+        float aValues[] = {1, 2, 3, 4, 5, 6};
+        float bValues[] = {7, 8, 9, 10, 11, 12};
+        float expectedValues[] = {58, 64, 139, 154};
+        for(int i = 0; i < 6; i++){
+            a[i / 3][i % 3] = aValues[i];
+            b[i / 2][i % 2] = bValues[i];
+        }
+        for(int i = 0; i < 4; i++){
+            expected[i / 2][i % 2] = expectedValues[i];
+        }
+        ml::matrix<float> product = a.blockedMultiply(b);
+        float error = maxDifference(product, expected);
+        report("blocked product 2x3 * 3x2", error == 0.f, error);
+
+        //sizes that aren't multiple of the blocks:
+        ml::matrix<float> big1(301, 517), big2(517, 263);
+        fillRandom(big1, 1);
+        fillRandom(big2, 2);
+        ml::matrix<float> naive = big1.naiveMultiply(big2);
+        ml::matrix<float> blocked = big1.blockedMultiply(big2);
+        error = maxDifference(naive, blocked);
+        report("blocked product 301x517 * 517x263", error < 1e-3f, error);
+
+        //transposition of a non square matrix:
+        ml::matrix<float> transposed = a.transpose();
+        bool passed = transposed.getRows() == 3 && transposed.getCols() == 2 && transposed[2][1] == 6 && transposed[1][0] == 2;
+        report("transpose 2x3", passed, 0.f);
+    }
+
+    //test the LU and the closed form inverses against known inverses
+    void inverseTest(){
+        //known inverse:
+        ml::matrix<float> m(3, 3), expected(3, 3);
+        float values[] = {2, -1, 0, -1, 2, -1, 0, -1, 2};
+        float expectedValues[] = {0.75f, 0.5f, 0.25f, 0.5f, 1.f, 0.5f, 0.25f, 0.5f, 0.75f};
+        for(int i = 0; i < 9; i++){
+            m[i / 3][i % 3] = values[i];
+            expected[i / 3][i % 3] = expectedValues[i];
+        }
+        ml::matrix<float> inverse = m.inverse();
+        float error = maxDifference(inverse, expected);
+        report("LU inverse 3x3", error < 1e-5f, error);
+
+        //closed form against LU on a model matrix:
+        ml::matrix<float> model(4, 4, true);
+        float position[] = {1.f, -2.f, 3.f};
+        float scale[] = {0.5f, 2.f, 4.f};
+        model = utils::translate(model, position);
+        model = utils::rotateX(model, 0.3f);
+        model = utils::rotateY(model, 1.1f);
+        model = utils::scale(model, scale);
+        ml::matrix<float> identity4(4, 4, true);
+        ml::matrix<float> closedForm = model.inverse4x4();
+        ml::matrix<float> lu = model.solve(identity4);
+        error = maxDifference(closedForm, lu);
+        report("closed form 4x4 inverse against LU", error < 1e-4f, error);
+        ml::matrix<float> shouldBeIdentity = model * closedForm;
+        error = maxDifference(shouldBeIdentity, identity4);
+        report("model * inverse4x4(model) = I", error < 1e-5f, error);
+
+        //bigger random matrix:
+        ml::matrix<float> big(200, 200), identity(200, 200, true);
+        fillRandom(big, 3);
+        ml::matrix<float> bigInverse = big.inverse();
+        ml::matrix<float> product = big * bigInverse;
+        error = maxDifference(product, identity);
+        report("A * inverse(A) = I (200x200)", error < 1e-2f, error);
+
+        //singular matrices must be rejected:
+        ml::matrix<float> singular(1.f, 4, 4);
+        bool thrown = false;
+        try{
+            singular.inverse();
+        }catch( std::domain_error &e ){
+            thrown = true;
+        }
+        report("singular inverse throws", thrown, 0.f);
+
+        //random 4x4 matrices of rank 3, the last row a combination of the others, go through inverse4x4
+        std::mt19937 generator(26);
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        int inverted = 0;
+        for(int t = 0; t < 1000; t++){
+            ml::matrix<float> rank3(4, 4);
+            fillRandom(rank3, 1000 + t);
+            float a = distribution(generator), b = distribution(generator), c = distribution(generator);
+            for(int j = 0; j < 4; j++){
+                rank3[3][j] = a * rank3[0][j] + b * rank3[1][j] + c * rank3[2][j];
+            }
+            try{
+                rank3.inverse();
+                inverted++;
+            }catch( std::domain_error &e ){
+            }
+        }
+        report("inverse of 4x4 matrices of rank 3 throws", inverted == 0, inverted);
+    }
+
+    //test the determinant against known values
+    void determinantTest(){
+        ml::matrix<float> m(3, 3);
+        float values[] = {6, 1, 1, 4, -2, 5, 2, 8, 7};
+        for(int i = 0; i < 9; i++){
+            m[i / 3][i % 3] = values[i];
+        }
+        float error = std::abs(m.determinant() - (-306.f));
+        report("determinant 3x3 = -306", error < 1e-3f, error);
+
+        //a row swap is needed for the first pivot:
+        ml::matrix<float> swap(2, 2);
+        swap[0][0] = 0; swap[0][1] = 1;
+        swap[1][0] = 1; swap[1][1] = 0;
+        error = std::abs(swap.determinant() - (-1.f));
+        report("determinant of a permutation = -1", error == 0.f, error);
+
+        ml::matrix<float> scale(4, 4, true);
+        float scaleValues[] = {2.f, 3.f, 4.f};
+        scale = utils::scale(scale, scaleValues);
+        error = std::abs(scale.determinant() - 24.f);
+        report("determinant of scale(2, 3, 4) = 24", error < 1e-4f, error);
+
+        ml::matrix<float> singular(1.f, 3, 3);
+        error = std::abs(singular.determinant());
+        report("determinant of a singular matrix = 0", error == 0.f, error);
+    }
+
+    //test the linear system solver against a known solution
+    void solveTest(){
+        // 2x + y - z = 8, -3x - y + 2z = -11, -2x + y + 2z = -3  =>  x = 2, y = 3, z = -1
+        ml::matrix<float> a(3, 3), b(3, 1), expected(3, 1);
+        float values[] = {2, 1, -1, -3, -1, 2, -2, 1, 2};
+        for(int i = 0; i < 9; i++){
+            a[i / 3][i % 3] = values[i];
+        }
+        b[0][0] = 8; b[1][0] = -11; b[2][0] = -3;
+        expected[0][0] = 2; expected[1][0] = 3; expected[2][0] = -1;
+        ml::matrix<float> x = a.solve(b);
+        float error = maxDifference(x, expected);
+        report("solve 3x3 system", error < 1e-5f, error);
+    }
+
+    //compare the normal matrix with the transpose of the inverse of the model matrix
+    void normalMatrixTest(){
+        ml::matrix<float> model(4, 4, true);
+        float position[] = {2.f, 0.f, -1.f};
+        float scale[] = {0.1f, 0.3f, 2.f};
+        model = utils::translate(model, position);
+        model = utils::rotateZ(model, 0.7f);
+        model = utils::rotateX(model, -0.4f);
+        model = utils::scale(model, scale);
+
+        ml::matrix<float> normal = utils::normalMatrix(model);
+        ml::matrix<float> expected4 = model.inverse().transpose();
+        ml::matrix<float> expected(3, 3);
+        for(int i = 0; i < 3; i++){
+            for(int j = 0; j < 3; j++){
+                expected[i][j] = expected4[i][j];
+            }
+        }
+        float error = maxDifference(normal, expected);
+        report("normal matrix = transpose(inverse(model))", error < 1e-4f, error);
+    }
+
+    //the light contribution at its radius must be the cutoff intensity
+    void lightRadiusTest(){
+        graphicslib::PointLight light;
+        light.ambient = light.diffuse = light.specular = glm::vec3(1.f, 0.5f, 0.2f);
+        float intensity = POINT_LIGHT_KA + POINT_LIGHT_KD + POINT_LIGHT_KS;
+
+        float attenuations[][3] = {{1.f, 0.09f, 0.032f}, {0.f, 0.2f, 0.f}, {1.f, 0.f, 1.8f}};
+        for(auto &attenuation : attenuations){
+            light.constant = attenuation[0];
+            light.linear = attenuation[1];
+            light.quadratic = attenuation[2];
+            float d = LightClusters::pointLightRadius(light);
+            float contribution = intensity / (light.constant + light.linear * d + light.quadratic * d * d);
+            float error = std::abs(contribution - LIGHT_CUTOFF_INTENSITY) / LIGHT_CUTOFF_INTENSITY;
+            report("light contribution at its radius = cutoff", error < 1e-3f, error);
+        }
+
+        //without attenuation the light reaches everything, and a too weak light nothing
+        light.constant = 1.f;
+        light.linear = light.quadratic = 0.f;
+        report("radius without attenuation is infinite", std::isinf(LightClusters::pointLightRadius(light)), 0.f);
+        light.constant = 1000.f;
+        report("radius of an invisible light is 0", LightClusters::pointLightRadius(light) == 0.f, 0.f);
+    }
+
+    //the triangles of an index buffer, each one starting by its smallest vertex (keeps the winding), sorted
+    static std::vector<std::array<glm::vec3, 3>> sortedTriangles(const std::vector<Vertex> &vertices,
+                                                                  const std::vector<unsigned int> &indices){
+        auto less = [](const glm::vec3 &a, const glm::vec3 &b){
+            return std::make_tuple(a.x, a.y, a.z) < std::make_tuple(b.x, b.y, b.z);
+        };
+        std::vector<std::array<glm::vec3, 3>> triangles;
+        for(size_t i = 0; i + 2 < indices.size(); i += 3){
+            std::array<glm::vec3, 3> triangle = {vertices[indices[i]].Position, vertices[indices[i + 1]].Position,
+                                                 vertices[indices[i + 2]].Position};
+            while(less(triangle[1], triangle[0]) || less(triangle[2], triangle[0]))
+                std::rotate(triangle.begin(), triangle.begin() + 1, triangle.end());
+            triangles.push_back(triangle);
+        }
+        std::sort(triangles.begin(), triangles.end(), [&](const std::array<glm::vec3, 3> &a, const std::array<glm::vec3, 3> &b){
+            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), less);
+        });
+        return triangles;
+    }
+
+    //check that the mesh optimization keeps the triangles and improves the cache use of a shuffled grid
+    void meshOptimizationTest(){
+        //grid of 100x100 quads with its triangles in a random order
+        const unsigned int n = 100;
+        std::vector<Vertex> vertices((n + 1) * (n + 1));
+        for(unsigned int i = 0; i < vertices.size(); i++){
+            vertices[i].Position = glm::vec3(i % (n + 1), i / (n + 1), 0.f);
+        }
+        std::vector<std::array<unsigned int, 3>> triangles;
+        for(unsigned int y = 0; y < n; y++){
+            for(unsigned int x = 0; x < n; x++){
+                unsigned int v = y * (n + 1) + x;
+                triangles.push_back({v, v + 1, v + n + 2});
+                triangles.push_back({v, v + n + 2, v + n + 1});
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+        std::vector<unsigned int> indices;
+        for(auto &triangle : triangles){
+            indices.insert(indices.end(), triangle.begin(), triangle.end());
+        }
+        //some unused vertices, the fetch optimization removes them
+        std::vector<Vertex> optimizedVertices = vertices;
+        optimizedVertices.resize(vertices.size() + 10);
+        std::vector<unsigned int> optimizedIndices = indices;
+
+        meshoptimizer::VertexCacheStatistics before = meshoptimizer::analyzeVertexCache(indices, vertices.size());
+        meshoptimizer::optimizeVertexCache(optimizedIndices, optimizedVertices.size());
+        meshoptimizer::VertexCacheStatistics after = meshoptimizer::analyzeVertexCache(optimizedIndices, optimizedVertices.size());
+        meshoptimizer::optimizeVertexFetch(optimizedVertices, optimizedIndices);
+
+        report("optimized triangles are the same", sortedTriangles(vertices, indices) == sortedTriangles(optimizedVertices, optimizedIndices), 0.f);
+        report("unused vertices removed", optimizedVertices.size() == vertices.size(), optimizedVertices.size() - vertices.size());
+        //a grid can't go below 0.5 transformed vertices per triangle, a shuffled one is close to 3
+        report("ACMR of the shuffled grid > 2.5", before.acmr() > 2.5f, before.acmr());
+        report("ACMR of the optimized grid < 0.8", after.acmr() < 0.8f, after.acmr());
+        report("optimized ACMR is the same after the fetch optimization",
+               meshoptimizer::analyzeVertexCache(optimizedIndices, optimizedVertices.size()).transformedVertices == after.transformedVertices, 0.f);
+
+        //the vertices are in the order of the first use
+        unsigned int nextVertex = 0;
+        bool firstUseOrder = true;
+        for(unsigned int index : optimizedIndices){
+            if(index > nextVertex)
+                firstUseOrder = false;
+            else if(index == nextVertex)
+                nextVertex++;
+        }
+        report("vertices in the order of the first use", firstUseOrder, 0.f);
+    }
+
+    //check the simplification of a flat grid (keeps its outline) and of a sphere (keeps its shape and winding)
+    //sphere of radius 1 around the origin, counterclockwise seen from outside, with a UV seam where the longitude
+    //wraps around and degenerate triangles at the poles
+    static void uvSphere(unsigned int rings, unsigned int segments, std::vector<Vertex> &vertices,
+                         std::vector<unsigned int> &indices){
+        vertices.clear();
+        indices.clear();
+        for(unsigned int r = 0; r <= rings; r++){
+            for(unsigned int s = 0; s <= segments; s++){
+                float theta = 3.14159265f * r / rings, phi = 2.f * 3.14159265f * s / segments;
+                Vertex vertex;
+                vertex.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+                //the copies of the poles are at exactly the same position
+                if(r == 0 || r == rings){
+                    vertex.Normal = glm::vec3(0.f, r == 0 ? 1.f : -1.f, 0.f);
+                }
+                vertex.Position = vertex.Normal;
+                vertex.TexCoords = glm::vec2((float) s / segments, (float) r / rings);
+                vertices.push_back(vertex);
+            }
+        }
+        for(unsigned int r = 0; r < rings; r++){
+            for(unsigned int s = 0; s < segments; s++){
+                unsigned int v = r * (segments + 1) + s;
+                indices.insert(indices.end(), {v, v + 1, v + segments + 2, v, v + segments + 2, v + segments + 1});
+            }
+        }
+    }
+
+    void simplificationTest(){
+        //grid of 64x64 quads in the plane z = 0
+        const unsigned int n = 64;
+        std::vector<Vertex> vertices((n + 1) * (n + 1));
+        for(unsigned int i = 0; i < vertices.size(); i++){
+            vertices[i].Position = glm::vec3(i % (n + 1), i / (n + 1), 0.f);
+            vertices[i].Normal = glm::vec3(0.f, 0.f, 1.f);
+        }
+        std::vector<unsigned int> indices;
+        for(unsigned int y = 0; y < n; y++){
+            for(unsigned int x = 0; x < n; x++){
+                unsigned int v = y * (n + 1) + x;
+                indices.insert(indices.end(), {v, v + 1, v + n + 2, v, v + n + 2, v + n + 1});
+            }
+        }
+        auto area = [&](const std::vector<unsigned int> &triangles){
+            float sum = 0.f;
+            for(size_t i = 0; i < triangles.size(); i += 3){
+                glm::vec3 a = vertices[triangles[i]].Position, b = vertices[triangles[i + 1]].Position, c = vertices[triangles[i + 2]].Position;
+                sum += glm::cross(b - a, c - a).z * 0.5f;
+            }
+            return sum;
+        };
+        float error;
+        std::vector<unsigned int> simplified = meshoptimizer::simplify(vertices, indices, indices.size() / 10, error);
+        report("simplified grid has at most 10% of the triangles", simplified.size() <= indices.size() / 10, simplified.size() / 3);
+        //the outline doesn't move and no triangle is flipped, so the area is the same
+        report("simplified grid has the same area", std::abs(area(simplified) - n * n) < 1e-2f, area(simplified) - n * n);
+        report("simplified grid error is 0", error < 1e-4f, error);
+
+        //sphere of radius 1, with a UV seam where the longitude wraps around
+        uvSphere(48, 96, vertices, indices);
+        //the triangles at the poles are degenerate, the simplification drops them
+        simplified = meshoptimizer::simplify(vertices, indices, indices.size() / 4, error);
+        report("simplified sphere has at most 25% of the triangles", simplified.size() <= indices.size() / 4, simplified.size() / 3);
+        report("simplified sphere error < 1% of the radius", error < 0.01f, error);
+        int flipped = 0;
+        for(size_t i = 0; i < simplified.size(); i += 3){
+            glm::vec3 a = vertices[simplified[i]].Position, b = vertices[simplified[i + 1]].Position, c = vertices[simplified[i + 2]].Position;
+            flipped += glm::dot(glm::cross(b - a, c - a), a + b + c) < 0.f;
+        }
+        report("simplified sphere has no inverted triangles", flipped == 0, flipped);
+    }
+
+    void weldTest(){
+        //grid of 32x32 quads where every triangle has its own vertices, the ones of the right half moved a bit
+        //less than the tolerance, and a UV seam down the middle
+        const unsigned int n = 32;
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::mt19937 random(3);
+        std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+        float tolerance = n * std::sqrt(2.f) * WELD_POSITION_TOLERANCE;
+        for(unsigned int y = 0; y < n; y++){
+            for(unsigned int x = 0; x < n; x++){
+                glm::vec2 corners[6] = {{x, y}, {x + 1, y}, {x + 1, y + 1}, {x, y}, {x + 1, y + 1}, {x, y + 1}};
+                for(const glm::vec2 &corner : corners){
+                    Vertex vertex;
+                    vertex.Position = glm::vec3(corner, 0.f);
+                    if(x >= n / 2){
+                        vertex.Position += glm::vec3(jitter(random), jitter(random), 0.f) * tolerance;
+                    }
+                    vertex.Normal = glm::vec3(0.f, 0.f, 1.f);
+                    //the left half is mapped apart from the right one
+                    vertex.TexCoords = corner / (float) n + glm::vec2(x < n / 2 ? 0.f : 0.5f, 0.f);
+                    indices.push_back(vertices.size());
+                    vertices.push_back(vertex);
+                }
+            }
+        }
+        std::vector<unsigned int> original = indices;
+        std::vector<Vertex> originalVertices = vertices;
+        size_t removed = meshoptimizer::weldVertices(vertices, indices);
+        //the column of the seam keeps two copies
+        size_t expected = (n + 1) * (n + 1) + n + 1;
+        report("welded grid has one vertex per position and UV", vertices.size() == expected, vertices.size());
+        report("welding removes the other vertices", removed == 6 * n * n - expected, removed);
+        int moved = 0;
+        for(size_t i = 0; i < indices.size(); i++){
+            moved += glm::length(vertices[indices[i]].Position - originalVertices[original[i]].Position) > tolerance;
+        }
+        report("welded corners move less than the tolerance", moved == 0, moved);
+
+        //a triangle collapsed by the welding is removed
+        vertices.assign(3, originalVertices[0]);
+        vertices[2].Position.x += 1.f;
+        indices = {0, 1, 2};
+        meshoptimizer::weldVertices(vertices, indices);
+        report("degenerate triangle is removed", indices.empty() && vertices.size() == 2, indices.size());
+    }
+
+    void tangentSpaceTest(){
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        uvSphere(48, 96, vertices, indices);
+        for(Vertex &vertex : vertices){
+            vertex.Normal = glm::vec3(0.f);
+        }
+        meshoptimizer::generateNormals(vertices, indices);
+        float normalError = 0.f;
+        for(const Vertex &vertex : vertices){
+            normalError = std::max(normalError, glm::length(vertex.Normal - vertex.Position));
+        }
+        //the copies on the seam and at the poles get the same normal, close to the normal of the sphere
+        //(the diagonals that split the quads tilt it about 2 degrees)
+        report("sphere normals point out", normalError < 0.05f, normalError);
+
+        //the angle weighting doesn't depend on how a face is split: the apex of a flat pyramid where one face has two
+        //triangles, its normal stays vertical
+        std::vector<Vertex> apex(6);
+        glm::vec3 positions[6] = {{0, 0, 0.3f}, {1, 0, 0}, {0, 1, 0}, {-1, 0, 0}, {0, -1, 0}, {0.5f, 0.5f, 0}};
+        for(int i = 0; i < 6; i++){
+            apex[i].Position = positions[i];
+        }
+        std::vector<unsigned int> apexIndices = {0, 1, 5,  0, 5, 2,  0, 2, 3,  0, 3, 4,  0, 4, 1};
+        meshoptimizer::generateNormals(apex, apexIndices);
+        report("angle weighted normal is the axis of the pyramid", glm::length(apex[0].Normal - glm::vec3(0.f, 0.f, 1.f)) < 1e-4f,
+               glm::length(apex[0].Normal - glm::vec3(0.f, 0.f, 1.f)));
+        report("smooth apex isn't split", apex.size() == 6, apex.size());
+
+        //the edges of a cube are creases: its 8 shared corners become 24 vertices with the normals of the faces
+        std::vector<Vertex> cube(8);
+        for(int i = 0; i < 8; i++){
+            cube[i].Position = glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+        }
+        std::vector<unsigned int> cubeIndices = {0, 2, 3,  0, 3, 1,  4, 5, 7,  4, 7, 6,  0, 1, 5,  0, 5, 4,
+                                                 2, 6, 7,  2, 7, 3,  0, 4, 6,  0, 6, 2,  1, 3, 7,  1, 7, 5};
+        meshoptimizer::generateNormals(cube, cubeIndices);
+        float faceError = 0.f;
+        for(size_t t = 0; t < cubeIndices.size(); t += 3){
+            const glm::vec3 &p0 = cube[cubeIndices[t]].Position, &p1 = cube[cubeIndices[t + 1]].Position,
+                            &p2 = cube[cubeIndices[t + 2]].Position;
+            glm::vec3 faceNormal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
+            for(int k = 0; k < 3; k++){
+                faceError = std::max(faceError, glm::length(cube[cubeIndices[t + k]].Normal - faceNormal));
+            }
+        }
+        report("cube is split on its creases", cube.size() == 24, cube.size());
+        report("cube normals are the normals of the faces", faceError < 1e-5f, faceError);
+
+        meshoptimizer::generateTangents(vertices, indices);
+        float orthogonality = 0.f, alignment = 0.f;
+        int leftHanded = 0, checked = 0;
+        for(size_t v = 0; v < vertices.size(); v++){
+            const Vertex &vertex = vertices[v];
+            //u grows with the longitude: the tangent of the sphere is the direction of growing phi
+            float theta = 3.14159265f * vertex.TexCoords.y, phi = 2.f * 3.14159265f * vertex.TexCoords.x;
+            if(std::sin(theta) < 0.1f){
+                continue;
+            }
+            glm::vec3 expected(-std::sin(phi), 0.f, std::cos(phi));
+            orthogonality = std::max(orthogonality, std::abs(glm::dot(vertex.Tangent, vertex.Normal)));
+            alignment = std::max(alignment, glm::length(vertex.Tangent - expected));
+            leftHanded += glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.f;
+            checked++;
+        }
+        report("tangents are perpendicular to the normals", orthogonality < 1e-4f, orthogonality);
+        report("tangents follow the texture u direction", alignment < 0.05f, alignment);
+        //v grows from the north pole to the south one, against cross(normal, tangent)
+        report("sphere tangent frames have the same handedness", leftHanded == 0 || leftHanded == checked, leftHanded);
+
+        //a strip whose texture is mirrored on its middle column: u goes 0, 1, 0 along x, so the left half is right-handed
+        //and the right half left-handed, and the vertices of the seam are split between them
+        std::vector<Vertex> strip(6);
+        for(int i = 0; i < 6; i++){
+            int column = i % 3, row = i / 3;
+            strip[i].Position = glm::vec3(column - 1, row, 0);
+            strip[i].Normal = glm::vec3(0.f, 0.f, 1.f);
+            strip[i].TexCoords = glm::vec2(column == 1 ? 1.f : 0.f, row);
+        }
+        std::vector<unsigned int> stripIndices = {0, 1, 4,  0, 4, 3,  1, 2, 5,  1, 5, 4};
+        meshoptimizer::generateTangents(strip, stripIndices);
+        float frameError = 0.f;
+        for(size_t t = 0; t < stripIndices.size(); t += 3){
+            //dP/du points to the seam on both halves, dP/dv is +y
+            glm::vec3 tangent = t < 6 ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(-1.f, 0.f, 0.f);
+            for(int k = 0; k < 3; k++){
+                const Vertex &vertex = strip[stripIndices[t + k]];
+                frameError = std::max(frameError, glm::length(vertex.Tangent - tangent));
+                frameError = std::max(frameError, glm::length(vertex.Bitangent - glm::vec3(0.f, 1.f, 0.f)));
+            }
+        }
+        report("mirrored seam is split", strip.size() == 8, strip.size());
+        report("mirrored halves keep their own tangent frames", frameError < 1e-5f, frameError);
+    }
+
+    void octahedralEncodingTest(){
+        //the axes, the diagonals of both halves (z < 0 is folded over the diagonals) and random directions
+        std::vector<glm::vec3> directions = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1},
+                                             {1, 1, 1}, {-1, 1, 1}, {1, -1, -1}, {-1, -1, -1}, {0.3f, -0.2f, -0.9f}};
+        std::mt19937 generator(34);
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        for(int i = 0; i < 1000; i++){
+            directions.push_back(glm::vec3(distribution(generator), distribution(generator), distribution(generator)));
+        }
+        //the distance between unit vectors, about the angle in radians (an acos in float isn't that precise)
+        float maxError = 0.f;
+        for(const glm::vec3 &direction : directions){
+            glm::vec3 unit = glm::normalize(direction);
+            short encoded[2];
+            Mesh::octahedralEncode(unit, encoded);
+            maxError = std::max(maxError, glm::length(Mesh::octahedralDecode(encoded) - unit));
+        }
+        report("octahedral encoding round trip", maxError < 2e-4f, maxError);
+
+        //a zero normal decodes to a unit vector, not to the NaN of a division by 0
+        short encoded[2] = {1234, -1234};
+        Mesh::octahedralEncode(glm::vec3(0.f), encoded);
+        glm::vec3 decoded = Mesh::octahedralDecode(encoded);
+        report("octahedral encoding of a zero vector", decoded == glm::vec3(0.f, 0.f, 1.f), glm::length(decoded));
+    }
+
+    void rangeAllocatorTest(){
+        RangeAllocator allocator(100);
+        size_t a = allocator.allocate(30), b = allocator.allocate(30), c = allocator.allocate(30);
+        report("ranges are allocated in order", a == 0 && b == 30 && c == 60, c);
+        report("full allocator fails", allocator.allocate(20) == RangeAllocator::INVALID, allocator.largestFreeRange());
+        //freeing the middle and then the first range merges them
+        allocator.free(b, 30);
+        allocator.free(a, 30);
+        report("freed neighbors are merged", allocator.largestFreeRange() == 60, allocator.largestFreeRange());
+        size_t d = allocator.allocate(50);
+        report("merged range is reused", d == 0 && allocator.used() == 80, allocator.used());
+        allocator.free(c, 30);
+        allocator.free(d, 50);
+        report("empty allocator is one range", allocator.largestFreeRange() == 100 && allocator.used() == 0, allocator.largestFreeRange());
+
+        //random allocations never overlap
+        std::mt19937 random(7);
+        RangeAllocator randomAllocator(1 << 16);
+        std::vector<std::pair<size_t, size_t>> ranges;
+        size_t overlaps = 0;
+        for(int i = 0; i < 2000; i++){
+            if(!ranges.empty() && random() % 3 == 0){
+                size_t r = random() % ranges.size();
+                randomAllocator.free(ranges[r].first, ranges[r].second);
+                ranges.erase(ranges.begin() + r);
+                continue;
+            }
+            size_t size = 1 + random() % 1000;
+            size_t offset = randomAllocator.allocate(size);
+            if(offset == RangeAllocator::INVALID){
+                continue;
+            }
+            for(const auto &range : ranges){
+                overlaps += offset < range.first + range.second && range.first < offset + size;
+            }
+            ranges.push_back(std::make_pair(offset, size));
+        }
+        for(const auto &range : ranges){
+            randomAllocator.free(range.first, range.second);
+        }
+        report("random ranges don't overlap", overlaps == 0, overlaps);
+        report("random ranges are all merged back", randomAllocator.largestFreeRange() == (1 << 16), randomAllocator.largestFreeRange());
+    }
+
+    //the frustum planes of a view and projection, in the form meshoptimizer::meshletVisible takes them
+    static void frustumPlanes(const glm::mat4 &clip, glm::vec4 planes[6]){
+        for(int axis = 0; axis < 3; axis++){
+            for(int side = 0; side < 2; side++){
+                float sign = side ? -1.f : 1.f;
+                glm::vec4 plane;
+                for(int column = 0; column < 4; column++){
+                    plane[column] = clip[column][3] + sign * clip[column][axis];
+                }
+                planes[2 * axis + side] = plane / glm::length(glm::vec3(plane));
+            }
+        }
+    }
+
+    //a triangle that faces the camera and isn't entirely behind one of the frustum planes
+    static bool triangleVisible(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c,
+                                const glm::vec3 &cameraPosition, const glm::vec4 planes[6]){
+        if(glm::dot(glm::cross(b - a, c - a), cameraPosition - a) <= 0.f)
+            return false;
+        for(int p = 0; p < 6; p++){
+            glm::vec3 normal(planes[p]);
+            if(glm::dot(normal, a) + planes[p].w < 0.f && glm::dot(normal, b) + planes[p].w < 0.f &&
+               glm::dot(normal, c) + planes[p].w < 0.f)
+                return false;
+        }
+        return true;
+    }
+
+    //views around a sphere: from the 26 directions of the cube's faces, edges and corners
+    static std::vector<glm::vec3> viewDirections(){
+        std::vector<glm::vec3> directions;
+        for(int x = -1; x <= 1; x++){
+            for(int y = -1; y <= 1; y++){
+                for(int z = -1; z <= 1; z++){
+                    if(x || y || z){
+                        directions.push_back(glm::normalize(glm::vec3(x, y, z)));
+                    }
+                }
+            }
+        }
+        return directions;
+    }
+
+    void meshletTest(){
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        uvSphere(48, 96, vertices, indices);
+        std::vector<unsigned int> meshletIndices = indices;
+        meshoptimizer::optimizeVertexCache(meshletIndices, vertices.size());
+        std::vector<Meshlet> meshlets = meshoptimizer::buildMeshlets(vertices, meshletIndices);
+        report("meshlets keep the triangles", sortedTriangles(vertices, indices) == sortedTriangles(vertices, meshletIndices), 0.f);
+
+        size_t covered = 0, oversized = 0;
+        for(const Meshlet &meshlet : meshlets){
+            std::vector<unsigned int> used(meshletIndices.begin() + meshlet.indexOffset,
+                                           meshletIndices.begin() + meshlet.indexOffset + meshlet.indexCount);
+            std::sort(used.begin(), used.end());
+            size_t meshletVertices = std::unique(used.begin(), used.end()) - used.begin();
+            oversized += meshletVertices > MESHLET_MAX_VERTICES || meshlet.indexCount > 3 * MESHLET_MAX_TRIANGLES;
+            covered += meshlet.indexOffset == covered ? meshlet.indexCount : 0;
+        }
+        report("meshlets cover the indices in order", covered == meshletIndices.size(), covered);
+        report("meshlets are within the limits", oversized == 0, oversized);
+
+        //from outside and from inside the sphere, no triangle that can be seen is in a culled meshlet
+        size_t missed = 0, submitted = 0, total = 0;
+        std::vector<glm::vec3> directions = viewDirections();
+        for(float distance : {3.f, 1.5f, 0.5f}){
+            for(const glm::vec3 &direction : directions){
+                glm::vec3 cameraPosition = direction * distance;
+                glm::vec3 up = std::abs(direction.y) > 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+                glm::vec4 planes[6];
+                frustumPlanes(glm::perspective(glm::radians(45.f), 1.f, 0.1f, 10.f) *
+                              glm::lookAt(cameraPosition, cameraPosition - direction, up), planes);
+                for(const Meshlet &meshlet : meshlets){
+                    bool visible = meshoptimizer::meshletVisible(meshlet, cameraPosition, planes);
+                    submitted += visible ? meshlet.indexCount / 3 : 0;
+                    total += meshlet.indexCount / 3;
+                    for(unsigned int i = meshlet.indexOffset; !visible && i < meshlet.indexOffset + meshlet.indexCount; i += 3){
+                        missed += triangleVisible(vertices[meshletIndices[i]].Position, vertices[meshletIndices[i + 1]].Position,
+                                                  vertices[meshletIndices[i + 2]].Position, cameraPosition, planes);
+                    }
+                }
+            }
+        }
+        report("culled meshlets have no visible triangle", missed == 0, missed);
+        report("meshlet culling submits less than 60% of the triangles", submitted < total * 6 / 10, (float) submitted / total);
+    }
+
+    //a mesh for the software renderer from its positions, facing normal and without textures
+    static Mesh softwareMesh(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices,
+                             const glm::vec3 &normal = glm::vec3(0.f, 0.f, 1.f)){
+        std::vector<Vertex> vertices(positions.size());
+        for(size_t v = 0; v < positions.size(); v++){
+            vertices[v].Position = positions[v];
+            vertices[v].Normal = normal;
+            vertices[v].TexCoords = glm::vec2(0.f);
+            vertices[v].Tangent = glm::vec3(1.f, 0.f, 0.f);
+            vertices[v].Bitangent = glm::vec3(0.f, 1.f, 0.f);
+        }
+        return Mesh(vertices, indices, std::vector<Texture>());
+    }
+
+    //a rectangle of the xy plane at depth z
+    static Mesh softwareQuad(float minX, float maxX, float minY, float maxY, float z,
+                             const glm::vec3 &normal = glm::vec3(0.f, 0.f, 1.f)){
+        return softwareMesh({glm::vec3(minX, minY, z), glm::vec3(maxX, minY, z), glm::vec3(maxX, maxY, z),
+                             glm::vec3(minX, maxY, z)}, {0, 1, 2, 0, 2, 3}, normal);
+    }
+
+    //pixels with different colors in two frames of the same size
+    static int differentPixels(const SoftwareRenderer &a, const SoftwareRenderer &b){
+        int different = 0;
+        for(int y = 0; y < a.getHeight(); y++){
+            for(int x = 0; x < a.getWidth(); x++){
+                different += a.pixel(x, y) != b.pixel(x, y);
+            }
+        }
+        return different;
+    }
+
+    //check that the software rasterizer covers the pixels of adjacent triangles once, clips the triangles outside of
+    //the frame and behind the camera, and gives the same image with any order of the draws and number of threads
+    void softwareRasterizerTest(){
+        bool upload = Mesh::uploadToGpu;
+        Mesh::uploadToGpu = false;
+        //not multiples of the tiles or of the 4 pixels of the rows
+        const int width = 301, height = 203;
+        const int subpixels = 1 << SOFTWARE_SUBPIXEL_BITS;
+        graphicslib::LightingInformation noLights;
+        noLights.numberOfPointLights = 0;
+        glm::mat4 identity(1.f);
+        SoftwareRenderer renderer(width, height);
+
+        //a fan of thin triangles around a point, the vertices are already in clip coordinates
+        const unsigned int corners = 37;
+        std::vector<glm::vec3> positions = {glm::vec3(0.13f, -0.07f, 0.f)};
+        std::vector<unsigned int> indices;
+        for(unsigned int c = 0; c < corners; c++){
+            float angle = 2.f * 3.14159265f * c / corners + 0.3f;
+            positions.push_back(glm::vec3(0.13f + 0.71f * std::cos(angle), -0.07f + 0.53f * std::sin(angle), 0.f));
+            indices.insert(indices.end(), {0, 1 + c, 1 + (c + 1) % corners});
+        }
+        Mesh fan = softwareMesh(positions, indices);
+        renderer.beginFrame(noLights, identity, glm::vec3(0.f, 0.f, 1.f), graphicslib::PHONG_SHADING);
+        renderer.draw(fan, identity, identity, "");
+        renderer.endFrame();
+        //the pixel centers strictly inside a triangle must be covered, the ones on an edge may be
+        std::vector<glm::ivec2> window;
+        for(const glm::vec3 &position : positions){
+            window.push_back(glm::ivec2(std::lround((position.x * 0.5f + 0.5f) * width * subpixels),
+                                        std::lround((position.y * 0.5f + 0.5f) * height * subpixels)));
+        }
+        size_t inside = 0, touched = 0;
+        for(int y = 0; y < height; y++){
+            for(int x = 0; x < width; x++){
+                glm::ivec2 center(x * subpixels + subpixels / 2, y * subpixels + subpixels / 2);
+                bool strictly = false, onEdge = false;
+                for(size_t i = 0; i < indices.size(); i += 3){
+                    long long minimum = LLONG_MAX;
+                    for(int k = 0; k < 3; k++){
+                        glm::ivec2 a = window[indices[i + k]], b = window[indices[i + (k + 1) % 3]];
+                        //the fan is counterclockwise
+                        minimum = std::min(minimum, (long long) (b.x - a.x) * (center.y - a.y) -
+                                                    (long long) (b.y - a.y) * (center.x - a.x));
+                    }
+                    strictly = strictly || minimum > 0;
+                    onEdge = onEdge || minimum == 0;
+                }
+                inside += strictly;
+                touched += strictly || onEdge;
+            }
+        }
+        size_t covered = renderer.fragmentsCovered();
+        report("triangles of a fan cover the pixels inside it", covered >= inside && covered <= touched,
+               (float) covered - inside);
+        //a pixel covered twice fails the depth test the second time
+        report("triangles of a fan cover each pixel once", renderer.fragmentsShaded() == covered,
+               (float) covered - renderer.fragmentsShaded());
+
+        //a quad bigger than the frame is clipped to it
+        Mesh big = softwareQuad(-3.f, 3.f, -2.5f, 4.f, 0.f);
+        renderer.beginFrame(noLights, identity, glm::vec3(0.f, 0.f, 1.f), graphicslib::PHONG_SHADING);
+        renderer.draw(big, identity, identity, "");
+        renderer.endFrame();
+        report("a quad bigger than the frame covers every pixel", renderer.fragmentsCovered() == (size_t) width * height,
+               (float) renderer.fragmentsCovered() - width * height);
+
+        //a floor that goes from behind the camera to the horizon covers the pixels whose rays hit it
+        const float fov = glm::radians(60.f), aspect = (float) width / height, far = 1000.f;
+        Mesh floor = softwareMesh({glm::vec3(-50.f, -1.f, 5.f), glm::vec3(50.f, -1.f, 5.f),
+                                   glm::vec3(50.f, -1.f, -far / 2.f), glm::vec3(-50.f, -1.f, -far / 2.f)},
+                                  {0, 1, 2, 0, 2, 3}, glm::vec3(0.f, 1.f, 0.f));
+        glm::mat4 perspective = glm::perspective(fov, aspect, 0.1f, far);
+        renderer.beginFrame(noLights, perspective, glm::vec3(0.f), graphicslib::PHONG_SHADING);
+        renderer.draw(floor, perspective, identity, "");
+        renderer.endFrame();
+        long long expected = 0;
+        for(int y = 0; y < height; y++){
+            for(int x = 0; x < width; x++){
+                glm::vec3 ray(((x + 0.5f) / width * 2.f - 1.f) * std::tan(fov / 2.f) * aspect,
+                              ((y + 0.5f) / height * 2.f - 1.f) * std::tan(fov / 2.f), -1.f);
+                glm::vec3 hit = ray * (-1.f / ray.y);
+                expected += ray.y < 0.f && hit.z >= -far / 2.f && std::abs(hit.x) <= 50.f;
+            }
+        }
+        //the far edge is a few pixels under the horizon, a row is left for its rounding
+        float floorError = std::abs((float) renderer.fragmentsCovered() - expected);
+        report("a triangle crossing the near plane is clipped", floorError <= width, floorError);
+
+        //the nearest of two overlapping quads is seen whatever the order of their draws
+        graphicslib::LightingInformation lighting;
+        graphicslib::PointLight light;
+        light.position = glm::vec3(0.2f, 0.3f, 1.5f);
+        light.constant = 1.f;
+        light.linear = 0.09f;
+        light.quadratic = 0.032f;
+        light.ambient = glm::vec3(0.05f);
+        light.diffuse = glm::vec3(0.8f, 0.7f, 0.6f);
+        light.specular = glm::vec3(1.f);
+        light.radius = 100.f;
+        lighting.pointLights.push_back(light);
+        lighting.numberOfPointLights = 1;
+        Mesh front = softwareQuad(-0.8f, 0.4f, -0.6f, 0.5f, -0.3f);
+        Mesh back = softwareQuad(-0.4f, 0.8f, -0.5f, 0.7f, 0.2f, glm::normalize(glm::vec3(0.6f, 0.f, 0.8f)));
+        SoftwareRenderer reversed(width, height);
+        renderer.beginFrame(lighting, identity, glm::vec3(0.f, 0.f, 2.f), graphicslib::PHONG_SHADING);
+        renderer.draw(front, identity, identity, "");
+        renderer.draw(back, identity, identity, "");
+        renderer.endFrame();
+        reversed.beginFrame(lighting, identity, glm::vec3(0.f, 0.f, 2.f), graphicslib::PHONG_SHADING);
+        reversed.draw(back, identity, identity, "");
+        reversed.draw(front, identity, identity, "");
+        reversed.endFrame();
+        report("the depth test doesn't depend on the order of the draws", differentPixels(renderer, reversed) == 0,
+               differentPixels(renderer, reversed));
+
+        //overlapping spheres drawn by one thread and by four
+        std::vector<Vertex> sphereVertices;
+        std::vector<unsigned int> sphereIndices;
+        uvSphere(24, 48, sphereVertices, sphereIndices);
+        Mesh sphere(sphereVertices, sphereIndices, std::vector<Texture>());
+        glm::mat4 view = glm::lookAt(glm::vec3(0.f, 1.f, 4.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+        glm::mat4 viewProjection = glm::perspective(glm::radians(45.f), aspect, 0.1f, 100.f) * view;
+        ThreadPool single(1), several(4);
+        int different = 0;
+        for(graphicslib::ShadingMode shading : {graphicslib::PHONG_SHADING, graphicslib::GOURAUD_SHADING}){
+            SoftwareRenderer one(width, height, single), four(width, height, several);
+            for(SoftwareRenderer *frame : {&one, &four}){
+                frame->beginFrame(lighting, viewProjection, glm::vec3(0.f, 1.f, 4.f), shading);
+                for(int s = 0; s < 5; s++){
+                    glm::mat4 model = glm::translate(identity, glm::vec3(0.7f * (s - 2), 0.2f * (s % 2), -0.5f * s));
+                    frame->draw(sphere, viewProjection * model, model, "");
+                }
+                frame->endFrame();
+            }
+            different += differentPixels(one, four) + (one.fragmentsShaded() != four.fragmentsShaded());
+        }
+        report("the image doesn't depend on the number of threads", different == 0, different);
+
+        Mesh::uploadToGpu = upload;
+    }
+
+    //distance to the nearest triangle hit by a ray, with the same arithmetic of the BVH, or FLT_MAX
+    static float nearestTriangle(const std::vector<glm::vec3> &positions, const std::vector<unsigned int> &indices,
+                                 const glm::vec3 &origin, const glm::vec3 &direction){
+        float nearest = FLT_MAX;
+        for(size_t i = 0; i < indices.size(); i += 3){
+            glm::vec3 corner = positions[indices[i]];
+            glm::vec3 edge1 = positions[indices[i + 1]] - corner, edge2 = positions[indices[i + 2]] - corner;
+            glm::vec3 p = glm::cross(direction, edge2);
+            float determinant = glm::dot(edge1, p);
+            if(std::abs(determinant) < 1e-20f){
+                continue;
+            }
+            float inverseDeterminant = 1.f / determinant;
+            glm::vec3 s = origin - corner;
+            float u = glm::dot(s, p) * inverseDeterminant;
+            glm::vec3 q = glm::cross(s, edge1);
+            float v = glm::dot(direction, q) * inverseDeterminant;
+            float distance = glm::dot(edge2, q) * inverseDeterminant;
+            if(u >= 0.f && u <= 1.f && v >= 0.f && u + v <= 1.f && distance > 0.f){
+                nearest = std::min(nearest, distance);
+            }
+        }
+        return nearest;
+    }
+
+    //check the nearest hits and the shadow rays of the BVH of a triangle soup and a sphere against all the triangles
+    void bvhTest(){
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<float> distribution(-1.f, 1.f);
+        std::vector<glm::vec3> positions;
+        std::vector<unsigned int> indices;
+        for(int t = 0; t < 3000; t++){
+            glm::vec3 center(distribution(generator), distribution(generator), distribution(generator));
+            for(int k = 0; k < 3; k++){
+                indices.push_back(positions.size());
+                positions.push_back(center + 0.1f * glm::vec3(distribution(generator), distribution(generator),
+                                                              distribution(generator)));
+            }
+        }
+        //shared vertices and the degenerate triangles of the poles
+        std::vector<Vertex> sphereVertices;
+        std::vector<unsigned int> sphereIndices;
+        uvSphere(32, 64, sphereVertices, sphereIndices);
+        unsigned int firstVertex = positions.size();
+        for(const Vertex &vertex : sphereVertices){
+            positions.push_back(vertex.Position * 0.5f + glm::vec3(0.3f, -0.2f, 0.1f));
+        }
+        for(unsigned int index : sphereIndices){
+            indices.push_back(firstVertex + index);
+        }
+
+        Bvh bvh;
+        bvh.build(positions, indices);
+        int wrongHits = 0, wrongShadows = 0, hits = 0;
+        const int rays = 4000;
+        for(int r = 0; r < rays; r++){
+            glm::vec3 origin = 2.f * glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+            glm::vec3 direction = glm::normalize(glm::vec3(distribution(generator), distribution(generator),
+                                                           distribution(generator)));
+            //some rays along the axes
+            if(r % 10 == 0){
+                direction = glm::vec3(0.f);
+                direction[r / 10 % 3] = r % 20 ? 1.f : -1.f;
+            }
+            float expected = nearestTriangle(positions, indices, origin, direction);
+            BvhHit hit;
+            bool found = bvh.intersect(origin, direction, FLT_MAX, hit);
+            hits += found;
+            wrongHits += found != (expected < FLT_MAX) || (found && hit.distance != expected);
+            float maxDistance = 1.5f * std::abs(distribution(generator));
+            wrongShadows += bvh.occluded(origin, direction, maxDistance) != (expected < maxDistance);
+        }
+        report("BVH finds the nearest triangle", wrongHits == 0, wrongHits);
+        report("BVH shadow rays find the triangles in between", wrongShadows == 0, wrongShadows);
+        report("BVH rays hit the triangles", hits > rays / 10, (float) hits / rays);
+    }
+
+    //check the direct light of a floor against CalcPointLight and that the paths don't depend on the number of threads
+    void pathTracerTest(){
+        bool upload = Mesh::uploadToGpu;
+        Mesh::uploadToGpu = false;
+        graphicslib::LightingInformation lighting;
+        graphicslib::PointLight light;
+        light.position = glm::vec3(0.f, 2.f, 0.f);
+        light.constant = 1.f;
+        light.linear = 0.09f;
+        light.quadratic = 0.032f;
+        light.ambient = glm::vec3(0.05f);
+        light.diffuse = glm::vec3(1.f, 0.9f, 0.8f);
+        light.specular = glm::vec3(0.f);
+        light.radius = 100.f;
+        lighting.pointLights.push_back(light);
+        lighting.numberOfPointLights = 1;
+
+        //a floor seen from above, the pixel in the middle sees the point under the light. A plane doesn't light
+        //itself, so there is only the direct light
+        Mesh floor = softwareMesh({glm::vec3(-5.f, 0.f, 5.f), glm::vec3(5.f, 0.f, 5.f), glm::vec3(5.f, 0.f, -5.f),
+                                   glm::vec3(-5.f, 0.f, -5.f)}, {0, 1, 2, 0, 2, 3}, glm::vec3(0.f, 1.f, 0.f));
+        glm::vec3 eye(0.f, 3.f, 0.f);
+        glm::mat4 viewProjection = glm::perspective(glm::radians(30.f), 1.f, 0.1f, 100.f) *
+                                   glm::lookAt(eye, glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f));
+        PathTracer tracer(33, 33);
+        tracer.setScene({&floor}, {glm::mat4(1.f)}, {""}, lighting, viewProjection, eye);
+        tracer.addSamples(16);
+        float attenuation = 1.f / (light.constant + light.linear * 2.f + light.quadratic * 4.f);
+        glm::vec3 expected = POINT_LIGHT_KD * light.diffuse * attenuation * glm::vec3(1.f, 0.5f, 0.31f);
+        float error = glm::length(tracer.pixel(16, 16) - expected);
+        report("path traced direct light", error < 1e-3f, error);
+
+        //spheres over the floor, lit directly and by each other
+        std::vector<Vertex> sphereVertices;
+        std::vector<unsigned int> sphereIndices;
+        uvSphere(16, 32, sphereVertices, sphereIndices);
+        Mesh sphere(sphereVertices, sphereIndices, std::vector<Texture>());
+        std::vector<const Mesh*> meshes = {&floor};
+        std::vector<glm::mat4> modelMatrices = {glm::mat4(1.f)};
+        for(int s = 0; s < 3; s++){
+            meshes.push_back(&sphere);
+            modelMatrices.push_back(glm::translate(glm::mat4(1.f), glm::vec3(0.8f * (s - 1), 0.5f, 0.3f * s)) *
+                                    glm::scale(glm::mat4(1.f), glm::vec3(0.4f)));
+        }
+        std::vector<std::string> directories(meshes.size());
+        ThreadPool single(1), several(3);
+        PathTracer one(40, 40, single), three(40, 40, several);
+        int different = 0;
+        for(PathTracer *frame : {&one, &three}){
+            frame->setScene(meshes, modelMatrices, directories, lighting, viewProjection, eye);
+            frame->addSamples(4);
+        }
+        for(int y = 0; y < 40; y++){
+            for(int x = 0; x < 40; x++){
+                different += one.pixel(x, y) != three.pixel(x, y);
+            }
+        }
+        report("the path traced image doesn't depend on the number of threads", different == 0, different);
+        Mesh::uploadToGpu = upload;
+    }
+
+    //the 3 first components of a half float vector of BakedLighting
+    static glm::vec3 unpackHalf3(const unsigned short packed[4]){
+        return glm::vec3(glm::unpackHalf1x16(packed[0]), glm::unpackHalf1x16(packed[1]), glm::unpackHalf1x16(packed[2]));
+    }
+
+    //check the baked light of a floor against CalcPointLight, its shadow and ambient occlusion under a square,
+    //that it doesn't depend on the number of threads and that it's loaded from the cache
+    void lightBakingTest(){
+        bool upload = Mesh::uploadToGpu;
+        Mesh::uploadToGpu = false;
+        bool shadows = LightBaker::shadows;
+        int occlusionSamples = LightBaker::ambientOcclusionSamples;
+        std::string cacheDirectory = LightBaker::cacheDirectory;
+        LightBaker::shadows = true;
+        LightBaker::ambientOcclusionSamples = 0;
+        LightBaker::cacheDirectory = "";
+
+        graphicslib::LightingInformation lighting;
+        graphicslib::PointLight light;
+        light.position = glm::vec3(0.f, 2.f, 0.f);
+        light.constant = 1.f;
+        light.linear = 0.09f;
+        light.quadratic = 0.032f;
+        light.ambient = glm::vec3(0.2f);
+        light.diffuse = glm::vec3(1.f, 0.9f, 0.8f);
+        light.specular = glm::vec3(0.5f);
+        light.radius = LightClusters::pointLightRadius(light);
+        lighting.pointLights.push_back(light);
+        lighting.numberOfPointLights = 1;
+
+        //a floor with a vertex under the light, and a square between them
+        std::vector<glm::vec3> floorPositions = {glm::vec3(-5.f, 0.f, 5.f), glm::vec3(5.f, 0.f, 5.f), glm::vec3(5.f, 0.f, -5.f),
+                                                 glm::vec3(-5.f, 0.f, -5.f), glm::vec3(0.f)};
+        Mesh floor = softwareMesh(floorPositions, {0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4}, glm::vec3(0.f, 1.f, 0.f));
+        Mesh square = softwareMesh({glm::vec3(-0.5f, 1.f, 0.5f), glm::vec3(0.5f, 1.f, 0.5f), glm::vec3(0.5f, 1.f, -0.5f),
+                                    glm::vec3(-0.5f, 1.f, -0.5f)}, {0, 1, 2, 0, 2, 3}, glm::vec3(0.f, 1.f, 0.f));
+        //the floor is moved up, the baked lighting is in the world
+        glm::mat4 lift = glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.25f, 0.f));
+
+        LightBaker baker;
+        std::vector<std::vector<BakedLighting>> baked;
+        baker.bake({&floor}, {lift}, lighting, baked);
+        float error = 0.f;
+        for(size_t v = 0; v < floorPositions.size(); v++){
+            glm::vec3 position = floorPositions[v] + glm::vec3(0.f, 0.25f, 0.f);
+            float distance = glm::length(light.position - position);
+            glm::vec3 lightDirection = (light.position - position) / distance;
+            float attenuation = 1.f / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
+            glm::vec3 diffuse = (POINT_LIGHT_KA * light.ambient + POINT_LIGHT_KD * light.diffuse * lightDirection.y) * attenuation;
+            glm::vec3 specular = POINT_LIGHT_KS * light.specular * attenuation;
+            const BakedLighting &vertex = baked[0][v];
+            //half floats keep 11 bits
+            error = std::max(error, glm::length(unpackHalf3(vertex.Diffuse) - diffuse) / glm::length(diffuse));
+            error = std::max(error, glm::length(unpackHalf3(vertex.Specular) - specular) / glm::length(specular));
+            error = std::max(error, glm::length(unpackHalf3(vertex.LightDirection) - lightDirection));
+        }
+        report("baked light matches CalcPointLight", error < 2e-3f, error);
+
+        //the square shadows the vertex under the light, which keeps the ambient term only
+        baker.bake({&floor, &square}, {glm::mat4(1.f), glm::mat4(1.f)}, lighting, baked);
+        glm::vec3 ambient = POINT_LIGHT_KA * light.ambient / (light.constant + light.linear * 2.f + light.quadratic * 4.f);
+        glm::vec3 shadowed = unpackHalf3(baked[0][4].Diffuse);
+        error = glm::length(shadowed - ambient) + glm::length(unpackHalf3(baked[0][4].Specular));
+        report("the vertex in the shadow only has the ambient light", error < 1e-4f, error);
+        report("the baked rays include the shadow rays", baker.raysTraced() == 9, baker.raysTraced());
+
+        //the square covers a part of the sky of the vertex under it, the corners are far from it
+        LightBaker::ambientOcclusionSamples = 256;
+        ThreadPool single(1), several(3);
+        LightBaker one(single), three(several);
+        std::vector<std::vector<BakedLighting>> threeBaked;
+        one.bake({&floor, &square}, {glm::mat4(1.f), glm::mat4(1.f)}, lighting, baked);
+        three.bake({&floor, &square}, {glm::mat4(1.f), glm::mat4(1.f)}, lighting, threeBaked);
+        float occlusion = glm::unpackHalf1x16(baked[0][4].Diffuse[3]);
+        float cornerOcclusion = glm::unpackHalf1x16(baked[0][0].Diffuse[3]);
+        report("ambient occlusion under the square", occlusion > 0.5f && occlusion < 0.95f, occlusion);
+        report("no ambient occlusion at the corners", cornerOcclusion == 1.f, cornerOcclusion);
+        int different = 0;
+        for(size_t m = 0; m < baked.size(); m++){
+            different += std::memcmp(baked[m].data(), threeBaked[m].data(), baked[m].size() * sizeof(BakedLighting)) != 0;
+        }
+        report("the baked light doesn't depend on the number of threads", different == 0, different);
+
+        //the second bake of the same scene comes from the file of the first, moving the light bakes it again
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "lightbakingtest";
+        std::filesystem::remove_all(directory);
+        LightBaker::cacheDirectory = directory.string();
+        std::vector<std::vector<BakedLighting>> cached;
+        one.bake({&floor, &square}, {glm::mat4(1.f), glm::mat4(1.f)}, lighting, baked);
+        bool bakedFirst = !one.loadedFromCache();
+        one.bake({&floor, &square}, {glm::mat4(1.f), glm::mat4(1.f)}, lighting, cached);
+        different = 0;
+        for(size_t m = 0; m < baked.size(); m++){
+            different += cached[m].size() != baked[m].size() ||
+                         std::memcmp(baked[m].data(), cached[m].data(), baked[m].size() * sizeof(BakedLighting)) != 0;
+        }
+        report("baked light loaded from the cache", bakedFirst && one.loadedFromCache() && different == 0, different);
+        lighting.pointLights[0].position.x += 0.1f;
+        one.bake({&floor, &square}, {glm::mat4(1.f), glm::mat4(1.f)}, lighting, cached);
+        report("a moved light is baked again", !one.loadedFromCache(), one.raysTraced());
+        std::filesystem::remove_all(directory);
+
+        LightBaker::shadows = shadows;
+        LightBaker::ambientOcclusionSamples = occlusionSamples;
+        LightBaker::cacheDirectory = cacheDirectory;
+        Mesh::uploadToGpu = upload;
+    }
+
+    //check the ambient occlusion of a floor at the foot of a wall and far from it, that it doesn't depend on the
+    //number of threads and that no rays are traced without samples
+    void ambientOcclusionTest(){
+        bool upload = Mesh::uploadToGpu;
+        Mesh::uploadToGpu = false;
+
+        //the wall hides half of the sky of the vertex at its foot, the corner of the floor is farther than the rays
+        Mesh floor = softwareMesh({glm::vec3(-5.f, 0.f, 5.f), glm::vec3(5.f, 0.f, 5.f), glm::vec3(5.f, 0.f, -5.f),
+                                   glm::vec3(-5.f, 0.f, -5.f), glm::vec3(0.f)}, {0, 1, 4, 1, 2, 4, 2, 3, 4, 3, 0, 4},
+                                  glm::vec3(0.f, 1.f, 0.f));
+        Mesh wall = softwareMesh({glm::vec3(0.01f, 0.f, 5.f), glm::vec3(0.01f, 0.f, -5.f), glm::vec3(0.01f, 10.f, -5.f),
+                                  glm::vec3(0.01f, 10.f, 5.f)}, {0, 1, 2, 0, 2, 3}, glm::vec3(-1.f, 0.f, 0.f));
+        std::vector<const Mesh*> meshes = {&floor, &wall};
+
+        ThreadPool single(1), several(3);
+        std::vector<std::vector<float>> occlusion, threeOcclusion;
+        size_t rays = ambientocclusion::bake(meshes, 1024, occlusion, single);
+        ambientocclusion::bake(meshes, 1024, threeOcclusion, several);
+        report("half of the sky is hidden at the foot of the wall", std::abs(occlusion[0][4] - 0.5f) < 0.06f, occlusion[0][4]);
+        report("nothing is hidden far from the wall", occlusion[0][0] == 1.f, occlusion[0][0]);
+        report("one ray per sample and vertex", rays == 9 * 1024, rays);
+        report("the ambient occlusion doesn't depend on the number of threads",
+               occlusion == threeOcclusion, occlusion == threeOcclusion);
+
+        rays = ambientocclusion::bake(meshes, 0, occlusion, single);
+        bool unoccluded = true;
+        for(const std::vector<float> &mesh : occlusion){
+            for(float visibility : mesh){
+                unoccluded = unoccluded && visibility == 1.f;
+            }
+        }
+        report("no ambient occlusion without samples", unoccluded && rays == 0, rays);
+
+        Mesh::uploadToGpu = upload;
+    }
+
+    //a cube map with a color in the directions above the horizon and another below
+    static CubeMap environmentCube(int size, const glm::vec3 &above, const glm::vec3 &below){
+        CubeMap cube;
+        cube.resize(size);
+        for(int face = 0; face < 6; face++){
+            for(int y = 0; y < size; y++){
+                for(int x = 0; x < size; x++){
+                    cube.texel(face, x, y) = glm::vec4(cube.direction(face, x + 0.5f, y + 0.5f).y > 0.f ? above : below, 1.f);
+                }
+            }
+        }
+        return cube;
+    }
+
+    //biggest relative difference between the texels of two cube maps of the same size
+    static float cubeError(const CubeMap &a, const CubeMap &b){
+        float error = 0.f;
+        for(size_t t = 0; t < a.texels.size(); t++){
+            error = std::max(error, glm::length(glm::vec3(a.texels[t] - b.texels[t])) /
+                                    std::max(glm::length(glm::vec3(b.texels[t])), 1e-6f));
+        }
+        return error;
+    }
+
+    //check the irradiance and the prefiltered levels of a constant and of a half lit environment, the energy of
+    //the BRDF table, that nothing depends on the number of threads and the cache of the bundled HDR image
+    void environmentLightingTest(){
+        ThreadPool single(1), several(3);
+        EnvironmentLighting one(single), three(several);
+
+        //a constant environment is its own irradiance and its own reflection at any roughness
+        glm::vec3 color(0.5f, 1.f, 2.f);
+        CubeMap constant = environmentCube(64, color, color);
+        one.compute(constant);
+        float error = 0.f;
+        for(const glm::vec3 &normal : {glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, -1.f, 0.f), glm::normalize(glm::vec3(1.f, 2.f, 3.f))}){
+            error = std::max(error, glm::length(one.irradiance(normal) - color) / glm::length(color));
+        }
+        report("irradiance of a constant environment", error < 1e-3f, error);
+        error = 0.f;
+        for(const CubeMap &level : one.prefilteredLevels()){
+            error = std::max(error, cubeError(level, environmentCube(level.size, color, color)));
+        }
+        report("prefiltered levels of a constant environment", error < 1e-3f, error);
+
+        //lit above the horizon: the cosine weighted average is 1 facing up, 1/2 facing the horizon and 0 facing down
+        CubeMap halfLit = environmentCube(64, glm::vec3(1.f), glm::vec3(0.f));
+        one.compute(halfLit);
+        three.compute(halfLit);
+        glm::vec3 up = one.irradiance(glm::vec3(0.f, 1.f, 0.f));
+        glm::vec3 side = one.irradiance(glm::vec3(1.f, 0.f, 0.f));
+        glm::vec3 down = one.irradiance(glm::vec3(0.f, -1.f, 0.f));
+        error = std::max(std::max(std::abs(up.g - 1.f), std::abs(side.g - 0.5f)), down.g);
+        report("irradiance of a half lit environment", error < 0.02f, error);
+        //the rougher levels blur the horizon more
+        const std::vector<CubeMap> &levels = one.prefilteredLevels();
+        glm::vec3 above = glm::normalize(glm::vec3(1.f, 0.2f, 0.f));
+        float sharp = levels[0].sample(above).g, rough = levels.back().sample(above).g;
+        report("the rougher levels blur the horizon", sharp > 0.99f && rough < 0.9f && rough > 0.5f, rough);
+
+        int different = std::memcmp(one.irradianceCoefficients(), three.irradianceCoefficients(), 9 * sizeof(glm::vec3)) != 0;
+        for(size_t l = 0; l < levels.size(); l++){
+            different += levels[l].texels != three.prefilteredLevels()[l].texels;
+        }
+        different += one.brdfTable() != three.brdfTable();
+        report("the environment lighting doesn't depend on the number of threads", different == 0, different);
+
+        //the scale and the bias of F0 never reflect more light than arrives, and a smooth surface facing the view
+        //reflects all of it
+        float most = 0.f;
+        for(const glm::vec2 &texel : one.brdfTable()){
+            most = std::max(most, texel.x + texel.y);
+        }
+        glm::vec2 smooth = one.brdf(1.f, 0.f);
+        report("the BRDF table keeps the energy", most <= 1.001f && smooth.x + smooth.y > 0.95f, most);
+
+        //the second load of the image comes from the file of the first
+        std::string cacheDirectory = EnvironmentLighting::cacheDirectory;
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "environmentlightingtest";
+        std::filesystem::remove_all(directory);
+        EnvironmentLighting::cacheDirectory = directory.string();
+        EnvironmentLighting computed, cached;
+        bool loaded = computed.load(ENVIRONMENT_MAP_FILE) && cached.load(ENVIRONMENT_MAP_FILE);
+        error = 0.f;
+        if(loaded){
+            error = cubeError(cached.irradianceMap(), computed.irradianceMap());
+            for(size_t l = 0; l < computed.prefilteredLevels().size(); l++){
+                error = std::max(error, cubeError(cached.prefilteredLevels()[l], computed.prefilteredLevels()[l]));
+            }
+        }
+        //the file has half floats
+        report("environment lighting loaded from the cache",
+               loaded && !computed.loadedFromCache() && cached.loadedFromCache() && error < 1e-3f, error);
+        std::filesystem::remove_all(directory);
+        EnvironmentLighting::cacheDirectory = cacheDirectory;
+    }
+
+    //an image whose texels are given by a function of their coordinates
+    template<typename Texel>
+    static texturecompressor::Image testImage(int width, int height, Texel texel){
+        texturecompressor::Image image;
+        image.width = width;
+        image.height = height;
+        image.texels.resize(4 * (size_t) width * height);
+        for(int y = 0; y < height; y++){
+            for(int x = 0; x < width; x++){
+                glm::ivec4 color = texel(x, y);
+                for(int c = 0; c < 4; c++){
+                    image.texels[4 * ((size_t) y * width + x) + c] = (unsigned char) color[c];
+                }
+            }
+        }
+        return image;
+    }
+
+    //peak signal to noise ratio in dB of the first channels of an image after its encoding in a format
+    static float encodedPsnr(const texturecompressor::Image &image, texturecompressor::BlockFormat format, int channels,
+                             ThreadPool &pool){
+        std::vector<unsigned char> blocks;
+        texturecompressor::encode(image, format, blocks, pool);
+        texturecompressor::Image decoded = texturecompressor::decode(blocks.data(), format, image.width, image.height);
+        double error = 0.0;
+        for(size_t i = 0; i < image.texels.size(); i++){
+            if((int) (i % 4) < channels){
+                double difference = (double) image.texels[i] - decoded.texels[i];
+                error += difference * difference;
+            }
+        }
+        error /= image.texels.size() / 4 * channels;
+        return error > 0.0 ? (float) (10.0 * std::log10(255.0 * 255.0 / error)) : 99.f;
+    }
+
+    //check the error of each block format on smooth images, that the mipmaps of the colors are averaged in linear
+    //space and the normals stay unit length, the sizes of the levels, the KTX file and that the blocks and the
+    //mipmaps don't depend on the number of threads
+    void textureCompressionTest(){
+        using namespace texturecompressor;
+        ThreadPool single(1), several(3);
+
+        Image gradient = testImage(64, 64, [](int x, int y){
+            return glm::ivec4(x * 4, y * 4, 255 - (x + y) * 2, 255 - x * 3);
+        });
+        float psnr = encodedPsnr(gradient, BC1_FORMAT, 3, single);
+        report("BC1 of a gradient (PSNR in dB)", psnr > 35.f, psnr);
+        //two colors of 565 need no more than the endpoints
+        Image twoColors = testImage(4, 4, [](int x, int y){
+            return (x + y) % 2 ? glm::ivec4(255, 0, 0, 255) : glm::ivec4(0, 0, 255, 255);
+        });
+        psnr = encodedPsnr(twoColors, BC1_FORMAT, 3, single);
+        report("BC1 of a block of two colors (PSNR in dB)", psnr == 99.f, psnr);
+        psnr = std::min(encodedPsnr(gradient, BC4_FORMAT, 1, single), encodedPsnr(gradient, BC5_FORMAT, 2, single));
+        report("BC4 and BC5 of a gradient (PSNR in dB)", psnr > 39.f, psnr);
+        psnr = encodedPsnr(gradient, BC3_FORMAT, 4, single);
+        report("BC3 of a gradient with alpha (PSNR in dB)", psnr > 35.f, psnr);
+        psnr = encodedPsnr(gradient, BC7_FORMAT, 4, single);
+        report("BC7 of a gradient with alpha (PSNR in dB)", psnr > 39.f, psnr);
+
+        //the average of black and white is 0.5 in linear space, 188 in sRGB, and 128 for the data
+        Image checkerboard = testImage(8, 8, [](int x, int y){
+            return (x + y) % 2 ? glm::ivec4(255) : glm::ivec4(0, 0, 0, 255);
+        });
+        std::vector<Image> colorLevels = generateMipmaps(checkerboard, COLOR_TEXTURE, single);
+        std::vector<Image> dataLevels = generateMipmaps(checkerboard, DATA_TEXTURE, single);
+        float error = std::max(std::abs(colorLevels[1].texels[0] - 188.f), std::abs(dataLevels[1].texels[0] - 128.f));
+        report("mipmaps averaged in linear space", error <= 1.f, error);
+
+        //bumps of normals in every direction
+        Image normals = testImage(32, 32, [](int x, int y){
+            glm::vec3 normal = glm::normalize(glm::vec3(std::sin(x * 0.7f), std::cos(y * 0.9f), 1.f));
+            return glm::ivec4(glm::round((normal * 0.5f + 0.5f) * 255.f), 255);
+        });
+        error = 0.f;
+        std::vector<Image> normalLevels = generateMipmaps(normals, NORMAL_TEXTURE, single);
+        for(size_t l = 1; l < normalLevels.size(); l++){
+            for(size_t t = 0; t < normalLevels[l].texels.size(); t += 4){
+                glm::vec3 normal = glm::vec3(normalLevels[l].texels[t], normalLevels[l].texels[t + 1],
+                                             normalLevels[l].texels[t + 2]) / 255.f * 2.f - 1.f;
+                error = std::max(error, std::abs(glm::length(normal) - 1.f));
+            }
+        }
+        report("mipmaps of the normals are unit length", error < 0.02f, error);
+
+        std::vector<Image> oddLevels = generateMipmaps(testImage(5, 3, [](int, int){ return glm::ivec4(255); }), DATA_TEXTURE, single);
+        bool sizes = oddLevels.size() == 3 && oddLevels[1].width == 2 && oddLevels[1].height == 1 &&
+                     oddLevels[2].width == 1 && oddLevels[2].height == 1;
+        report("mipmaps down to 1x1", sizes && levelSize(BC1_FORMAT, 5, 3) == 16 && levelSize(BC7_FORMAT, 1, 1) == 16,
+               oddLevels.size());
+
+        //the file has every level as it was written
+        CompressedTexture written, read;
+        compress(gradient, COLOR_TEXTURE, BC7_FORMAT, written, single);
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "texturecompressiontest.ktx";
+        bool same = writeContainer(path.string(), written) && readContainer(path.string(), read) &&
+                    read.format == written.format && read.levels.size() == written.levels.size() && read.bytes() == written.bytes();
+        for(size_t l = 0; same && l < read.levels.size(); l++){
+            same = read.levels[l].width == written.levels[l].width && read.levels[l].height == written.levels[l].height &&
+                   std::memcmp(&read.data[read.levels[l].offset], &written.data[written.levels[l].offset], read.levels[l].size) == 0;
+        }
+        std::filesystem::remove(path);
+        report("KTX file read back", same && written.levels.size() == 7, written.levels.size());
+
+        int different = 0;
+        for(BlockFormat format : {BC1_FORMAT, BC3_FORMAT, BC4_FORMAT, BC5_FORMAT, BC7_FORMAT}){
+            std::vector<unsigned char> one, three;
+            encode(gradient, format, one, single);
+            encode(gradient, format, three, several);
+            different += one != three;
+        }
+        std::vector<Image> threeLevels = generateMipmaps(normals, NORMAL_TEXTURE, several);
+        for(size_t l = 0; l < normalLevels.size(); l++){
+            different += normalLevels[l].texels != threeLevels[l].texels;
+        }
+        report("the texture compression doesn't depend on the number of threads", different == 0, different);
+
+        //the container of an image follows its kind and its writes, and there's none for an image that isn't there
+        std::filesystem::path image = std::filesystem::temp_directory_path() / "texturecompressiontest.png";
+        std::ofstream(image, std::ios::binary) << "not really a png";
+        std::string first = containerPath(image.string(), COLOR_TEXTURE);
+        bool paths = !first.empty() && first == containerPath(image.string(), COLOR_TEXTURE) &&
+                     first != containerPath(image.string(), NORMAL_TEXTURE);
+        std::ofstream(image, std::ios::binary | std::ios::app) << " and longer";
+        paths = paths && first != containerPath(image.string(), COLOR_TEXTURE);
+        std::filesystem::remove(image);
+        paths = paths && containerPath(image.string(), COLOR_TEXTURE).empty();
+        report("containers of the images", paths, 0);
+    }
+
+    //check the level the streamer requests for the size of a texture on the screen, the size of an object behind
+    //the camera, and that the read of the coarse levels of a KTX file has the same blocks as the read of the whole
+    //file
+    void textureStreamingTest(){
+        using namespace texturecompressor;
+        //a texel per pixel is the level 0, each halving of the pixels is a level more, up to the last one
+        int levels[] = {TextureStreamer::requiredLevel(1024, 1024, 1024.f, 11), TextureStreamer::requiredLevel(1024, 512, 512.f, 11),
+                        TextureStreamer::requiredLevel(1024, 1024, 100.f, 11), TextureStreamer::requiredLevel(1024, 1024, 0.01f, 11),
+                        TextureStreamer::requiredLevel(256, 256, std::numeric_limits<float>::infinity(), 9),
+                        TextureStreamer::requiredLevel(256, 256, 0.f, 9)};
+        int expected[] = {0, 1, 3, 10, 0, 8};
+        int wrong = 0;
+        for(int i = 0; i < 6; i++){
+            wrong += levels[i] != expected[i];
+        }
+        report("levels required for the size on the screen", wrong == 0, wrong);
+
+        //an object behind the camera covers no pixels, its textures are requested at their last level
+        Camera camera(glm::vec3(0.f, 0.f, 3.f));
+        ml::matrix<float> view = camera.GetViewMatrix();
+        ml::matrix<float> projection = graphicslib::getProjectionMatrix();
+        float inFront = graphicslib::projectedSphereRadius(glm::vec3(0.f), 1.f, view, projection, 600);
+        float behind = graphicslib::projectedSphereRadius(glm::vec3(0.f, 0.f, 10.f), 1.f, view, projection, 600);
+        float inside = graphicslib::projectedSphereRadius(glm::vec3(0.f, 0.f, 3.5f), 1.f, view, projection, 600);
+        bool projected = inFront > 0.f && inFront < 600.f && behind == 0.f && std::isinf(inside) &&
+                         TextureStreamer::requiredLevel(1024, 1024, behind, 11) == 10;
+        report("projected radius in front of, behind and around the camera", projected, behind);
+
+        ThreadPool single(1);
+        Image gradient = testImage(256, 128, [](int x, int y){
+            return glm::ivec4(x, y * 2, 255 - x, 255);
+        });
+        CompressedTexture texture, all, coarse;
+        compress(gradient, COLOR_TEXTURE, BC1_FORMAT, texture, single);
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "texturestreamingtest.ktx";
+        bool read = writeContainer(path.string(), texture) && readContainer(path.string(), all) &&
+                    readContainer(path.string(), coarse, TEXTURE_STREAM_RESIDENT_SIZE);
+        std::filesystem::remove(path);
+        //64x32 is the level 2
+        bool same = read && all.firstLevel == 0 && coarse.firstLevel == 2 && coarse.levels.size() == all.levels.size() &&
+                    coarse.data.size() < all.data.size();
+        for(size_t l = 2; same && l < all.levels.size(); l++){
+            same = coarse.levels[l].size == all.levels[l].size &&
+                   std::memcmp(&coarse.data[coarse.levels[l].offset], &all.data[all.levels[l].offset], all.levels[l].size) == 0;
+        }
+        report("coarse levels of a KTX file", same, read ? coarse.data.size() : 0);
+    }
+
+    void textureArrayTest(){
+        //two sizes of diffuse textures in BC1, a specular one of the same size, an RGB image and one that can't be read
+        std::vector<TextureLayout> layouts = {{"texture_diffuse", 512, 512, texturecompressor::BC1_FORMAT, 0},
+                                              {"texture_diffuse", 256, 256, texturecompressor::BC1_FORMAT, 0},
+                                              {"texture_specular", 512, 512, texturecompressor::BC1_FORMAT, 0},
+                                              {"texture_diffuse", 512, 512, texturecompressor::BC1_FORMAT, 0},
+                                              {"texture_diffuse", 512, 512, -1, 3},
+                                              {"texture_diffuse", 512, 512, -1, 0},
+                                              {"texture_diffuse", 512, 512, texturecompressor::BC1_FORMAT, 0}};
+        std::vector<std::vector<unsigned int>> groups = Model::groupTextureArrays(layouts, 16);
+        std::vector<std::vector<unsigned int>> expected = {{0, 3, 6}, {1}, {2}, {4}};
+        report("textures grouped by type, size and format", groups == expected, groups.size());
+
+        //the fourth 512x512 diffuse texture starts a second array
+        groups = Model::groupTextureArrays(layouts, 2);
+        expected = {{0, 3}, {1}, {2}, {4}, {6}};
+        report("texture arrays split at the limit of layers", groups == expected, groups.size());
+    }
+
+    void sceneFileTest(){
+        using namespace scenefile;
+        //a comment, CRLF and tab separators, a sign +, an object without all its position and no end in the last line
+        std::string text = "//object <path> <x y z>\n"
+                           "object a.obj 0 1 2\r\n"
+                           "object b.obj\t-1.5 +2 1e1\n"
+                           "object a.obj 3 4\n"
+                           "\n"
+                           "light 1 2 3  1 1 1  0.2 0.0 0.0\n"
+                           "light 0 0 0  1 1 1  1 0 0\n"
+                           "camera 0 0 6  0 0 0  0 1 0\n"
+                           "object a.obj 5 6 7";
+        Scene scene;
+        size_t skipped = parse(text.data(), text.data() + text.size(), scene);
+        bool read = skipped == 1 && scene.paths.size() == 2 && scene.objects.size() == 3 && scene.lights.size() == 2 &&
+                    scene.hasCamera && scene.objects[0].path == scene.objects[2].path &&
+                    scene.paths[scene.objects[1].path] == "b.obj" && scene.objects[1].position == glm::vec3(-1.5f, 2.f, 10.f) &&
+                    scene.objects[2].position == glm::vec3(5.f, 6.f, 7.f) && scene.lights[0].linear == 0.2f &&
+                    scene.cameraPosition == glm::vec3(0.f, 0.f, 6.f);
+        report("entries of a scene file", read, skipped);
+
+        //the object of a.obj at 5 6 7 moves, b.obj is removed, c.obj is added, a light changes and the other goes
+        std::string nextText = "object a.obj 0 1 2\nobject a.obj 9 9 9\nobject c.obj 0 0 0\n"
+                               "light 1 2 3  1 0 0  0.2 0.0 0.0\ncamera 0 0 6  0 0 0  0 1 0\n";
+        Scene next;
+        parse(nextText.data(), nextText.data() + nextText.size(), next);
+        SceneDiff changes = diff(scene, next);
+        bool matched = changes.previousObjects == std::vector<int>{0, 2, -1} && changes.movedObjects == std::vector<unsigned int>{1} &&
+                       changes.addedObjects == std::vector<unsigned int>{2} && changes.removedObjects == std::vector<unsigned int>{1} &&
+                       changes.changedLights == std::vector<unsigned int>{0} && changes.removedLights == 1 &&
+                       !changes.cameraChanged && diff(next, next).empty();
+        report("changes between two scene files", matched, changes.addedObjects.size() + changes.removedObjects.size());
+
+        //the file is read from its mapping like the text, and its writes are noticed
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "scenefiletest";
+        std::filesystem::create_directories(directory);
+        std::string path = (directory / "scene.txt").string();
+        std::ofstream(path) << text;
+        Scene mapped;
+        bool same = scenefile::read(path, mapped) && mapped.paths == scene.paths && mapped.objects.size() == scene.objects.size() &&
+                    diff(scene, mapped).empty();
+        report("scene file read from its mapping", same, mapped.objects.size());
+
+        SceneWatcher watcher(path);
+        bool before = watcher.changed();
+        std::ofstream(path) << nextText;
+        bool written = watcher.changed();
+        bool after = watcher.changed();
+        std::ofstream((directory / "other.txt").string()) << nextText;
+        bool other = watcher.changed();
+        std::filesystem::remove_all(directory);
+        report("writes of the scene file noticed", !before && written && !after && !other, 0);
+    }
+
+    void sceneSnapshotTest(){
+        bool upload = Mesh::uploadToGpu;
+        int samples = Model::ambientOcclusionSamples;
+        std::string snapshotFile = SceneSnapshot::file;
+        bool writeAfterLoad = SceneSnapshot::writeAfterLoad, enabled = SceneSnapshot::enabled;
+        Mesh::uploadToGpu = false;
+        Model::ambientOcclusionSamples = 0;
+        SceneSnapshot::enabled = true;
+
+        //a scene of two small models, one of them used twice
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "scenesnapshottest";
+        std::filesystem::create_directories(directory);
+        std::string triangle = (directory / "triangle.obj").string();
+        std::string quad = (directory / "quad.obj").string();
+        std::ofstream(triangle) << "v 0 0 0\nv 2 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1\n";
+        std::ofstream(quad) << "v 0 0 0\nv 1 0 0\nv 1 4 0\nv 0 4 0\nvn 0 0 1\nf 1//1 2//1 3//1\nf 1//1 3//1 4//1\n";
+        std::string path = (directory / "scene.txt").string();
+        std::ofstream(path) << "object " << triangle << " 0 0 0\nobject " << quad << " 3 0 0\nobject " << triangle
+                            << " -3 1 0\nlight 1 2 3  1 1 1  0.2 0.0 0.0\nlight 0 5 0  1 0.5 0  1 0 0\n"
+                            << "camera 0 0 6  0 0 0  0 1 0\n";
+        SceneSnapshot::file = (directory / "scene.snapshot").string();
+
+        //read from the text, which writes the snapshot, then from the snapshot
+        graphicslib::LightingInformation textLighting, snapshotLighting;
+        SceneObjects textObjects, snapshotObjects;
+        Camera textCamera, snapshotCamera;
+        scenefile::Scene textScene, snapshotScene;
+        SceneSnapshot::writeAfterLoad = true;
+        graphicslib::readScene(path.c_str(), textLighting, textObjects, textCamera, &textScene);
+        SceneSnapshot::writeAfterLoad = false;
+        SceneSnapshot snapshot;
+        bool opened = snapshot.open(SceneSnapshot::file, path) && snapshot.numberOfModels() == 2 &&
+                      snapshot.numberOfObjects() == 3 && snapshot.numberOfLights() == 2 && snapshot.modelPath(1) == quad;
+        graphicslib::readScene(path.c_str(), snapshotLighting, snapshotObjects, snapshotCamera, &snapshotScene);
+
+        bool same = opened && snapshotObjects.size() == textObjects.size() &&
+                    snapshotLighting.pointLights.size() == textLighting.pointLights.size() &&
+                    snapshotCamera.Position == textCamera.Position && snapshotCamera.Front == textCamera.Front &&
+                    snapshotScene.paths == textScene.paths && scenefile::diff(textScene, snapshotScene).empty();
+        for(unsigned int o = 0; same && o < textObjects.size(); o++){
+            SceneObjects::Transform text = textObjects.transform(o), mapped = snapshotObjects.transform(o);
+            same = std::memcmp(&text, &mapped, sizeof(text)) == 0 && textObjects.worldMatrix(o) == snapshotObjects.worldMatrix(o);
+        }
+        for(size_t l = 0; same && l < textLighting.pointLights.size(); l++){
+            same = std::memcmp(&textLighting.pointLights[l], &snapshotLighting.pointLights[l], sizeof(graphicslib::PointLight)) == 0;
+        }
+        report("scene read from its snapshot", same, snapshotObjects.size());
+        //the objects of the same file share its model, in both reads
+        bool shared = textObjects.size() == 3 && snapshotObjects.size() == 3 &&
+                      textObjects.model(0).model == textObjects.model(2).model &&
+                      textObjects.model(0).model != textObjects.model(1).model &&
+                      snapshotObjects.model(0).model == snapshotObjects.model(2).model &&
+                      snapshotObjects.model(0).model != snapshotObjects.model(1).model;
+        report("objects of the same file share its model", shared, textObjects.size());
+        //and each one keeps the lighting baked at its place
+        std::string lightingCache = LightBaker::cacheDirectory;
+        LightBaker::cacheDirectory = "";
+        LightBaker baker;
+        baker.bake(textObjects, textLighting);
+        const graphicslib::ModelInformation &first = textObjects.model(0), &third = textObjects.model(2);
+        bool ownLighting = shared && first.bakedLightingId != third.bakedLightingId &&
+                           first.bakedLighting.size() == first.model->meshes.size() &&
+                           third.bakedLighting.size() == third.model->meshes.size() && !first.bakedLighting.empty() &&
+                           !first.bakedLighting[0].empty() && third.bakedLighting[0].size() == first.bakedLighting[0].size() &&
+                           std::memcmp(first.bakedLighting[0].data(), third.bakedLighting[0].data(), sizeof(BakedLighting)) != 0;
+        LightBaker::cacheDirectory = lightingCache;
+        report("objects sharing a model keep their own baked lighting", ownLighting, first.bakedLighting.size());
+
+        //a snapshot cut short, or of a scene file that changed since, isn't opened
+        std::uintmax_t size = std::filesystem::file_size(SceneSnapshot::file);
+        std::filesystem::copy_file(SceneSnapshot::file, SceneSnapshot::file + ".copy");
+        std::filesystem::resize_file(SceneSnapshot::file + ".copy", size - 1);
+        bool truncated = snapshot.open(SceneSnapshot::file + ".copy", path);
+        std::ofstream(path, std::ios::app) << "light 0 0 0  1 1 1  1 0 0\n";
+        bool changed = snapshot.open(SceneSnapshot::file, path);
+        report("outdated scene snapshot rejected", !truncated && !changed, truncated + changed);
+
+        graphicslib::deleteObjects(textObjects);
+        graphicslib::deleteObjects(snapshotObjects);
+        std::filesystem::remove_all(directory);
+        SceneSnapshot::file = snapshotFile;
+        SceneSnapshot::writeAfterLoad = writeAfterLoad;
+        SceneSnapshot::enabled = enabled;
+        Model::ambientOcclusionSamples = samples;
+        Mesh::uploadToGpu = upload;
+    }
+
+    void sceneObjectsTest(){
+        //random transforms, a number of objects that isn't a multiple of the batch
+        std::mt19937 generator(50);
+        std::uniform_real_distribution<float> distribution(-3.f, 3.f);
+        auto randomVector = [&](){
+            return glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+        };
+        SceneObjects objects;
+        graphicslib::ModelInformation modelInfo = {};
+        std::vector<SceneObjects::Transform> transforms(1001);
+        for(SceneObjects::Transform &transform : transforms){
+            transform.offset = randomVector();
+            transform.scale = randomVector();
+            transform.rotation = randomVector();
+            transform.position = randomVector();
+            objects.add(modelInfo, transform);
+        }
+        objects.updateTransforms();
+        float maxError = 0.f;
+        for(unsigned int o = 0; o < transforms.size(); o++){
+            ml::matrix<float> modelMatrix = graphicslib::getModelMatrix(transforms[o]);
+            glm::mat4 expected = graphicslib::toGlm(modelMatrix);
+            for(int column = 0; column < 4; column++){
+                for(int row = 0; row < 4; row++){
+                    maxError = std::max(maxError, std::abs(objects.worldMatrix(o)[column][row] - expected[column][row]));
+                }
+            }
+        }
+        report("world matrices of the scene objects", maxError < 1e-4f, maxError);
+
+        //the last object takes the index of a removed one, the handle of the removed one is never valid again
+        SceneObjects few;
+        SceneObjects::Transform transform = transforms[0];
+        ObjectHandle first = few.add(modelInfo, transform);
+        transform.position = glm::vec3(1.f, 2.f, 3.f);
+        ObjectHandle second = few.add(modelInfo, transform);
+        transform.position = glm::vec3(4.f, 5.f, 6.f);
+        ObjectHandle third = few.add(modelInfo, transform);
+        few.remove(second);
+        ObjectHandle fourth = few.add(modelInfo, transform);
+        bool handles = few.size() == 3 && !few.contains(second) && few.contains(third) && few.index(third) == 1 &&
+                       few.handle(1) == third && few.transform(1).position == glm::vec3(4.f, 5.f, 6.f) &&
+                       fourth.slot == second.slot && fourth != second && few.index(first) == 0 && few.index(fourth) == 2;
+        //a removed handle removes nothing, and none is valid after a clear
+        few.remove(second);
+        handles = handles && few.size() == 3;
+        few.clear();
+        handles = handles && few.empty() && !few.contains(first) && !few.contains(third) && !few.contains(fourth);
+        report("handles of the scene objects", handles, few.size());
+
+        //spheres in front, behind, beside, partly in and beyond the far plane of a camera looking down -Z
+        SceneObjects spheres;
+        SceneObjects::Transform placed = {glm::vec3(0.f), glm::vec3(1.f), glm::vec3(0.f), glm::vec3(0.f)};
+        glm::vec4 centers[] = {glm::vec4(0.f, 0.f, -5.f, 1.f), glm::vec4(0.f, 0.f, 5.f, 1.f), glm::vec4(20.f, 0.f, -5.f, 1.f),
+                               glm::vec4(5.5f, 0.f, -5.f, 1.f), glm::vec4(0.f, 0.f, -150.f, 1.f), glm::vec4(0.f, 0.f, -150.f, 60.f)};
+        for(const glm::vec4 &center : centers){
+            placed.position = glm::vec3(center);
+            unsigned int index = spheres.index(spheres.add(modelInfo, placed));
+            spheres.component(SceneObjects::MODEL_RADIUS)[index] = center.w;
+        }
+        spheres.updateTransforms();
+        glm::mat4 viewProjection = glm::perspective(glm::radians(90.f), 1.f, 0.1f, 100.f) *
+                                   glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+        std::vector<unsigned int> visible;
+        spheres.cull(viewProjection, visible);
+        report("scene objects in the view frustum", visible == std::vector<unsigned int>{0, 3, 5}, visible.size());
+    }
+
+    //the model files bundled in resources/objects
+    static std::vector<std::string> bundledModelPaths(){
+        std::vector<std::string> paths;
+        for(auto &entry : std::filesystem::recursive_directory_iterator("resources/objects")){
+            std::string extension = entry.path().extension().string();
+            if(extension == ".obj" || extension == ".fbx" || extension == ".gltf" || extension == ".dae"){
+                paths.push_back(entry.path().string());
+            }
+        }
+        std::sort(paths.begin(), paths.end());
+        return paths;
+    }
+
+    //ACMR and ATVR of every bundled model before and after the mesh optimization, and its levels of detail
+    void meshOptimizationBenchmark(){
+        std::vector<std::string> paths = bundledModelPaths();
+
+        std::cout << "FIFO cache of " << FIFO_CACHE_SIZE << " vertices" << std::endl;
+        std::cout << std::setw(44) << std::left << "model" << std::right << std::setw(10) << "triangles"
+                  << std::setw(10) << "vertices" << std::setw(14) << "ACMR before" << std::setw(13) << "ACMR after"
+                  << std::setw(14) << "ATVR before" << std::setw(13) << "ATVR after" << std::setw(10) << "ms" << std::endl;
+        for(const std::string &path : paths){
+            Assimp::Importer importer;
+            const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
+            if(!scene || !scene->mRootNode){
+                std::cerr << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+                continue;
+            }
+
+            meshoptimizer::VertexCacheStatistics before, after;
+            double milliseconds = 0.0, lodMilliseconds = 0.0;
+            std::vector<size_t> lodTriangles;
+            std::vector<float> lodErrors;
+            for(unsigned int m = 0; m < scene->mNumMeshes; m++){
+                std::vector<Vertex> vertices;
+                std::vector<unsigned int> indices;
+                ImportStatistics statistics;
+                Model::readMesh(scene->mMeshes[m], vertices, indices, statistics);
+                before += meshoptimizer::analyzeVertexCache(indices, vertices.size());
+                auto start = std::chrono::steady_clock::now();
+                meshoptimizer::optimizeVertexCache(indices, vertices.size());
+                milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                after += meshoptimizer::analyzeVertexCache(indices, vertices.size());
+
+                start = std::chrono::steady_clock::now();
+                std::vector<MeshLod> lods = meshoptimizer::generateLods(vertices, indices, true);
+                lodMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                //the meshes without a level keep drawing their coarsest one
+                for(size_t lod = 0; lod < LOD_COUNT; lod++){
+                    const MeshLod &level = lods[std::min(lod, lods.size() - 1)];
+                    if(lodTriangles.size() <= lod){
+                        lodTriangles.push_back(0);
+                        lodErrors.push_back(0.f);
+                    }
+                    lodTriangles[lod] += level.indexCount / 3;
+                    lodErrors[lod] = std::max(lodErrors[lod], level.error);
+                }
+            }
+            std::cout << std::setw(44) << std::left << path << std::right << std::setw(10) << before.triangles
+                      << std::setw(10) << before.vertices << std::setw(14) << before.acmr() << std::setw(13) << after.acmr()
+                      << std::setw(14) << before.atvr() << std::setw(13) << after.atvr() << std::setw(10) << milliseconds << std::endl;
+            std::cout << "    levels of detail (" << lodMilliseconds << " ms):";
+            for(size_t lod = 0; lod < lodTriangles.size(); lod++){
+                std::cout << " " << lodTriangles[lod] << " (error " << lodErrors[lod] << ")";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    //vertices and times of the import of every bundled model, with the welding and the generation of the tangents
+    //against the joining of the identical vertices and the tangents of assimp
+    void importBenchmark(){
+        std::cout << std::setw(44) << std::left << "model" << std::right << std::setw(10) << "read"
+                  << std::setw(10) << "welded" << std::setw(10) << "assimp" << std::setw(10) << "read ms"
+                  << std::setw(10) << "weld ms" << std::setw(12) << "normals ms" << std::setw(13) << "tangents ms"
+                  << std::setw(12) << "assimp ms" << std::setw(8) << "AO ms" << std::endl;
+        bool upload = Mesh::uploadToGpu;
+        Mesh::uploadToGpu = false;
+        for(const std::string &path : bundledModelPaths()){
+            Assimp::Importer importer;
+            auto start = std::chrono::steady_clock::now();
+            const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
+            double readMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if(!scene || !scene->mRootNode){
+                std::cerr << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+                continue;
+            }
+            ImportStatistics statistics;
+            std::vector<Mesh> meshes;
+            for(unsigned int m = 0; m < scene->mNumMeshes; m++){
+                std::vector<Vertex> vertices;
+                std::vector<unsigned int> indices;
+                Model::readMesh(scene->mMeshes[m], vertices, indices, statistics);
+                meshes.push_back(Mesh(vertices, indices, std::vector<Texture>()));
+            }
+
+            //the ambient occlusion of the whole model, as Model bakes it
+            std::vector<const Mesh*> occluded;
+            for(const Mesh &mesh : meshes){
+                occluded.push_back(&mesh);
+            }
+            std::vector<std::vector<float>> occlusion;
+            start = std::chrono::steady_clock::now();
+            ambientocclusion::bake(occluded, AMBIENT_OCCLUSION_SAMPLES, occlusion, ThreadPool::global());
+            double occlusionMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            //the post processing that the import used before
+            Assimp::Importer assimpImporter;
+            start = std::chrono::steady_clock::now();
+            const aiScene* assimpScene = assimpImporter.ReadFile(path, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices |
+                                                                       aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+            double assimpMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            size_t assimpVertices = 0;
+            for(unsigned int m = 0; assimpScene && m < assimpScene->mNumMeshes; m++){
+                assimpVertices += assimpScene->mMeshes[m]->mNumVertices;
+            }
+
+            std::cout << std::setw(44) << std::left << path << std::right << std::setw(10) << statistics.importedVertices
+                      << std::setw(10) << statistics.weldedVertices << std::setw(10) << assimpVertices
+                      << std::setw(10) << readMilliseconds << std::setw(10) << statistics.weldMilliseconds
+                      << std::setw(12) << statistics.normalMilliseconds << std::setw(13) << statistics.tangentMilliseconds
+                      << std::setw(12) << assimpMilliseconds << std::setw(8) << occlusionMilliseconds << std::endl;
+        }
+        Mesh::uploadToGpu = upload;
+    }
+
+    //triangles submitted with the meshlet culling against the ones that can be seen, around every bundled model
+    void meshletBenchmark(){
+        std::vector<std::string> paths = bundledModelPaths();
+        std::vector<glm::vec3> directions = viewDirections();
+        std::cout << "meshlets of at most " << MESHLET_MAX_TRIANGLES << " triangles and " << MESHLET_MAX_VERTICES
+                  << " vertices, " << directions.size() << " views at twice the bounding radius" << std::endl;
+        std::cout << std::setw(44) << std::left << "model" << std::right << std::setw(10) << "triangles"
+                  << std::setw(10) << "meshlets" << std::setw(12) << "submitted" << std::setw(10) << "visible"
+                  << std::setw(12) << "build ms" << std::setw(12) << "cull us" << std::endl;
+        for(const std::string &path : paths){
+            Assimp::Importer importer;
+            const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
+            if(!scene || !scene->mRootNode){
+                std::cerr << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+                continue;
+            }
+
+            //the meshes as the import leaves them for the culling
+            std::vector<std::vector<Vertex>> meshVertices;
+            std::vector<std::vector<unsigned int>> meshIndices;
+            std::vector<std::vector<Meshlet>> meshMeshlets;
+            glm::vec3 lower(INFINITY), upper(-INFINITY);
+            size_t triangles = 0, meshlets = 0;
+            double buildMilliseconds = 0.0;
+            for(unsigned int m = 0; m < scene->mNumMeshes; m++){
+                ImportStatistics statistics;
+                meshVertices.push_back(std::vector<Vertex>());
+                meshIndices.push_back(std::vector<unsigned int>());
+                Model::readMesh(scene->mMeshes[m], meshVertices.back(), meshIndices.back(), statistics);
+                meshoptimizer::optimizeVertexCache(meshIndices.back(), meshVertices.back().size());
+                auto start = std::chrono::steady_clock::now();
+                meshMeshlets.push_back(meshoptimizer::buildMeshlets(meshVertices.back(), meshIndices.back()));
+                buildMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                for(const Vertex &vertex : meshVertices.back()){
+                    lower = glm::min(lower, vertex.Position);
+                    upper = glm::max(upper, vertex.Position);
+                }
+                triangles += meshIndices.back().size() / 3;
+                meshlets += meshMeshlets.back().size();
+            }
+            glm::vec3 center = (lower + upper) * 0.5f;
+            float radius = glm::length(upper - lower) * 0.5f;
+
+            size_t submitted = 0, visible = 0;
+            double cullMicroseconds = 0.0;
+            for(const glm::vec3 &direction : directions){
+                glm::vec3 cameraPosition = center + direction * 2.f * radius;
+                glm::vec3 up = std::abs(direction.y) > 0.9f ? glm::vec3(1.f, 0.f, 0.f) : glm::vec3(0.f, 1.f, 0.f);
+                glm::vec4 planes[6];
+                frustumPlanes(glm::perspective(glm::radians(45.f), 1.f, 0.1f * radius, 10.f * radius) *
+                              glm::lookAt(cameraPosition, center, up), planes);
+                auto start = std::chrono::steady_clock::now();
+                for(const std::vector<Meshlet> &mesh : meshMeshlets){
+                    for(const Meshlet &meshlet : mesh){
+                        submitted += meshoptimizer::meshletVisible(meshlet, cameraPosition, planes) ? meshlet.indexCount / 3 : 0;
+                    }
+                }
+                cullMicroseconds += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+                for(size_t m = 0; m < meshIndices.size(); m++){
+                    const std::vector<Vertex> &vertices = meshVertices[m];
+                    const std::vector<unsigned int> &indices = meshIndices[m];
+                    for(size_t i = 0; i < indices.size(); i += 3){
+                        visible += triangleVisible(vertices[indices[i]].Position, vertices[indices[i + 1]].Position,
+                                                   vertices[indices[i + 2]].Position, cameraPosition, planes);
+                    }
+                }
+            }
+            std::cout << std::setw(44) << std::left << path << std::right << std::setw(10) << triangles
+                      << std::setw(10) << meshlets << std::setw(12) << submitted / directions.size()
+                      << std::setw(10) << visible / directions.size() << std::setw(12) << buildMilliseconds
+                      << std::setw(12) << cullMicroseconds / directions.size() << std::endl;
+        }
+    }
+
+    //time the naive and the blocked multiplication from 4x4 to 1024x1024
+    void multiplicationBenchmark(){
+        std::cout << "threads: " << ThreadPool::global().size() << std::endl;
+        std::cout << std::setw(6) << "size" << std::setw(16) << "naive (ms)" << std::setw(16) << "blocked (ms)"
+                  << std::setw(12) << "speedup" << std::setw(16) << "blocked GFLOPS" << std::endl;
+        for(int n = 4; n <= 1024; n *= 2){
+            ml::matrix<float> a(n, n), b(n, n);
+            fillRandom(a, n);
+            fillRandom(b, n + 1);
+
+            //repeat the small sizes so the time is measurable
+            int repetitions = std::max(1, (1 << 24) / (n * n * n));
+
+            auto start = std::chrono::steady_clock::now();
+            for(int r = 0; r < repetitions; r++){
+                ml::matrix<float> c = a.naiveMultiply(b);
+            }
+            auto middle = std::chrono::steady_clock::now();
+            for(int r = 0; r < repetitions; r++){
+                ml::matrix<float> c = a.blockedMultiply(b);
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            double naive = std::chrono::duration<double, std::milli>(middle - start).count() / repetitions;
+            double blocked = std::chrono::duration<double, std::milli>(end - middle).count() / repetitions;
+            double gflops = 2.0 * n * n * n / (blocked * 1e6);
+            std::cout << std::setw(6) << n << std::setw(16) << naive << std::setw(16) << blocked
+                      << std::setw(12) << naive / blocked << std::setw(16) << gflops << std::endl;
+        }
+    }
+
+    //frames of the scene rendered on the CPU with each shading, by one thread and by the whole pool
+    void softwareRendererBenchmark(){
+        bool upload = Mesh::uploadToGpu;
+        Mesh::uploadToGpu = false;
+        graphicslib::LightingInformation lighting;
+        SceneObjects objects;
+        Camera camera;
+        graphicslib::readScene(SCENE_FILE, lighting, objects, camera);
+
+        //the size of the window
+        const int size = 800, frames = 10;
+        ThreadPool single(1);
+        std::cout << std::setw(10) << "shading" << std::setw(10) << "threads" << std::setw(12) << "triangles"
+                  << std::setw(12) << "rasterized" << std::setw(12) << "fragments" << std::setw(12) << "ms/frame"
+                  << std::setw(10) << "frames/s" << std::setw(10) << "Mtris/s" << std::endl;
+        for(graphicslib::ShadingMode shading : {graphicslib::PHONG_SHADING, graphicslib::GOURAUD_SHADING}){
+            for(ThreadPool *pool : {&single, &ThreadPool::global()}){
+                SoftwareRenderer renderer(size, size, *pool);
+                //the first frame reads the textures
+                renderer.render(objects, lighting, camera, shading);
+                auto start = std::chrono::steady_clock::now();
+                for(int f = 0; f < frames; f++){
+                    renderer.render(objects, lighting, camera, shading);
+                }
+                double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+                std::cout << std::setw(10) << (shading == graphicslib::PHONG_SHADING ? "Phong" : "Gouraud")
+                          << std::setw(10) << pool->size() << std::setw(12) << renderer.trianglesSubmitted()
+                          << std::setw(12) << renderer.trianglesRasterized() << std::setw(12) << renderer.fragmentsShaded()
+                          << std::setw(12) << milliseconds << std::setw(10) << 1000.0 / milliseconds
+                          << std::setw(10) << renderer.trianglesSubmitted() / (milliseconds * 1000.0) << std::endl;
+            }
+        }
+
+        graphicslib::deleteObjects(objects);
+        Mesh::uploadToGpu = upload;
+    }
+
+    //BVH build and rays per second of the path tracer in the scene, by one thread and by the whole pool
+    void pathTracerBenchmark(){
+        bool upload = Mesh::uploadToGpu;
+        Mesh::uploadToGpu = false;
+        graphicslib::LightingInformation lighting;
+        SceneObjects objects;
+        Camera camera;
+        auto start = std::chrono::steady_clock::now();
+        graphicslib::readScene(SCENE_FILE, lighting, objects, camera);
+        double loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "scene loaded in " << loadMilliseconds << " ms" << std::endl;
+
+        const int size = 200, samples = 4;
+        ThreadPool single(1);
+        std::cout << std::setw(10) << "threads" << std::setw(12) << "triangles" << std::setw(10) << "nodes"
+                  << std::setw(12) << "build (ms)" << std::setw(12) << "trace (ms)" << std::setw(10) << "Mrays/s" << std::endl;
+        for(ThreadPool *pool : {&single, &ThreadPool::global()}){
+            PathTracer tracer(size, size, *pool);
+            tracer.setScene(objects, lighting, camera);
+            start = std::chrono::steady_clock::now();
+            tracer.addSamples(samples);
+            double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << std::setw(10) << pool->size() << std::setw(12) << tracer.getBvh().numberOfTriangles()
+                      << std::setw(10) << tracer.getBvh().numberOfNodes() << std::setw(12) << tracer.buildMilliseconds()
+                      << std::setw(12) << milliseconds << std::setw(10) << tracer.raysTraced() / (milliseconds * 1000.0)
+                      << std::endl;
+        }
+
+        graphicslib::deleteObjects(objects);
+        Mesh::uploadToGpu = upload;
+    }
+
+    //bake time and rays per second of the lighting of the scene, with and without the shadows and the ambient occlusion
+    void lightBakingBenchmark(){
+        bool upload = Mesh::uploadToGpu;
+        Mesh::uploadToGpu = false;
+        bool shadows = LightBaker::shadows;
+        int occlusionSamples = LightBaker::ambientOcclusionSamples;
+        std::string cacheDirectory = LightBaker::cacheDirectory;
+        LightBaker::cacheDirectory = "";
+        graphicslib::LightingInformation lighting;
+        SceneObjects objects;
+        Camera camera;
+        graphicslib::readScene(SCENE_FILE, lighting, objects, camera);
+
+        std::cout << lighting.numberOfPointLights << " lights, " << ThreadPool::global().size() << " threads" << std::endl;
+        std::cout << std::setw(10) << "shadows" << std::setw(10) << "AO rays" << std::setw(12) << "vertices"
+                  << std::setw(12) << "rays" << std::setw(12) << "bake (ms)" << std::setw(10) << "Mrays/s" << std::endl;
+        LightBaker baker;
+        for(int occlusion : {0, 16}){
+            for(bool shadowRays : {false, true}){
+                LightBaker::shadows = shadowRays;
+                LightBaker::ambientOcclusionSamples = occlusion;
+                baker.bake(objects, lighting);
+                std::cout << std::setw(10) << (shadowRays ? "yes" : "no") << std::setw(10) << occlusion
+                          << std::setw(12) << baker.vertices() << std::setw(12) << baker.raysTraced()
+                          << std::setw(12) << baker.bakeMilliseconds()
+                          << std::setw(10) << baker.raysTraced() / (baker.bakeMilliseconds() * 1000.0) << std::endl;
+            }
+        }
+
+        graphicslib::deleteObjects(objects);
+        LightBaker::shadows = shadows;
+        LightBaker::ambientOcclusionSamples = occlusionSamples;
+        LightBaker::cacheDirectory = cacheDirectory;
+        Mesh::uploadToGpu = upload;
+    }
+
+    //time of each step of the environment lighting of the bundled HDR image, for one thread and the whole pool,
+    //and of its load from the cache
+    void environmentLightingBenchmark(){
+        std::string cacheDirectory = EnvironmentLighting::cacheDirectory;
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "environmentlightingbenchmark";
+        std::filesystem::remove_all(directory);
+        ThreadPool single(1);
+        std::cout << ENVIRONMENT_MAP_FILE << ": cube " << ENVIRONMENT_CUBE_SIZE << ", prefiltered " << ENVIRONMENT_PREFILTER_SIZE
+                  << " with " << ENVIRONMENT_PREFILTER_LEVELS << " levels" << std::endl;
+        std::cout << std::setw(10) << "threads" << std::setw(10) << "cache" << std::setw(10) << "cube ms"
+                  << std::setw(15) << "irradiance ms" << std::setw(14) << "prefilter ms" << std::setw(10) << "BRDF ms"
+                  << std::setw(10) << "total ms" << std::endl;
+        EnvironmentLighting::cacheDirectory = directory.string();
+        for(ThreadPool *pool : {&single, &ThreadPool::global()}){
+            //the cache written by the first load is read by the second one
+            for(int load = 0; load < 2; load++){
+                EnvironmentLighting lighting(*pool);
+                if(!lighting.load(ENVIRONMENT_MAP_FILE)){
+                    continue;
+                }
+                const EnvironmentLighting::Timings &timings = lighting.timings();
+                std::cout << std::setw(10) << pool->size() << std::setw(10) << (lighting.loadedFromCache() ? "loaded" : "no")
+                          << std::setw(10) << timings.cube << std::setw(15) << timings.irradiance
+                          << std::setw(14) << timings.prefilter << std::setw(10) << timings.brdf
+                          << std::setw(10) << timings.total << std::endl;
+            }
+            std::filesystem::remove_all(directory);
+        }
+        EnvironmentLighting::cacheDirectory = cacheDirectory;
+    }
+
+    //the images of the materials of the bundled models with the kind of each one, as Model loads them
+    static std::vector<std::pair<std::string, texturecompressor::TextureKind>> bundledTextures(){
+        std::vector<std::pair<std::string, texturecompressor::TextureKind>> textures;
+        const std::pair<aiTextureType, const char*> types[] = {{aiTextureType_DIFFUSE, "texture_diffuse"},
+            {aiTextureType_SPECULAR, "texture_specular"}, {aiTextureType_HEIGHT, "texture_normal"},
+            {aiTextureType_AMBIENT, "texture_height"}};
+        for(const std::string &path : bundledModelPaths()){
+            Assimp::Importer importer;
+            const aiScene* scene = importer.ReadFile(path, 0);
+            if(!scene){
+                continue;
+            }
+            std::string directory = path.substr(0, path.find_last_of('/'));
+            for(unsigned int m = 0; m < scene->mNumMaterials; m++){
+                for(const auto &type : types){
+                    for(unsigned int t = 0; t < scene->mMaterials[m]->GetTextureCount(type.first); t++){
+                        aiString file;
+                        scene->mMaterials[m]->GetTexture(type.first, t, &file);
+                        std::pair<std::string, texturecompressor::TextureKind> texture(directory + '/' + file.C_Str(),
+                                                                                      texturecompressor::kindOf(type.second));
+                        if(std::find(textures.begin(), textures.end(), texture) == textures.end()){
+                            textures.push_back(texture);
+                        }
+                    }
+                }
+            }
+        }
+        return textures;
+    }
+
+    //memory of the textures of the bundled models as RGBA8 with the mipmaps against their blocks, the time of the
+    //decoding of each image against the read of its KTX file, and the time of its conditioning
+    void textureCompressionBenchmark(){
+        const char *formats[] = {"BC1", "BC3", "BC4", "BC5", "BC7"};
+        std::string cacheDirectory = texturecompressor::cacheDirectory;
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "texturecompressionbenchmark";
+        std::filesystem::create_directories(directory);
+        texturecompressor::cacheDirectory = directory.string();
+        std::cout << std::setw(52) << std::left << "texture" << std::right << std::setw(11) << "size" << std::setw(8) << "format"
+                  << std::setw(10) << "RGBA8 KB" << std::setw(10) << "BC KB" << std::setw(8) << "ratio"
+                  << std::setw(12) << "decode ms" << std::setw(9) << "KTX ms" << std::setw(11) << "encode ms" << std::endl;
+        double rawBytes = 0.0, blockBytes = 0.0, decodeTime = 0.0, readTime = 0.0;
+        for(const auto &texture : bundledTextures()){
+            auto start = std::chrono::steady_clock::now();
+            int width, height, components;
+            unsigned char *data = stbi_load(texture.first.c_str(), &width, &height, &components, 0);
+            double decodeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if(!data){
+                continue;
+            }
+            stbi_image_free(data);
+
+            texturecompressor::CompressedTexture compressed, read;
+            start = std::chrono::steady_clock::now();
+            texturecompressor::compress(texture.first, texture.second, false, compressed, ThreadPool::global());
+            double encodeMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::string path = texturecompressor::containerPath(texture.first, texture.second);
+            texturecompressor::writeContainer(path, compressed);
+            //the hash of the image that finds its file is part of the load
+            start = std::chrono::steady_clock::now();
+            bool loaded = texturecompressor::readContainer(texturecompressor::containerPath(texture.first, texture.second), read);
+            double readMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if(!loaded){
+                continue;
+            }
+
+            //what glTexImage2D and glGenerateMipmap keep of the image
+            double raw = 4.0 * width * height * 4.0 / 3.0;
+            rawBytes += raw;
+            blockBytes += read.bytes();
+            decodeTime += decodeMilliseconds;
+            readTime += readMilliseconds;
+            std::cout << std::setw(52) << std::left << texture.first << std::right
+                      << std::setw(11) << std::to_string(width) + "x" + std::to_string(height)
+                      << std::setw(8) << formats[read.format] << std::setw(10) << (int) (raw / 1024.0)
+                      << std::setw(10) << read.bytes() / 1024 << std::setw(8) << raw / read.bytes()
+                      << std::setw(12) << decodeMilliseconds << std::setw(9) << readMilliseconds
+                      << std::setw(11) << encodeMilliseconds << std::endl;
+        }
+        std::cout << std::setw(52) << std::left << "all" << std::right << std::setw(29) << (int) (rawBytes / 1024.0)
+                  << std::setw(10) << (int) (blockBytes / 1024.0) << std::setw(8) << rawBytes / std::max(blockBytes, 1.0)
+                  << std::setw(12) << decodeTime << std::setw(9) << readTime << std::endl;
+        std::filesystem::remove_all(directory);
+        texturecompressor::cacheDirectory = cacheDirectory;
+    }
+
+    void sceneFileBenchmark(){
+        //a generated scene: the objects of a few models on a grid, and the lights above them
+        const char *models[] = {"resources/objects/cyborg/cyborg.obj", "resources/objects/rock/rock.obj",
+                                "resources/objects/planet/planet.obj", "resources/objects/nanosuit/nanosuit.obj"};
+        std::filesystem::path path = std::filesystem::temp_directory_path() / "scenefilebenchmark.txt";
+        std::ostringstream text;
+        text << "//object <path> <x y z>" << std::endl;
+        for(int o = 0; o < 100000; o++){
+            text << "object " << models[o % 4] << " " << (o % 316) * 2.5f << " 0.0 " << (o / 316) * 2.5f << std::endl;
+        }
+        for(int l = 0; l < 1000; l++){
+            text << "light " << (l % 32) * 25.f << " 4.0 " << (l / 32) * 25.f << "  1.0 0.9 0.8  0.2 0.0 0.01" << std::endl;
+        }
+        text << "camera 0.0 10.0 -10.0  0.0 0.0 0.0  0.0 1.0 0.0" << std::endl;
+        std::ofstream(path.string()) << text.str();
+
+        //the lines with getline and istringstream, as readScene read them before
+        auto start = std::chrono::steady_clock::now();
+        std::ifstream file(path.string());
+        std::string line;
+        size_t streamEntries = 0;
+        while(std::getline(file, line)){
+            std::istringstream lineStream(line);
+            std::string firstWord, modelPath;
+            float values[9];
+            lineStream >> firstWord;
+            if(firstWord == "object"){
+                lineStream >> modelPath >> values[0] >> values[1] >> values[2];
+            }else if(firstWord == "light" || firstWord == "camera"){
+                for(float &value : values){
+                    lineStream >> value;
+                }
+            }else{
+                continue;
+            }
+            streamEntries++;
+        }
+        double streamMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        scenefile::Scene scene;
+        scenefile::read(path.string(), scene);
+        double readMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        //an object moved in the middle of the file, what a reload finds
+        scenefile::Scene next = scene;
+        next.objects[50000].position.y += 1.f;
+        start = std::chrono::steady_clock::now();
+        scenefile::SceneDiff changes = scenefile::diff(scene, next);
+        double diffMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::filesystem::remove(path);
+
+        size_t entries = scene.objects.size() + scene.lights.size() + scene.hasCamera;
+        std::cout << entries << " entries (" << text.str().size() / 1024 << " KB): getline and istringstream "
+                  << streamMilliseconds << " ms (" << streamEntries << " entries), mapped with from_chars "
+                  << readMilliseconds << " ms (" << scene.paths.size() << " paths), diff of a moved object "
+                  << diffMilliseconds << " ms (" << changes.movedObjects.size() << " moved)" << std::endl;
+    }
+
+    void sceneSnapshotBenchmark(){
+        bool upload = Mesh::uploadToGpu;
+        int samples = Model::ambientOcclusionSamples;
+        std::string snapshotFile = SceneSnapshot::file;
+        bool writeAfterLoad = SceneSnapshot::writeAfterLoad, enabled = SceneSnapshot::enabled;
+        Mesh::uploadToGpu = false;
+        Model::ambientOcclusionSamples = 0;
+        SceneSnapshot::enabled = true;
+
+        //a generated scene of 100000 objects of the bundled models and 1000 lights, each read loads the 4 models once
+        const char *paths[] = {"resources/objects/cyborg/cyborg.obj", "resources/objects/rock/rock.obj",
+                               "resources/objects/planet/planet.obj", "resources/objects/nanosuit/nanosuit.obj"};
+        std::filesystem::path directory = std::filesystem::temp_directory_path() / "scenesnapshotbenchmark";
+        std::filesystem::create_directories(directory);
+        std::string path = (directory / "scene.txt").string();
+        {
+            std::ofstream file(path);
+            for(int o = 0; o < 100000; o++){
+                file << "object " << paths[o % 4] << " " << (o % 320) * 2.5f << " 0.0 " << (o / 320) * 2.5f << std::endl;
+            }
+            for(int l = 0; l < 1000; l++){
+                file << "light " << (l % 32) * 25.f << " 4.0 " << (l / 32) * 25.f << "  1.0 0.9 0.8  0.2 0.0 0.01" << std::endl;
+            }
+            file << "camera 0.0 10.0 -10.0  0.0 0.0 0.0  0.0 1.0 0.0" << std::endl;
+        }
+        SceneSnapshot::file = (directory / "scene.snapshot").string();
+
+        //the text, which writes the snapshot, then the snapshot, both through readScene as the application reads them
+        graphicslib::LightingInformation textLighting, snapshotLighting;
+        SceneObjects textObjects, snapshotObjects;
+        Camera textCamera, snapshotCamera;
+        SceneSnapshot::writeAfterLoad = true;
+        auto start = std::chrono::steady_clock::now();
+        graphicslib::readScene(path.c_str(), textLighting, textObjects, textCamera);
+        double textMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        SceneSnapshot::writeAfterLoad = false;
+        //the models are deleted, the snapshot loads them again instead of sharing the ones of the text
+        size_t textObjectCount = textObjects.size();
+        graphicslib::deleteObjects(textObjects);
+        SceneSnapshot snapshot;
+        bool opened = snapshot.open(SceneSnapshot::file, path);
+        start = std::chrono::steady_clock::now();
+        graphicslib::readScene(path.c_str(), snapshotLighting, snapshotObjects, snapshotCamera);
+        double snapshotMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << textObjectCount << " objects and " << textLighting.pointLights.size() << " lights: text "
+                  << textMilliseconds << " ms (" << std::filesystem::file_size(path) / 1024 << " KB, snapshot written), snapshot "
+                  << (opened ? "" : "NOT OPENED ") << snapshotMilliseconds << " ms ("
+                  << std::filesystem::file_size(SceneSnapshot::file) / 1024 << " KB, " << snapshotObjects.size()
+                  << " objects)" << std::endl;
+
+        graphicslib::deleteObjects(snapshotObjects);
+        std::filesystem::remove_all(directory);
+        SceneSnapshot::file = snapshotFile;
+        SceneSnapshot::writeAfterLoad = writeAfterLoad;
+        SceneSnapshot::enabled = enabled;
+        Model::ambientOcclusionSamples = samples;
+        Mesh::uploadToGpu = upload;
+    }
+
+    void sceneObjectsBenchmark(){
+        //objects moving on a grid, each one with its own rotation and scale
+        const int numberOfObjects = 500000, frames = 10;
+        std::mt19937 generator(50);
+        std::uniform_real_distribution<float> distribution(0.f, 6.f);
+        SceneObjects objects;
+        graphicslib::ModelInformation modelInfo = {};
+        std::vector<SceneObjects::Transform> transforms(numberOfObjects);
+        for(int o = 0; o < numberOfObjects; o++){
+            SceneObjects::Transform &transform = transforms[o];
+            transform.offset = glm::vec3(-0.5f);
+            transform.scale = glm::vec3(0.5f + distribution(generator) * 0.1f);
+            transform.rotation = glm::vec3(distribution(generator), distribution(generator), distribution(generator));
+            transform.position = glm::vec3((o % 1000) * 2.f, 0.f, (o / 1000) * -2.f);
+            objects.add(modelInfo, transform);
+            objects.component(SceneObjects::MODEL_RADIUS)[o] = 0.87f;
+        }
+        glm::mat4 viewProjection = glm::perspective(glm::radians(60.f), 16.f / 9.f, 0.1f, 500.f) *
+                                   glm::lookAt(glm::vec3(1000.f, 20.f, 10.f), glm::vec3(1000.f, 0.f, -200.f), glm::vec3(0.f, 1.f, 0.f));
+
+        //the model matrix of each object with the matrices of utils, as each frame did before
+        auto start = std::chrono::steady_clock::now();
+        float sum = 0.f;
+        for(const SceneObjects::Transform &transform : transforms){
+            sum += graphicslib::getModelMatrix(transform).getMatrix()[0][3];
+        }
+        double matrixMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        ThreadPool single(1);
+        std::vector<unsigned int> visible;
+        std::cout << numberOfObjects << " objects, utils matrices " << matrixMilliseconds << " ms (" << (sum != 0.f)
+                  << ")" << std::endl;
+        std::cout << std::setw(10) << "threads" << std::setw(12) << "move (ms)" << std::setw(14) << "update (ms)"
+                  << std::setw(12) << "cull (ms)" << std::setw(10) << "visible" << std::setw(14) << "Mobjects/s" << std::endl;
+        for(ThreadPool *pool : {&single, &ThreadPool::global()}){
+            double moveMilliseconds = 0.0, updateMilliseconds = 0.0, cullMilliseconds = 0.0;
+            for(int f = 0; f < frames; f++){
+                //every object moves in every frame, written in place
+                start = std::chrono::steady_clock::now();
+                float *y = objects.component(SceneObjects::POSITION_Y);
+                for(int o = 0; o < numberOfObjects; o++){
+                    y[o] = std::sin(f * 0.1f + o * 0.01f);
+                }
+                auto moved = std::chrono::steady_clock::now();
+                objects.updateTransforms(*pool);
+                auto updated = std::chrono::steady_clock::now();
+                objects.cull(viewProjection, visible);
+                auto culled = std::chrono::steady_clock::now();
+                moveMilliseconds += std::chrono::duration<double, std::milli>(moved - start).count() / frames;
+                updateMilliseconds += std::chrono::duration<double, std::milli>(updated - moved).count() / frames;
+                cullMilliseconds += std::chrono::duration<double, std::milli>(culled - updated).count() / frames;
+            }
+            std::cout << std::setw(10) << pool->size() << std::setw(12) << moveMilliseconds << std::setw(14)
+                      << updateMilliseconds << std::setw(12) << cullMilliseconds << std::setw(10) << visible.size()
+                      << std::setw(14) << numberOfObjects / (updateMilliseconds * 1000.0) << std::endl;
+        }
+    }
 }
@@ -0,0 +1,913 @@
+#include <texturecompressor.hpp>
+#include <threadpool.hpp>
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+//the S3TC formats aren't in the core profile, the GPUs that have them expose GL_EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+namespace texturecompressor {
+
+    std::string cacheDirectory = "cache/textures";
+
+    static const float PI = 3.14159265f;
+
+    //identifier of the KTX 1.1 files
+    static const unsigned char KTX_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    //internal and base formats of OpenGL of the block formats
+    unsigned int internalFormat(BlockFormat format){
+        switch(format){
+            case BC1_FORMAT: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+            case BC3_FORMAT: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            case BC4_FORMAT: return GL_COMPRESSED_RED_RGTC1;
+            case BC5_FORMAT: return GL_COMPRESSED_RG_RGTC2;
+            default: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        }
+    }
+
+    static unsigned int baseFormat(BlockFormat format){
+        switch(format){
+            case BC1_FORMAT: return GL_RGB;
+            case BC4_FORMAT: return GL_RED;
+            case BC5_FORMAT: return GL_RG;
+            default: return GL_RGBA;
+        }
+    }
+
+    static size_t blockSize(BlockFormat format){
+        return format == BC1_FORMAT || format == BC4_FORMAT ? 8 : 16;
+    }
+
+    size_t CompressedTexture::bytes() const{
+        size_t total = 0;
+        for(const Level &level : levels){
+            total += level.size;
+        }
+        return total;
+    }
+
+    TextureKind kindOf(const std::string &type){
+        if(type == "texture_diffuse"){
+            return COLOR_TEXTURE;
+        }
+        return type == "texture_normal" ? NORMAL_TEXTURE : DATA_TEXTURE;
+    }
+
+    BlockFormat chooseFormat(TextureKind kind, int components, bool hasAlpha, bool highQuality){
+        if(kind == NORMAL_TEXTURE){
+            return BC5_FORMAT;
+        }
+        if(components == 1){
+            return BC4_FORMAT;
+        }
+        if(highQuality){
+            return BC7_FORMAT;
+        }
+        return hasAlpha ? BC3_FORMAT : BC1_FORMAT;
+    }
+
+    size_t levelSize(BlockFormat format, int width, int height){
+        return (size_t) ((width + 3) / 4) * ((height + 3) / 4) * blockSize(format);
+    }
+
+    //sRGB to linear and back, as the sRGB textures of OpenGL
+    static float toLinear(float value){
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    static float toSrgb(float value){
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+    }
+
+    static unsigned char toByte(float value){
+        return (unsigned char) std::lround(std::min(std::max(value, 0.f), 1.f) * 255.f);
+    }
+
+    //Lanczos kernel with 2 lobes
+    static float lanczos(float x){
+        x = std::abs(x);
+        if(x < 1e-6f){
+            return 1.f;
+        }
+        if(x >= 2.f){
+            return 0.f;
+        }
+        float px = PI * x;
+        return 2.f * std::sin(px) * std::sin(px / 2.f) / (px * px);
+    }
+
+    //the source texels (wrapped around as GL_REPEAT) and their weights of each texel of a resampled row or column
+    struct Taps{
+        std::vector<int> first, count;
+        std::vector<int> indices;
+        std::vector<float> weights;
+    };
+
+    static Taps resamplingTaps(int source, int destination){
+        Taps taps;
+        float scale = (float) source / destination;
+        float support = 2.f * scale;
+        for(int x = 0; x < destination; x++){
+            float center = (x + 0.5f) * scale;
+            int begin = (int) std::floor(center - support), end = (int) std::ceil(center + support);
+            taps.first.push_back(taps.indices.size());
+            float sum = 0.f;
+            for(int i = begin; i <= end; i++){
+                float weight = lanczos((i + 0.5f - center) / scale);
+                if(weight == 0.f){
+                    continue;
+                }
+                taps.indices.push_back((i % source + source) % source);
+                taps.weights.push_back(weight);
+                sum += weight;
+            }
+            taps.count.push_back(taps.indices.size() - taps.first.back());
+            for(size_t t = taps.first.back(); t < taps.indices.size(); t++){
+                taps.weights[t] /= sum;
+            }
+        }
+        return taps;
+    }
+
+    std::vector<Image> generateMipmaps(const Image &image, TextureKind kind, ThreadPool &pool){
+        std::vector<Image> levels(1, image);
+        //the texels of the last level in linear space: the normals in [-1, 1]
+        int width = image.width, height = image.height;
+        std::vector<float> linear(image.texels.size());
+        for(size_t i = 0; i < image.texels.size(); i++){
+            float value = image.texels[i] / 255.f;
+            bool color = i % 4 != 3;
+            if(kind == COLOR_TEXTURE && color){
+                value = toLinear(value);
+            }else if(kind == NORMAL_TEXTURE && color){
+                value = value * 2.f - 1.f;
+            }
+            linear[i] = value;
+        }
+
+        while(width > 1 || height > 1){
+            int nextWidth = std::max(width / 2, 1), nextHeight = std::max(height / 2, 1);
+            Taps horizontal = resamplingTaps(width, nextWidth), vertical = resamplingTaps(height, nextHeight);
+            //the rows are resampled first, then the columns
+            std::vector<float> rows(4 * (size_t) nextWidth * height), next(4 * (size_t) nextWidth * nextHeight);
+            pool.parallelFor(0, height, 16, [&](int begin, int end){
+                for(int y = begin; y < end; y++){
+                    for(int x = 0; x < nextWidth; x++){
+                        float sum[4] = {0.f, 0.f, 0.f, 0.f};
+                        for(int t = horizontal.first[x]; t < horizontal.first[x] + horizontal.count[x]; t++){
+                            const float *texel = &linear[4 * ((size_t) y * width + horizontal.indices[t])];
+                            for(int c = 0; c < 4; c++){
+                                sum[c] += texel[c] * horizontal.weights[t];
+                            }
+                        }
+                        std::copy(sum, sum + 4, &rows[4 * ((size_t) y * nextWidth + x)]);
+                    }
+                }
+            });
+            pool.parallelFor(0, nextHeight, 16, [&](int begin, int end){
+                for(int y = begin; y < end; y++){
+                    for(int x = 0; x < nextWidth; x++){
+                        float sum[4] = {0.f, 0.f, 0.f, 0.f};
+                        for(int t = vertical.first[y]; t < vertical.first[y] + vertical.count[y]; t++){
+                            const float *texel = &rows[4 * ((size_t) vertical.indices[t] * nextWidth + x)];
+                            for(int c = 0; c < 4; c++){
+                                sum[c] += texel[c] * vertical.weights[t];
+                            }
+                        }
+                        //the negative lobes can leave the range
+                        if(kind == NORMAL_TEXTURE){
+                            float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+                            for(int c = 0; c < 3; c++){
+                                sum[c] = length > 0.f ? sum[c] / length : (c == 2 ? 1.f : 0.f);
+                            }
+                        }else{
+                            for(int c = 0; c < 3; c++){
+                                sum[c] = std::max(sum[c], 0.f);
+                            }
+                        }
+                        sum[3] = std::min(std::max(sum[3], 0.f), 1.f);
+                        std::copy(sum, sum + 4, &next[4 * ((size_t) y * nextWidth + x)]);
+                    }
+                }
+            });
+
+            Image level;
+            level.width = nextWidth;
+            level.height = nextHeight;
+            level.texels.resize(next.size());
+            for(size_t i = 0; i < next.size(); i++){
+                float value = next[i];
+                bool color = i % 4 != 3;
+                if(kind == COLOR_TEXTURE && color){
+                    value = toSrgb(std::min(value, 1.f));
+                }else if(kind == NORMAL_TEXTURE && color){
+                    value = value * 0.5f + 0.5f;
+                }
+                level.texels[i] = toByte(value);
+            }
+            levels.push_back(std::move(level));
+            linear.swap(next);
+            width = nextWidth;
+            height = nextHeight;
+        }
+        return levels;
+    }
+
+    //the colors of a block and of the palettes, in 0..255
+    struct Color{
+        int r, g, b, a;
+    };
+
+    static int squaredDistance(const Color &x, const Color &y, bool alpha){
+        int dr = x.r - y.r, dg = x.g - y.g, db = x.b - y.b, da = alpha ? x.a - y.a : 0;
+        return dr * dr + dg * dg + db * db + da * da;
+    }
+
+    //principal axis of the colors (RGB or RGBA) of a block, by power iterations on their covariance
+    static void principalAxis(const Color block[16], int channels, float mean[4], float axis[4]){
+        for(int c = 0; c < 4; c++){
+            mean[c] = 0.f;
+            axis[c] = c < channels ? 1.f : 0.f;
+        }
+        for(int i = 0; i < 16; i++){
+            const int values[4] = {block[i].r, block[i].g, block[i].b, block[i].a};
+            for(int c = 0; c < channels; c++){
+                mean[c] += values[c] / 16.f;
+            }
+        }
+        float covariance[4][4] = {};
+        for(int i = 0; i < 16; i++){
+            const int values[4] = {block[i].r, block[i].g, block[i].b, block[i].a};
+            for(int j = 0; j < channels; j++){
+                for(int k = 0; k < channels; k++){
+                    covariance[j][k] += (values[j] - mean[j]) * (values[k] - mean[k]);
+                }
+            }
+        }
+        //the iterations start from the column of the channel that varies the most, which can't be orthogonal to
+        //the axis as a fixed direction can (red and blue from (1, 1, 1))
+        int widest = 0;
+        for(int c = 1; c < channels; c++){
+            if(covariance[c][c] > covariance[widest][widest]){
+                widest = c;
+            }
+        }
+        if(covariance[widest][widest] > 0.f){
+            for(int c = 0; c < channels; c++){
+                axis[c] = covariance[c][widest];
+            }
+        }
+        for(int iteration = 0; iteration < TEXTURE_AXIS_ITERATIONS; iteration++){
+            float next[4] = {0.f, 0.f, 0.f, 0.f};
+            float length = 0.f;
+            for(int j = 0; j < channels; j++){
+                for(int k = 0; k < channels; k++){
+                    next[j] += covariance[j][k] * axis[k];
+                }
+                length += next[j] * next[j];
+            }
+            //all the colors are the same
+            if(length < 1e-12f){
+                break;
+            }
+            length = std::sqrt(length);
+            for(int j = 0; j < channels; j++){
+                axis[j] = next[j] / length;
+            }
+        }
+    }
+
+    //the extremes of the projections of the colors on the axis
+    static void axisExtremes(const Color block[16], int channels, const float mean[4], const float axis[4],
+                             float low[4], float high[4]){
+        float lowest = 0.f, highest = 0.f;
+        for(int i = 0; i < 16; i++){
+            const int values[4] = {block[i].r, block[i].g, block[i].b, block[i].a};
+            float projection = 0.f;
+            for(int c = 0; c < channels; c++){
+                projection += (values[c] - mean[c]) * axis[c];
+            }
+            lowest = std::min(lowest, projection);
+            highest = std::max(highest, projection);
+        }
+        for(int c = 0; c < 4; c++){
+            low[c] = std::min(std::max(mean[c] + axis[c] * lowest, 0.f), 255.f);
+            high[c] = std::min(std::max(mean[c] + axis[c] * highest, 0.f), 255.f);
+        }
+    }
+
+    //endpoints that fit the colors best in the least squares sense for their palette weights (of the second endpoint)
+    static bool leastSquaresEndpoints(const Color block[16], const float weights[16], float first[4], float second[4]){
+        float aa = 0.f, ab = 0.f, bb = 0.f;
+        float ax[4] = {0.f, 0.f, 0.f, 0.f}, bx[4] = {0.f, 0.f, 0.f, 0.f};
+        for(int i = 0; i < 16; i++){
+            float b = weights[i], a = 1.f - b;
+            const int values[4] = {block[i].r, block[i].g, block[i].b, block[i].a};
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for(int c = 0; c < 4; c++){
+                ax[c] += a * values[c];
+                bx[c] += b * values[c];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if(std::abs(determinant) < 1e-6f){
+            return false;
+        }
+        for(int c = 0; c < 4; c++){
+            first[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.f), 255.f);
+            second[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.f), 255.f);
+        }
+        return true;
+    }
+
+    static unsigned short packRgb565(const float color[4]){
+        int r = std::lround(color[0] * 31.f / 255.f), g = std::lround(color[1] * 63.f / 255.f);
+        int b = std::lround(color[2] * 31.f / 255.f);
+        return (unsigned short) (r << 11 | g << 5 | b);
+    }
+
+    static Color unpackRgb565(unsigned short packed){
+        int r = packed >> 11 & 31, g = packed >> 5 & 63, b = packed & 31;
+        return Color{r << 3 | r >> 2, g << 2 | g >> 4, b << 3 | b >> 2, 255};
+    }
+
+    //the 4 colors of a BC1 block, 3 and a transparent black when the first endpoint isn't bigger
+    static void bc1Palette(unsigned short color0, unsigned short color1, bool fourColors, Color palette[4]){
+        palette[0] = unpackRgb565(color0);
+        palette[1] = unpackRgb565(color1);
+        if(fourColors || color0 > color1){
+            palette[2] = Color{(2 * palette[0].r + palette[1].r) / 3, (2 * palette[0].g + palette[1].g) / 3,
+                               (2 * palette[0].b + palette[1].b) / 3, 255};
+            palette[3] = Color{(palette[0].r + 2 * palette[1].r) / 3, (palette[0].g + 2 * palette[1].g) / 3,
+                               (palette[0].b + 2 * palette[1].b) / 3, 255};
+        }else{
+            palette[2] = Color{(palette[0].r + palette[1].r) / 2, (palette[0].g + palette[1].g) / 2,
+                               (palette[0].b + palette[1].b) / 2, 255};
+            palette[3] = Color{0, 0, 0, 0};
+        }
+    }
+
+    //nearest colors of the 4 colors palette of two endpoints, returns the squared error
+    static int bc1Indices(const Color block[16], unsigned short color0, unsigned short color1, int indices[16]){
+        Color palette[4];
+        bc1Palette(color0, color1, true, palette);
+        int error = 0;
+        for(int i = 0; i < 16; i++){
+            int best = 0, bestDistance = squaredDistance(block[i], palette[0], false);
+            for(int p = 1; p < 4; p++){
+                int distance = squaredDistance(block[i], palette[p], false);
+                if(distance < bestDistance){
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices[i] = best;
+            error += bestDistance;
+        }
+        return error;
+    }
+
+    //a BC1 block in the 4 colors mode: the endpoints on the axis of the colors, refined once by least squares
+    static void encodeBc1(const Color block[16], unsigned char out[8]){
+        float mean[4], axis[4], low[4], high[4];
+        principalAxis(block, 3, mean, axis);
+        axisExtremes(block, 3, mean, axis, low, high);
+        unsigned short color0 = packRgb565(high), color1 = packRgb565(low);
+        int indices[16];
+        int error = bc1Indices(block, color0, color1, indices);
+
+        const float paletteWeights[4] = {0.f, 1.f, 1.f / 3.f, 2.f / 3.f};
+        float weights[16], first[4], second[4];
+        for(int i = 0; i < 16; i++){
+            weights[i] = paletteWeights[indices[i]];
+        }
+        if(leastSquaresEndpoints(block, weights, first, second)){
+            unsigned short refined0 = packRgb565(first), refined1 = packRgb565(second);
+            int refinedIndices[16];
+            int refinedError = bc1Indices(block, refined0, refined1, refinedIndices);
+            if(refinedError < error){
+                color0 = refined0;
+                color1 = refined1;
+                std::copy(refinedIndices, refinedIndices + 16, indices);
+            }
+        }
+
+        //the 4 colors mode needs the first endpoint bigger, swapping them swaps the indices 0 and 1, 2 and 3
+        if(color0 < color1){
+            std::swap(color0, color1);
+            for(int &index : indices){
+                index ^= 1;
+            }
+        }else if(color0 == color1){
+            std::fill(indices, indices + 16, 0);
+        }
+        unsigned int bits = 0;
+        for(int i = 0; i < 16; i++){
+            bits |= (unsigned int) indices[i] << (2 * i);
+        }
+        out[0] = color0 & 0xFF;
+        out[1] = color0 >> 8;
+        out[2] = color1 & 0xFF;
+        out[3] = color1 >> 8;
+        for(int b = 0; b < 4; b++){
+            out[4 + b] = bits >> (8 * b) & 0xFF;
+        }
+    }
+
+    //the 8 values of a BC4 block whose first endpoint is bigger
+    static void bc4Palette(int value0, int value1, int palette[8]){
+        palette[0] = value0;
+        palette[1] = value1;
+        if(value0 > value1){
+            for(int i = 1; i < 7; i++){
+                palette[i + 1] = ((7 - i) * value0 + i * value1 + 3) / 7;
+            }
+        }else{
+            for(int i = 1; i < 5; i++){
+                palette[i + 1] = ((5 - i) * value0 + i * value1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    //a BC4 block between the extremes of the values
+    static void encodeBc4(const int values[16], unsigned char out[8]){
+        int low = *std::min_element(values, values + 16), high = *std::max_element(values, values + 16);
+        int palette[8];
+        bc4Palette(high, low, palette);
+        unsigned long long bits = 0;
+        for(int i = 0; i < 16; i++){
+            int best = 0;
+            for(int p = 1; p < 8 && high > low; p++){
+                if(std::abs(values[i] - palette[p]) < std::abs(values[i] - palette[best])){
+                    best = p;
+                }
+            }
+            bits |= (unsigned long long) best << (3 * i);
+        }
+        out[0] = high;
+        out[1] = low;
+        for(int b = 0; b < 6; b++){
+            out[2 + b] = bits >> (8 * b) & 0xFF;
+        }
+    }
+
+    static void decodeBc4(const unsigned char in[8], int values[16]){
+        int palette[8];
+        bc4Palette(in[0], in[1], palette);
+        unsigned long long bits = 0;
+        for(int b = 0; b < 6; b++){
+            bits |= (unsigned long long) in[2 + b] << (8 * b);
+        }
+        for(int i = 0; i < 16; i++){
+            values[i] = palette[bits >> (3 * i) & 7];
+        }
+    }
+
+    //weights of the 4 bits indices of BC7
+    static const int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    static void bc7Palette(const int endpoint0[4], const int endpoint1[4], Color palette[16]){
+        for(int i = 0; i < 16; i++){
+            int w = BC7_WEIGHTS[i];
+            palette[i] = Color{((64 - w) * endpoint0[0] + w * endpoint1[0] + 32) >> 6,
+                               ((64 - w) * endpoint0[1] + w * endpoint1[1] + 32) >> 6,
+                               ((64 - w) * endpoint0[2] + w * endpoint1[2] + 32) >> 6,
+                               ((64 - w) * endpoint0[3] + w * endpoint1[3] + 32) >> 6};
+        }
+    }
+
+    //the endpoints of mode 6 with their p-bits: 7 bits per component and the p-bit as the lowest bit
+    static void quantizeBc7(const float color[4], int pBit, int quantized[4]){
+        for(int c = 0; c < 4; c++){
+            int value = std::min(std::max((int) std::lround((color[c] - pBit) / 2.f), 0), 127);
+            quantized[c] = value << 1 | pBit;
+        }
+    }
+
+    //nearest colors of the palette of two endpoints, returns the squared error
+    static int bc7Indices(const Color block[16], const int endpoint0[4], const int endpoint1[4], int indices[16]){
+        Color palette[16];
+        bc7Palette(endpoint0, endpoint1, palette);
+        int error = 0;
+        for(int i = 0; i < 16; i++){
+            int best = 0, bestDistance = squaredDistance(block[i], palette[0], true);
+            for(int p = 1; p < 16; p++){
+                int distance = squaredDistance(block[i], palette[p], true);
+                if(distance < bestDistance){
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+            indices[i] = best;
+            error += bestDistance;
+        }
+        return error;
+    }
+
+    //the best p-bits of two endpoints, returns the squared error
+    static int bc7Endpoints(const Color block[16], const float first[4], const float second[4], int endpoint0[4],
+                            int endpoint1[4], int indices[16]){
+        int bestError = -1;
+        for(int pBits = 0; pBits < 4; pBits++){
+            int candidate0[4], candidate1[4], candidateIndices[16];
+            quantizeBc7(first, pBits & 1, candidate0);
+            quantizeBc7(second, pBits >> 1, candidate1);
+            int error = bc7Indices(block, candidate0, candidate1, candidateIndices);
+            if(bestError < 0 || error < bestError){
+                bestError = error;
+                std::copy(candidate0, candidate0 + 4, endpoint0);
+                std::copy(candidate1, candidate1 + 4, endpoint1);
+                std::copy(candidateIndices, candidateIndices + 16, indices);
+            }
+        }
+        return bestError;
+    }
+
+    //write count bits of a value at a bit of a block, from the lowest bit
+    static void putBits(unsigned char block[16], int &position, int count, unsigned int value){
+        for(int b = 0; b < count; b++, position++){
+            block[position / 8] |= (value >> b & 1) << (position % 8);
+        }
+    }
+
+    static unsigned int getBits(const unsigned char block[16], int &position, int count){
+        unsigned int value = 0;
+        for(int b = 0; b < count; b++, position++){
+            value |= (unsigned int) (block[position / 8] >> (position % 8) & 1) << b;
+        }
+        return value;
+    }
+
+    //a BC7 block in mode 6: the endpoints on the axis of the colors, refined once by least squares
+    static void encodeBc7(const Color block[16], unsigned char out[16]){
+        float mean[4], axis[4], low[4], high[4];
+        principalAxis(block, 4, mean, axis);
+        axisExtremes(block, 4, mean, axis, low, high);
+        int endpoint0[4], endpoint1[4], indices[16];
+        int error = bc7Endpoints(block, low, high, endpoint0, endpoint1, indices);
+
+        float weights[16], first[4], second[4];
+        for(int i = 0; i < 16; i++){
+            weights[i] = BC7_WEIGHTS[indices[i]] / 64.f;
+        }
+        if(error > 0 && leastSquaresEndpoints(block, weights, first, second)){
+            int refined0[4], refined1[4], refinedIndices[16];
+            if(bc7Endpoints(block, first, second, refined0, refined1, refinedIndices) < error){
+                std::copy(refined0, refined0 + 4, endpoint0);
+                std::copy(refined1, refined1 + 4, endpoint1);
+                std::copy(refinedIndices, refinedIndices + 16, indices);
+            }
+        }
+
+        //the highest bit of the index of the first texel is implicitly 0
+        if(indices[0] >= 8){
+            std::swap_ranges(endpoint0, endpoint0 + 4, endpoint1);
+            for(int &index : indices){
+                index = 15 - index;
+            }
+        }
+        std::memset(out, 0, 16);
+        int position = 0;
+        putBits(out, position, 7, 1 << 6);
+        for(int c = 0; c < 4; c++){
+            putBits(out, position, 7, endpoint0[c] >> 1);
+            putBits(out, position, 7, endpoint1[c] >> 1);
+        }
+        putBits(out, position, 1, endpoint0[0] & 1);
+        putBits(out, position, 1, endpoint1[0] & 1);
+        for(int i = 0; i < 16; i++){
+            putBits(out, position, i == 0 ? 3 : 4, indices[i]);
+        }
+    }
+
+    static void decodeBc7(const unsigned char in[16], Color colors[16]){
+        int position = 0;
+        //only mode 6 is written, the other modes decode to magenta
+        if(getBits(in, position, 7) != 1 << 6){
+            std::fill(colors, colors + 16, Color{255, 0, 255, 255});
+            return;
+        }
+        int endpoint0[4], endpoint1[4];
+        for(int c = 0; c < 4; c++){
+            endpoint0[c] = getBits(in, position, 7) << 1;
+            endpoint1[c] = getBits(in, position, 7) << 1;
+        }
+        int pBit0 = getBits(in, position, 1), pBit1 = getBits(in, position, 1);
+        for(int c = 0; c < 4; c++){
+            endpoint0[c] |= pBit0;
+            endpoint1[c] |= pBit1;
+        }
+        Color palette[16];
+        bc7Palette(endpoint0, endpoint1, palette);
+        for(int i = 0; i < 16; i++){
+            colors[i] = palette[getBits(in, position, i == 0 ? 3 : 4)];
+        }
+    }
+
+    void encode(const Image &image, BlockFormat format, std::vector<unsigned char> &blocks, ThreadPool &pool){
+        int blocksX = (image.width + 3) / 4, blocksY = (image.height + 3) / 4;
+        size_t size = blockSize(format);
+        blocks.assign((size_t) blocksX * blocksY * size, 0);
+        pool.parallelFor(0, blocksY, TEXTURE_BLOCK_ROW_GRAIN, [&](int begin, int end){
+            for(int by = begin; by < end; by++){
+                for(int bx = 0; bx < blocksX; bx++){
+                    Color block[16];
+                    for(int i = 0; i < 16; i++){
+                        int x = std::min(4 * bx + i % 4, image.width - 1), y = std::min(4 * by + i / 4, image.height - 1);
+                        const unsigned char *texel = &image.texels[4 * ((size_t) y * image.width + x)];
+                        block[i] = Color{texel[0], texel[1], texel[2], texel[3]};
+                    }
+                    unsigned char *out = &blocks[((size_t) by * blocksX + bx) * size];
+                    int red[16], green[16], alpha[16];
+                    for(int i = 0; i < 16; i++){
+                        red[i] = block[i].r;
+                        green[i] = block[i].g;
+                        alpha[i] = block[i].a;
+                    }
+                    switch(format){
+                        case BC1_FORMAT: encodeBc1(block, out); break;
+                        case BC3_FORMAT: encodeBc4(alpha, out); encodeBc1(block, out + 8); break;
+                        case BC4_FORMAT: encodeBc4(red, out); break;
+                        case BC5_FORMAT: encodeBc4(red, out); encodeBc4(green, out + 8); break;
+                        case BC7_FORMAT: encodeBc7(block, out); break;
+                    }
+                }
+            }
+        });
+    }
+
+    Image decode(const unsigned char *blocks, BlockFormat format, int width, int height){
+        Image image;
+        image.width = width;
+        image.height = height;
+        image.texels.resize(4 * (size_t) width * height);
+        int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        size_t size = blockSize(format);
+        for(int by = 0; by < blocksY; by++){
+            for(int bx = 0; bx < blocksX; bx++){
+                const unsigned char *in = blocks + ((size_t) by * blocksX + bx) * size;
+                Color colors[16];
+                int values[16], more[16];
+                if(format == BC1_FORMAT || format == BC3_FORMAT){
+                    const unsigned char *color = format == BC3_FORMAT ? in + 8 : in;
+                    Color palette[4];
+                    bc1Palette(color[0] | color[1] << 8, color[2] | color[3] << 8, format == BC3_FORMAT, palette);
+                    unsigned int bits = color[4] | color[5] << 8 | color[6] << 16 | (unsigned int) color[7] << 24;
+                    for(int i = 0; i < 16; i++){
+                        colors[i] = palette[bits >> (2 * i) & 3];
+                    }
+                    if(format == BC3_FORMAT){
+                        decodeBc4(in, values);
+                        for(int i = 0; i < 16; i++){
+                            colors[i].a = values[i];
+                        }
+                    }
+                }else if(format == BC4_FORMAT || format == BC5_FORMAT){
+                    decodeBc4(in, values);
+                    if(format == BC5_FORMAT){
+                        decodeBc4(in + 8, more);
+                    }
+                    for(int i = 0; i < 16; i++){
+                        colors[i] = Color{values[i], format == BC5_FORMAT ? more[i] : 0, 0, 255};
+                    }
+                }else{
+                    decodeBc7(in, colors);
+                }
+                for(int i = 0; i < 16; i++){
+                    int x = 4 * bx + i % 4, y = 4 * by + i / 4;
+                    if(x < width && y < height){
+                        unsigned char *texel = &image.texels[4 * ((size_t) y * width + x)];
+                        texel[0] = colors[i].r;
+                        texel[1] = colors[i].g;
+                        texel[2] = colors[i].b;
+                        texel[3] = colors[i].a;
+                    }
+                }
+            }
+        }
+        return image;
+    }
+
+    void compress(const Image &image, TextureKind kind, BlockFormat format, CompressedTexture &texture, ThreadPool &pool){
+        texture.format = format;
+        texture.firstLevel = 0;
+        texture.levels.clear();
+        texture.data.clear();
+        std::vector<unsigned char> blocks;
+        for(const Image &level : generateMipmaps(image, kind, pool)){
+            encode(level, format, blocks, pool);
+            texture.levels.push_back(CompressedTexture::Level{level.width, level.height, texture.data.size(), blocks.size()});
+            texture.data.insert(texture.data.end(), blocks.begin(), blocks.end());
+        }
+    }
+
+    bool compress(const std::string &filename, TextureKind kind, bool highQuality, CompressedTexture &texture,
+                  ThreadPool &pool){
+        Image image;
+        int components;
+        unsigned char *data = stbi_load(filename.c_str(), &image.width, &image.height, &components, 4);
+        if(!data){
+            return false;
+        }
+        image.texels.assign(data, data + 4 * (size_t) image.width * image.height);
+        stbi_image_free(data);
+        bool hasAlpha = false;
+        for(size_t i = 3; i < image.texels.size() && (components == 2 || components == 4); i += 4){
+            hasAlpha = hasAlpha || image.texels[i] < 255;
+        }
+
+        compress(image, kind, chooseFormat(kind, components, hasAlpha, highQuality), texture, pool);
+        return true;
+    }
+
+    bool writeContainer(const std::string &path, const CompressedTexture &texture){
+        //only a texture with all its levels
+        if(texture.levels.empty() || texture.firstLevel != 0){
+            return false;
+        }
+        std::ofstream file(path, std::ios::binary);
+        if(!file.is_open()){
+            return false;
+        }
+        //endianness, type, type size, format, internal and base formats, width, height, depth, array elements,
+        //faces, levels and key/value bytes
+        unsigned int header[13] = {0x04030201u, 0, 1, 0, internalFormat(texture.format), baseFormat(texture.format),
+                                   (unsigned int) texture.levels[0].width, (unsigned int) texture.levels[0].height, 0,
+                                   0, 1, (unsigned int) texture.levels.size(), 0};
+        file.write((const char*) KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+        file.write((const char*) header, sizeof(header));
+        //the blocks are 8 or 16 bytes, so the levels need no padding
+        for(const CompressedTexture::Level &level : texture.levels){
+            unsigned int size = level.size;
+            file.write((const char*) &size, sizeof(size));
+            file.write((const char*) &texture.data[level.offset], level.size);
+        }
+        return (bool) file;
+    }
+
+    bool readContainer(const std::string &path, CompressedTexture &texture, int maxSize){
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if(!file.is_open()){
+            return false;
+        }
+        size_t fileSize = file.tellg();
+        file.seekg(0);
+        unsigned char identifier[sizeof(KTX_IDENTIFIER)];
+        unsigned int header[13];
+        file.read((char*) identifier, sizeof(identifier));
+        file.read((char*) header, sizeof(header));
+        if(!file || std::memcmp(identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0){
+            return false;
+        }
+        int format = 0;
+        while(format <= BC7_FORMAT && internalFormat((BlockFormat) format) != header[4]){
+            format++;
+        }
+        if(header[0] != 0x04030201u || format > BC7_FORMAT || header[10] != 1 || header[11] == 0 || header[11] > 32){
+            return false;
+        }
+
+        //the sizes of the levels follow from their dimensions, so the first level read is found without reading
+        //the ones before it
+        texture.format = (BlockFormat) format;
+        texture.levels.clear();
+        texture.firstLevel = -1;
+        size_t offset = sizeof(identifier) + sizeof(header) + header[12], firstOffset = 0;
+        int width = header[6], height = header[7];
+        for(unsigned int l = 0; l < header[11]; l++){
+            size_t size = levelSize(texture.format, width, height);
+            bool last = l + 1 == header[11];
+            if(texture.firstLevel < 0 && (maxSize <= 0 || std::max(width, height) <= maxSize || last)){
+                texture.firstLevel = l;
+                firstOffset = offset;
+            }
+            offset += sizeof(unsigned int);
+            //the offsets of the levels read are in data, the others have none
+            texture.levels.push_back(CompressedTexture::Level{width, height, texture.firstLevel < 0 ? 0 : offset - firstOffset, size});
+            offset += size;
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+        }
+        if(offset > fileSize){
+            return false;
+        }
+        std::vector<unsigned char> data(offset - firstOffset);
+        file.seekg(firstOffset);
+        file.read((char*) data.data(), data.size());
+        if(!file){
+            return false;
+        }
+        for(size_t l = texture.firstLevel; l < texture.levels.size(); l++){
+            unsigned int size;
+            std::memcpy(&size, &data[texture.levels[l].offset - sizeof(size)], sizeof(size));
+            if(size != texture.levels[l].size){
+                return false;
+            }
+        }
+        texture.data = std::move(data);
+        return true;
+    }
+
+    std::string containerPath(const std::string &filename, TextureKind kind){
+        //the image is known by its path, size and modification time, like the files of a scene snapshot: it isn't
+        //read to find its container
+        std::error_code error;
+        std::uint64_t size = std::filesystem::file_size(filename, error);
+        if(error){
+            return "";
+        }
+        std::int64_t time = std::filesystem::last_write_time(filename, error).time_since_epoch().count();
+        if(error){
+            return "";
+        }
+        std::string absolutePath = std::filesystem::absolute(filename, error).lexically_normal().string();
+        if(error){
+            absolutePath = filename;
+        }
+
+        //FNV-1a of the image, its kind and the version
+        unsigned long long hash = 14695981039346656037ULL;
+        auto add = [&hash](const void *data, size_t size){
+            const unsigned char *bytes = (const unsigned char*) data;
+            for(size_t i = 0; i < size; i++){
+                hash ^= bytes[i];
+                hash *= 1099511628211ULL;
+            }
+        };
+        unsigned int settings[] = {TEXTURE_CONDITIONING_VERSION, (unsigned int) kind};
+        add(settings, sizeof(settings));
+        add(absolutePath.data(), absolutePath.size());
+        add(&size, sizeof(size));
+        add(&time, sizeof(time));
+
+        std::ostringstream path;
+        path << cacheDirectory << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".ktx";
+        return path.str();
+    }
+
+    //true if the context has an extension
+    static bool hasExtension(const char *name){
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for(GLint i = 0; i < count; i++){
+            if(std::strcmp((const char*) glGetStringi(GL_EXTENSIONS, i), name) == 0){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isSupported(BlockFormat format){
+        switch(format){
+            //RGTC is core since OpenGL 3.0
+            case BC4_FORMAT:
+            case BC5_FORMAT:
+                return true;
+            case BC7_FORMAT:
+                return GLAD_GL_VERSION_4_2 || hasExtension("GL_ARB_texture_compression_bptc");
+            default:
+                return hasExtension("GL_EXT_texture_compression_s3tc");
+        }
+    }
+
+    unsigned int upload(const CompressedTexture &texture){
+        if(texture.levels.empty() || !isSupported(texture.format)){
+            return 0;
+        }
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        for(size_t l = texture.firstLevel; l < texture.levels.size(); l++){
+            const CompressedTexture::Level &level = texture.levels[l];
+            glCompressedTexImage2D(GL_TEXTURE_2D, l, internalFormat(texture.format), level.width, level.height, 0,
+                                   level.size, &texture.data[level.offset]);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, texture.firstLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levels.size() - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        return textureID;
+    }
+}
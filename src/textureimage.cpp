@@ -0,0 +1,98 @@
+#include <textureimage.hpp>
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+bool TextureImage::load(const std::string &filename){
+    levels.clear();
+    int width, height;
+    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &components, 0);
+    if(!data){
+        return false;
+    }
+    levels.push_back(Level{width, height, std::vector<unsigned char>(data, data + (size_t) width * height * components)});
+    stbi_image_free(data);
+
+    //each level is the average of 2x2 texels of the previous one, down to 1x1
+    while(width > 1 || height > 1){
+        const Level &previous = levels.back();
+        Level level;
+        level.width = std::max(width / 2, 1);
+        level.height = std::max(height / 2, 1);
+        level.texels.resize((size_t) level.width * level.height * components);
+        for(int y = 0; y < level.height; y++){
+            int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+            for(int x = 0; x < level.width; x++){
+                int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+                for(int c = 0; c < components; c++){
+                    int sum = previous.texels[((size_t) y0 * width + x0) * components + c] +
+                              previous.texels[((size_t) y0 * width + x1) * components + c] +
+                              previous.texels[((size_t) y1 * width + x0) * components + c] +
+                              previous.texels[((size_t) y1 * width + x1) * components + c];
+                    level.texels[((size_t) y * level.width + x) * components + c] = (unsigned char) ((sum + 2) / 4);
+                }
+            }
+        }
+        width = level.width;
+        height = level.height;
+        levels.push_back(std::move(level));
+    }
+    return true;
+}
+
+glm::vec3 TextureImage::sampleLevel(int level, const glm::vec2 &coordinates) const{
+    const Level &texture = levels[level];
+    //the texel centers are at the half coordinates
+    float u = coordinates.x * texture.width - 0.5f;
+    float v = coordinates.y * texture.height - 0.5f;
+    float x0 = std::floor(u), y0 = std::floor(v);
+    float fx = u - x0, fy = v - y0;
+    glm::vec3 texels[4];
+    for(int i = 0; i < 4; i++){
+        int x = (int) std::fmod(x0 + (i & 1), (float) texture.width);
+        int y = (int) std::fmod(y0 + (i >> 1), (float) texture.height);
+        x += x < 0 ? texture.width : 0;
+        y += y < 0 ? texture.height : 0;
+        const unsigned char *texel = &texture.texels[((size_t) y * texture.width + x) * components];
+        //1 component images are GL_RED textures
+        texels[i] = components >= 3 ? glm::vec3(texel[0], texel[1], texel[2]) : glm::vec3(texel[0], 0.f, 0.f);
+    }
+    glm::vec3 bottom = glm::mix(texels[0], texels[1], fx);
+    glm::vec3 top = glm::mix(texels[2], texels[3], fx);
+    return glm::mix(bottom, top, fy) / 255.f;
+}
+
+glm::vec3 TextureImage::sample(const glm::vec2 &coordinates, const glm::vec2 &dx, const glm::vec2 &dy) const{
+    //the biggest change of the texels of the first level between neighboring pixels
+    glm::vec2 size((float) levels[0].width, (float) levels[0].height);
+    float rho = std::max(glm::length(dx * size), glm::length(dy * size));
+    float lod = rho > 0.f ? std::log2(rho) : 0.f;
+    //magnification
+    if(lod <= 0.f){
+        return sampleLevel(0, coordinates);
+    }
+    int lastLevel = levels.size() - 1;
+    lod = std::min(lod, (float) lastLevel);
+    int level = (int) lod;
+    if(level == lastLevel){
+        return sampleLevel(level, coordinates);
+    }
+    return glm::mix(sampleLevel(level, coordinates), sampleLevel(level + 1, coordinates), lod - level);
+}
+
+const TextureImage* TextureCache::get(const std::string &directory, const std::string &path){
+    std::string filename = directory + '/' + path;
+    auto found = images.find(filename);
+    if(found != images.end()){
+        return found->second.levels.empty() ? NULL : &found->second;
+    }
+    TextureImage &image = images[filename];
+    if(!image.load(filename)){
+        std::cerr << "Texture failed to load at path: " << path << std::endl;
+        return NULL;
+    }
+    return &image;
+}
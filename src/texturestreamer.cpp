@@ -0,0 +1,296 @@
+#include <texturestreamer.hpp>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cmath>
+
+bool TextureStreamer::enabled = true;
+size_t TextureStreamer::budget = (size_t) TEXTURE_STREAM_BUDGET << 20;
+
+TextureStreamer& TextureStreamer::global(){
+    static TextureStreamer streamer(budget);
+    return streamer;
+}
+
+TextureStreamer::TextureStreamer(size_t budgetBytes) : budgetBytes(budgetBytes){
+    resident = 0;
+    loading = 0;
+    frame = 0;
+    uploaded = 0;
+    dropped = 0;
+    reading = false;
+    stopping = false;
+    loader = std::thread(&TextureStreamer::loaderLoop, this);
+}
+
+TextureStreamer::~TextureStreamer(){
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        stopping = true;
+    }
+    loadAvailable.notify_all();
+    loader.join();
+}
+
+void TextureStreamer::loaderLoop(){
+    std::unique_lock<std::mutex> lock(loadMutex);
+    while(true){
+        loadAvailable.wait(lock, [this]{ return stopping || !pendingLoads.empty(); });
+        if(stopping){
+            return;
+        }
+        Load load = std::move(pendingLoads.front());
+        pendingLoads.pop_front();
+        reading = true;
+
+        //the file is read without the lock, so the frames can queue more loads meanwhile
+        lock.unlock();
+        load.read = texturecompressor::readContainer(load.path, load.data, load.maxSize) && load.data.firstLevel == load.level;
+        lock.lock();
+
+        readLoads.push_back(std::move(load));
+        reading = false;
+        loadsRead.notify_all();
+    }
+}
+
+unsigned int TextureStreamer::load(const std::string &container){
+    texturecompressor::CompressedTexture coarse;
+    if(!texturecompressor::readContainer(container, coarse, TEXTURE_STREAM_RESIDENT_SIZE)){
+        return 0;
+    }
+    unsigned int id = texturecompressor::upload(coarse);
+    if(id == 0){
+        return 0;
+    }
+
+    StreamedTexture texture;
+    texture.id = id;
+    texture.path = container;
+    texture.format = coarse.format;
+    texture.levels = coarse.levels;
+    texture.coarseLevel = coarse.firstLevel;
+    texture.residentLevel = coarse.firstLevel;
+    texture.wantedLevel = coarse.firstLevel;
+    texture.loadingLevel = -1;
+    texture.finestLevel = 0;
+    texture.lastUsed = frame;
+    resident += levelBytes(texture, texture.residentLevel, texture.levels.size());
+    textureIndices[id] = textures.size();
+    textures.push_back(texture);
+    return id;
+}
+
+int TextureStreamer::requiredLevel(int width, int height, float pixelsPerUv, int levels){
+    //the texels of a unit of the texture coordinates over the pixels it covers, on the longest side
+    float texelsPerPixel = std::max(width, height) / pixelsPerUv;
+    if(!(texelsPerPixel > 1.f)){
+        return 0;
+    }
+    //clamped before the conversion, a surface that covers no pixels divides by 0
+    return (int) std::min(std::floor(std::log2(texelsPerPixel)), levels - 1.f);
+}
+
+void TextureStreamer::request(unsigned int texture, float pixelsPerUv){
+    auto found = textureIndices.find(texture);
+    if(found == textureIndices.end()){
+        return;
+    }
+    StreamedTexture &streamed = textures[found->second];
+    int level = requiredLevel(streamed.levels[0].width, streamed.levels[0].height, pixelsPerUv, streamed.levels.size());
+    streamed.wantedLevel = std::min(streamed.wantedLevel, std::max(level, streamed.finestLevel));
+    streamed.lastUsed = frame;
+}
+
+void TextureStreamer::release(unsigned int texture){
+    auto found = textureIndices.find(texture);
+    if(found == textureIndices.end()){
+        return;
+    }
+    //the last texture takes the index of the released one
+    size_t index = found->second;
+    size_t last = textures.size() - 1;
+    {
+        //the loads refer to their textures by index, the one the thread reads is waited for
+        std::unique_lock<std::mutex> lock(loadMutex);
+        loadsRead.wait(lock, [this]{ return !reading; });
+        for(std::deque<Load> *loads : {&pendingLoads, &readLoads}){
+            for(auto load = loads->begin(); load != loads->end();){
+                if(load->texture == index){
+                    load = loads->erase(load);
+                    continue;
+                }
+                if(load->texture == last){
+                    load->texture = index;
+                }
+                load++;
+            }
+        }
+    }
+    StreamedTexture &released = textures[index];
+    if(released.loadingLevel >= 0){
+        loading -= levelBytes(released, released.loadingLevel, released.residentLevel);
+    }
+    resident -= levelBytes(released, released.residentLevel, released.levels.size());
+    textureIndices.erase(found);
+    if(index != last){
+        textures[index] = std::move(textures[last]);
+        textureIndices[textures[index].id] = index;
+    }
+    textures.pop_back();
+}
+
+size_t TextureStreamer::levelBytes(const StreamedTexture &texture, int first, int last){
+    size_t bytes = 0;
+    for(int l = first; l < last; l++){
+        bytes += texture.levels[l].size;
+    }
+    return bytes;
+}
+
+void TextureStreamer::uploadLoad(Load &load){
+    StreamedTexture &texture = textures[load.texture];
+    size_t bytes = levelBytes(texture, load.level, texture.residentLevel);
+    loading -= bytes;
+    texture.loadingLevel = -1;
+    if(!load.read){
+        //the file is missing or not the one loaded before: the texture keeps the levels it has and isn't read again
+        texture.finestLevel = texture.residentLevel;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    for(int l = load.level; l < texture.residentLevel; l++){
+        const texturecompressor::CompressedTexture::Level &level = load.data.levels[l];
+        glCompressedTexImage2D(GL_TEXTURE_2D, l, texturecompressor::internalFormat(texture.format), level.width,
+                               level.height, 0, level.size, &load.data.data[level.offset]);
+    }
+    //the new levels are sampled once they're all there
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, load.level);
+    uploaded += texture.residentLevel - load.level;
+    texture.residentLevel = load.level;
+    resident += bytes;
+}
+
+void TextureStreamer::dropLevels(StreamedTexture &texture, int level){
+    if(level <= texture.residentLevel){
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    //an empty image frees the memory of a level
+    for(int l = texture.residentLevel; l < level; l++){
+        glCompressedTexImage2D(GL_TEXTURE_2D, l, texturecompressor::internalFormat(texture.format), 0, 0, 0, 0, NULL);
+    }
+    resident -= levelBytes(texture, texture.residentLevel, level);
+    dropped += level - texture.residentLevel;
+    texture.residentLevel = level;
+}
+
+bool TextureStreamer::makeRoom(size_t bytes, size_t skipped){
+    if(resident + loading + bytes <= budgetBytes){
+        return true;
+    }
+    std::vector<size_t> order;
+    for(size_t t = 0; t < textures.size(); t++){
+        //the levels of a texture being loaded are dropped after its load
+        if(t != skipped && textures[t].loadingLevel < 0){
+            order.push_back(t);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b){
+        return textures[a].lastUsed < textures[b].lastUsed;
+    });
+    for(size_t t : order){
+        StreamedTexture &texture = textures[t];
+        //a texture used in this frame keeps what it needs
+        int floor = texture.lastUsed == frame ? texture.wantedLevel : texture.coarseLevel;
+        while(texture.residentLevel < floor && resident + loading + bytes > budgetBytes){
+            dropLevels(texture, texture.residentLevel + 1);
+        }
+        if(resident + loading + bytes <= budgetBytes){
+            return true;
+        }
+    }
+    return false;
+}
+
+void TextureStreamer::update(){
+    //the levels read, up to the bytes of a frame
+    std::vector<Load> loads;
+    {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        size_t bytes = 0;
+        while(!readLoads.empty() && (loads.empty() || bytes < TEXTURE_STREAM_UPLOAD_BYTES)){
+            const Load &load = readLoads.front();
+            bytes += levelBytes(textures[load.texture], load.level, textures[load.texture].residentLevel);
+            loads.push_back(std::move(readLoads.front()));
+            readLoads.pop_front();
+        }
+    }
+    for(Load &load : loads){
+        uploadLoad(load);
+    }
+
+    //the textures used in this frame that need finer levels than they have
+    std::vector<Load> newLoads;
+    for(size_t t = 0; t < textures.size(); t++){
+        StreamedTexture &texture = textures[t];
+        if(texture.loadingLevel >= 0 || texture.lastUsed != frame){
+            continue;
+        }
+        if(texture.wantedLevel > texture.residentLevel){
+            //the finer levels are dropped only for the budget, a texture that comes closer again has them
+            continue;
+        }
+        //the finest level that fits in the budget
+        int level = texture.wantedLevel;
+        while(level < texture.residentLevel && !makeRoom(levelBytes(texture, level, texture.residentLevel), t)){
+            level++;
+        }
+        if(level < texture.residentLevel){
+            texture.loadingLevel = level;
+            loading += levelBytes(texture, level, texture.residentLevel);
+            int maxSize = std::max(texture.levels[level].width, texture.levels[level].height);
+            newLoads.push_back(Load{t, level, texture.path, maxSize, texturecompressor::CompressedTexture(), false});
+        }
+    }
+    if(!newLoads.empty()){
+        std::lock_guard<std::mutex> lock(loadMutex);
+        for(Load &load : newLoads){
+            pendingLoads.push_back(std::move(load));
+        }
+        loadAvailable.notify_one();
+    }
+
+    frame++;
+    for(StreamedTexture &texture : textures){
+        texture.wantedLevel = texture.coarseLevel;
+    }
+}
+
+void TextureStreamer::finishLoads(){
+    std::unique_lock<std::mutex> lock(loadMutex);
+    loadsRead.wait(lock, [this]{ return pendingLoads.empty() && !reading; });
+}
+
+size_t TextureStreamer::residentBytes() const{
+    return resident;
+}
+
+size_t TextureStreamer::numberOfTextures() const{
+    return textures.size();
+}
+
+int TextureStreamer::residentLevel(unsigned int texture) const{
+    auto found = textureIndices.find(texture);
+    return found == textureIndices.end() ? -1 : textures[found->second].residentLevel;
+}
+
+size_t TextureStreamer::levelsUploaded() const{
+    return uploaded;
+}
+
+size_t TextureStreamer::levelsDropped() const{
+    return dropped;
+}
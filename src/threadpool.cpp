@@ -0,0 +1,116 @@
+#include <threadpool.hpp>
+
+#include <algorithm>
+
+// true inside the threads that are executing a job, used to run nested loops inline
+static thread_local bool insideJob = false;
+
+ThreadPool::ThreadPool(unsigned int numberOfThreads) : generation(0), busyWorkers(0), stopping(false)
+{
+    if(numberOfThreads == 0)
+        numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    job.body = nullptr;
+    job.next = 0;
+    job.last = 0;
+    job.grain = 1;
+
+    // the caller is the first thread, so only create the others
+    for(unsigned int i = 1; i < numberOfThreads; i++)
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    for(auto &worker : workers)
+        worker.join();
+}
+
+unsigned int ThreadPool::size() const
+{
+    return workers.size() + 1;
+}
+
+void ThreadPool::parallelFor(int first, int last, int grain, const std::function<void(int, int)> &body)
+{
+    if(first >= last)
+        return;
+    grain = std::max(grain, 1);
+
+    // run inline when there are no workers, when the range fits in one chunk,
+    // when we're already inside a loop or when another thread owns the pool
+    std::unique_lock<std::mutex> callerLock(callerMutex, std::defer_lock);
+    if(workers.empty() || last - first <= grain || insideJob || !callerLock.try_lock())
+    {
+        for(int begin = first; begin < last; begin += grain)
+            body(begin, std::min(begin + grain, last));
+        return;
+    }
+
+    // publish the job and wake the workers
+    {
+        std::lock_guard<std::mutex> lock(jobMutex);
+        job.body = &body;
+        job.next = first;
+        job.last = last;
+        job.grain = grain;
+        busyWorkers = workers.size();
+        generation++;
+    }
+    jobAvailable.notify_all();
+
+    // help with the work
+    runChunks();
+
+    // wait for the workers to finish their last chunks
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobFinished.wait(lock, [this]{ return busyWorkers == 0; });
+    job.body = nullptr;
+}
+
+ThreadPool& ThreadPool::global()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+    unsigned long long seenGeneration = 0;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(jobMutex);
+            jobAvailable.wait(lock, [&]{ return stopping || generation != seenGeneration; });
+            if(stopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        runChunks();
+
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            busyWorkers--;
+        }
+        jobFinished.notify_one();
+    }
+}
+
+void ThreadPool::runChunks()
+{
+    insideJob = true;
+    while(true)
+    {
+        int begin = job.next.fetch_add(job.grain);
+        if(begin >= job.last)
+            break;
+        (*job.body)(begin, std::min(begin + job.grain, job.last));
+    }
+    insideJob = false;
+}
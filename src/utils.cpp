@@ -110,6 +110,36 @@ namespace utils{
         return modelMatrix * scaleMatrix;
     }
 
+    //return the normal matrix of the model matrix
+    //transpose(inverse(A)) = cofactor(A)/det(A), so we only need the cofactors of the upper 3x3
+    ml::matrix<float> normalMatrix(ml::matrix<float> &modelMatrix){
+        ml::matrix<float> &m = modelMatrix;
+        ml::matrix<float> normal(3, 3);
+
+        normal[0][0] = m[1][1]*m[2][2] - m[1][2]*m[2][1];
+        normal[0][1] = m[1][2]*m[2][0] - m[1][0]*m[2][2];
+        normal[0][2] = m[1][0]*m[2][1] - m[1][1]*m[2][0];
+        normal[1][0] = m[0][2]*m[2][1] - m[0][1]*m[2][2];
+        normal[1][1] = m[0][0]*m[2][2] - m[0][2]*m[2][0];
+        normal[1][2] = m[0][1]*m[2][0] - m[0][0]*m[2][1];
+        normal[2][0] = m[0][1]*m[1][2] - m[0][2]*m[1][1];
+        normal[2][1] = m[0][2]*m[1][0] - m[0][0]*m[1][2];
+        normal[2][2] = m[0][0]*m[1][1] - m[0][1]*m[1][0];
+
+        float det = m[0][0]*normal[0][0] + m[0][1]*normal[0][1] + m[0][2]*normal[0][2];
+        //a degenerated model matrix keeps the cofactors, the shaders normalize the normals anyway
+        if(det != 0.f){
+            int i, j;
+            for(i = 0; i < 3; i++){
+                for(j = 0; j < 3; j++){
+                    normal[i][j] /= det;
+                }
+            }
+        }
+
+        return normal;
+    }
+
     ml::matrix<float> orthogonalMatrix(float xw_max, float xw_min, float yw_max, float yw_min, float z_near, float z_far){
         ml::matrix<float> orthogonal(4, 4, true);
 
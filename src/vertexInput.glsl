@@ -0,0 +1,78 @@
+// vertex attributes of the meshes and their decoding, shared by the vertex shaders.
+// COMPRESSED_VERTICES: the compressed layout of Mesh::compressVertices (quantized positions,
+// octahedral normal and tangent, half float texture coordinates)
+// BAKED: the lighting baked into the vertices by LightBaker (BakedLighting), in both layouts
+// AMBIENT_OCCLUSION: the ambient occlusion baked into the vertices at the import (Mesh::ambientOcclusion)
+// TEXTURE_ARRAYS: the layers of the textures of the mesh in the texture arrays of its model (Mesh::setTextureLayers)
+
+#ifdef COMPRESSED_VERTICES
+layout (location = 0) in vec4 aPos;       // position in [0, 1] inside the box of the mesh, w is the tangent handedness
+layout (location = 1) in vec2 aNormal;    // octahedral normal
+layout (location = 2) in vec2 aTexCoords; // converted from half floats by the vertex fetch
+layout (location = 3) in vec2 aTangent;   // octahedral tangent
+
+// box of the quantized positions
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 OctahedralDecode(vec2 e){
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if(v.z < 0.0){
+        v.xy = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+vec3 VertexPosition(){
+    return positionOffset + aPos.xyz * positionScale;
+}
+
+vec3 VertexNormal(){
+    return OctahedralDecode(aNormal);
+}
+
+// tangent and handedness (bitangent = cross(normal, tangent) * w)
+vec4 VertexTangent(){
+    return vec4(OctahedralDecode(aTangent), aPos.w * 2.0 - 1.0);
+}
+#else
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in vec3 aTangent;
+layout (location = 4) in vec3 aBitangent;
+
+vec3 VertexPosition(){
+    return aPos;
+}
+
+vec3 VertexNormal(){
+    return aNormal;
+}
+
+vec4 VertexTangent(){
+    return vec4(aTangent, dot(cross(aNormal, aTangent), aBitangent) < 0.0 ? -1.0 : 1.0);
+}
+#endif
+
+#ifdef BAKED
+layout (location = 5) in vec4 aBakedDiffuse;        // ambient and diffuse light, w is the ambient occlusion
+layout (location = 6) in vec3 aBakedSpecular;       // specular light
+layout (location = 7) in vec3 aBakedLightDirection; // world direction the specular light comes from
+#endif
+
+#ifdef AMBIENT_OCCLUSION
+layout (location = 8) in float aOcclusion;
+
+float VertexOcclusion(){
+    return aOcclusion;
+}
+#else
+float VertexOcclusion(){
+    return 1.0;
+}
+#endif
+
+#ifdef TEXTURE_ARRAYS
+layout (location = 9) in vec2 aTextureLayers; // layers of the diffuse and the specular textures
+#endif